@@ -1,49 +1,408 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 
-#define MAX_CONTACTS 100
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-// 定义联系人结构体
-struct Contact {
-    char name[50];
-    char phone[20];
-};
+// 通讯录（同样的结构也用来做 设备ID -> 元数据 查表，上千条）：
+// - 字符串池：所有名字/电话连续放在一块可增长的内存里，记录只存偏移；同样的字符串只存一份（驻留）
+// - 名字 -> 记录：开放寻址哈希（线性探测，容量 2 的幂，装载率不超过 1/2），O(1)
+// - 名字有序索引：改动后按需重建，前缀查找 = 二分找下界 + 顺序扫，O(log n + k)
+// - 记录数组、字符串池、哈希表都按 2 倍增长，没有固定上限
+// - 存盘：头 | 记录 | 有序索引 | 哈希槽 | 字符串池，原样写出；启动时 mmap 整个文件，不解析就能直接查（只读），
+//   第一次修改时才拷到堆上
 
-// 全局数组存放联系人
-struct Contact contacts[MAX_CONTACTS];
-int contact_count = 0;
+#define CS_MAGIC     "CTS1"
+#define CS_HASH_MIN  16
 
-// 添加联系人
-void add_contact(const char *name, const char *phone) {
-    if (contact_count < MAX_CONTACTS) {
-        strcpy(contacts[contact_count].name, name);
-        strcpy(contacts[contact_count].phone, phone);
-        contact_count++;
-    } else {
-        printf("通讯录已满，不能再添加。\n");
+// 定义联系人结构体：两个偏移都指向字符串池
+typedef struct {
+    uint32_t name;
+    uint32_t phone;
+} Contact;
+
+// 哈希槽：val = 记录下标（或池偏移）+ 1，0 表示空槽
+typedef struct {
+    uint32_t hash;
+    uint32_t val;
+} HSlot;
+
+typedef struct {
+    HSlot   *slot;
+    uint32_t cap;   // 2 的幂
+    uint32_t n;
+} HTab;
+
+typedef struct {
+    char     *pool;     uint32_t pool_len, pool_cap;
+    Contact  *rec;      uint32_t count, rec_cap;
+    uint32_t *sorted;   // 按名字排序的记录下标（count 个）
+    bool      sorted_ok;
+    HTab      by_name;  // 名字 -> 记录下标
+    HTab      strings;  // 驻留：字符串内容 -> 池偏移（映射打开时为空，转可写时重建）
+    void     *map;      // 非 NULL：上面的数组直接指向映射的文件（只读）
+    size_t    map_len;
+} ContactStore;
+
+// 文件头（之后依次是 rec[count]、sorted[count]、slot[hash_cap]、pool[pool_len]，本机字节序）
+typedef struct {
+    char     magic[4];
+    uint32_t count;
+    uint32_t pool_len;
+    uint32_t hash_cap;
+} CsFileHeader;
+
+// --------- 哈希 ---------
+static uint32_t fnv1a(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+    return h;
+}
+
+static const char *cs_key(const ContactStore *cs, const HTab *t, uint32_t val) {
+    return cs->pool + (t == &cs->by_name ? cs->rec[val - 1].name : val - 1);
+}
+
+// 找 key 所在的槽；没有则返回它该放的空槽
+static HSlot *ht_probe(const ContactStore *cs, const HTab *t, uint32_t h, const char *key) {
+    uint32_t mask = t->cap - 1;
+    for (uint32_t i = h & mask;; i = (i + 1) & mask) {
+        HSlot *s = &t->slot[i];
+        if (!s->val || (s->hash == h && strcmp(cs_key(cs, t, s->val), key) == 0)) return s;
+    }
+}
+
+static bool ht_init(HTab *t, uint32_t cap) {
+    t->slot = (HSlot *)calloc(cap, sizeof(HSlot));
+    t->cap = t->slot ? cap : 0;
+    t->n = 0;
+    return t->slot != NULL;
+}
+
+// 翻倍：只按保存的 hash 找空槽，不用再比较字符串
+static bool ht_grow(HTab *t) {
+    HTab nt;
+    if (!ht_init(&nt, t->cap * 2)) return false;
+    for (uint32_t i = 0; i < t->cap; ++i) {
+        if (!t->slot[i].val) continue;
+        uint32_t j = t->slot[i].hash & (nt.cap - 1);
+        while (nt.slot[j].val) j = (j + 1) & (nt.cap - 1);
+        nt.slot[j] = t->slot[i];
+    }
+    nt.n = t->n;
+    free(t->slot);
+    *t = nt;
+    return true;
+}
+
+// 插入一个确定不存在的 key
+static bool ht_insert(ContactStore *cs, HTab *t, uint32_t h, uint32_t val) {
+    if ((t->n + 1) * 2 > t->cap && !ht_grow(t)) return false;
+    HSlot *s = ht_probe(cs, t, h, cs_key(cs, t, val));
+    s->hash = h;
+    s->val = val;
+    t->n++;
+    return true;
+}
+
+// --------- 字符串池 ---------
+// 返回偏移；失败返回 UINT32_MAX
+static uint32_t pool_put(ContactStore *cs, const char *s, size_t len) {
+    if (len >= UINT32_MAX - cs->pool_len) return UINT32_MAX;
+    if (cs->pool_len + len + 1 > cs->pool_cap) {
+        size_t cap = cs->pool_cap ? cs->pool_cap : 256;
+        while (cap < cs->pool_len + len + 1) cap *= 2;
+        if (cap > UINT32_MAX) cap = UINT32_MAX;
+        char *p = (char *)realloc(cs->pool, cap);
+        if (!p) return UINT32_MAX;
+        cs->pool = p;
+        cs->pool_cap = (uint32_t)cap;
+    }
+    uint32_t off = cs->pool_len;
+    memcpy(cs->pool + off, s, len + 1);
+    cs->pool_len += (uint32_t)len + 1;
+    return off;
+}
+
+// 驻留：同样的内容只存一份
+static uint32_t cs_intern(ContactStore *cs, const char *s) {
+    uint32_t h = fnv1a(s);
+    HSlot *hit = ht_probe(cs, &cs->strings, h, s);
+    if (hit->val) return hit->val - 1;
+    uint32_t off = pool_put(cs, s, strlen(s));
+    if (off == UINT32_MAX || !ht_insert(cs, &cs->strings, h, off + 1)) return UINT32_MAX;
+    return off;
+}
+
+// --------- 存储 ---------
+static bool cs_init(ContactStore *cs) {
+    memset(cs, 0, sizeof(*cs));
+    cs->sorted_ok = true;
+    return ht_init(&cs->by_name, CS_HASH_MIN) && ht_init(&cs->strings, CS_HASH_MIN);
+}
+
+static void cs_unmap(ContactStore *cs) {
+    if (!cs->map) return;
+#ifdef _WIN32
+    UnmapViewOfFile(cs->map);
+#else
+    munmap(cs->map, cs->map_len);
+#endif
+    cs->map = NULL;
+}
+
+static void cs_free(ContactStore *cs) {
+    if (cs->map) cs_unmap(cs);
+    else {
+        free(cs->pool);
+        free(cs->rec);
+        free(cs->sorted);
+        free(cs->by_name.slot);
+    }
+    free(cs->strings.slot);
+    memset(cs, 0, sizeof(*cs));
+}
+
+static void *dup_mem(const void *p, size_t n, size_t cap) {
+    void *q = malloc(cap ? cap : 1);
+    if (q && n) memcpy(q, p, n);
+    return q;
+}
+
+// 映射打开的只读存储转成堆上的可写存储（第一次修改前调用；已可写时什么也不做）
+static bool cs_make_writable(ContactStore *cs) {
+    if (!cs->map) return true;
+    ContactStore w = *cs;
+    w.pool_cap = cs->pool_len * 2 > 256 ? cs->pool_len * 2 : 256;
+    w.rec_cap = cs->count * 2 > 16 ? cs->count * 2 : 16;
+    w.pool = (char *)dup_mem(cs->pool, cs->pool_len, w.pool_cap);
+    w.rec = (Contact *)dup_mem(cs->rec, cs->count * sizeof(Contact), w.rec_cap * sizeof(Contact));
+    w.sorted = (uint32_t *)dup_mem(cs->sorted, cs->count * sizeof(uint32_t), w.rec_cap * sizeof(uint32_t));
+    w.by_name.slot = (HSlot *)dup_mem(cs->by_name.slot, cs->by_name.cap * sizeof(HSlot), cs->by_name.cap * sizeof(HSlot));
+    w.map = NULL;
+    if (!w.pool || !w.rec || !w.sorted || !w.by_name.slot || !ht_init(&w.strings, CS_HASH_MIN)) {
+        free(w.pool); free(w.rec); free(w.sorted); free(w.by_name.slot);
+        return false;
+    }
+    // 驻留表没有存盘，按记录重建（池里每个字符串都被某条记录引用）
+    for (uint32_t i = 0; i < w.count; ++i) {
+        uint32_t offs[2] = { w.rec[i].name, w.rec[i].phone };
+        for (int k = 0; k < 2; ++k) {
+            const char *s = w.pool + offs[k];
+            uint32_t h = fnv1a(s);
+            if (!ht_probe(&w, &w.strings, h, s)->val && !ht_insert(&w, &w.strings, h, offs[k] + 1)) {
+                free(w.pool); free(w.rec); free(w.sorted); free(w.by_name.slot); free(w.strings.slot);
+                return false;
+            }
+        }
+    }
+    free(cs->strings.slot);
+    cs_unmap(cs);
+    *cs = w;
+    return true;
+}
+
+// 添加联系人；同名则更新电话。失败（内存不足）返回 false
+static bool cs_add(ContactStore *cs, const char *name, const char *phone) {
+    if (!cs_make_writable(cs)) return false;
+    uint32_t h = fnv1a(name);
+    HSlot *hit = ht_probe(cs, &cs->by_name, h, name);
+    uint32_t ph = cs_intern(cs, phone);
+    if (ph == UINT32_MAX) return false;
+    if (hit->val) { cs->rec[hit->val - 1].phone = ph; return true; }
+
+    if (cs->count == cs->rec_cap) {
+        uint32_t cap = cs->rec_cap ? cs->rec_cap * 2 : 16;
+        Contact *r = (Contact *)realloc(cs->rec, cap * sizeof(Contact));
+        if (!r) return false;
+        cs->rec = r;
+        uint32_t *so = (uint32_t *)realloc(cs->sorted, cap * sizeof(uint32_t));
+        if (!so) return false;
+        cs->sorted = so;
+        cs->rec_cap = cap;
+    }
+    uint32_t nm = cs_intern(cs, name);
+    if (nm == UINT32_MAX) return false;
+    cs->rec[cs->count] = (Contact){ nm, ph };
+    if (!ht_insert(cs, &cs->by_name, h, cs->count + 1)) return false;
+    cs->count++;
+    cs->sorted_ok = false;
+    return true;
+}
+
+static const char *cs_name(const ContactStore *cs, const Contact *c)  { return cs->pool + c->name; }
+static const char *cs_phone(const ContactStore *cs, const Contact *c) { return cs->pool + c->phone; }
+
+// 按名字查找：O(1)
+static const Contact *cs_find(const ContactStore *cs, const char *name) {
+    const HSlot *s = ht_probe(cs, &cs->by_name, fnv1a(name), name);
+    return s->val ? &cs->rec[s->val - 1] : NULL;
+}
+
+// --------- 有序索引 ---------
+static const ContactStore *g_sort_cs;   // qsort 没有上下文参数
+static int cmp_by_name(const void *a, const void *b) {
+    const ContactStore *cs = g_sort_cs;
+    return strcmp(cs->pool + cs->rec[*(const uint32_t *)a].name, cs->pool + cs->rec[*(const uint32_t *)b].name);
+}
+
+static void cs_sort(ContactStore *cs) {
+    if (cs->sorted_ok) return;
+    for (uint32_t i = 0; i < cs->count; ++i) cs->sorted[i] = i;
+    g_sort_cs = cs;
+    qsort(cs->sorted, cs->count, sizeof(uint32_t), cmp_by_name);
+    cs->sorted_ok = true;
+}
+
+// 前缀查找：按名字顺序对每个匹配调一次 fn，返回匹配数
+static uint32_t cs_prefix(ContactStore *cs, const char *prefix,
+                          void (*fn)(const ContactStore *cs, const Contact *c, void *user), void *user) {
+    cs_sort(cs);
+    size_t plen = strlen(prefix);
+    uint32_t lo = 0, hi = cs->count;    // 下界：第一个 name >= prefix
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (strcmp(cs->pool + cs->rec[cs->sorted[mid]].name, prefix) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    uint32_t n = 0;
+    for (; lo < cs->count; ++lo, ++n) {
+        const Contact *c = &cs->rec[cs->sorted[lo]];
+        if (strncmp(cs->pool + c->name, prefix, plen) != 0) break;
+        if (fn) fn(cs, c, user);
+    }
+    return n;
+}
+
+// --------- 存盘 / 映射打开 ---------
+static bool cs_save(ContactStore *cs, const char *path) {
+    cs_sort(cs);
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    CsFileHeader hd = { {0}, cs->count, cs->pool_len, cs->by_name.cap };
+    memcpy(hd.magic, CS_MAGIC, 4);
+    bool ok = fwrite(&hd, sizeof(hd), 1, f) == 1
+           && fwrite(cs->rec, sizeof(Contact), cs->count, f) == cs->count
+           && fwrite(cs->sorted, sizeof(uint32_t), cs->count, f) == cs->count
+           && fwrite(cs->by_name.slot, sizeof(HSlot), cs->by_name.cap, f) == cs->by_name.cap
+           && fwrite(cs->pool, 1, cs->pool_len, f) == cs->pool_len;
+    return (fclose(f) == 0) && ok;
+}
+
+static void *map_file(const char *path, size_t *len) {
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (fh == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER sz;
+    void *p = NULL;
+    if (GetFileSizeEx(fh, &sz) && sz.QuadPart > 0) {
+        HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mh) {
+            p = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mh);   // 视图保持映射
+        }
+        *len = (size_t)sz.QuadPart;
     }
+    CloseHandle(fh);
+    return p;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    void *p = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) p = NULL;
+        *len = (size_t)st.st_size;
+    }
+    close(fd);
+    return p;
+#endif
+}
+
+// 映射打开存盘文件：校验后各数组直接指向映射，查找/前缀查找立即可用；格式不对返回 false
+static bool cs_open_mapped(ContactStore *cs, const char *path) {
+    size_t len = 0;
+    uint8_t *p = (uint8_t *)map_file(path, &len);
+    if (!p) return false;
+    ContactStore m;
+    memset(&m, 0, sizeof(m));
+    m.map = p;
+    m.map_len = len;
+    CsFileHeader hd;
+    bool ok = len >= sizeof(hd);
+    if (ok) {
+        memcpy(&hd, p, sizeof(hd));
+        uint64_t need = sizeof(hd) + (uint64_t)hd.count * (sizeof(Contact) + sizeof(uint32_t))
+                      + (uint64_t)hd.hash_cap * sizeof(HSlot) + hd.pool_len;
+        ok = memcmp(hd.magic, CS_MAGIC, 4) == 0 && need == len && hd.hash_cap >= CS_HASH_MIN
+          && (hd.hash_cap & (hd.hash_cap - 1)) == 0 && hd.count < hd.hash_cap
+          && (hd.pool_len > 0 ? p[len - 1] == '\0' : hd.count == 0); // 空表保存出来没有字符串池
+    }
+    if (ok) {
+        m.count = hd.count;
+        m.pool_len = hd.pool_len;
+        m.rec = (Contact *)(p + sizeof(hd));
+        m.sorted = (uint32_t *)(m.rec + hd.count);
+        m.by_name.slot = (HSlot *)(m.sorted + hd.count);
+        m.by_name.cap = hd.hash_cap;
+        m.by_name.n = hd.count;
+        m.pool = (char *)(m.by_name.slot + hd.hash_cap);
+        m.sorted_ok = true;
+        for (uint32_t i = 0; ok && i < hd.count; ++i)
+            ok = m.rec[i].name < hd.pool_len && m.rec[i].phone < hd.pool_len && m.sorted[i] < hd.count;
+        uint32_t used = 0;   // 非空槽数必须等于记录数，否则探测可能不停
+        for (uint32_t i = 0; ok && i < hd.hash_cap; ++i) {
+            ok = m.by_name.slot[i].val <= hd.count;
+            used += m.by_name.slot[i].val != 0;
+        }
+        ok = ok && used == hd.count;
+    }
+    if (!ok) { cs_unmap(&m); return false; }
+    cs_free(cs);
+    *cs = m;
+    return true;
+}
+
+// --------- 原来的三个入口（全局通讯录） ---------
+static ContactStore g_book;
+
+void add_contact(const char *name, const char *phone) {
+    if (!cs_add(&g_book, name, phone))
+        printf("内存不足，不能再添加。\n");
 }
 
-// 显示所有联系人
+// 显示所有联系人（按添加顺序）
 void show_contacts() {
     printf("---- 通讯录 ----\n");
-    for (int i = 0; i < contact_count; i++) {
-        printf("%d. %s - %s\n", i + 1, contacts[i].name, contacts[i].phone);
+    for (uint32_t i = 0; i < g_book.count; i++) {
+        printf("%u. %s - %s\n", i + 1, cs_name(&g_book, &g_book.rec[i]), cs_phone(&g_book, &g_book.rec[i]));
     }
 }
 
 // 按名字查找联系人
 void find_contact(const char *name) {
-    for (int i = 0; i < contact_count; i++) {
-        if (strcmp(contacts[i].name, name) == 0) {
-            printf("找到：%s 的电话是 %s\n", contacts[i].name, contacts[i].phone);
-            return;
-        }
-    }
-    printf("没有找到这个人。\n");
+    const Contact *c = cs_find(&g_book, name);
+    if (c) printf("找到：%s 的电话是 %s\n", cs_name(&g_book, c), cs_phone(&g_book, c));
+    else   printf("没有找到这个人。\n");
+}
+
+static void print_match(const ContactStore *cs, const Contact *c, void *user) {
+    uint32_t *shown = (uint32_t *)user;
+    if ((*shown)++ < 3) printf("  %s -> %s\n", cs_name(cs, c), cs_phone(cs, c));
 }
 
 int main() {
+    cs_init(&g_book);
     add_contact("Alice", "123456");
     add_contact("Bob", "9876544862145458565321525661");
 
@@ -52,5 +411,26 @@ int main() {
     find_contact("Alice");
     find_contact("Charlie");
 
+    // 批量：设备 ID -> 元数据，存盘后映射打开再查
+    char id[32], meta[48];
+    for (int i = 0; i < 5000; ++i) {
+        snprintf(id, sizeof(id), "dev-%05d", i);
+        snprintf(meta, sizeof(meta), "fw=1.%d;site=%c", i % 4, 'A' + i % 3);
+        add_contact(id, meta);
+    }
+    uint32_t shown = 0;
+    printf("前缀 dev-012：%u 条\n", cs_prefix(&g_book, "dev-012", print_match, &shown));
+
+    if (!cs_save(&g_book, "contacts.bin") || !cs_open_mapped(&g_book, "contacts.bin")) {
+        printf("存盘/映射失败。\n");
+        cs_free(&g_book);
+        return 1;
+    }
+    printf("映射打开 contacts.bin：%u 条，字符串池 %u 字节\n", g_book.count, g_book.pool_len);
+    find_contact("dev-04242");
+    add_contact("Charlie", "555");   // 第一次修改：拷到堆上
+    find_contact("Charlie");
+
+    cs_free(&g_book);
     return 0;
 }
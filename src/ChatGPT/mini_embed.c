@@ -1,24 +1,284 @@
 // mini_embed.c  — PC 上的“嵌入式系统”模拟
+// 调度：分层定时轮 + 协作式任务，主循环睡到下一个到期时刻（或有按键输入）才醒，不再每 1ms 空转一次
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime、pselect（-std=c11 下默认不声明）
+#endif
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
 #include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/select.h>
+#endif
 
 #define ARRAY_LEN(x) ((int)(sizeof(x)/sizeof((x)[0])))
 
+#ifndef RUN_MS
+#define RUN_MS 3600000u   // 最多跑一小时
+#endif
+
 // --------- 固定宽度 & 全局“硬件寄存器” ---------
 static volatile uint32_t g_ms = 0;          // 1ms 系统时间
 static volatile uint8_t  LED_PORT = 0x00;   // 8 位 LED 端口（1=亮，0=灭）
 
-// --------- Tick: 1ms “中断”模拟（轮询实现）---------
-static void host_sleep_ms(int ms) {
-    struct timespec ts = {.tv_sec = ms/1000, .tv_nsec = (ms%1000)*1000000L};
-    nanosleep(&ts, NULL);
+// --------- 时钟与休眠（主机模拟）---------
+// 目标板上对应：一个自由运行的硬件定时器 + 比较中断；host_wait_until 即“设比较值，WFI 睡下”
+static bool g_stdin_eof = false;   // stdin 读到 EOF 后不再等它（否则 poll 一直报可读）
+
+#ifdef _WIN32
+static uint64_t host_clock_us(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)((double)c.QuadPart * 1e6 / (double)freq.QuadPart);
+}
+
+// 控制台句柄在鼠标/焦点/按键抬起等事件上也是“有信号”的，fgetc 却会一直等：先把这些事件读掉
+static bool host_console_has_key(HANDLE h) {
+    INPUT_RECORD r;
+    DWORD n;
+    while (PeekConsoleInputA(h, &r, 1, &n) && n == 1) {
+        if (r.EventType == KEY_EVENT && r.Event.KeyEvent.bKeyDown) return true;
+        ReadConsoleInputA(h, &r, 1, &n);
+    }
+    return false;
+}
+
+// 等 stdin 可读，最多 us 微秒（<0 一直等）；返回是否可读
+static bool host_wait_stdin(long long us) {
+    DWORD ms = us < 0 ? INFINITE : (DWORD)((us + 999) / 1000);
+    if (g_stdin_eof) {
+        Sleep(ms);
+        return false;
+    }
+    HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD mode;
+    bool console = GetConsoleMode(h, &mode) != 0;
+    uint64_t end = us < 0 ? UINT64_MAX : host_clock_us() + (uint64_t)us;
+    for (;;) {
+        if (WaitForSingleObject(h, ms) != WAIT_OBJECT_0) return false;
+        if (!console || host_console_has_key(h)) return true;
+        if (us >= 0) { // 只有非按键事件：等剩下的时间
+            uint64_t now = host_clock_us();
+            if (now >= end) return false;
+            ms = (DWORD)((end - now + 999) / 1000);
+        }
+    }
+}
+#else
+static uint64_t host_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// 等 stdin 可读，最多 us 微秒（<0 一直等）；返回是否可读
+static bool host_wait_stdin(long long us) {
+    struct timespec ts = { .tv_sec = (time_t)(us / 1000000), .tv_nsec = (long)(us % 1000000) * 1000L };
+    fd_set rd;
+    FD_ZERO(&rd);
+    if (!g_stdin_eof) FD_SET(0, &rd);
+    return pselect(g_stdin_eof ? 0 : 1, &rd, NULL, NULL, us < 0 ? NULL : &ts, NULL) > 0;
+}
+#endif
+
+static uint64_t host_now_us(void) {
+    static uint64_t t0;
+    uint64_t us = host_clock_us();
+    if (!t0) t0 = us;
+    return us - t0;
+}
+static uint32_t host_now_ms(void) { return (uint32_t)(host_now_us() / 1000u); }
+
+// stdin 是否有数据可读（不阻塞）
+static bool host_stdin_ready(void) {
+    return !g_stdin_eof && host_wait_stdin(0);
+}
+
+// 睡到 due_ms（UINT32_MAX 表示没有定时事件），或 stdin 有输入提前醒来；返回是否因输入醒来
+static bool host_wait_until(uint32_t due_ms) {
+    if (due_ms == UINT32_MAX) return host_wait_stdin(-1);
+    uint64_t now = host_now_us(), due = (uint64_t)due_ms * 1000u;
+    return host_wait_stdin(due > now ? (long long)(due - now) : 0);
+}
+
+// --------- 分层定时轮 ---------
+// 3 级 × 64 格：第 0 级 1ms/格，第 1 级 64ms/格，第 2 级 4096ms/格（约 262 秒；更远的先放最远一格，到时再下放）
+// - 定时器按到期时刻挂到对应格的链表上，登记/取消 O(1)（取消要在所在格的短链表里摘掉）
+// - 推进到第 0 级一圈的起点时，把上一级当前格里的定时器重新登记（自然落到更细的一级）
+// - tw_next_due 给出最近的到期时刻，主循环据此决定睡多久
+#define TW_BITS   6
+#define TW_SLOTS  (1u << TW_BITS)
+#define TW_MASK   (TW_SLOTS - 1)
+#define TW_LEVELS 3
+
+typedef struct Timer {
+    struct Timer *next;
+    uint32_t due;         // 登记的到期时刻（ms，统计抖动用）
+    uint32_t at;          // 实际挂的时刻（过去的到期时刻按“下一个要处理的 tick”算）
+    uint8_t  lvl, idx;    // 挂在哪一格
+    bool     armed;
+} Timer;
+
+typedef struct {
+    Timer   *slot[TW_LEVELS][TW_SLOTS];
+    uint32_t next;        // 下一个要处理的 tick：早于它的定时器都已取出
+} TimerWheel;
+
+static void tw_init(TimerWheel *w, uint32_t now) {
+    for (int l = 0; l < TW_LEVELS; ++l)
+        for (unsigned i = 0; i < TW_SLOTS; ++i) w->slot[l][i] = NULL;
+    w->next = now;
+}
+
+static void tw_link(TimerWheel *w, Timer *t) {
+    uint32_t at = t->at;
+    int l = 0;
+    while (l < TW_LEVELS - 1 && (at >> (TW_BITS * l)) - (w->next >> (TW_BITS * l)) >= TW_SLOTS) ++l;
+    uint32_t span = (at >> (TW_BITS * l)) - (w->next >> (TW_BITS * l));
+    if (span >= TW_SLOTS) span = TW_SLOTS - 1;   // 超出最高级：先挂最远一格
+    t->lvl = (uint8_t)l;
+    t->idx = (uint8_t)(((w->next >> (TW_BITS * l)) + span) & TW_MASK);
+    t->next = w->slot[l][t->idx];
+    w->slot[l][t->idx] = t;
+}
+
+static void tw_cancel(TimerWheel *w, Timer *t) {
+    if (!t->armed) return;
+    for (Timer **pp = &w->slot[t->lvl][t->idx]; *pp; pp = &(*pp)->next)
+        if (*pp == t) { *pp = t->next; break; }
+    t->armed = false;
+}
+
+static void tw_add(TimerWheel *w, Timer *t, uint32_t due) {
+    tw_cancel(w, t);
+    t->due = due;
+    t->at = due > w->next ? due : w->next;
+    t->armed = true;
+    tw_link(w, t);
+}
+
+// 把第 l 级当前格整体重新登记（w->next 已指向这一格的起点）
+static void tw_cascade(TimerWheel *w, int l) {
+    unsigned i = (w->next >> (TW_BITS * l)) & TW_MASK;
+    Timer *t = w->slot[l][i];
+    w->slot[l][i] = NULL;
+    while (t) { Timer *n = t->next; tw_link(w, t); t = n; }
+}
+
+// 处理 next..now 的每个 tick，到期的定时器摘下来串成链表返回（由调用方逐个运行）
+static Timer *tw_advance(TimerWheel *w, uint32_t now) {
+    Timer *expired = NULL;
+    for (; (int32_t)(now - w->next) >= 0; ++w->next) {
+        uint32_t t = w->next;
+        if ((t & TW_MASK) == 0) {
+            if ((t & ((TW_SLOTS << TW_BITS) - 1)) == 0) tw_cascade(w, 2);
+            tw_cascade(w, 1);
+        }
+        Timer **pp = &w->slot[0][t & TW_MASK];
+        while (*pp) {
+            Timer *x = *pp;
+            if (x->at == t) { *pp = x->next; x->armed = false; x->next = expired; expired = x; }
+            else pp = &x->next;
+        }
+    }
+    return expired;
+}
+
+// 最近的到期时刻；没有定时器返回 UINT32_MAX
+// 第 0 级只按顺序扫到下一个下放边界：过了边界，上一级下放下来的定时器可能比第 0 级剩下的更早，
+// 那部分与第 1、2 级一起取最小的 at
+static uint32_t tw_next_due(const TimerWheel *w) {
+    uint32_t bound = (w->next | TW_MASK) + 1;
+    for (uint32_t t = w->next; t != bound; ++t)
+        for (const Timer *x = w->slot[0][t & TW_MASK]; x; x = x->next)
+            if (x->at == t) return t;
+    uint32_t best = UINT32_MAX;
+    for (unsigned i = 0; i < TW_SLOTS; ++i)
+        for (const Timer *x = w->slot[0][i]; x; x = x->next)
+            if (x->at < best) best = x->at;
+    for (int l = 1; l < TW_LEVELS; ++l)
+        for (unsigned i = 0; i < TW_SLOTS; ++i)
+            for (const Timer *x = w->slot[l][i]; x; x = x->next)
+                if (x->at < best) best = x->at;
+    return best;
+}
+
+// --------- 协作式调度 ---------
+// 任务登记一个周期（sched_every）或一个截止时刻（sched_at），到期后在主循环里按顺序运行；
+// 周期任务按固定节拍续期（不累积漂移），落后一整个周期以上记一次 overrun 并跳过错过的节拍
+struct App;
+typedef void (*TaskFn)(struct App *a, uint32_t now_ms);
+
+typedef struct {
+    Timer       tm;          // 必须是第一个成员：到期链表里的 Timer* 即 Task*
+    const char *name;
+    TaskFn      fn;
+    uint32_t    period_ms;   // 0 = 单次（任务自己决定下一次 sched_at）
+    // 统计
+    uint32_t runs, overruns;
+    uint64_t run_us_sum, late_us_sum;
+    uint32_t run_us_max, late_us_max;   // 运行耗时 / 抖动（实际开始 - 登记的到期时刻）
+} Task;
+
+typedef struct {
+    TimerWheel wheel;
+    uint32_t   wakeups;      // 主循环醒来的次数
+} Sched;
+
+static void task_init(Task *t, const char *name, TaskFn fn) {
+    *t = (Task){ .name = name, .fn = fn };
+}
+
+static void sched_at(Sched *s, Task *t, uint32_t due_ms) {
+    t->period_ms = 0;
+    tw_add(&s->wheel, &t->tm, due_ms);
+}
+
+static void sched_every(Sched *s, Task *t, uint32_t period_ms, uint32_t first_ms) {
+    tw_add(&s->wheel, &t->tm, first_ms);
+    t->period_ms = period_ms;
 }
-static void systick_poll_once(void) {
-    host_sleep_ms(1);
-    g_ms++;
+
+static void sched_cancel(Sched *s, Task *t) { tw_cancel(&s->wheel, &t->tm); t->period_ms = 0; }
+
+// 运行所有到期任务
+static void sched_run(Sched *s, struct App *a, uint32_t now_ms) {
+    Timer *x = tw_advance(&s->wheel, now_ms);
+    while (x) {
+        Timer *n = x->next;
+        Task *t = (Task *)x;
+        uint64_t start = host_now_us();
+        uint64_t due_us = (uint64_t)t->tm.due * 1000u;
+        uint32_t late = start > due_us ? (uint32_t)(start - due_us) : 0;
+        t->fn(a, now_ms);
+        uint32_t run = (uint32_t)(host_now_us() - start);
+        t->runs++;
+        t->run_us_sum += run;  if (run > t->run_us_max) t->run_us_max = run;
+        t->late_us_sum += late; if (late > t->late_us_max) t->late_us_max = late;
+        if (t->period_ms && !t->tm.armed) {   // 任务自己改了登记就听它的
+            uint32_t due = t->tm.due + t->period_ms;
+            while ((int32_t)(due - now_ms) <= 0) { due += t->period_ms; t->overruns++; }
+            tw_add(&s->wheel, &t->tm, due);
+        }
+        x = n;
+    }
+}
+
+static void sched_report(const Sched *s, const Task *const *tasks, int n, uint32_t elapsed_ms) {
+    printf("\n运行 %u ms，主循环醒来 %u 次（1ms 轮询需要 %u 次）\n", elapsed_ms, s->wakeups, elapsed_ms);
+    printf("%-8s %8s %10s %10s %10s %10s %8s\n", "task", "runs", "run_avg_us", "run_max_us",
+           "late_avg_us", "late_max_us", "overrun");
+    for (int i = 0; i < n; ++i) {
+        const Task *t = tasks[i];
+        printf("%-8s %8u %10.1f %10u %10.1f %10u %8u\n", t->name, t->runs,
+               t->runs ? (double)t->run_us_sum / t->runs : 0.0, t->run_us_max,
+               t->runs ? (double)t->late_us_sum / t->runs : 0.0, t->late_us_max, t->overruns);
+    }
 }
 
 // --------- 键 / 去抖 ---------
@@ -35,10 +295,10 @@ typedef struct {
 
 // 从标准输入读取按键事件：按下=‘p’，释放=‘r’。无输入则返回 false。
 static bool read_key_event(bool *level_out) {
-    // 非阻塞拉取：用 stdin 的行缓冲简单模拟
+    // 非阻塞拉取：调用方先用 host_stdin_ready 确认有数据；用 stdin 的行缓冲简单模拟
     // 建议你每隔若干 ms 敲 ‘p’/‘r’ 回车试试
     int c = fgetc(stdin);
-    if (c == EOF) return false;
+    if (c == EOF) { g_stdin_eof = true; return false; }
     if (c == 'p' || c == 'P') { *level_out = true;  return true; }
     if (c == 'r' || c == 'R') { *level_out = false; return true; }
     return false;
@@ -79,35 +339,84 @@ static void button_update(Button *b, bool input_level, uint32_t now_ms,
 }
 
 // --------- 软 PWM（占空比 0..100） ---------
+// SoftPWM 只记“主占空比”（亮度档 / 呼吸灯当前值），由灯效映射到 8 个通道（见 app_apply_fx）
 typedef struct {
     uint8_t duty;      // 目标占空比
-    uint8_t counter;   // 0..99 递增
 } SoftPWM;
 
-static void pwm_init(SoftPWM *p){ p->duty = 50; p->counter = 0; }
-// 每 1ms 调一次：counter 0..99 循环，返回当前应“点亮”的门限判定
-static bool pwm_tick_and_is_on(SoftPWM *p){
-    bool on = (p->counter < p->duty);
-    p->counter = (p->counter + 1) % 100;
-    return on;
+static void pwm_init(SoftPWM *p){ p->duty = 50; }
+
+// 8 通道 PWM 引擎：按各通道占空比预先算好一个周期 PWM_STEPS 个时隙的端口值
+// （table[s] 的第 ch 位 = 通道 ch 在第 s 个时隙是否点亮），每个 tick 只做一次查表 + 一次端口写。
+// 目标板上可以用定时器触发 DMA 循环把 table 搬到 GPIO 输出寄存器，CPU 完全不参与；
+// 占空比变了才标脏，下一个 tick 前重建一次表
+#define PWM_CH    8
+#define PWM_STEPS 100
+
+typedef struct {
+    uint8_t  duty[PWM_CH];       // 各通道占空比 0..100
+    uint8_t  table[PWM_STEPS];   // 一个 PWM 周期的端口值
+    uint8_t  phase;              // 下一个输出的时隙
+    bool     dirty;              // duty 改过，table 待重建
+    uint32_t rebuilds;           // 重建次数（统计）
+} PwmBank;
+
+static void pwm_bank_init(PwmBank *b){
+    for (int ch = 0; ch < PWM_CH; ++ch) b->duty[ch] = 0;
+    b->phase = 0; b->dirty = true; b->rebuilds = 0;
+}
+
+// 设置 mask 里各通道的占空比；和当前值一样的不标脏
+static void pwm_bank_set(PwmBank *b, uint8_t mask, uint8_t duty){
+    if (duty > PWM_STEPS) duty = PWM_STEPS;
+    for (int ch = 0; ch < PWM_CH; ++ch)
+        if ((mask >> ch & 1u) && b->duty[ch] != duty) { b->duty[ch] = duty; b->dirty = true; }
+}
+
+// 每个时隙先全亮（占空比非 0 的通道），再把各通道从 duty 起的时隙熄掉
+static void pwm_bank_rebuild(PwmBank *b){
+    uint8_t lit = 0;
+    for (int ch = 0; ch < PWM_CH; ++ch) if (b->duty[ch]) lit |= (uint8_t)(1u << ch);
+    for (int s = 0; s < PWM_STEPS; ++s) b->table[s] = lit;
+    for (int ch = 0; ch < PWM_CH; ++ch)
+        for (int s = b->duty[ch]; s < PWM_STEPS; ++s) b->table[s] &= (uint8_t)~(1u << ch);
+    b->dirty = false;
+    b->rebuilds++;
+}
+
+// 定时器 tick：当前时隙的端口值，并前进一格（回绕用比较，不取模）
+static uint8_t pwm_bank_tick(PwmBank *b){
+    if (b->dirty) pwm_bank_rebuild(b);
+    uint8_t v = b->table[b->phase];
+    if (++b->phase == PWM_STEPS) b->phase = 0;
+    return v;
 }
 
 // --------- 灯效状态机 ---------
 typedef enum { FX_STEADY=0, FX_BREATH, FX_CHASER } EffectMode;
 typedef struct {
     EffectMode mode;
-    uint32_t   last_ms;
     uint8_t    chaser_pos; // 0..7
     int        breath_dir; // +1 / -1
 } Effects;
 
-static void effects_init(Effects *e){ e->mode=FX_STEADY; e->last_ms=0; e->chaser_pos=0; e->breath_dir=+1; }
+#define FX_BREATH_MS 15
+#define FX_CHASER_MS 80
+
+static void effects_init(Effects *e){ e->mode=FX_STEADY; e->chaser_pos=0; e->breath_dir=+1; }
+
+// 各模式的更新周期（0 = 不需要更新，不登记定时器）
+static uint32_t effects_period_ms(EffectMode m){
+    return m == FX_BREATH ? FX_BREATH_MS : m == FX_CHASER ? FX_CHASER_MS : 0;
+}
 
 // TODO(2): 完成特效更新（非阻塞）
-// - FX_STEADY: 不变
+// 调度器按 effects_period_ms 的周期调用本函数，进来就是该走一步了（不用自己比较时间）
+// - FX_STEADY: 不变（不会被调用）
 // - FX_BREATH: 每 15ms 改变一次占空比 duty += breath_dir；到 0 或 100 反向
 // - FX_CHASER: 每 80ms chaser_pos = (pos+1)%8
 static void effects_update(Effects *e, SoftPWM *pwm, uint32_t now_ms){
+    (void)pwm; (void)now_ms;
     switch (e->mode){
     case FX_STEADY: break;
     case FX_BREATH:
@@ -120,25 +429,54 @@ static void effects_update(Effects *e, SoftPWM *pwm, uint32_t now_ms){
 }
 
 // --------- 协作式任务 ---------
-typedef struct {
+#define RENDER_MS 10
+
+typedef struct App {
     Button  btn;
     SoftPWM pwm;
+    PwmBank bank;           // 8 路 LED 的 PWM 表
     Effects fx;
     uint8_t brightness_idx; // 0..3  -> 25/50/75/100
+    Sched   sched;
+    Task    t_btn, t_fx, t_render;
 } App;
 
 static const uint8_t k_brightness_table[4] = {25, 50, 75, 100};
 
-static void app_init(App *a){
+static void task_buttons(App *a, uint32_t now_ms);
+static void task_effects(App *a, uint32_t now_ms);
+static void task_render_tick(App *a, uint32_t now_ms);
+static void app_set_mode(App *a, EffectMode m, uint32_t now_ms);
+
+static void app_init(App *a, uint32_t now_ms){
     a->btn = (Button){ .st=BTN_IDLE, .last_change_ms=0, .press_ms=0, .stable_level=false };
     pwm_init(&a->pwm);
+    pwm_bank_init(&a->bank);
     effects_init(&a->fx);
     a->brightness_idx = 1; // 50%
     a->pwm.duty = k_brightness_table[a->brightness_idx];
+
+    tw_init(&a->sched.wheel, now_ms);
+    a->sched.wakeups = 0;
+    task_init(&a->t_btn, "buttons", task_buttons);     // 有输入或到去抖/长按截止时刻才运行
+    task_init(&a->t_fx, "effects", task_effects);      // 周期随模式变
+    task_init(&a->t_render, "render", task_render_tick);
+    sched_every(&a->sched, &a->t_render, RENDER_MS, now_ms + RENDER_MS);
+    app_set_mode(a, a->fx.mode, now_ms);
 }
 
-// TODO(3): 按键处理任务（1ms 调用一次）
-// - 短按：切换模式 -> STEADY -> BREATH -> CHASER -> STEADY
+// 切换灯效模式，并按新模式重新登记特效任务（STEADY 不需要更新，撤掉定时器）
+static void app_set_mode(App *a, EffectMode m, uint32_t now_ms){
+    a->fx.mode = m;
+    uint32_t period = effects_period_ms(m);
+    if (period) sched_every(&a->sched, &a->t_fx, period, now_ms + period);
+    else        sched_cancel(&a->sched, &a->t_fx);
+}
+
+static void task_effects(App *a, uint32_t now_ms){ effects_update(&a->fx, &a->pwm, now_ms); }
+
+// TODO(3): 按键处理任务（有按键输入时，以及去抖/长按判定的截止时刻被调用）
+// - 短按：切换模式 -> STEADY -> BREATH -> CHASER -> STEADY（用 app_set_mode，特效任务随之改周期）
 // - 长按：切换亮度档 25/50/75/100（更新 pwm.duty）
 // - 使用 button_update 返回的 short_pressed/long_pressed
 static void task_buttons(App *a, uint32_t now_ms){
@@ -147,58 +485,68 @@ static void task_buttons(App *a, uint32_t now_ms){
 
     // 从 stdin 抓事件（可多次触发，最后一次为准）
     bool lvl;
-    if (read_key_event(&lvl)) raw_level = lvl;
+    while (host_stdin_ready())
+        if (read_key_event(&lvl)) raw_level = lvl;
 
     // TODO(3a): 调用 button_update，基于事件切换 a->fx.mode 和 a->brightness_idx / pwm.duty
-    (void)now_ms;
-}
+    (void)raw_level; (void)short_p; (void)long_p;
 
-// TODO(4): 渲染任务（每 10ms 调用一次即可）
-// - 计算当前 8 位 LED 显示：
-//   * STEADY/BREATH：全部位等于 pwm_on ? 1 : 0
-//   * CHASER：只有 chaser_pos 那一位等于 pwm_on，其它位为 0
-// - 打印一行 8 字符（1/0），不阻塞
-static void task_render(App *a){
-    bool on = pwm_tick_and_is_on(&a->pwm);
-    uint8_t port = 0;
+    // 去抖、长按要在某个时刻再看一眼：按状态登记截止时刻；空闲时不登记，等下一次输入唤醒
+    uint32_t due = 0;
+    if (a->btn.st == BTN_DEBOUNCE)     due = a->btn.last_change_ms + DEBOUNCE_MS;
+    else if (a->btn.st == BTN_PRESSED) due = a->btn.press_ms + LONG_MS;
+    if (due) sched_at(&a->sched, &a->t_btn, due > now_ms ? due : now_ms + 1);
+}
 
+// 灯效 -> 各通道占空比（值没变就不会触发重建）
+// - STEADY/BREATH：8 个通道都用主占空比
+// - CHASER：只有 chaser_pos 那一路用主占空比，其它路为 0
+static void app_apply_fx(App *a){
     switch (a->fx.mode){
     case FX_STEADY: case FX_BREATH:
-        // TODO(4a): port = on ? 0xFF : 0x00;
-        port = on ? 0xFF : 0x00;
+        pwm_bank_set(&a->bank, 0xFF, a->pwm.duty);
         break;
-    case FX_CHASER:
-        // TODO(4b): 设置第 fx.chaser_pos 位根据 on 决定亮灭
-        port = on ? (uint8_t)(1u << a->fx.chaser_pos) : 0u;
+    case FX_CHASER: {
+        uint8_t on = (uint8_t)(1u << a->fx.chaser_pos);
+        pwm_bank_set(&a->bank, on, a->pwm.duty);
+        pwm_bank_set(&a->bank, (uint8_t)~on, 0);
         break;
     }
+    }
+}
 
-    LED_PORT = port;
+// 渲染任务（每 10ms 一次）：同步占空比，查表写端口，打印一行 8 字符（1/0），不阻塞
+static void task_render(App *a){
+    app_apply_fx(a);
+    LED_PORT = pwm_bank_tick(&a->bank);
     // 打印
     for (int i=7;i>=0;--i) putchar( (LED_PORT>>i)&1 ? '1':'0');
     putchar('\n');
 }
 
-// 主循环：1ms tick，分频调任务
+static void task_render_tick(App *a, uint32_t now_ms){ (void)now_ms; task_render(a); }
+
+// 主循环（tickless）：睡到最近的到期时刻或有按键输入，醒来运行所有到期任务
 int main(void){
-    App app; app_init(&app);
-    uint32_t last_render = 0;
+    static App app;
+    app_init(&app, host_now_ms());
 
     // 关闭 stdin 缓冲（便于即刻读到 p/r）
     setbuf(stdin, NULL);
 
-    while (g_ms < 3600000) { // 最多跑一小时
-        systick_poll_once();
-
-        // 1ms 任务
-        task_buttons(&app, g_ms);
-        effects_update(&app.fx, &app.pwm, g_ms);
-
-        // 10ms 渲染
-        if (g_ms - last_render >= 10){
-            last_render = g_ms;
-            task_render(&app);
-        }
+    while (g_ms < RUN_MS) {
+        uint32_t due = tw_next_due(&app.sched.wheel);
+        if (due > RUN_MS) due = RUN_MS;
+        bool input = host_wait_until(due);
+        app.sched.wakeups++;
+        g_ms = host_now_ms();
+        // 有输入就马上跑按键任务（tw_add 会顶掉它登记的去抖/长按截止时刻，由它自己重新登记）；
+        // 等到截止时刻再读的话 stdin 一直可读，每轮都立刻醒来空转
+        if (input) sched_at(&app.sched, &app.t_btn, g_ms);
+        sched_run(&app.sched, &app, g_ms);
     }
+    const Task *tasks[] = { &app.t_btn, &app.t_fx, &app.t_render };
+    sched_report(&app.sched, tasks, ARRAY_LEN(tasks), g_ms);
+    printf("pwm: 表重建 %u 次\n", app.bank.rebuilds);
     return 0;
 }
@@ -2,91 +2,57 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-/// 配置：缓冲区容量（固定，不用 malloc）
+#include "../ringbuf/ringbuf_typed.h"
+
+/// 配置：缓冲区容量（固定，不用 malloc；定长环要求 2 的幂，下标用 & 代替 %）
 #define BUF_CAP 8
-typedef int buf_elem_t;   // 元素类型（先用 int，后面你可以改成 uint8_t 等）
+typedef int buf_elem_t;   // 元素类型（先用 int，后面你可以改成 uint8_t、结构体等）
 
 /// 返回码
 typedef enum { BUF_OK = 0, BUF_FULL = 1, BUF_EMPTY = 2 } BufStatus;
 
-/// 数据结构：head 写入位置，tail 读取位置，count 当前元素数
-typedef struct {
-    buf_elem_t data[BUF_CAP];
-    int head;   // 下一次写入的位置
-    int tail;   // 下一次读取的位置
-    int count;  // 当前已存元素个数
-} RingBuf;
-
-/// —— 工具函数 ——
-/// 把索引前进一步并在容量处回绕
-static inline int step(int i) { return (i + 1) % BUF_CAP; }
-
-/// 初始化
-void rb_init(RingBuf *rb) {
-    rb->head = rb->tail = rb->count = 0;
-    for (int i = 0; i < BUF_CAP; ++i) rb->data[i] = 0;
-}
-
-/// 判空/判满
-bool rb_is_empty(const RingBuf *rb) { return rb->count == 0; }
-bool rb_is_full (const RingBuf *rb) { return rb->count == BUF_CAP; }
+/// 数据结构：由 ringbuf_typed.h 生成 IntRing 类型和 int_ring_* 函数
+/// （head/tail 是自由增长的计数器，已存个数 = tail - head；与 ringbuf.h 的 RingBuf / rb_* 不重名）
+RB_TYPED_DEFINE(IntRing, int_ring, buf_elem_t, BUF_CAP)
 
 /// 存：入队（不覆盖旧数据，满则返回 BUF_FULL）
-BufStatus rb_push(RingBuf *rb, buf_elem_t v) {
-    if (rb_is_full(rb)) return BUF_FULL;
-    rb->data[rb->head] = v;
-    rb->head = step(rb->head);
-    rb->count++;
-    return BUF_OK;
+BufStatus buf_push(IntRing *rb, buf_elem_t v) {
+    return int_ring_push(rb, &v) ? BUF_OK : BUF_FULL;
 }
 
 /// 取：出队（读取最早写入的一个元素）
-BufStatus rb_pop(RingBuf *rb, buf_elem_t *out) {
-    if (rb_is_empty(rb)) return BUF_EMPTY;
-    if (out) *out = rb->data[rb->tail];
-    rb->tail = step(rb->tail);
-    rb->count--;
-    return BUF_OK;
+BufStatus buf_pop(IntRing *rb, buf_elem_t *out) {
+    return int_ring_pop(rb, out) ? BUF_OK : BUF_EMPTY;
 }
 
 /// 查看：窥视队头（不移除）
-BufStatus rb_peek(const RingBuf *rb, buf_elem_t *out) {
-    if (rb_is_empty(rb)) return BUF_EMPTY;
-    if (out) *out = rb->data[rb->tail];
+BufStatus buf_peek(IntRing *rb, buf_elem_t *out) {
+    const buf_elem_t *p = int_ring_front(rb);
+    if (!p) return BUF_EMPTY;
+    if (out) *out = *p;
     return BUF_OK;
 }
 
-/// 查看：按队内索引读取（0 表示队头，count-1 表示队尾），不移除
-/// 成功返回 1，失败返回 0
-int rb_at(const RingBuf *rb, int index, buf_elem_t *out) {
-    if (index < 0 || index >= rb->count) return 0;
-    int pos = (rb->tail + index) % BUF_CAP;
-    if (out) *out = rb->data[pos];
-    return 1;
-}
-
 /// 检索：查找第一个等于 v 的元素，返回相对队头的索引，找不到返回 -1
-int rb_find_first(const RingBuf *rb, buf_elem_t v) {
-    for (int i = 0; i < rb->count; ++i) {
-        int pos = (rb->tail + i) % BUF_CAP;
-        if (rb->data[pos] == v) return i;
-    }
+int buf_find_first(IntRing *rb, buf_elem_t v) {
+    const buf_elem_t *p;
+    for (size_t i = 0; (p = int_ring_at(rb, i)) != NULL; ++i)
+        if (*p == v) return (int)i;
     return -1;
 }
 
 /// 打印当前内容（从队头到队尾）
-void rb_dump(const RingBuf *rb) {
-    printf("RB{count=%d, cap=%d} [ ", rb->count, BUF_CAP);
-    for (int i = 0; i < rb->count; ++i) {
-        int pos = (rb->tail + i) % BUF_CAP;
-        printf("%d ", rb->data[pos]);
-    }
+void buf_dump(IntRing *rb) {
+    printf("RB{count=%zu, cap=%zu} [ ", int_ring_size(rb), int_ring_capacity());
+    const buf_elem_t *p;
+    for (size_t i = 0; (p = int_ring_at(rb, i)) != NULL; ++i)
+        printf("%d ", *p);
     printf("]\n");
 }
 
 /// 一个简单的交互式测试：a(添加), g(取出), p(查看队头), f(查找), d(打印), q(退出)
 int main(void) {
-    RingBuf rb; rb_init(&rb);
+    IntRing rb; int_ring_init(&rb);
     printf("Commands: a <num>=push, g=pop, p=peek, f <num>=find, d=dump, q=quit\n");
 
     char cmd;
@@ -98,29 +64,29 @@ int main(void) {
         if (cmd == 'a') {                   // push
             buf_elem_t v;
             if (scanf("%d", &v) == 1) {
-                BufStatus s = rb_push(&rb, v);
+                BufStatus s = buf_push(&rb, v);
                 if (s == BUF_OK)   printf("push OK\n");
                 else               printf("push FAIL (FULL)\n");
             }
         } else if (cmd == 'g') {            // pop
             buf_elem_t v;
-            BufStatus s = rb_pop(&rb, &v);
+            BufStatus s = buf_pop(&rb, &v);
             if (s == BUF_OK)   printf("pop -> %d\n", v);
             else               printf("pop FAIL (EMPTY)\n");
         } else if (cmd == 'p') {            // peek
             buf_elem_t v;
-            BufStatus s = rb_peek(&rb, &v);
+            BufStatus s = buf_peek(&rb, &v);
             if (s == BUF_OK)   printf("peek = %d\n", v);
             else               printf("peek FAIL (EMPTY)\n");
         } else if (cmd == 'f') {            // find
             buf_elem_t v;
             if (scanf("%d", &v) == 1) {
-                int idx = rb_find_first(&rb, v);
+                int idx = buf_find_first(&rb, v);
                 if (idx >= 0) printf("found at index %d (0=head)\n", idx);
                 else          printf("not found\n");
             }
         } else if (cmd == 'd') {            // dump
-            rb_dump(&rb);
+            buf_dump(&rb);
         } else if (cmd == 'q') {
             break;
         } else {
@@ -0,0 +1,214 @@
+// bench_search.c — rb_search 新旧实现对比（噪声串口流 / 抓包文件）
+// 编译：gcc -O2 bench_search.c ringbuf.c ringbuf_find.c ringbuf_vm.c hex_codec.c -o bench_search
+// 用法：bench_search [抓包文件] [轮数]
+//   不给文件时生成 8 MiB 合成流：随机噪声中夹杂 AA 55 | LEN | PAYLOAD | CHK 帧
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuf.h"
+
+#define RB_CAP (64 * 1024) // 与 serial_port 的 g_rb 一致
+#define SYNTH_BYTES (8u * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* 旧实现（逐字节 rb_at + 取模），用作对照 */
+static bool old_search(const RingBuf *rb, const void *pattern, size_t m, size_t *out_index)
+{
+    if (!rb || !rb->data || !pattern)
+        return false;
+    if (m == 0)
+    {
+        if (out_index)
+            *out_index = 0;
+        return true;
+    }
+    if (m > rb->size)
+        return false;
+    const uint8_t *pat = (const uint8_t *)pattern;
+    size_t limit = rb->size - m;
+    for (size_t pos = 0; pos <= limit; ++pos)
+    {
+        size_t k = 0;
+        while (k < m && rb->data[(rb->head + pos + k) % rb->cap] == pat[k])
+            ++k;
+        if (k == m)
+        {
+            if (out_index)
+                *out_index = pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef bool (*SearchFn)(const RingBuf *, const void *, size_t, size_t *);
+
+// 合成噪声流：约 1/4 的字节属于帧，其余是随机噪声（噪声里本身也会出现 AA）
+static uint8_t *make_stream(size_t n)
+{
+    uint8_t *p = (uint8_t *)malloc(n);
+    if (!p)
+        return NULL;
+    uint32_t x = 2463534242u;
+    size_t i = 0;
+    while (i < n)
+    {
+        x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+        size_t noise = x % 600;
+        for (size_t k = 0; k < noise && i < n; ++k)
+        {
+            x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+            p[i++] = (uint8_t)x;
+        }
+        uint8_t len = (uint8_t)(x >> 8);
+        if (i + 4u + len > n)
+            break;
+        p[i++] = 0xAA;
+        p[i++] = 0x55;
+        p[i++] = len;
+        unsigned chk = len;
+        for (unsigned k = 0; k < len; ++k)
+        {
+            p[i] = (uint8_t)(k * 31u + len);
+            chk += p[i++];
+        }
+        p[i++] = (uint8_t)chk;
+    }
+    while (i < n)
+        p[i++] = 0;
+    return p;
+}
+
+static uint8_t *load_file(const char *path, size_t *out_n)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (sz <= 0)
+    {
+        fclose(f);
+        return NULL;
+    }
+    uint8_t *p = (uint8_t *)malloc((size_t)sz);
+    if (p && fread(p, 1, (size_t)sz, f) != (size_t)sz)
+    {
+        free(p);
+        p = NULL;
+    }
+    fclose(f);
+    *out_n = (size_t)sz;
+    return p;
+}
+
+/*
+ * 模拟 try_pop_one_frame 的找头过程：环里灌满数据，从 head 反复检索模式，
+ * 命中就消费到命中点之后，找不到就清空；返回扫描过的字节数（用于算吞吐）
+ */
+static size_t hunt(RingBuf *rb, SearchFn fn, const uint8_t *stream, size_t n,
+                   const uint8_t *pat, size_t m, size_t *hits)
+{
+    size_t fed = 0, scanned = 0;
+    rb_clear(rb);
+    // 先推进一半容量，让数据跨越数组末尾（走“两段”路径）
+    uint8_t pad[RB_CAP / 2];
+    memset(pad, 0, sizeof(pad));
+    rb_push(rb, pad, sizeof(pad));
+    rb_pop(rb, pad, sizeof(pad));
+    while (fed < n)
+    {
+        fed += rb_push(rb, stream + fed, n - fed);
+        size_t idx = 0;
+        while (fn(rb, pat, m, &idx))
+        {
+            ++*hits;
+            scanned += idx + m;
+            rb_read_consume(rb, idx + 1);
+        }
+        scanned += rb_size(rb);
+        rb_clear(rb);
+    }
+    return scanned;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = SYNTH_BYTES;
+    uint8_t *stream = NULL;
+    const char *src = "synthetic";
+    if (argc > 1)
+    {
+        stream = load_file(argv[1], &n);
+        src = argv[1];
+        if (!stream)
+        {
+            fprintf(stderr, "无法读取 %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else
+        stream = make_stream(n);
+    int rounds = (argc > 2) ? atoi(argv[2]) : 3;
+    if (!stream || rounds <= 0)
+    {
+        fprintf(stderr, "内存不足或参数错误。\n");
+        return 1;
+    }
+
+    RingBuf rb;
+    if (!rb_init(&rb, RB_CAP))
+    {
+        fprintf(stderr, "ring buffer init failed\n");
+        return 1;
+    }
+
+    // AA 55 帧头（频繁命中），以及几种长度的不命中模式（整段扫描）
+    struct
+    {
+        const char *name;
+        uint8_t pat[64];
+        size_t m;
+    } cases[] = {
+        {"hdr AA55", {0xAA, 0x55}, 2},
+        {"4B miss", {0xDE, 0xAD, 0xBE, 0xEF}, 4},
+        {"16B miss", {0}, 16},
+        {"64B miss", {0}, 64},
+    };
+    for (size_t k = 0; k < 64; ++k)
+        cases[2].pat[k] = cases[3].pat[k] = (uint8_t)(0xF0 ^ k);
+
+    printf("source=%s bytes=%zu rounds=%d cap=%d\n", src, n, rounds, RB_CAP);
+    printf("%-10s %12s %12s %9s %8s\n", "pattern", "old MB/s", "new MB/s", "speedup", "hits");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c)
+    {
+        double mbps[2] = {0, 0};
+        size_t hits[2] = {0, 0};
+        SearchFn fns[2] = {old_search, rb_search};
+        for (int v = 0; v < 2; ++v)
+        {
+            size_t scanned = 0;
+            double t0 = now_sec();
+            for (int r = 0; r < rounds; ++r)
+                scanned += hunt(&rb, fns[v], stream, n, cases[c].pat, cases[c].m, &hits[v]);
+            double dt = now_sec() - t0;
+            mbps[v] = dt > 0 ? (double)scanned / dt / 1e6 : 0;
+        }
+        printf("%-10s %12.1f %12.1f %8.1fx %8zu%s\n", cases[c].name, mbps[0], mbps[1],
+               mbps[0] > 0 ? mbps[1] / mbps[0] : 0, hits[1] / (size_t)rounds,
+               hits[0] == hits[1] ? "" : "  (MISMATCH!)");
+    }
+
+    rb_free(&rb);
+    free(stream);
+    return 0;
+}
@@ -0,0 +1,311 @@
+#include "hex_codec.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define HEX_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HEX_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/* 解码表：半字节值 + 1；HX_SP 为空白；0 为非法字符 */
+#define HX_SP 0x80
+static const uint8_t hx_unhex[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,  ['5'] = 6,  ['6'] = 7,  ['7'] = 8,
+    ['8'] = 9,  ['9'] = 10, ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    [' '] = HX_SP, ['\t'] = HX_SP, ['\r'] = HX_SP, ['\n'] = HX_SP, ['\v'] = HX_SP, ['\f'] = HX_SP,
+};
+static const char hx_digits[17] = "0123456789ABCDEF";
+
+/* 解码时整段 SIMD 没对上，至少标量走这么多字符再试（避免格式不规整时每个字符都白试一次） */
+#define HX_RETRY 16
+
+#if defined(HEX_SSE2)
+/* ---------------- SSE2 / SSSE3 ---------------- */
+#if defined(__GNUC__) || defined(__clang__)
+#define HX_SSSE3_FN __attribute__((target("ssse3")))
+static int hx_has_ssse3(void) { return __builtin_cpu_supports("ssse3"); }
+#else
+#define HX_SSSE3_FN
+static int hx_has_ssse3(void) {
+    static volatile int cached = -1; /* 并发首次调用只会写入同一个值 */
+    if (cached < 0) {
+        int r[4];
+        __cpuid(r, 1);
+        cached = (r[2] >> 9) & 1;
+    }
+    return cached;
+}
+#endif
+
+/* 16 个半字节（0~15） -> '0'~'9' 'A'~'F'：加 '0'，大于 9 的再加 7 */
+static inline __m128i hx_nib2chr(__m128i n) {
+    __m128i gt9 = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), _mm_and_si128(gt9, _mm_set1_epi8(7)));
+}
+
+/* 16 字节 -> 高/低半字节的字符 */
+static inline void hx_split(__m128i v, __m128i *hi, __m128i *lo) {
+    const __m128i m = _mm_set1_epi8(0x0F);
+    *hi = hx_nib2chr(_mm_and_si128(_mm_srli_epi16(v, 4), m));
+    *lo = hx_nib2chr(_mm_and_si128(v, m));
+}
+
+/* 16 个字符 -> 半字节；*ok 中 0xFF 表示该字符是十六进制数字 */
+static inline __m128i hx_chr2nib(__m128i c, __m128i *ok) {
+    __m128i lw  = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i dig = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i let = _mm_and_si128(_mm_cmpgt_epi8(lw, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lw, _mm_set1_epi8('f' + 1)));
+    *ok = _mm_or_si128(dig, let);
+    return _mm_or_si128(_mm_and_si128(dig, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                        _mm_and_si128(let, _mm_sub_epi8(lw, _mm_set1_epi8('a' - 10))));
+}
+
+static size_t hx_enc_simd(char *d, const uint8_t *s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, d += 32) {
+        __m128i hi, lo;
+        hx_split(_mm_loadu_si128((const __m128i*)(s + i)), &hi, &lo);
+        _mm_storeu_si128((__m128i*)d, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(d + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+/* "XX " 交织：输出第 p 个字符取 hi[p/3] / lo[p/3] / ' '（p%3 = 0/1/2），按 16 字节一块用 pshufb 搬 */
+HX_SSSE3_FN static size_t hx_enc_spaced_ssse3(char *d, const uint8_t *s, size_t n) {
+    static const uint8_t mk[3][3][16] = {
+        {{0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05},
+         {0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80},
+         {0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00}},
+        {{0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80},
+         {0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A},
+         {0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00}},
+        {{0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80},
+         {0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80},
+         {0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20}},
+    };
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, d += 48) {
+        __m128i hi, lo;
+        hx_split(_mm_loadu_si128((const __m128i*)(s + i)), &hi, &lo);
+        for (int j = 0; j < 3; ++j) {
+            __m128i o = _mm_or_si128(_mm_shuffle_epi8(hi, _mm_loadu_si128((const __m128i*)mk[j][0])),
+                                     _mm_shuffle_epi8(lo, _mm_loadu_si128((const __m128i*)mk[j][1])));
+            _mm_storeu_si128((__m128i*)(d + 16 * j), _mm_or_si128(o, _mm_loadu_si128((const __m128i*)mk[j][2])));
+        }
+    }
+    return i;
+}
+
+static size_t hx_enc_spaced_simd(char *d, const uint8_t *s, size_t n) {
+    return hx_has_ssse3() ? hx_enc_spaced_ssse3(d, s, n) : 0;
+}
+
+/* 32 个连续十六进制字符 -> 16 字节；不是整段返回 0 */
+static int hx_dec_run32(uint8_t *d, const char *s) {
+    __m128i ok0, ok1;
+    __m128i v0 = hx_chr2nib(_mm_loadu_si128((const __m128i*)s), &ok0);
+    __m128i v1 = hx_chr2nib(_mm_loadu_si128((const __m128i*)(s + 16)), &ok1);
+    if (_mm_movemask_epi8(_mm_and_si128(ok0, ok1)) != 0xFFFF) return 0;
+    /* 每个 16 位里低字节是高半字节、高字节是低半字节 */
+    const __m128i lo8 = _mm_set1_epi16(0x00FF);
+    __m128i w0 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v0, lo8), 4), _mm_srli_epi16(v0, 8));
+    __m128i w1 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v1, lo8), 4), _mm_srli_epi16(v1, 8));
+    _mm_storeu_si128((__m128i*)d, _mm_packus_epi16(w0, w1));
+    return 1;
+}
+
+/* 48 个字符的 "XX XX ... XX " -> 16 字节：三块各用 pshufb 收拢高位字符/低位字符/分隔符 */
+HX_SSSE3_FN static int hx_dec_spaced48_ssse3(uint8_t *d, const char *s) {
+    static const uint8_t mk[3][3][16] = {
+        {{0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D}},
+        {{0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E}},
+        {{0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+         {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F}},
+    };
+    __m128i blk[3], f[3];
+    for (int j = 0; j < 3; ++j) blk[j] = _mm_loadu_si128((const __m128i*)(s + 16 * j));
+    for (int r = 0; r < 3; ++r) {
+        f[r] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(blk[0], _mm_loadu_si128((const __m128i*)mk[r][0])),
+                                         _mm_shuffle_epi8(blk[1], _mm_loadu_si128((const __m128i*)mk[r][1]))),
+                            _mm_shuffle_epi8(blk[2], _mm_loadu_si128((const __m128i*)mk[r][2])));
+    }
+    __m128i okh, okl;
+    __m128i h = hx_chr2nib(f[0], &okh), l = hx_chr2nib(f[1], &okl);
+    __m128i sp = _mm_cmpeq_epi8(f[2], _mm_set1_epi8(' '));
+    if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(okh, okl), sp)) != 0xFFFF) return 0;
+    _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_slli_epi16(h, 4), l)); /* 半字节左移 4 不会越过字节 */
+    return 1;
+}
+
+static int hx_dec_spaced48(uint8_t *d, const char *s, int ssse3) {
+    return ssse3 ? hx_dec_spaced48_ssse3(d, s) : 0;
+}
+#define HX_DEC_SIMD 1
+#define HX_SPACED_OK() hx_has_ssse3()
+
+#elif defined(HEX_NEON)
+/* ---------------- AArch64 NEON：vld2/vld3、vst2/vst3 直接交织/拆分 ---------------- */
+static inline uint8x16_t hx_nib2chr(uint8x16_t n) {
+    uint8x16_t gt9 = vcgtq_u8(n, vdupq_n_u8(9));
+    return vaddq_u8(vaddq_u8(n, vdupq_n_u8('0')), vandq_u8(gt9, vdupq_n_u8(7)));
+}
+
+/* 字符 -> 半字节：减去基准后按无符号比较落在 [0, 9] / [0, 5] 即是数字/字母 */
+static inline uint8x16_t hx_chr2nib(uint8x16_t c, uint8x16_t *ok) {
+    uint8x16_t dv  = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t lv  = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t dig = vcleq_u8(dv, vdupq_n_u8(9));
+    uint8x16_t let = vcleq_u8(lv, vdupq_n_u8(5));
+    *ok = vorrq_u8(dig, let);
+    return vbslq_u8(dig, dv, vaddq_u8(lv, vdupq_n_u8(10)));
+}
+
+static size_t hx_enc_simd(char *d, const uint8_t *s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, d += 32) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16x2_t o;
+        o.val[0] = hx_nib2chr(vshrq_n_u8(v, 4));
+        o.val[1] = hx_nib2chr(vandq_u8(v, vdupq_n_u8(0x0F)));
+        vst2q_u8((uint8_t*)d, o);
+    }
+    return i;
+}
+
+static size_t hx_enc_spaced_simd(char *d, const uint8_t *s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, d += 48) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16x3_t o;
+        o.val[0] = hx_nib2chr(vshrq_n_u8(v, 4));
+        o.val[1] = hx_nib2chr(vandq_u8(v, vdupq_n_u8(0x0F)));
+        o.val[2] = vdupq_n_u8(' ');
+        vst3q_u8((uint8_t*)d, o);
+    }
+    return i;
+}
+
+static int hx_dec_run32(uint8_t *d, const char *s) {
+    uint8x16x2_t c = vld2q_u8((const uint8_t*)s);
+    uint8x16_t okh, okl;
+    uint8x16_t h = hx_chr2nib(c.val[0], &okh), l = hx_chr2nib(c.val[1], &okl);
+    if (vminvq_u8(vandq_u8(okh, okl)) != 0xFF) return 0;
+    vst1q_u8(d, vorrq_u8(vshlq_n_u8(h, 4), l));
+    return 1;
+}
+
+static int hx_dec_spaced48(uint8_t *d, const char *s, int unused) {
+    (void)unused;
+    uint8x16x3_t c = vld3q_u8((const uint8_t*)s);
+    uint8x16_t okh, okl;
+    uint8x16_t h = hx_chr2nib(c.val[0], &okh), l = hx_chr2nib(c.val[1], &okl);
+    uint8x16_t sp = vceqq_u8(c.val[2], vdupq_n_u8(' '));
+    if (vminvq_u8(vandq_u8(vandq_u8(okh, okl), sp)) != 0xFF) return 0;
+    vst1q_u8(d, vorrq_u8(vshlq_n_u8(h, 4), l));
+    return 1;
+}
+#define HX_DEC_SIMD 1
+#define HX_SPACED_OK() 1
+
+#else
+static size_t hx_enc_simd(char *d, const uint8_t *s, size_t n) { (void)d; (void)s; (void)n; return 0; }
+static size_t hx_enc_spaced_simd(char *d, const uint8_t *s, size_t n) { (void)d; (void)s; (void)n; return 0; }
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+size_t hex_encode(char *dst, const void *src, size_t n) {
+    const uint8_t *s = (const uint8_t*)src;
+    size_t i = hx_enc_simd(dst, s, n);
+    for (char *d = dst + 2 * i; i < n; ++i) {
+        *d++ = hx_digits[s[i] >> 4];
+        *d++ = hx_digits[s[i] & 15];
+    }
+    return 2 * n;
+}
+
+size_t hex_encode_spaced(char *dst, const void *src, size_t n) {
+    const uint8_t *s = (const uint8_t*)src;
+    size_t i = hx_enc_spaced_simd(dst, s, n);
+    for (char *d = dst + 3 * i; i < n; ++i) {
+        *d++ = hx_digits[s[i] >> 4];
+        *d++ = hx_digits[s[i] & 15];
+        *d++ = ' ';
+    }
+    return 3 * n;
+}
+
+size_t hex_decode(void *dst, const char *src, size_t len, size_t *err_pos) {
+    uint8_t *d = (uint8_t*)dst;
+    const unsigned char *s = (const unsigned char*)src;
+    size_t n = 0, i = 0;
+    unsigned acc = 0;
+    int half = 0;
+#if defined(HX_DEC_SIMD)
+    size_t simd_at = 0;
+    int spaced = HX_SPACED_OK();
+#endif
+    while (i < len) {
+#if defined(HX_DEC_SIMD)
+        /* 字节边界上才走整段：32 个连续数字，或 "XX " x16（都不可能含 0x 前缀） */
+        if (!half && i >= simd_at) {
+            if (len - i >= 32 && hx_dec_run32(d + n, src + i)) { n += 16; i += 32; continue; }
+            if (len - i >= 48 && hx_dec_spaced48(d + n, src + i, spaced)) { n += 16; i += 48; continue; }
+            simd_at = i + HX_RETRY;
+        }
+#endif
+        unsigned v = hx_unhex[s[i]];
+        if (v == HX_SP) { ++i; continue; }
+        if (v == 0) {
+            if (err_pos) *err_pos = i;
+            return 0;
+        }
+        /* 一组数字开头的 0x / 0X 前缀 */
+        if (v == 1 && i + 2 < len && (s[i + 1] | 0x20) == 'x' && hx_unhex[s[i + 2]] != 0 &&
+            hx_unhex[s[i + 2]] != HX_SP && (i == 0 || hx_unhex[s[i - 1]] == HX_SP)) {
+            i += 2;
+            continue;
+        }
+        --v;
+        if (half) d[n++] = (uint8_t)(acc << 4 | v);
+        else acc = v;
+        half = !half;
+        ++i;
+    }
+    if (half) {
+        /* 奇数个半字节：整体右移半字节，相当于最前面补一个 0 */
+        unsigned carry = 0;
+        for (size_t k = 0; k < n; ++k) {
+            unsigned b = d[k];
+            d[k] = (uint8_t)(carry << 4 | b >> 4);
+            carry = b & 15;
+        }
+        d[n++] = (uint8_t)(carry << 4 | acc);
+    }
+    if (n == 0 && err_pos) *err_pos = len;
+    return n;
+}
+
+const char *hex_codec_impl(void) {
+#if defined(HEX_SSE2)
+    return hx_has_ssse3() ? "ssse3" : "sse2";
+#elif defined(HEX_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef HEX_CODEC_H
+#define HEX_CODEC_H
+
+/*
+ * 十六进制编解码（ringbuf 工具与串口终端共用：dump、pushx/txx、实时 HEX 显示）。
+ * 全部写进调用方给的缓冲区，不分配内存，不走 printf。
+ *
+ * 实现：
+ * - 编码：x86 SSE2 一次 16 字节（半字节 -> 字符用比较 + 加法，不查表）；
+ *         "XX " 带空格格式要跨步交织，用 SSSE3 pshufb（运行时检测 CPU）；
+ *         AArch64 NEON 用 vst2q/vst3q 直接交织写出；其余情况查 256 项表
+ * - 解码：标量查表一遍扫描；遇到 32 个连续十六进制字符或 48 个字符的 "XX XX ..." 整段时
+ *         整段用 SIMD 分类 + 拼字节（SSE2 / SSSE3 / NEON），不是整段就继续标量
+ * - 解码容忍空白（空格、\t、\r、\n 等）与写在一组数字开头的 0x/0X 前缀；
+ *   半字节总数为奇数时整体前补 0（"1 23" -> 01 23），与原先 parse_hex_bytes 一致
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEX_ENCODE_LEN(n)  ((n) * 2)      /* hex_encode 写出的字符数 */
+#define HEX_SPACED_LEN(n)  ((n) * 3)      /* hex_encode_spaced 写出的字符数 */
+#define HEX_DECODE_MAX(len) ((len) / 2 + 1) /* hex_decode 输出缓冲至少这么大 */
+
+/**
+ * @brief 编码为连续的大写十六进制："DEADBEEF"（不写结尾 '\0'）
+ * @return 写出的字符数（2n）
+ */
+size_t hex_encode(char *dst, const void *src, size_t n);
+
+/**
+ * @brief 编码为每字节 "XX "（与 printf("%02X ") 逐字节输出相同，不写结尾 '\0'）
+ * @return 写出的字符数（3n）
+ */
+size_t hex_encode_spaced(char *dst, const void *src, size_t n);
+
+/**
+ * @brief 解码十六进制文本 src[0..len)（不要求 '\0' 结尾）
+ * @param dst     输出，至少 HEX_DECODE_MAX(len) 字节
+ * @param err_pos 可为 NULL；失败时写入第一个非法字符的下标（没有半字节时写 len）
+ * @return 字节数；有非法字符或一个半字节也没有返回 0
+ */
+size_t hex_decode(void *dst, const char *src, size_t len, size_t *err_pos);
+
+/**
+ * @brief 当前使用的实现："ssse3" / "sse2" / "neon" / "scalar"（基准与诊断输出用）
+ */
+const char *hex_codec_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HEX_CODEC_H */
@@ -1,15 +1,36 @@
-// main.c — 交互式 + 可视化 + 彩色指针 + bench，容量固定 32 字节
+// main.c — 交互式 + 可视化 + 彩色指针 + bench；也可非交互批处理，回放/校验脚本
+//
+// 用法：rb [-c 容量] [-m mod|pow2|mirror] [-b] [-k] [脚本文件|-]
+//   -c N   容量（字节，可带 k/m/g 后缀，默认 32）
+//   -m     后端：取模（默认）/ 2 的幂 / 镜像映射
+//   -b     批处理：不打提示符、不自动可视化，修改类命令不打印状态行；给了脚本文件时自动进入
+//   -k     批处理里命令失败（用法错误、expect 不符）后继续执行（默认停在第一个失败）
+// 批处理的汇总（行数、失败数、耗时、吞吐）打到 stderr，失败时退出码为 1
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <time.h>
 
 #include "ringbuf.h"
+#include "hex_codec.h"
 
-#define LINE_MAX_LEN 4096
-#define FIXED_CAP 32 // 硬限制容量
+#define DEFAULT_CAP 32   // 不带 -c 时的容量（交互演示）
+#define VIZ_CELLS 32     // 可视化最多画这么多格
+#define RB_STR_(x) #x
+#define RB_STR(x) RB_STR_(x)
+#define LINE_INIT_CAP 4096
+
+enum
+{
+    MODE_MOD,
+    MODE_POW2,
+    MODE_MIRROR
+};
 
 /*---------------------- 终端颜色支持（Windows 终端开启 ANSI） ----------------------*/
 #if defined(_WIN32)
@@ -35,32 +56,96 @@ static void enable_ansi(void) {}
 #define C_TAIL "\x1b[36;1m" // 亮青：tail
 #define C_HT "\x1b[35;1m"   // 亮紫：head==tail
 
-/*---------------------- 小工具 ----------------------*/
+/*---------------------- 运行状态 ----------------------*/
+static bool g_batch;          // 批处理模式
+static size_t g_lineno;       // 当前脚本行号（批处理报错用）
+static unsigned long g_fail;  // 失败的命令数
+static size_t g_pushed, g_popped;
 
-// 去掉行尾 \r\n
-static void chomp(char *s)
+// 修改类命令的状态行：批处理时不打印
+static void note(const char *fmt, ...)
 {
-    if (!s)
+    if (g_batch)
         return;
-    size_t n = strlen(s);
-    while (n && (s[n - 1] == '\n' || s[n - 1] == '\r'))
-        s[--n] = '\0';
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
 }
 
-static int is_hex(char c) { return isxdigit((unsigned char)c) ? 1 : 0; }
-
-static unsigned char hexpair_to_byte(char hi, char lo)
+// 命令失败（用法错误、解析失败、expect 不符）：计数；批处理时带行号打到 stderr
+static void fail(const char *fmt, ...)
 {
-    unsigned v = 0;
-    if (hi >= '0' && hi <= '9')
-        v = (hi - '0') << 4;
-    else
-        v = ((unsigned)(toupper(hi) - 'A') + 10) << 4;
-    if (lo >= '0' && lo <= '9')
-        v |= (lo - '0');
+    va_list ap;
+    va_start(ap, fmt);
+    g_fail++;
+    if (g_batch)
+    {
+        fprintf(stderr, "第 %zu 行：", g_lineno);
+        vfprintf(stderr, fmt, ap);
+    }
     else
-        v |= (unsigned)(toupper(lo) - 'A') + 10;
-    return (unsigned char)v;
+        vprintf(fmt, ap);
+    va_end(ap);
+}
+
+// 复用的临时缓冲（批处理里每条命令都 malloc/free 太慢）
+static unsigned char *scratch(size_t n)
+{
+    static unsigned char *buf;
+    static size_t cap;
+    if (n > cap)
+    {
+        size_t c = cap ? cap : 4096;
+        while (c < n)
+            c *= 2;
+        unsigned char *p = (unsigned char *)realloc(buf, c);
+        if (!p)
+            return NULL;
+        buf = p;
+        cap = c;
+    }
+    return buf;
+}
+
+/*---------------------- 小工具 ----------------------*/
+
+// 读一整行（不限长度，按需扩容），*len 为去掉行尾 \r\n 后的长度；EOF 且什么也没读到返回 NULL
+static char *read_line(FILE *in, char **buf, size_t *cap, size_t *len)
+{
+    size_t n = 0;
+    if (!*buf)
+    {
+        *buf = (char *)malloc(LINE_INIT_CAP);
+        if (!*buf)
+            return NULL;
+        *cap = LINE_INIT_CAP;
+    }
+    for (;;)
+    {
+        if (*cap - n < 2)
+        {
+            char *p = (char *)realloc(*buf, *cap * 2);
+            if (!p)
+                return NULL;
+            *buf = p;
+            *cap *= 2;
+        }
+        size_t room = *cap - n;
+        if (room > INT_MAX)
+            room = INT_MAX;
+        if (!fgets(*buf + n, (int)room, in))
+            break;
+        n += strlen(*buf + n);
+        if (n && (*buf)[n - 1] == '\n')
+            break;
+    }
+    if (n == 0)
+        return NULL;
+    while (n && ((*buf)[n - 1] == '\n' || (*buf)[n - 1] == '\r'))
+        (*buf)[--n] = '\0';
+    *len = n;
+    return *buf;
 }
 
 // 简易不区分大小写比较：相等返回 1
@@ -78,57 +163,68 @@ static int ieq(const char *a, const char *b)
     return *a == '\0' && *b == '\0';
 }
 
-// 解析十六进制输入：支持空格与 0x 前缀；奇数个半字节自动前补 0
-static size_t parse_hex_bytes(const char *line, unsigned char **out)
+// 解码到临时缓冲；失败返回 0
+static size_t parse_hex_bytes(const char *s, size_t len, unsigned char **out)
 {
-    if (!line || !out)
-        return 0;
-    *out = NULL;
-    char buf[LINE_MAX_LEN];
-    size_t j = 0;
-    for (size_t i = 0; line[i] && j + 1 < sizeof(buf); ++i)
-    {
-        unsigned char c = (unsigned char)line[i];
-        if (isspace(c))
-            continue;
-        if (c == '0' && (line[i + 1] == 'x' || line[i + 1] == 'X') && is_hex(line[i + 2]))
-        {
-            i += 1;
-            continue;
-        }
-        buf[j++] = (char)c;
-    }
-    buf[j] = '\0';
-    size_t hexcnt = 0;
-    for (size_t i = 0; i < j; ++i)
+    *out = scratch(HEX_DECODE_MAX(len));
+    return *out ? hex_decode(*out, s, len, NULL) : 0;
+}
+
+// 解析容量：十进制/0x 前缀，可带 k/m/g 后缀（1024 进制）
+static bool parse_size(const char *s, size_t *out)
+{
+    char *end = NULL;
+    unsigned long long v = strtoull(s, &end, 0);
+    if (end == s)
+        return false;
+    switch (tolower((unsigned char)*end))
     {
-        if (!is_hex(buf[i]))
-            return 0;
-        hexcnt++;
+    case 'g':
+        v <<= 10; /* fallthrough */
+    case 'm':
+        v <<= 10; /* fallthrough */
+    case 'k':
+        v <<= 10;
+        ++end;
+        break;
     }
-    if (hexcnt == 0)
-        return 0;
+    if (*end && !isspace((unsigned char)*end))
+        return false;
+    *out = (size_t)v;
+    return v > 0 && (unsigned long long)*out == v;
+}
 
-    int odd = (hexcnt % 2) ? 1 : 0;
-    size_t bytes = (hexcnt + odd) / 2;
-    unsigned char *mem = (unsigned char *)malloc(bytes);
-    if (!mem)
-        return 0;
+static bool parse_mode(const char *s, int *mode)
+{
+    if (ieq(s, "mod"))
+        *mode = MODE_MOD;
+    else if (ieq(s, "pow2"))
+        *mode = MODE_POW2;
+    else if (ieq(s, "mirror"))
+        *mode = MODE_MIRROR;
+    else
+        return false;
+    return true;
+}
 
-    size_t bi = 0, i = 0;
-    if (odd)
-        mem[bi++] = hexpair_to_byte('0', buf[i++]);
-    while (i + 1 < j)
-        mem[bi++] = hexpair_to_byte(buf[i], buf[i + 1]), i += 2;
-    *out = mem;
-    return bytes;
+static bool ring_open(RingBuf *rb, size_t cap, int mode)
+{
+    if (mode == MODE_MIRROR)
+        return rb_init_mirror(rb, cap);
+    return mode == MODE_POW2 ? rb_init_pow2(rb, cap) : rb_init(rb, cap);
 }
 
+static const char *mode_name(const RingBuf *rb) { return rb->mirror ? "mirror" : rb->mask ? "pow2" : "mod"; }
+
 static void print_bytes_line(const unsigned char *p, size_t n)
 {
+    char txt[HEX_SPACED_LEN(256)];
     printf("HEX  : ");
-    for (size_t i = 0; i < n; ++i)
-        printf("%02X ", p[i]);
+    for (size_t i = 0; i < n; i += 256)
+    {
+        size_t c = n - i < 256 ? n - i : 256;
+        fwrite(txt, 1, hex_encode_spaced(txt, p + i, c), stdout);
+    }
     if (n == 0)
         printf("(empty)");
     printf("\nASCII: ");
@@ -139,17 +235,28 @@ static void print_bytes_line(const unsigned char *p, size_t n)
     printf("\n");
 }
 
+// 从 head 起的 n 字节是否等于 p（零拷贝，直接比对两段）
+static bool ring_equals(const RingBuf *rb, const unsigned char *p, size_t n)
+{
+    RbSpan sp[2];
+    if (rb_read_peek_spans(rb, sp) < n)
+        return false;
+    size_t a = sp[0].len < n ? sp[0].len : n;
+    return memcmp(sp[0].ptr, p, a) == 0 && (a == n || memcmp(sp[1].ptr, p + a, n - a) == 0);
+}
+
 /*---------------------- 可视化 ----------------------*/
-// 以 32 格渲染：索引行 / 值行 / 指针行（彩色）
+// 最多渲染 VIZ_CELLS 格：索引行 / 值行 / 指针行（彩色）
 static void visualize(const RingBuf *rb)
 {
     size_t cap_vis = rb_capacity(rb);
-    if (cap_vis > FIXED_CAP)
-        cap_vis = FIXED_CAP;
+    if (cap_vis > VIZ_CELLS)
+        cap_vis = VIZ_CELLS;
 
-    printf("\n[Visualization] cap=%zu size=%zu head=%zu tail=%zu%s\n",
+    printf("\n[Visualization] cap=%zu size=%zu head=%zu tail=%zu%s%s\n",
            rb_capacity(rb), rb_size(rb), rb->head, rb->tail,
-           (rb_size(rb) == rb_capacity(rb) && rb_capacity(rb) > 0) ? " (FULL)" : "");
+           (rb_size(rb) == rb_capacity(rb) && rb_capacity(rb) > 0) ? " (FULL)" : "",
+           cap_vis < rb_capacity(rb) ? "（只画前 " RB_STR(VIZ_CELLS) " 格）" : "");
 
     // 1) 索引行
     printf("Index: ");
@@ -192,15 +299,41 @@ static void visualize(const RingBuf *rb)
 }
 
 /*---------------------- bench：简单压力/环回测试 ----------------------*/
+// 在当前容量上跑；各容量/块大小/位置的分位数与 CSV/JSON 输出见独立的 rb_bench.c
+static double now_sec(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// 一轮：push 满 chunk、peek 1 字节、检索一个不存在的模式、pop 一半制造环回
+static size_t bench_loop(RingBuf *rb, size_t iters, unsigned char *tmp, size_t chunk,
+                         size_t *pushed, size_t *popped)
+{
+    static const unsigned char miss[2] = {0xEE, 0xEF}; // tmp 里不会出现
+    size_t sink = 0, idx = 0;
+    for (size_t i = 0; i < iters; ++i)
+    {
+        *pushed += rb_push(rb, tmp, chunk);    // 尽力写
+        unsigned char b = 0;
+        sink += rb_peek(rb, &b, 1, 0) + b;
+        sink += rb_search(rb, miss, sizeof(miss), &idx) ? 1 : 0;
+        *popped += rb_pop(rb, tmp, chunk / 2); // 每轮读一半，制造环回
+    }
+    return sink;
+}
+
 static void cmd_bench(RingBuf *rb, size_t iters, size_t chunk)
 {
     if (chunk == 0)
     {
-        printf("bench: chunk 需要 > 0\n");
+        fail("bench: chunk 需要 > 0\n");
         return;
     }
-    if (chunk > FIXED_CAP)
-        chunk = FIXED_CAP; // 我们固定 32 字节上限
+    size_t cap = rb_capacity(rb);
+    if (chunk > cap)
+        chunk = cap;
     unsigned char *tmp = (unsigned char *)malloc(chunk);
     if (!tmp)
     {
@@ -208,7 +341,7 @@ static void cmd_bench(RingBuf *rb, size_t iters, size_t chunk)
         return;
     }
     for (size_t i = 0; i < chunk; ++i)
-        tmp[i] = (unsigned char)i;
+        tmp[i] = (unsigned char)(i % 0xEE);
 
     size_t pushed = 0, popped = 0;
     for (size_t i = 0; i < iters; ++i)
@@ -218,6 +351,33 @@ static void cmd_bench(RingBuf *rb, size_t iters, size_t chunk)
     }
     printf("bench: iters=%zu chunk=%zu | pushed=%zu popped=%zu size=%zu free=%zu\n",
            iters, chunk, pushed, popped, rb_size(rb), rb_free_space(rb));
+
+    // 对比：同容量的取模模式（rb_init）与 2 的幂模式（rb_init_pow2），各用一个临时缓冲
+    const char *names[2] = {"mod ", "pow2"};
+    double ns[2] = {0, 0};
+    volatile size_t sink = 0;
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        RingBuf t;
+        bool ok = mode ? rb_init_pow2(&t, cap) : rb_init(&t, cap);
+        if (!ok)
+        {
+            fprintf(stderr, "内存不足。\n");
+            break;
+        }
+        for (size_t i = 0; i < chunk; ++i)
+            tmp[i] = (unsigned char)(i % 0xEE);
+        size_t pu = 0, po = 0;
+        double t0 = now_sec();
+        sink += bench_loop(&t, iters, tmp, chunk, &pu, &po);
+        double dt = now_sec() - t0;
+        ns[mode] = iters ? dt * 1e9 / (double)iters : 0.0;
+        printf("bench[%s]: cap=%zu pushed=%zu popped=%zu | %.3f ms, %.1f ns/iter\n",
+               names[mode], rb_capacity(&t), pu, po, dt * 1e3, ns[mode]);
+        rb_free(&t);
+    }
+    if (ns[1] > 0)
+        printf("bench: pow2 相对 mod 加速 %.2fx（每轮 push+peek+search+pop）\n", ns[0] / ns[1]);
     free(tmp);
 }
 
@@ -225,57 +385,132 @@ static void cmd_bench(RingBuf *rb, size_t iters, size_t chunk)
 static void print_help(void)
 {
     printf(
-        "命令（容量固定 32 字节）：\n"
+        "命令：\n"
         "  help                      显示帮助\n"
-        "  viz                       打印可视化网格（带彩色 H/T）\n"
-        "  autoviz on|off            修改后是否自动可视化（默认 on）\n"
+        "  viz                       打印可视化网格（带彩色 H/T，最多 32 格）\n"
+        "  autoviz on|off            修改后是否自动可视化（交互默认 on，批处理默认 off）\n"
         "  cap / size / free         基本信息\n"
         "  clear                     清空缓冲区\n"
         "  dump [N]                  转储最多 N 字节（默认 64）\n"
         "  pushs <字符串>            以字符串写入\n"
-        "  pushx <hex...>            以十六进制写入，如：01 02 0xFF DEADBEEF\n"
+        "  pushx <hex...>            以十六进制写入，如：01 02 0xFF DEADBEEF（一行不限长度）\n"
+        "  pusho <字符串>            覆盖写入（空间不够时丢弃最旧数据）\n"
         "  pop <N>                   读出 N 字节\n"
+        "  popx <hex...>             读出与给定字节等长的数据，并校验内容一致\n"
+        "  skip <N>                  丢弃最前面 N 字节（不拷贝）\n"
         "  peek <offset> <N>         仅查看\n"
         "  searchs <字符串>          检索字符串\n"
         "  searchx <hex...>          检索十六进制序列\n"
-        "  bench <iters> <chunk>     简易压力测试（反复 push/pop）\n"
-        "  init                      重新初始化为 32 字节（忽略参数）\n"
+        "  expect size|free|cap <N>  校验数值，不符记为失败\n"
+        "  expectx <hex...>          校验 head 起的字节（不消费）\n"
+        "  bench <iters> <chunk>     简易压力测试（反复 push/pop，并对比 mod/pow2 两种模式耗时；完整基准见 rb_bench）\n"
+        "  init [容量] [mod|pow2|mirror]  重新初始化（不给参数则沿用当前容量与模式）\n"
+        "  # ...                     注释（脚本里用）\n"
         "  exit / quit               退出\n");
 }
 
+static void print_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "用法：%s [-c 容量] [-m mod|pow2|mirror] [-b] [-k] [脚本文件|-]\n"
+            "  -c N   容量（字节，可带 k/m/g 后缀，默认 %d）\n"
+            "  -m     后端（默认 mod）\n"
+            "  -b     批处理：不打提示符、不可视化；给了脚本文件时自动进入\n"
+            "  -k     批处理里命令失败后继续（默认停在第一个失败）\n",
+            argv0, DEFAULT_CAP);
+}
+
 /*---------------------- 主体 ----------------------*/
-int main(void)
+int main(int argc, char **argv)
 {
-    enable_ansi(); // 尝试开启 ANSI 颜色（Windows 终端）
+    size_t cap = DEFAULT_CAP;
+    int mode = MODE_MOD;
+    bool keep_going = false;
+    const char *script = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *a = argv[i];
+        if (!strcmp(a, "-c") && i + 1 < argc)
+        {
+            if (!parse_size(argv[++i], &cap))
+            {
+                fprintf(stderr, "容量无效：%s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (!strcmp(a, "-m") && i + 1 < argc)
+        {
+            if (!parse_mode(argv[++i], &mode))
+            {
+                fprintf(stderr, "模式无效：%s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (!strcmp(a, "-b"))
+            g_batch = true;
+        else if (!strcmp(a, "-k"))
+            keep_going = true;
+        else if ((a[0] != '-' || !strcmp(a, "-")) && !script)
+        {
+            script = a;
+            g_batch = true;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *in = stdin;
+    if (script && strcmp(script, "-"))
+    {
+        in = fopen(script, "r");
+        if (!in)
+        {
+            fprintf(stderr, "打不开脚本：%s\n", script);
+            return 2;
+        }
+    }
 
     RingBuf rb;
-    bool auto_viz = true;
+    bool auto_viz = !g_batch;
 
-    if (!rb_init(&rb, FIXED_CAP))
+    if (!ring_open(&rb, cap, mode))
     {
-        fprintf(stderr, "初始化失败：内存不足？\n");
+        fprintf(stderr, "初始化失败：内存不足或平台不支持该模式？\n");
         return 1;
     }
-    printf("环形缓冲区就绪：容量固定为 %d 字节。输入 help 查看命令。\n", FIXED_CAP);
-    visualize(&rb);
+    if (!g_batch)
+    {
+        enable_ansi(); // 尝试开启 ANSI 颜色（Windows 终端）
+        printf("环形缓冲区就绪：容量 %zu 字节（%s）。输入 help 查看命令。\n", rb_capacity(&rb), mode_name(&rb));
+        visualize(&rb);
+    }
 
-    char line[LINE_MAX_LEN];
+    char *line = NULL;
+    size_t line_cap = 0, line_len = 0;
+    double t_start = now_sec();
 
     for (;;)
     {
-        printf("\nrb32> ");
-        if (!fgets(line, sizeof(line), stdin))
+        if (g_batch && g_fail && !keep_going)
+            break;
+        if (!g_batch)
+            printf("\nrb> ");
+        if (!read_line(in, &line, &line_cap, &line_len))
         {
-            printf("\n退出。\n");
+            note("\n退出。\n");
             break;
         }
-        chomp(line);
+        g_lineno++;
 
-        // 跳过空行
+        // 跳过空行与注释
         char *p = line;
         while (*p && isspace((unsigned char)*p))
             ++p;
-        if (!*p)
+        if (!*p || *p == '#')
             continue;
 
         // 解析命令
@@ -287,6 +522,7 @@ int main(void)
         char *args = p + ci;
         while (*args && isspace((unsigned char)*args))
             ++args;
+        size_t args_len = line_len - (size_t)(args - line);
 
         // 分发
         if (ieq(cmd, "help") || ieq(cmd, "?"))
@@ -295,7 +531,7 @@ int main(void)
         }
         else if (ieq(cmd, "exit") || ieq(cmd, "quit"))
         {
-            printf("再见。\n");
+            note("再见。\n");
             break;
         }
         else if (ieq(cmd, "viz"))
@@ -312,15 +548,15 @@ int main(void)
             if (ieq(args, "on"))
             {
                 auto_viz = true;
-                printf("autoviz -> on\n");
+                note("autoviz -> on\n");
             }
             else if (ieq(args, "off"))
             {
                 auto_viz = false;
-                printf("autoviz -> off\n");
+                note("autoviz -> off\n");
             }
             else
-                printf("用法：autoviz on|off\n");
+                fail("用法：autoviz on|off\n");
         }
         else if (ieq(cmd, "cap"))
         {
@@ -337,7 +573,7 @@ int main(void)
         else if (ieq(cmd, "clear"))
         {
             rb_clear(&rb);
-            printf("已清空。\n");
+            note("已清空。\n");
             if (auto_viz)
                 visualize(&rb);
         }
@@ -354,7 +590,7 @@ int main(void)
             size_t avail = rb_size(&rb);
             if (n > avail)
                 n = avail;
-            unsigned char *buf = (unsigned char *)malloc(n ? n : 1);
+            unsigned char *buf = scratch(n ? n : 1);
             if (!buf)
             {
                 fprintf(stderr, "内存不足。\n");
@@ -363,18 +599,18 @@ int main(void)
             size_t got = rb_peek(&rb, buf, n, 0);
             printf("DUMP %zu 字节（从head）：\n", got);
             print_bytes_line(buf, got);
-            free(buf);
         }
         else if (ieq(cmd, "pushs"))
         {
             if (!*args)
             {
-                printf("用法：pushs <字符串>\n");
+                fail("用法：pushs <字符串>\n");
                 continue;
             }
-            size_t want = strlen(args);
+            size_t want = args_len;
             size_t wrote = rb_push(&rb, args, want);
-            printf("pushs: 请求=%zu 实际=%zu（free=%zu）\n", want, wrote, rb_free_space(&rb));
+            g_pushed += wrote;
+            note("pushs: 请求=%zu 实际=%zu（free=%zu）\n", want, wrote, rb_free_space(&rb));
             if (auto_viz)
                 visualize(&rb);
         }
@@ -382,19 +618,48 @@ int main(void)
         {
             if (!*args)
             {
-                printf("用法：pushx <hex...>\n");
+                fail("用法：pushx <hex...>\n");
                 continue;
             }
             unsigned char *bytes = NULL;
-            size_t n = parse_hex_bytes(args, &bytes);
+            size_t n = parse_hex_bytes(args, args_len, &bytes);
             if (n == 0)
             {
-                printf("pushx: 解析失败（示例：01 02 0xFF DEADBEEF）\n");
+                fail("pushx: 解析失败（示例：01 02 0xFF DEADBEEF）\n");
                 continue;
             }
             size_t wrote = rb_push(&rb, bytes, n);
-            printf("pushx: 请求=%zu 实际=%zu（free=%zu）\n", n, wrote, rb_free_space(&rb));
-            free(bytes);
+            g_pushed += wrote;
+            note("pushx: 请求=%zu 实际=%zu（free=%zu）\n", n, wrote, rb_free_space(&rb));
+            if (auto_viz)
+                visualize(&rb);
+        }
+        else if (ieq(cmd, "pusho"))
+        {
+            if (!*args)
+            {
+                fail("用法：pusho <字符串>\n");
+                continue;
+            }
+            size_t want = args_len, dropped = 0;
+            size_t wrote = rb_push_overwrite(&rb, args, want, &dropped);
+            g_pushed += wrote;
+            note("pusho: 请求=%zu 实际=%zu 丢弃最旧=%zu\n", want, wrote, dropped);
+            if (auto_viz)
+                visualize(&rb);
+        }
+        else if (ieq(cmd, "skip"))
+        {
+            char *end = NULL;
+            unsigned long tmp = strtoul(args, &end, 0);
+            if (!*args || end == args)
+            {
+                fail("用法：skip <N>\n");
+                continue;
+            }
+            size_t got = rb_skip(&rb, (size_t)tmp);
+            g_popped += got;
+            note("skip: 实际丢弃=%zu 剩余=%zu\n", got, rb_size(&rb));
             if (auto_viz)
                 visualize(&rb);
         }
@@ -402,66 +667,123 @@ int main(void)
         {
             if (!*args)
             {
-                printf("用法：pop <N>\n");
+                fail("用法：pop <N>\n");
                 continue;
             }
             char *end = NULL;
             unsigned long tmp = strtoul(args, &end, 0);
             if (end == args)
             {
-                printf("pop: 参数错误\n");
+                fail("pop: 参数错误\n");
                 continue;
             }
             size_t want = (size_t)tmp;
             size_t avail = rb_size(&rb);
             if (want > avail)
                 want = avail;
-            unsigned char *buf = (unsigned char *)malloc(want ? want : 1);
+            if (g_batch)
+            {
+                g_popped += rb_skip(&rb, want); // 不展示就不用拷贝
+                continue;
+            }
+            unsigned char *buf = scratch(want ? want : 1);
             if (!buf)
             {
                 fprintf(stderr, "内存不足。\n");
                 continue;
             }
             size_t got = rb_pop(&rb, buf, want);
+            g_popped += got;
             printf("pop: 实际读出=%zu 剩余=%zu\n", got, rb_size(&rb));
             print_bytes_line(buf, got);
-            free(buf);
             if (auto_viz)
                 visualize(&rb);
         }
+        else if (ieq(cmd, "popx") || ieq(cmd, "expectx"))
+        {
+            bool consume = ieq(cmd, "popx");
+            if (!*args)
+            {
+                fail("用法：%s <hex...>\n", cmd);
+                continue;
+            }
+            unsigned char *want = NULL;
+            size_t n = parse_hex_bytes(args, args_len, &want);
+            if (n == 0)
+            {
+                fail("%s: 解析失败\n", cmd);
+                continue;
+            }
+            if (!ring_equals(&rb, want, n))
+            {
+                fail("%s: 不符（期望 %zu 字节，缓冲区 size=%zu）\n", cmd, n, rb_size(&rb));
+                continue;
+            }
+            if (consume)
+            {
+                g_popped += rb_skip(&rb, n);
+                if (auto_viz)
+                    visualize(&rb);
+            }
+            note("%s: %zu 字节一致\n", cmd, n);
+        }
+        else if (ieq(cmd, "expect"))
+        {
+            char what[16] = {0};
+            unsigned long long v = 0;
+            if (sscanf(args, "%15s %llu", what, &v) != 2)
+            {
+                fail("用法：expect size|free|cap <N>\n");
+                continue;
+            }
+            size_t got;
+            if (ieq(what, "size"))
+                got = rb_size(&rb);
+            else if (ieq(what, "free"))
+                got = rb_free_space(&rb);
+            else if (ieq(what, "cap"))
+                got = rb_capacity(&rb);
+            else
+            {
+                fail("用法：expect size|free|cap <N>\n");
+                continue;
+            }
+            if ((unsigned long long)got != v)
+                fail("expect %s: 期望 %llu 实际 %zu\n", what, v, got);
+        }
         else if (ieq(cmd, "peek"))
         {
             // peek <offset> <N>
             if (!*args)
             {
-                printf("用法：peek <offset> <N>\n");
+                fail("用法：peek <offset> <N>\n");
                 continue;
             }
             char *end = NULL;
             unsigned long off = strtoul(args, &end, 0);
             if (end == args)
             {
-                printf("peek: offset 应为数字\n");
+                fail("peek: offset 应为数字\n");
                 continue;
             }
             while (*end && isspace((unsigned char)*end))
                 ++end;
             if (!*end)
             {
-                printf("peek: 缺少 N 参数\n");
+                fail("peek: 缺少 N 参数\n");
                 continue;
             }
             unsigned long nval = strtoul(end, &end, 0);
             size_t offset = (size_t)off, n = (size_t)nval;
             if (offset >= rb_size(&rb))
             {
-                printf("peek: offset 超界（size=%zu）\n", rb_size(&rb));
+                fail("peek: offset 超界（size=%zu）\n", rb_size(&rb));
                 continue;
             }
             size_t maxn = rb_size(&rb) - offset;
             if (n > maxn)
                 n = maxn;
-            unsigned char *buf = (unsigned char *)malloc(n ? n : 1);
+            unsigned char *buf = scratch(n ? n : 1);
             if (!buf)
             {
                 fprintf(stderr, "内存不足。\n");
@@ -475,37 +797,36 @@ int main(void)
         {
             if (!*args)
             {
-                printf("用法：searchs <字符串>\n");
+                fail("用法：searchs <字符串>\n");
                 continue;
             }
             size_t idx = 0;
-            int found = rb_search(&rb, args, strlen(args), &idx);
+            int found = rb_search(&rb, args, args_len, &idx);
             printf(found ? "FOUND at %zu\n" : "NOT FOUND\n", idx);
         }
         else if (ieq(cmd, "searchx"))
         {
             if (!*args)
             {
-                printf("用法：searchx <hex...>\n");
+                fail("用法：searchx <hex...>\n");
                 continue;
             }
             unsigned char *pat = NULL;
-            size_t m = parse_hex_bytes(args, &pat);
+            size_t m = parse_hex_bytes(args, args_len, &pat);
             if (m == 0)
             {
-                printf("searchx: 解析失败\n");
+                fail("searchx: 解析失败\n");
                 continue;
             }
             size_t idx = 0;
             int found = rb_search(&rb, pat, m, &idx);
-            free(pat);
             printf(found ? "FOUND at %zu\n" : "NOT FOUND\n", idx);
         }
         else if (ieq(cmd, "bench"))
         {
             if (!*args)
             {
-                printf("用法：bench <iters> <chunk>\n");
+                fail("用法：bench <iters> <chunk>\n");
                 continue;
             }
             char *end = NULL;
@@ -514,7 +835,7 @@ int main(void)
                 ++end;
             if (end == args || !*end)
             {
-                printf("用法：bench <iters> <chunk>\n");
+                fail("用法：bench <iters> <chunk>\n");
                 continue;
             }
             unsigned long ch = strtoul(end, NULL, 0);
@@ -524,22 +845,47 @@ int main(void)
         }
         else if (ieq(cmd, "init"))
         {
-            rb_free(&rb);
-            if (!rb_init(&rb, FIXED_CAP))
+            // init [容量] [mod|pow2|mirror]：参数可任意顺序，缺省沿用当前
+            size_t ncap = rb_capacity(&rb);
+            int nmode = rb.mirror ? MODE_MIRROR : rb.mask ? MODE_POW2 : MODE_MOD;
+            bool ok = true;
+            char *tok = strtok(args, " \t");
+            for (; tok && ok; tok = strtok(NULL, " \t"))
+                ok = parse_mode(tok, &nmode) || parse_size(tok, &ncap);
+            if (!ok)
             {
-                fprintf(stderr, "init失败：内存不足？\n");
-                return 1;
+                fail("用法：init [容量] [mod|pow2|mirror]\n");
+                continue;
+            }
+            RingBuf nrb;
+            if (!ring_open(&nrb, ncap, nmode))
+            {
+                fail("init 失败：内存不足或平台不支持该模式？\n");
+                continue;
             }
-            printf("已重新初始化为固定容量 %d 字节。\n", FIXED_CAP);
+            rb_free(&rb);
+            rb = nrb;
+            note("已重新初始化：容量 %zu 字节（%s）。\n", rb_capacity(&rb), mode_name(&rb));
             if (auto_viz)
                 visualize(&rb);
         }
         else
         {
-            printf("未知命令：%s  （help 查看帮助）\n", cmd);
+            fail("未知命令：%s  （help 查看帮助）\n", cmd);
         }
     }
 
+    if (g_batch)
+    {
+        double dt = now_sec() - t_start;
+        double mb = (double)(g_pushed + g_popped) / (1024.0 * 1024.0);
+        fprintf(stderr, "batch: 行=%zu 失败=%lu 耗时=%.3f s | push=%zu pop=%zu（%.1f MiB/s）size=%zu\n",
+                g_lineno, g_fail, dt, g_pushed, g_popped, dt > 0 ? mb / dt : 0.0, rb_size(&rb));
+    }
+
+    free(line);
+    if (in != stdin)
+        fclose(in);
     rb_free(&rb);
-    return 0;
+    return (g_batch && g_fail) ? 1 : 0;
 }
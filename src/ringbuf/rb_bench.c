@@ -0,0 +1,1034 @@
+// rb_bench.c — 环形缓冲区与串口解析流水线的基准测试（ns/op、GB/s 与分位数，可输出 CSV/JSON 做版本间对比）
+// 编译（Linux/macOS）：
+//   gcc -O2 rb_bench.c ringbuf.c ringbuf_find.c ringbuf_vm.c ringbuf_spsc.c ringbuf_wait.c hex_codec.c
+//       ../serial_port/frame_parser.c ../serial_port/proto.c ../serial_port/crc.c ../serial_port/sp_thread.c
+//       -o rb_bench -pthread
+// 编译（MinGW）：同上，去掉 -pthread
+// 用法：rb_bench [--csv | --json] [--quick] [--suite rb|spsc|parser|lat]... [--samples N] [--budget-ms N]
+//               [--load N] [--cpus P,C]
+//
+// 三组用例：
+//   rb     单线程 RingBuf：rb_push / rb_pop / rb_peek / rb_search，容量 32 B ~ 64 MiB，
+//          mod / pow2 / mirror 三种模式，aligned（从 0 起，块不跨界）/ offset1（错开 1 字节）/
+//          straddle（每次操作都跨越数组末尾）三种位置
+//   spsc   RingBufSpsc 跨线程：生产者线程按块写，主线程按块读并校验字节序
+//   parser frame_parser 喂合成噪声流：几种内置协议 × 噪声比例 × 喂入块大小
+//   lat    单向延迟（尾延迟）：生产者按固定间隔推带时间戳的 16 字节消息，消费者像 printer 一样睡在环事件上，
+//          每条消息一个样本（推入 -> 取出的 ns）。同一组消息分别在 default / rt / pinned / pin+rt 四种线程配置
+//          （绑核、SCHED_FIFO / TIME_CRITICAL，见 sp_thread.h）与普通 / 大页两种环内存下各跑一遍；
+//          --load N 另起 N 个普通优先级的忙等线程模拟机器负载，差别主要体现在 p99.9 / max。
+//          rt 需要实时调度权限，pinned 需要至少 2 个逻辑 CPU，做不到的组合跳过（stderr 说明原因）
+//
+// 每个用例先跑一个不计时的预热样本，再取最多 --samples 个样本（单个用例最多 --budget-ms，至少 5 个样本）；
+// 每个样本计时一批操作，记为 ns/op。输出 p50/p90/p99，GB/s 按 p50 计算（每次操作的字节数 / p50）。
+// straddle 位置靠 rb_write_commit + rb_skip 把读写位置“转一圈”回到边界前，这两个 O(1) 调用计入耗时。
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // clock_gettime
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "ringbuf.h"
+#include "ringbuf_spsc.h"
+#include "ringbuf_vm.h"
+#include "../serial_port/frame_parser.h"
+#include "../serial_port/crc.h"
+#include "../serial_port/sp_thread.h"
+
+#define MAX_SAMPLES 1001
+#define MIN_SAMPLES 5
+#define SAMPLE_BYTES (256u * 1024) // rb 用例：每个样本大约搬这么多字节
+#define SAMPLE_MIN_OPS 16
+#define SAMPLE_MAX_OPS 4096
+#define SPSC_SAMPLE_BYTES (256u * 1024)  // spsc 用例：消费者每收这么多字节记一个样本
+#define PARSER_SAMPLE_BYTES (64u * 1024) // parser 用例：每个样本喂这么多字节
+#define MAX_CHUNK (64u * 1024)
+#define LAT_MSGS 20000          // lat 用例：每种配置推这么多条消息（--quick 为 1/4），每条一个样本
+#define LAT_WARM 200            // 最前面这么多条不计（缺页、首次唤醒）
+#define LAT_GAP_NS 50000.0      // 消息间隔 50us：消费者每条都要从睡眠中被唤醒
+#define LAT_CAP (4u << 20)      // lat 用例的环容量（够大才谈得上大页）
+#define SAMPLES_CAP (LAT_MSGS > MAX_SAMPLES ? LAT_MSGS : MAX_SAMPLES)
+#define MAX_LOAD 64
+
+typedef enum
+{
+    OUT_TEXT = 0,
+    OUT_CSV,
+    OUT_JSON
+} OutFmt;
+
+static OutFmt g_fmt = OUT_TEXT;
+static bool g_quick = false;
+static size_t g_samples = 101;
+static double g_budget_ns = 200e6;
+static size_t g_rows = 0; // 已输出的结果（JSON 逗号 / 文本表头）
+static int g_errors = 0;  // 校验失败（spsc 字节序 / parser 帧数）
+static volatile size_t g_sink;
+static int g_load = 0;                  // lat：背景忙等线程数
+static int g_cpu_prod = -1, g_cpu_cons = -1; // lat：pinned 配置用的 CPU（-1 自动选）
+
+/* ---------------- 平台相关：时钟、让出 CPU、线程 ---------------- */
+#ifdef _WIN32
+static double now_ns(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1e9 / (double)freq.QuadPart;
+}
+static void bench_yield(void) { SwitchToThread(); }
+// 睡到（或让到）时刻 t：Windows 的 Sleep 粒度到毫秒级，只能让出 CPU 轮询
+static void sleep_until_ns(double t)
+{
+    while (now_ns() < t)
+        SwitchToThread();
+}
+#else
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+static void bench_yield(void) { sched_yield(); }
+// 绝对时刻睡眠：实时线程也会真的让出 CPU（忙等会饿死同核的消费者）
+static void sleep_until_ns(double t)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(t / 1e9);
+    ts.tv_nsec = (long)(t - (double)ts.tv_sec * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        ;
+}
+#endif
+
+/* ---------------- 统计与输出 ---------------- */
+
+typedef struct
+{
+    double v[SAMPLES_CAP]; // 每个样本的 ns/op（lat 为每条消息的延迟）
+    size_t n;
+} Samples;
+
+typedef struct
+{
+    const char *suite;   // rb / spsc / parser
+    const char *op;      // push / pop / peek / search / stream / feed
+    const char *mode;    // mod / pow2 / mirror / 协议名
+    size_t cap;          // 环容量（parser 为 0）
+    size_t chunk;        // 每次操作的块大小（search 为模式长度）
+    const char *pattern; // 位置模式 / 噪声比例
+    double bytes_per_op; // 算 GB/s 用
+} Case;
+
+static Samples g_s;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 最近秩分位数（样本已排序）
+static double pct(const double *v, size_t n, double p)
+{
+    size_t k = (size_t)(p / 100.0 * (double)(n - 1) + 0.5);
+    return v[k < n ? k : n - 1];
+}
+
+static const char *fmt_size(size_t n, char *buf, size_t len)
+{
+    if (n == 0)
+        snprintf(buf, len, "-");
+    else if (n % (1024u * 1024) == 0)
+        snprintf(buf, len, "%zuM", n / (1024u * 1024));
+    else if (n % 1024 == 0)
+        snprintf(buf, len, "%zuK", n / 1024);
+    else
+        snprintf(buf, len, "%zu", n);
+    return buf;
+}
+
+static void report(const Case *c, Samples *s)
+{
+    if (s->n == 0)
+        return;
+    qsort(s->v, s->n, sizeof(s->v[0]), cmp_double);
+    double sum = 0;
+    for (size_t i = 0; i < s->n; ++i)
+        sum += s->v[i];
+    double mean = sum / (double)s->n;
+    double p50 = pct(s->v, s->n, 50), p90 = pct(s->v, s->n, 90), p99 = pct(s->v, s->n, 99);
+    double p999 = pct(s->v, s->n, 99.9), max = s->v[s->n - 1];
+    double gbps = p50 > 0 ? c->bytes_per_op / p50 : 0; // 字节/ns 即 GB/s
+
+    switch (g_fmt)
+    {
+    case OUT_CSV:
+        if (g_rows == 0)
+            printf("suite,op,mode,cap,chunk,pattern,samples,ns_min,ns_mean,ns_p50,ns_p90,ns_p99,gbps,ns_p999,ns_max\n");
+        printf("%s,%s,%s,%zu,%zu,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.3f,%.3f\n", c->suite, c->op, c->mode, c->cap,
+               c->chunk, c->pattern, s->n, s->v[0], mean, p50, p90, p99, gbps, p999, max);
+        break;
+    case OUT_JSON:
+        printf("%s\n    {\"suite\":\"%s\",\"op\":\"%s\",\"mode\":\"%s\",\"cap\":%zu,\"chunk\":%zu,\"pattern\":\"%s\","
+               "\"samples\":%zu,\"ns_min\":%.3f,\"ns_mean\":%.3f,\"ns_p50\":%.3f,\"ns_p90\":%.3f,\"ns_p99\":%.3f,"
+               "\"gbps\":%.4f,\"ns_p999\":%.3f,\"ns_max\":%.3f}",
+               g_rows ? "," : "", c->suite, c->op, c->mode, c->cap, c->chunk, c->pattern, s->n, s->v[0], mean, p50,
+               p90, p99, gbps, p999, max);
+        break;
+    default:
+    {
+        char cap[24];
+        if (g_rows == 0)
+            printf("%-6s %-6s %-16s %6s %6s %-8s %10s %10s %10s %11s %11s %9s\n", "suite", "op", "mode", "cap",
+                   "chunk", "pattern", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns", "GB/s");
+        printf("%-6s %-6s %-16s %6s %6zu %-8s %10.2f %10.2f %10.2f %11.2f %11.2f %9.3f\n", c->suite, c->op, c->mode,
+               fmt_size(c->cap, cap, sizeof(cap)), c->chunk, c->pattern, p50, p90, p99, p999, max, gbps);
+        break;
+    }
+    }
+    ++g_rows;
+    fflush(stdout);
+}
+
+typedef double (*SampleFn)(void *ctx); // 跑一个样本，返回 ns/op
+
+static void run_case(const Case *c, SampleFn fn, void *ctx)
+{
+    g_s.n = 0;
+    fn(ctx); // 预热（缺页、缓存、分支预测）
+    double t0 = now_ns();
+    while (g_s.n < g_samples && (g_s.n < MIN_SAMPLES || now_ns() - t0 < g_budget_ns))
+        g_s.v[g_s.n++] = fn(ctx);
+    report(c, &g_s);
+}
+
+static uint32_t xorshift(uint32_t *x)
+{
+    *x ^= *x << 13, *x ^= *x >> 17, *x ^= *x << 5;
+    return *x;
+}
+
+/* ---------------- rb：单线程 RingBuf ---------------- */
+
+typedef enum
+{
+    PAT_ALIGNED = 0,
+    PAT_OFFSET1,
+    PAT_STRADDLE
+} WrapPat;
+
+static const char *const k_pat_names[] = {"aligned", "offset1", "straddle"};
+static const char *const k_mode_names[] = {"mod", "pow2", "mirror"};
+
+typedef struct
+{
+    RingBuf *rb;
+    size_t chunk;
+    WrapPat pat;
+    size_t ops;      // 每个样本的操作数（batch 的整数倍）
+    size_t batch;    // 连续操作数（不超过 cap / chunk，之后用 O(1) 的 skip/commit 腾出或补充）
+    size_t peek_off; // peek：下一次的偏移
+    uint8_t *buf;    // 源 / 目的缓冲
+    const uint8_t *pat_bytes; // search：模式
+} RbCtx;
+
+static bool init_mode(RingBuf *rb, int mode, size_t cap)
+{
+    bool ok = (mode == 0) ? rb_init(rb, cap) : (mode == 1) ? rb_init_pow2(rb, cap) : rb_init_mirror(rb, cap);
+    if (ok && rb_capacity(rb) != cap) // 镜像容量不能小于页大小/分配粒度，会被放大，这种组合不测
+    {
+        rb_free(rb);
+        ok = false;
+    }
+    return ok;
+}
+
+// 把空环的读写位置移到 pos（rb_write_commit + rb_skip 只动计数，不拷贝）
+static void rb_seek(RingBuf *rb, size_t pos)
+{
+    rb_clear(rb);
+    rb_write_commit(rb, pos);
+    rb_skip(rb, pos);
+}
+
+static size_t start_pos(size_t cap, size_t chunk, WrapPat pat)
+{
+    if (pat == PAT_OFFSET1)
+        return 1;
+    if (pat == PAT_STRADDLE)
+        return cap - chunk / 2;
+    return 0;
+}
+
+static void plan(RbCtx *x, size_t cap)
+{
+    size_t t = SAMPLE_BYTES / x->chunk;
+    if (t < SAMPLE_MIN_OPS)
+        t = SAMPLE_MIN_OPS;
+    if (t > SAMPLE_MAX_OPS)
+        t = SAMPLE_MAX_OPS;
+    x->batch = (t < cap / x->chunk) ? t : cap / x->chunk;
+    x->ops = (t + x->batch - 1) / x->batch * x->batch;
+}
+
+static double sample_push(void *arg)
+{
+    RbCtx *x = (RbCtx *)arg;
+    RingBuf *rb = x->rb;
+    size_t back = rb_capacity(rb) - x->chunk;
+    double t0 = now_ns();
+    if (x->pat == PAT_STRADDLE)
+    {
+        for (size_t i = 0; i < x->ops; ++i)
+        {
+            rb_push(rb, x->buf, x->chunk);
+            rb_skip(rb, x->chunk);
+            rb_write_commit(rb, back); // 转一圈回到边界前，下一次仍然跨界
+            rb_skip(rb, back);
+        }
+    }
+    else
+    {
+        for (size_t done = 0; done < x->ops; done += x->batch)
+        {
+            for (size_t i = 0; i < x->batch; ++i)
+                rb_push(rb, x->buf, x->chunk);
+            rb_skip(rb, x->batch * x->chunk);
+        }
+    }
+    return (now_ns() - t0) / (double)x->ops;
+}
+
+static double sample_pop(void *arg)
+{
+    RbCtx *x = (RbCtx *)arg;
+    RingBuf *rb = x->rb;
+    size_t back = rb_capacity(rb) - x->chunk;
+    size_t got = 0;
+    double t0 = now_ns();
+    if (x->pat == PAT_STRADDLE)
+    {
+        for (size_t i = 0; i < x->ops; ++i)
+        {
+            rb_write_commit(rb, x->chunk);
+            got += rb_pop(rb, x->buf, x->chunk);
+            rb_write_commit(rb, back);
+            rb_skip(rb, back);
+        }
+    }
+    else
+    {
+        for (size_t done = 0; done < x->ops; done += x->batch)
+        {
+            rb_write_commit(rb, x->batch * x->chunk); // 环里已有的旧字节当作新数据
+            for (size_t i = 0; i < x->batch; ++i)
+                got += rb_pop(rb, x->buf, x->chunk);
+        }
+    }
+    double dt = now_ns() - t0;
+    g_sink += got;
+    return dt / (double)x->ops;
+}
+
+// 环是满的：straddle 总在偏移 0 处读（head 在边界前半块），其余按块循环各个偏移
+static double sample_peek(void *arg)
+{
+    RbCtx *x = (RbCtx *)arg;
+    RingBuf *rb = x->rb;
+    size_t limit = rb_size(rb) - x->chunk;
+    size_t got = 0;
+    double t0 = now_ns();
+    for (size_t i = 0; i < x->ops; ++i)
+    {
+        got += rb_peek(rb, x->buf, x->chunk, x->peek_off);
+        if (x->pat != PAT_STRADDLE && (x->peek_off += x->chunk) > limit)
+            x->peek_off = 0;
+    }
+    double dt = now_ns() - t0;
+    g_sink += got;
+    return dt / (double)x->ops;
+}
+
+// 环是满的且不含模式：每次 rb_search 扫完整个环
+static double sample_search(void *arg)
+{
+    RbCtx *x = (RbCtx *)arg;
+    size_t idx = 0;
+    double t0 = now_ns();
+    for (size_t i = 0; i < x->ops; ++i)
+        if (rb_search(x->rb, x->pat_bytes, x->chunk, &idx))
+            g_sink += idx;
+    return (now_ns() - t0) / (double)x->ops;
+}
+
+static void suite_rb(void)
+{
+    static const size_t caps_full[] = {32, 512, 4096, 64u << 10, 1u << 20, 16u << 20, 64u << 20};
+    static const size_t caps_quick[] = {32, 4096, 64u << 10, 1u << 20, 64u << 20};
+    static const size_t chunks_full[] = {1, 16, 256, 4096, 64u << 10};
+    static const size_t chunks_quick[] = {1, 64, 4096};
+    const size_t *caps = g_quick ? caps_quick : caps_full;
+    const size_t *chunks = g_quick ? chunks_quick : chunks_full;
+    size_t ncaps = g_quick ? sizeof(caps_quick) / sizeof(caps_quick[0]) : sizeof(caps_full) / sizeof(caps_full[0]);
+    size_t nchunks =
+        g_quick ? sizeof(chunks_quick) / sizeof(chunks_quick[0]) : sizeof(chunks_full) / sizeof(chunks_full[0]);
+
+    // 模式首字节 0x5A 在填充数据里约每 128 字节出现一次（走候选校验），其余字节带最高位，保证不命中
+    uint8_t pat[16] = {0x5A};
+    for (size_t k = 1; k < sizeof(pat); ++k)
+        pat[k] = (uint8_t)(0x80 | (k * 37u));
+    static const size_t pat_lens[] = {4, 16};
+
+    uint8_t *buf = (uint8_t *)malloc(MAX_CHUNK);
+    if (!buf)
+    {
+        fprintf(stderr, "内存不足。\n");
+        ++g_errors;
+        return;
+    }
+    for (size_t i = 0; i < MAX_CHUNK; ++i)
+        buf[i] = (uint8_t)i;
+
+    SampleFn fns[3] = {sample_push, sample_pop, sample_peek};
+    const char *ops[3] = {"push", "pop", "peek"};
+    for (size_t ci = 0; ci < ncaps; ++ci)
+    {
+        size_t cap = caps[ci];
+        for (int mode = 0; mode < 3; ++mode)
+        {
+            RingBuf rb;
+            if (!init_mode(&rb, mode, cap))
+                continue;
+            // 先把整块内存写一遍：缺页不算进测量，search 也需要“不含模式”的数据
+            uint32_t seed = 2463534242u;
+            for (size_t i = 0; i < cap; ++i)
+                rb.data[i] = (uint8_t)(xorshift(&seed) & 0x7F);
+
+            for (size_t k = 0; k < nchunks; ++k)
+            {
+                size_t chunk = chunks[k];
+                if (chunk > cap)
+                    break;
+                for (int p = 0; p < 3; ++p)
+                {
+                    if (p == PAT_STRADDLE && chunk < 2)
+                        continue; // 1 字节跨不了界
+                    if (p == PAT_OFFSET1 && chunk == cap)
+                        continue; // 满环操作，与 straddle 重复
+                    for (int o = 0; o < 3; ++o)
+                    {
+                        RbCtx x = {&rb, chunk, (WrapPat)p, 0, 0, 0, buf, NULL};
+                        plan(&x, cap);
+                        rb_seek(&rb, start_pos(cap, chunk, (WrapPat)p));
+                        if (fns[o] == sample_peek)
+                            rb_write_commit(&rb, cap);
+                        Case c = {"rb", ops[o], k_mode_names[mode], cap, chunk, k_pat_names[p], (double)chunk};
+                        run_case(&c, fns[o], &x);
+                    }
+                }
+            }
+
+            for (size_t k = 0; k < sizeof(pat_lens) / sizeof(pat_lens[0]); ++k)
+            {
+                if (pat_lens[k] > cap)
+                    continue;
+                for (int p = PAT_ALIGNED; p <= PAT_STRADDLE; p += PAT_STRADDLE)
+                {
+                    RbCtx x = {&rb, pat_lens[k], (WrapPat)p, 0, 1, 0, buf, pat};
+                    x.ops = (SAMPLE_BYTES / cap) ? SAMPLE_BYTES / cap : 1;
+                    rb_seek(&rb, p == PAT_STRADDLE ? cap / 2 : 0);
+                    rb_write_commit(&rb, cap);
+                    Case c = {"rb", "search", k_mode_names[mode], cap, pat_lens[k], k_pat_names[p], (double)cap};
+                    run_case(&c, sample_search, &x);
+                }
+            }
+            rb_free(&rb);
+        }
+    }
+    free(buf);
+}
+
+/* ---------------- spsc：跨线程生产者/消费者 ---------------- */
+
+typedef struct
+{
+    RingBufSpsc *rb;
+    size_t chunk;
+    uint64_t total;
+    const uint8_t *src; // 0..255 循环，长 256 + chunk：从 src + (pos & 0xFF) 取就是流位置的低 8 位
+} Producer;
+
+static void producer_run(Producer *p)
+{
+    uint64_t pos = 0;
+    while (pos < p->total)
+    {
+        size_t n = (p->total - pos < p->chunk) ? (size_t)(p->total - pos) : p->chunk;
+        size_t w = rbs_push(p->rb, p->src + (pos & 0xFF), n);
+        pos += w;
+        if (w < n)
+            bench_yield(); // 满了：让消费者跑
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI producer_thread(LPVOID arg)
+{
+    producer_run((Producer *)arg);
+    return 0;
+}
+#else
+static void *producer_thread(void *arg)
+{
+    producer_run((Producer *)arg);
+    return NULL;
+}
+#endif
+
+static void spsc_case(size_t cap, size_t chunk, bool mirror, const uint8_t *src, uint8_t *dst)
+{
+    RingBufSpsc rb;
+    if (mirror ? !rbs_init_mirror(&rb, cap) : !rbs_init(&rb, cap))
+        return;
+    if (rbs_capacity(&rb) != cap)
+    {
+        rbs_free(&rb);
+        return;
+    }
+    // 第一个样本算预热，不计
+    Producer p = {&rb, chunk, (uint64_t)(g_samples + 1) * SPSC_SAMPLE_BYTES, src};
+#ifdef _WIN32
+    HANDLE th = CreateThread(NULL, 0, producer_thread, &p, 0, NULL);
+    bool ok = (th != NULL);
+#else
+    pthread_t th;
+    bool ok = (pthread_create(&th, NULL, producer_thread, &p) == 0);
+#endif
+    if (!ok)
+    {
+        fprintf(stderr, "创建生产者线程失败。\n");
+        ++g_errors;
+        rbs_free(&rb);
+        return;
+    }
+
+    g_s.n = 0;
+    uint64_t pos = 0, mark = SPSC_SAMPLE_BYTES, seg = 0;
+    bool bad = false, warm = true;
+    double t_last = now_ns();
+    while (pos < p.total)
+    {
+        size_t got = rbs_pop(&rb, dst, chunk);
+        if (got == 0)
+        {
+            rbs_wait_readable(&rb, 1, 100);
+            continue;
+        }
+        if (dst[0] != (uint8_t)pos || dst[got - 1] != (uint8_t)(pos + got - 1))
+            bad = true;
+        pos += got;
+        seg += got;
+        if (pos >= mark)
+        {
+            double t = now_ns();
+            if (!warm && g_s.n < MAX_SAMPLES)
+                g_s.v[g_s.n++] = (t - t_last) * (double)chunk / (double)seg; // 折算成整块 pop 的耗时
+            warm = false;
+            t_last = t;
+            seg = 0;
+            mark += SPSC_SAMPLE_BYTES;
+        }
+    }
+#ifdef _WIN32
+    WaitForSingleObject(th, INFINITE);
+    CloseHandle(th);
+#else
+    pthread_join(th, NULL);
+#endif
+    rbs_free(&rb);
+    if (bad)
+    {
+        fprintf(stderr, "spsc: cap=%zu chunk=%zu 字节序错误！\n", cap, chunk);
+        ++g_errors;
+    }
+    Case c = {"spsc", "stream", mirror ? "mirror" : "pow2", cap, chunk, "xthread", (double)chunk};
+    report(&c, &g_s);
+}
+
+static void suite_spsc(void)
+{
+    static const size_t caps[] = {4096, 64u << 10, 1u << 20};
+    static const size_t chunks[] = {16, 256, 4096};
+    uint8_t *src = (uint8_t *)malloc(256 + MAX_CHUNK);
+    uint8_t *dst = (uint8_t *)malloc(MAX_CHUNK);
+    if (!src || !dst)
+    {
+        fprintf(stderr, "内存不足。\n");
+        ++g_errors;
+        free(src);
+        free(dst);
+        return;
+    }
+    for (size_t i = 0; i < 256 + MAX_CHUNK; ++i)
+        src[i] = (uint8_t)i;
+    for (size_t ci = 0; ci < sizeof(caps) / sizeof(caps[0]); ++ci)
+        for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k)
+        {
+            if (chunks[k] > caps[ci] / 2)
+                continue;
+            spsc_case(caps[ci], chunks[k], false, src, dst);
+            spsc_case(caps[ci], chunks[k], true, src, dst);
+        }
+    free(src);
+    free(dst);
+}
+
+/* ---------------- parser：frame_parser 喂合成噪声流 ---------------- */
+
+// 合成流：8~200 字节的帧之间插入随机噪声，噪声约占 noise_pct% 的字节；frames 返回完整帧数
+static uint8_t *make_proto_stream(const ProtoDesc *d, unsigned noise_pct, size_t n, size_t *frames)
+{
+    uint8_t *p = (uint8_t *)malloc(n);
+    if (!p)
+        return NULL;
+    uint8_t body[256], enc[2 * PROTO_MAX_FRAME + 2];
+    uint32_t x = 0x9E3779B9u;
+    size_t i = 0;
+    *frames = 0;
+    while (i < n)
+    {
+        size_t len = 8 + xorshift(&x) % 193;
+        for (size_t k = 0; k < len; ++k)
+            body[k] = (uint8_t)xorshift(&x);
+        size_t m = proto_encode(d, body, len, enc, sizeof(enc));
+        if (m == 0 || i + m > n)
+            break;
+        memcpy(p + i, enc, m);
+        i += m;
+        ++*frames;
+        size_t noise = noise_pct ? m * noise_pct / (100 - noise_pct) : 0;
+        noise = noise / 2 + xorshift(&x) % (noise + 1); // 平均值不变，长度有起伏
+        for (size_t k = 0; k < noise && i < n; ++k)
+            p[i++] = (uint8_t)xorshift(&x);
+    }
+    memset(p + i, 0, n - i);
+    return p;
+}
+
+typedef struct
+{
+    FrameParser *fp;
+    const uint8_t *stream;
+    size_t n;
+    size_t pos;
+    size_t chunk;
+} FeedCtx;
+
+static double sample_feed(void *arg)
+{
+    FeedCtx *x = (FeedCtx *)arg;
+    size_t fed = 0;
+    double t0 = now_ns();
+    while (fed < PARSER_SAMPLE_BYTES)
+    {
+        size_t k = x->n - x->pos < x->chunk ? x->n - x->pos : x->chunk;
+        g_sink += fp_feed(x->fp, x->stream + x->pos, k);
+        fed += k;
+        if ((x->pos += k) == x->n)
+            x->pos = 0; // 回到开头（接缝处最多丢一帧，可忽略）
+    }
+    return (now_ns() - t0) * (double)x->chunk / (double)fed;
+}
+
+static void suite_parser(void)
+{
+    static const char *const protos[] = {"aa55", "aa55-le16-crc16", "aa55-le16-crc32", "cobs-crc32", "slip-crc16"};
+    static const unsigned noises[] = {0, 50, 90};
+    static const char *const noise_names[] = {"noise0", "noise50", "noise90"};
+    static const size_t chunks[] = {1, 64, 4096};
+    size_t n = g_quick ? (1u << 20) : (4u << 20);
+    static FrameParser fp; // 带 PROTO_MAX_FRAME 缓冲，别放栈上
+
+    for (size_t pi = 0; pi < sizeof(protos) / sizeof(protos[0]); ++pi)
+    {
+        ProtoDesc d;
+        if (!proto_builtin(protos[pi], &d))
+            continue;
+        for (size_t ni = 0; ni < sizeof(noises) / sizeof(noises[0]); ++ni)
+        {
+            size_t frames = 0;
+            uint8_t *stream = make_proto_stream(&d, noises[ni], n, &frames);
+            if (!stream)
+            {
+                fprintf(stderr, "内存不足。\n");
+                ++g_errors;
+                return;
+            }
+            // 没有噪声时解析结果必须与生成的帧数一致，否则测出来的数字没有意义
+            fp_init(&fp, NULL, NULL);
+            fp_set_proto(&fp, &d);
+            fp_feed(&fp, stream, n);
+            if (noises[ni] == 0 && fp.frames != frames)
+            {
+                fprintf(stderr, "parser: %s 解析出 %llu 帧，应为 %zu\n", protos[pi], (unsigned long long)fp.frames,
+                        frames);
+                ++g_errors;
+            }
+            for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k)
+            {
+                fp_init(&fp, NULL, NULL);
+                fp_set_proto(&fp, &d);
+                FeedCtx x = {&fp, stream, n, 0, chunks[k]};
+                Case c = {"parser", "feed", protos[pi], 0, chunks[k], noise_names[ni], (double)chunks[k]};
+                run_case(&c, sample_feed, &x);
+            }
+            free(stream);
+        }
+    }
+}
+
+/* ---------------- lat：单向延迟与线程配置 ---------------- */
+
+typedef struct
+{
+    double t_ns; // 推入前一刻的时间戳
+    uint64_t seq;
+} LatMsg;
+
+typedef struct
+{
+    RingBufSpsc *rb;
+    size_t total;
+    SptConfig cfg;
+    atomic_int ready; // 0 未就绪；1 配置生效；-1 配置失败（err）
+    size_t full;      // 推不进去的消息（4 MiB 的环不该满）
+    char err[128];
+} LatProducer;
+
+static atomic_bool g_load_run;
+
+static void lat_producer_run(LatProducer *p)
+{
+    if (!spt_apply_self(&p->cfg, p->err, sizeof(p->err)))
+    {
+        atomic_store(&p->ready, -1);
+        return;
+    }
+    atomic_store(&p->ready, 1);
+    double t = now_ns();
+    for (size_t i = 0; i < p->total; ++i)
+    {
+        t += LAT_GAP_NS;
+        sleep_until_ns(t);
+        LatMsg m = {now_ns(), i};
+        if (rbs_push(p->rb, &m, sizeof(m)) != sizeof(m))
+            ++p->full;
+    }
+}
+
+static void load_run(void)
+{
+    uint32_t x = 1;
+    while (atomic_load_explicit(&g_load_run, memory_order_relaxed))
+        for (int i = 0; i < 1000; ++i)
+            g_sink += xorshift(&x);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI lat_producer_thread(LPVOID arg)
+{
+    lat_producer_run((LatProducer *)arg);
+    return 0;
+}
+static DWORD WINAPI load_thread(LPVOID arg)
+{
+    (void)arg;
+    load_run();
+    return 0;
+}
+#else
+static void *lat_producer_thread(void *arg)
+{
+    lat_producer_run((LatProducer *)arg);
+    return NULL;
+}
+static void *load_thread(void *arg)
+{
+    (void)arg;
+    load_run();
+    return NULL;
+}
+#endif
+
+// 一种线程配置 × 一种环内存：消费者（本线程）配 cons，生产者线程配 prod
+static void lat_case(bool huge, const char *pattern, const SptConfig *prod, const SptConfig *cons)
+{
+    RingBufSpsc rb;
+    if (huge ? !rbs_init_huge(&rb, LAT_CAP) : !rbs_init(&rb, LAT_CAP))
+    {
+        fprintf(stderr, "lat: 环初始化失败。\n");
+        ++g_errors;
+        return;
+    }
+    const char *mode = rb.huge == RB_VM_HUGE_EXPLICIT ? "hugetlb" : rb.huge == RB_VM_HUGE_THP ? "thp" : "pow2";
+    if (huge && !rb.huge)
+    {
+        rbs_free(&rb);
+        return; // 大页不可用：与普通内存那一组重复（suite_lat 已说明）
+    }
+    char err[128] = {0};
+    if (!spt_apply_self(cons, err, sizeof(err)))
+    {
+        fprintf(stderr, "lat: 跳过 %s/%s：%s\n", mode, pattern, err);
+        rbs_free(&rb);
+        return;
+    }
+    size_t n = g_quick ? LAT_MSGS / 4 : LAT_MSGS;
+    LatProducer p = {&rb, n + LAT_WARM, *prod, 0, 0, {0}};
+#ifdef _WIN32
+    HANDLE th = CreateThread(NULL, 0, lat_producer_thread, &p, 0, NULL);
+    bool ok = (th != NULL);
+#else
+    pthread_t th;
+    bool ok = (pthread_create(&th, NULL, lat_producer_thread, &p) == 0);
+#endif
+    if (ok)
+    {
+        g_s.n = 0;
+        uint64_t next = 0;
+        bool bad = false;
+        while (next < p.total && atomic_load(&p.ready) >= 0)
+        {
+            LatMsg m;
+            if (rbs_pop(&rb, &m, sizeof(m)) != sizeof(m))
+            {
+                rbs_wait_readable(&rb, sizeof(m), 100);
+                continue;
+            }
+            double lat = now_ns() - m.t_ns;
+            bad |= (m.seq != next);
+            if (next++ >= LAT_WARM && g_s.n < SAMPLES_CAP)
+                g_s.v[g_s.n++] = lat;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(th, INFINITE);
+        CloseHandle(th);
+#else
+        pthread_join(th, NULL);
+#endif
+        if (atomic_load(&p.ready) < 0)
+            fprintf(stderr, "lat: 跳过 %s/%s：%s\n", mode, pattern, p.err);
+        else
+        {
+            if (bad || p.full)
+            {
+                fprintf(stderr, "lat: %s/%s 消息序号错误或环满！\n", mode, pattern);
+                ++g_errors;
+            }
+            Case c = {"lat", "oneway", mode, LAT_CAP, sizeof(LatMsg), pattern, 0};
+            report(&c, &g_s);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "创建生产者线程失败。\n");
+        ++g_errors;
+    }
+    SptConfig def;
+    spt_default_config(&def);
+    spt_apply_self(&def, NULL, 0); // 本线程回到普通配置，后面的用例不受影响
+    rbs_free(&rb);
+}
+
+static void suite_lat(void)
+{
+    int ncpu = spt_cpu_count();
+    // 默认避开 CPU 0（多数系统的中断、定时器落在那里）
+    int pc = g_cpu_prod >= 0 ? g_cpu_prod : (ncpu >= 3 ? 1 : 0);
+    int cc = g_cpu_cons >= 0 ? g_cpu_cons : (ncpu >= 3 ? 2 : 1);
+    bool can_pin = ncpu >= 2 && pc != cc;
+    size_t hp = rb_vm_huge_page_size();
+    size_t probe = LAT_CAP;
+    RbVmHuge kind = RB_VM_HUGE_NONE;
+    void *mem = hp ? rb_vm_map_huge(&probe, &kind) : NULL;
+    if (mem)
+        rb_vm_unmap_huge(mem, probe);
+    if (g_fmt == OUT_TEXT)
+        printf("lat: %d 个逻辑 CPU，背景负载 %d 线程，大页 %s\n", ncpu, g_load,
+               kind == RB_VM_HUGE_EXPLICIT ? "hugetlb" : kind == RB_VM_HUGE_THP ? "透明大页" : "不可用");
+    if (!can_pin)
+        fprintf(stderr, "lat: 需要 2 个不同的逻辑 CPU，跳过 pinned / pin+rt\n");
+    else if (g_fmt == OUT_TEXT)
+        printf("lat: pinned 生产者 CPU %d / 消费者 CPU %d\n", pc, cc);
+
+#ifdef _WIN32
+    HANDLE load[MAX_LOAD];
+#else
+    pthread_t load[MAX_LOAD];
+#endif
+    int nload = 0;
+    atomic_store(&g_load_run, true);
+    for (; nload < g_load && nload < MAX_LOAD; ++nload)
+    {
+#ifdef _WIN32
+        load[nload] = CreateThread(NULL, 0, load_thread, NULL, 0, NULL);
+        if (!load[nload])
+            break;
+#else
+        if (pthread_create(&load[nload], NULL, load_thread, NULL) != 0)
+            break;
+#endif
+    }
+
+    SptConfig def, rt, pin_p, pin_c, pinrt_p, pinrt_c;
+    spt_default_config(&def);
+    rt = def;
+    rt.prio = SPT_REALTIME;
+    pin_p = pin_c = def;
+    pin_p.cpu = pc;
+    pin_c.cpu = cc;
+    pinrt_p = pin_p;
+    pinrt_c = pin_c;
+    pinrt_p.prio = pinrt_c.prio = SPT_REALTIME;
+    for (int huge = 0; huge < 2; ++huge)
+    {
+        if (huge && !mem)
+        {
+            fprintf(stderr, "lat: 大页不可用（没有预留大页，透明大页也关着），跳过大页一组\n");
+            break;
+        }
+        lat_case(huge, "default", &def, &def);
+        lat_case(huge, "rt", &rt, &rt);
+        if (!can_pin)
+            continue;
+        lat_case(huge, "pinned", &pin_p, &pin_c);
+        lat_case(huge, "pin+rt", &pinrt_p, &pinrt_c);
+    }
+
+    atomic_store(&g_load_run, false);
+    for (int i = 0; i < nload; ++i)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(load[i], INFINITE);
+        CloseHandle(load[i]);
+#else
+        pthread_join(load[i], NULL);
+#endif
+    }
+}
+
+/* ---------------- 主体 ---------------- */
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "用法：rb_bench [--csv | --json] [--quick] [--suite rb|spsc|parser|lat]... [--samples N] [--budget-ms N]\n"
+            "               [--load N] [--cpus P,C]\n"
+            "  --csv / --json   机器可读输出（默认对齐的文本表）\n"
+            "  --quick          少测几种容量/块大小，样本减到 31 个\n"
+            "  --suite S        只跑指定的组（可重复；默认全部）\n"
+            "  --samples N      每个用例最多 N 个样本（默认 101，上限 %d）\n"
+            "  --budget-ms N    每个用例最多跑 N 毫秒（默认 200，至少取 %d 个样本）\n"
+            "  --load N         lat：另起 N 个忙等线程模拟机器负载（默认 0，上限 %d）\n"
+            "  --cpus P,C       lat：pinned 配置的生产者 / 消费者 CPU（默认 1,2，不足 3 个 CPU 时 0,1）\n",
+            MAX_SAMPLES, MIN_SAMPLES, MAX_LOAD);
+}
+
+int main(int argc, char **argv)
+{
+    bool run_rb = false, run_spsc = false, run_parser = false, run_lat = false, any = false;
+    long samples = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--csv"))
+            g_fmt = OUT_CSV;
+        else if (!strcmp(argv[i], "--json"))
+            g_fmt = OUT_JSON;
+        else if (!strcmp(argv[i], "--quick"))
+            g_quick = true;
+        else if (!strcmp(argv[i], "--suite") && i + 1 < argc)
+        {
+            const char *s = argv[++i];
+            any = true;
+            if (!strcmp(s, "rb"))
+                run_rb = true;
+            else if (!strcmp(s, "spsc"))
+                run_spsc = true;
+            else if (!strcmp(s, "parser"))
+                run_parser = true;
+            else if (!strcmp(s, "lat"))
+                run_lat = true;
+            else
+            {
+                usage();
+                return 2;
+            }
+        }
+        else if (!strcmp(argv[i], "--samples") && i + 1 < argc)
+            samples = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--budget-ms") && i + 1 < argc)
+            g_budget_ns = atof(argv[++i]) * 1e6;
+        else if (!strcmp(argv[i], "--load") && i + 1 < argc)
+            g_load = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cpus") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%d,%d", &g_cpu_prod, &g_cpu_cons) != 2 || g_cpu_prod < 0 || g_cpu_cons < 0)
+            {
+                usage();
+                return 2;
+            }
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!any)
+        run_rb = run_spsc = run_parser = run_lat = true;
+    if (samples <= 0)
+        samples = g_quick ? 31 : 101;
+    g_samples = (samples < MIN_SAMPLES) ? MIN_SAMPLES : (samples > MAX_SAMPLES) ? MAX_SAMPLES : (size_t)samples;
+    crc_init();
+
+    if (g_fmt == OUT_JSON)
+    {
+        char date[32];
+        time_t t = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+        printf("{\n  \"tool\": \"rb_bench\",\n  \"schema\": 1,\n  \"date\": \"%s\",\n  \"quick\": %s,\n"
+               "  \"max_samples\": %zu,\n  \"budget_ms\": %.0f,\n  \"crc32c_hw\": %d,\n  \"load\": %d,\n"
+               "  \"results\": [",
+               date, g_quick ? "true" : "false", g_samples, g_budget_ns / 1e6, crc32c_hw(), g_load);
+    }
+    else if (g_fmt == OUT_TEXT)
+        printf("rb_bench: samples<=%zu budget=%.0f ms/case%s\n", g_samples, g_budget_ns / 1e6,
+               g_quick ? " (quick)" : "");
+
+    if (run_rb)
+        suite_rb();
+    if (run_spsc)
+        suite_spsc();
+    if (run_parser)
+        suite_parser();
+    if (run_lat)
+        suite_lat();
+
+    if (g_fmt == OUT_JSON)
+        printf("\n  ],\n  \"errors\": %d\n}\n", g_errors);
+    return g_errors ? 1 : 0;
+}
@@ -1,4 +1,7 @@
 #include "ringbuf.h"
+#include "ringbuf_vm.h"
+#include "ringbuf_find.h"
+#include "hex_codec.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -8,10 +11,26 @@ static inline size_t rb_mod(size_t x, size_t cap) {
     return (cap == 0) ? 0 : (x % cap);
 }
 
+/* 计数器 -> 真实下标：2的幂模式用位与，否则取模 */
+static inline size_t rb_idx(const RingBuf *rb, size_t x) {
+    return rb->mask ? (x & rb->mask) : rb_mod(x, rb->cap);
+}
+
+/* 计数器前进n：2的幂模式自由增长（回绕由&mask处理），否则回到[0,cap) */
+static inline size_t rb_adv(const RingBuf *rb, size_t x, size_t n) {
+    return rb->mask ? (x + n) : rb_mod(x + n, rb->cap);
+}
+
+/* 从真实下标start起、最多n字节中连续的那一段长度（镜像模式下整段都连续） */
+static inline size_t rb_contig(const RingBuf *rb, size_t start, size_t n) {
+    if (rb->mirror) return n;
+    size_t first = rb->cap - start;
+    return (first > n) ? n : first;
+}
+
 /* 从 head 出发的第 logical_index 个字节（不越界时使用） */
 static inline uint8_t rb_at(const RingBuf *rb, size_t logical_index) {
-    size_t idx = rb_mod(rb->head + logical_index, rb->cap);
-    return rb->data[idx];
+    return rb->data[rb_idx(rb, rb->head + logical_index)];
 }
 
 bool rb_init(RingBuf *rb, size_t capacity) {
@@ -22,16 +41,45 @@ bool rb_init(RingBuf *rb, size_t capacity) {
     rb->head = 0;
     rb->tail = 0;
     rb->size = 0;
+    rb->mask = 0;
+    rb->mirror = false;
+    return true;
+}
+
+bool rb_init_pow2(RingBuf *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = 1;
+    while (cap < capacity) {
+        if (cap > ((size_t)-1 >> 1)) return false; // 取整后溢出
+        cap <<= 1;
+    }
+    if (!rb_init(rb, cap)) return false;
+    rb->mask = cap - 1;
+    return true;
+}
+
+bool rb_init_mirror(RingBuf *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = capacity;
+    uint8_t *mem = (uint8_t*)rb_vm_map_mirror(&cap);
+    if (!mem) return false;
+    rb->data = mem;
+    rb->cap  = cap;
+    rb->head = rb->tail = rb->size = 0;
+    rb->mask = cap - 1; // 镜像大小总是2的幂
+    rb->mirror = true;
     return true;
 }
 
 void rb_free(RingBuf *rb) {
     if (!rb) return;
     if (rb->data) {
-        free(rb->data);
+        if (rb->mirror) rb_vm_unmap_mirror(rb->data, rb->cap);
+        else            free(rb->data);
         rb->data = NULL;
     }
-    rb->cap = rb->head = rb->tail = rb->size = 0;
+    rb->cap = rb->head = rb->tail = rb->size = rb->mask = 0;
+    rb->mirror = false;
 }
 
 void rb_clear(RingBuf *rb) {
@@ -54,10 +102,10 @@ size_t rb_push(RingBuf *rb, const void *src, size_t n) {
 
     const uint8_t *p = (const uint8_t*)src;
 
-    // 第一段：从tail到数组末尾
-    size_t first = rb->cap - rb->tail;
-    if (first > n) first = n;
-    memcpy(&rb->data[rb->tail], p, first);
+    // 第一段：从tail到数组末尾（镜像模式下就是全部）
+    size_t start = rb_idx(rb, rb->tail);
+    size_t first = rb_contig(rb, start, n);
+    memcpy(&rb->data[start], p, first);
 
     // 第二段：从0开始
     size_t second = n - first;
@@ -65,7 +113,7 @@ size_t rb_push(RingBuf *rb, const void *src, size_t n) {
         memcpy(&rb->data[0], p + first, second);
     }
 
-    rb->tail = rb_mod(rb->tail + n, rb->cap);
+    rb->tail = rb_adv(rb, rb->tail, n);
     rb->size += n;
     return n;
 }
@@ -79,10 +127,10 @@ size_t rb_pop(RingBuf *rb, void *dst, size_t n) {
 
     uint8_t *p = (uint8_t*)dst;
 
-    // 第一段：从head到数组末尾
-    size_t first = rb->cap - rb->head;
-    if (first > n) first = n;
-    memcpy(p, &rb->data[rb->head], first);
+    // 第一段：从head到数组末尾（镜像模式下就是全部）
+    size_t start = rb_idx(rb, rb->head);
+    size_t first = rb_contig(rb, start, n);
+    memcpy(p, &rb->data[start], first);
 
     // 第二段：从0开始
     size_t second = n - first;
@@ -90,11 +138,90 @@ size_t rb_pop(RingBuf *rb, void *dst, size_t n) {
         memcpy(p + first, &rb->data[0], second);
     }
 
-    rb->head = rb_mod(rb->head + n, rb->cap);
+    rb->head = rb_adv(rb, rb->head, n);
+    rb->size -= n;
+    return n;
+}
+
+size_t rb_push_overwrite(RingBuf *rb, const void *src, size_t n, size_t *dropped) {
+    if (dropped) *dropped = 0;
+    if (!rb || !rb->data || !src || n == 0) return 0;
+
+    const uint8_t *p = (const uint8_t*)src;
+    size_t lost = 0;
+    if (n > rb->cap) { // 只有最后cap字节能留下
+        lost = n - rb->cap;
+        p += lost;
+        n = rb->cap;
+    }
+
+    // 腾位置：直接推进head，不读被丢的数据
+    size_t free_bytes = rb_free_space(rb);
+    if (n > free_bytes) lost += rb_skip(rb, n - free_bytes);
+
+    rb_push(rb, p, n);
+    if (dropped) *dropped = lost;
+    return n;
+}
+
+size_t rb_skip(RingBuf *rb, size_t n) {
+    if (!rb || !rb->data) return 0;
+    if (n > rb->size) n = rb->size;
+    rb->head = rb_adv(rb, rb->head, n);
     rb->size -= n;
     return n;
 }
 
+size_t rb_write_reserve(RingBuf *rb, RbSpan spans[2]) {
+    if (!spans) return 0;
+    spans[0].ptr = spans[1].ptr = NULL;
+    spans[0].len = spans[1].len = 0;
+    if (!rb || !rb->data) return 0;
+
+    size_t free_bytes = rb_free_space(rb);
+    if (free_bytes == 0) return 0;
+
+    size_t start = rb_idx(rb, rb->tail);
+    size_t first = rb_contig(rb, start, free_bytes);
+    spans[0].ptr = &rb->data[start];
+    spans[0].len = first;
+    if (free_bytes > first) {
+        spans[1].ptr = &rb->data[0];
+        spans[1].len = free_bytes - first;
+    }
+    return free_bytes;
+}
+
+size_t rb_write_commit(RingBuf *rb, size_t n) {
+    if (!rb || !rb->data) return 0;
+    size_t free_bytes = rb_free_space(rb);
+    if (n > free_bytes) n = free_bytes;
+    rb->tail = rb_adv(rb, rb->tail, n);
+    rb->size += n;
+    return n;
+}
+
+size_t rb_read_peek_spans(const RingBuf *rb, RbSpan spans[2]) {
+    if (!spans) return 0;
+    spans[0].ptr = spans[1].ptr = NULL;
+    spans[0].len = spans[1].len = 0;
+    if (!rb || !rb->data || rb->size == 0) return 0;
+
+    size_t start = rb_idx(rb, rb->head);
+    size_t first = rb_contig(rb, start, rb->size);
+    spans[0].ptr = &rb->data[start];
+    spans[0].len = first;
+    if (rb->size > first) {
+        spans[1].ptr = &rb->data[0];
+        spans[1].len = rb->size - first;
+    }
+    return rb->size;
+}
+
+size_t rb_read_consume(RingBuf *rb, size_t n) {
+    return rb_skip(rb, n);
+}
+
 size_t rb_peek(const RingBuf *rb, void *dst, size_t n, size_t offset) {
     if (!rb || !rb->data || !dst) return 0;
     if (offset >= rb->size) return 0; // 起点越界，没得看
@@ -103,11 +230,10 @@ size_t rb_peek(const RingBuf *rb, void *dst, size_t n, size_t offset) {
     if (n > remain) n = remain;
 
     uint8_t *p = (uint8_t*)dst;
-    size_t start = rb_mod(rb->head + offset, rb->cap);
+    size_t start = rb_idx(rb, rb->head + offset);
 
     // 第一段
-    size_t first = rb->cap - start;
-    if (first > n) first = n;
+    size_t first = rb_contig(rb, start, n);
     memcpy(p, &rb->data[start], first);
 
     // 第二段
@@ -123,21 +249,13 @@ bool rb_search(const RingBuf *rb, const void *pattern, size_t m, size_t *out_ind
     if (m == 0) { if (out_index) *out_index = 0; return true; } // 空模式视为命中0
     if (m > rb->size) return false;
 
-    const uint8_t *pat = (const uint8_t*)pattern;
-    size_t limit = rb->size - m;
-
-    // 朴素匹配：稳定简单，够用
-    for (size_t pos = 0; pos <= limit; ++pos) {
-        size_t k = 0;
-        while (k < m && rb_at(rb, pos + k) == pat[k]) {
-            ++k;
-        }
-        if (k == m) {
-            if (out_index) *out_index = pos;
-            return true;
-        }
-    }
-    return false;
+    // 分段检索（SIMD/Horspool），跨接缝的命中由 rb_find_spans 处理；镜像模式下只有一段
+    RbSpan spans[2];
+    rb_read_peek_spans(rb, spans);
+    size_t idx = rb_find_spans(spans, (const uint8_t*)pattern, m);
+    if (idx == RB_FIND_NONE) return false;
+    if (out_index) *out_index = idx;
+    return true;
 }
 
 void rb_debug_dump(const RingBuf *rb, size_t max_bytes) {
@@ -145,9 +263,21 @@ void rb_debug_dump(const RingBuf *rb, size_t max_bytes) {
     printf("[cap=%zu size=%zu head=%zu tail=%zu] data: ",
            rb->cap, rb->size, rb->head, rb->tail);
     size_t n = (rb->size < max_bytes) ? rb->size : max_bytes;
-    for (size_t i = 0; i < n; ++i) {
-        printf("%02X ", rb_at(rb, i));
+    // 两段分别整块编码成 "XX " 再 fwrite，不逐字节 printf
+    char txt[HEX_SPACED_LEN(256)];
+    RbSpan spans[2];
+    rb_read_peek_spans(rb, spans);
+    for (int k = 0; k < 2 && n; ++k) {
+        const uint8_t *p = spans[k].ptr;
+        size_t m = spans[k].len < n ? spans[k].len : n;
+        n -= m;
+        while (m) {
+            size_t c = m < 256 ? m : 256;
+            fwrite(txt, 1, hex_encode_spaced(txt, p, c), stdout);
+            p += c;
+            m -= c;
+        }
     }
-    if (rb->size > n) printf("...");
+    if (rb->size > max_bytes) printf("...");
     printf("\n");
 }
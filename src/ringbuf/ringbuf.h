@@ -17,6 +17,10 @@
  * - push/pop 支持任意长度，自动分段拷贝（跨越“圈”时会分两段）
  * - peek 可以不移动读指针查看任意位置（从head起算的offset）
  * - search 能在缓冲区中检索目标字节序列（支持跨边界）
+ * - 零拷贝接口：reserve/commit 直接往 data 里写，peek_spans/consume 直接在 data 里读
+ * - 可选 2 的幂容量（rb_init_pow2）：用位与代替取模，head/tail 变为自由增长的计数器
+ * - 可选镜像映射（rb_init_mirror）：同一物理页映射两次，任何可读/可写区域都是一段连续内存
+ * - 存定长结构体（帧描述符、带时间戳的样本）而不是字节流时，用 ringbuf_typed.h 生成按元素类型的定长环
  */
 
 #include <stddef.h>
@@ -33,8 +37,16 @@ typedef struct {
     size_t   head;   // 读指针：下一个读出位置
     size_t   tail;   // 写指针：下一个写入位置
     size_t   size;   // 当前已用字节数
+    size_t   mask;   // 2的幂模式：cap-1，下标=计数器&mask；0表示普通取模模式
+    bool     mirror; // data 后面紧跟同一块内存的镜像（data[i]与data[i+cap]是同一字节）
 } RingBuf;
 
+/* 指向 RingBuf.data 内部的一段连续区域（零拷贝接口使用） */
+typedef struct {
+    uint8_t *ptr;    // 区域起点
+    size_t   len;    // 区域长度（0表示该段不存在）
+} RbSpan;
+
 /* ===== 基础管理 ===== */
 
 /**
@@ -45,6 +57,23 @@ typedef struct {
  */
 bool   rb_init(RingBuf *rb, size_t capacity);
 
+/**
+ * @brief 以2的幂容量初始化（capacity向上取整，例如 1000 -> 1024）
+ *        之后所有 rb_* 接口照常使用；内部下标用 &mask 计算，不再做整数取模，
+ *        head/tail 成为自由增长的计数器（真实下标 = head & mask）。
+ * @return true成功；false失败（capacity=0、过大或内存分配失败）
+ */
+bool   rb_init_pow2(RingBuf *rb, size_t capacity);
+
+/**
+ * @brief 以镜像映射内存初始化（Linux/macOS/Windows 主机）
+ *        capacity 向上取整为2的幂且不小于页大小（Windows 为 64 KiB 分配粒度），
+ *        同时启用2的幂模式。此后 push/pop/peek/search 都只做一段连续操作，
+ *        rb_read_peek_spans / rb_write_reserve 总是只给出 spans[0]。
+ * @return true成功；false失败（平台不支持或映射失败，可回退到 rb_init_pow2）
+ */
+bool   rb_init_mirror(RingBuf *rb, size_t capacity);
+
 /**
  * @brief 释放缓冲区（释放内存并清零结构体）
  */
@@ -80,6 +109,47 @@ size_t rb_push(RingBuf *rb, const void *src, size_t n);
  */
 size_t rb_pop (RingBuf *rb, void *dst, size_t n);
 
+/**
+ * @brief 覆盖式写入：空间不够时丢弃最旧数据（只推进head，被丢的字节不做任何拷贝）
+ *        n 超过容量时只保留 src 的最后 cap 字节
+ * @param dropped 可为NULL；返回丢弃的字节数（被挤掉的旧数据 + src 里放不下的前缀）
+ * @return 实际写入字节数（= min(n, cap)）
+ */
+size_t rb_push_overwrite(RingBuf *rb, const void *src, size_t n, size_t *dropped);
+
+/**
+ * @brief 丢弃最前面的n字节（只推进head，O(1)）
+ * @return 实际丢弃字节数（n超过已用大小时截断）
+ */
+size_t rb_skip(RingBuf *rb, size_t n);
+
+/* ===== 零拷贝：直接在 data 内部读写 ===== */
+
+/**
+ * @brief 预留可写空间（不移动tail）：给出最多两段连续区域
+ *        spans[0] 从tail到数组末尾，spans[1] 从数组开头起（不需要时len=0；镜像模式下恒为0）
+ * @return 两段总长度（即剩余空间）；调用方写入后用 rb_write_commit 提交
+ */
+size_t rb_write_reserve(RingBuf *rb, RbSpan spans[2]);
+
+/**
+ * @brief 提交写入：把已写进预留区域的前n字节计入缓冲（按spans[0]、spans[1]顺序）
+ * @return 实际提交字节数（n超过剩余空间时截断）
+ */
+size_t rb_write_commit(RingBuf *rb, size_t n);
+
+/**
+ * @brief 查看当前可读数据所在的最多两段连续区域（不移动head）
+ * @return 两段总长度（即已用大小）；处理完用 rb_read_consume 释放
+ */
+size_t rb_read_peek_spans(const RingBuf *rb, RbSpan spans[2]);
+
+/**
+ * @brief 消费最前面的n字节（与 rb_skip 相同，和 peek_spans 配对使用）
+ * @return 实际消费字节数（n超过已用大小时截断）
+ */
+size_t rb_read_consume(RingBuf *rb, size_t n);
+
 /* ===== 查看（不移动读指针） ===== */
 
 /**
@@ -96,7 +166,8 @@ size_t rb_peek(const RingBuf *rb, void *dst, size_t n, size_t offset);
  * @param out_index 若找到，返回逻辑起点（以head为0）
  * @return true找到；false未找到
  *
- * 说明：采用朴素匹配（简单稳定，够用）。数据量大/模式串长时可改KMP/Boyer-Moore。
+ * 说明：按连续段检索（首字节 SIMD 筛选 / 长模式用 Boyer-Moore-Horspool，见 ringbuf_find.h），
+ *       跨越数组末尾的命中单独验证，结果与逐字节朴素匹配完全一致。
  */
 bool   rb_search(const RingBuf *rb, const void *pattern, size_t m, size_t *out_index);
 
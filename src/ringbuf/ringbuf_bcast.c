@@ -0,0 +1,415 @@
+#include "ringbuf_bcast.h"
+#include "ringbuf_vm.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* --- 小工具：向上取整到2的幂（溢出返回0） --- */
+static size_t rbb_round_pow2(size_t x) {
+    size_t p = 1;
+    while (p < x) {
+        if (p > ((size_t)-1 >> 1)) return 0;
+        p <<= 1;
+    }
+    return p;
+}
+
+static inline bool rbb_valid_id(const RingBufBcast *rb, int id) {
+    return rb && rb->data && id >= 0 && id < RBB_MAX_READERS;
+}
+
+/* 从真实下标start起、最多n字节中连续的那一段长度（镜像模式下整段都连续） */
+static inline size_t rbb_contig(const RingBufBcast *rb, size_t start, size_t n) {
+    if (rb->mirror) return n;
+    size_t first = rb->cap - start;
+    return (first > n) ? n : first;
+}
+
+/* 把计数器pos起的n字节拆成最多两段（不检查越界） */
+static size_t rbb_fill_spans(const RingBufBcast *rb, size_t pos, size_t n, RbSpan spans[2]) {
+    size_t start = pos & rb->mask;
+    size_t first = rbb_contig(rb, start, n);
+    spans[0].ptr = &rb->data[start];
+    spans[0].len = first;
+    if (n > first) {
+        spans[1].ptr = &rb->data[0];
+        spans[1].len = n - first;
+    }
+    return n;
+}
+
+static void rbb_clear_spans(RbSpan spans[2]) {
+    spans[0].ptr = spans[1].ptr = NULL;
+    spans[0].len = spans[1].len = 0;
+}
+
+/*
+ * 读者落后的字节数：先读pos再读tail（pos总是<=tail）。
+ * DROP 读者的 pos 可能正被生产者推进，读到旧值时差值可能超过cap，截到cap即可。
+ */
+static inline size_t rbb_lag_of(const RingBufBcast *rb, int id) {
+    size_t p = atomic_load_explicit(&rb->cur[id].pos, memory_order_acquire);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t lag = t - p;
+    return (lag > rb->cap) ? rb->cap : lag;
+}
+
+static void rbb_setup(RingBufBcast *rb, uint8_t *mem, size_t cap, bool mirror) {
+    memset(rb->cur, 0, sizeof(rb->cur));
+    rb->data = mem;
+    rb->cap  = cap;
+    rb->mask = cap - 1;
+    rb->mirror = mirror;
+    atomic_init(&rb->tail, 0);
+    atomic_init(&rb->resv, 0);
+    atomic_init(&rb->readers, 0);
+    atomic_init(&rb->claimed, 0);
+    rb_ev_init(&rb->ev);
+    rb->notify = &rb->ev;
+}
+
+bool rbb_init(RingBufBcast *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = rbb_round_pow2(capacity);
+    if (cap == 0) return false;
+    uint8_t *mem = (uint8_t*)malloc(cap);
+    if (!mem) return false;
+    rbb_setup(rb, mem, cap, false);
+    return true;
+}
+
+bool rbb_init_mirror(RingBufBcast *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = capacity;
+    uint8_t *mem = (uint8_t*)rb_vm_map_mirror(&cap);
+    if (!mem) return false;
+    rbb_setup(rb, mem, cap, true);
+    return true;
+}
+
+void rbb_free(RingBufBcast *rb) {
+    if (!rb) return;
+    if (rb->data) {
+        if (rb->mirror) rb_vm_unmap_mirror(rb->data, rb->cap);
+        else            free(rb->data);
+        rb->data = NULL;
+    }
+    if (rb->notify) rb_ev_destroy(&rb->ev);
+    rb->notify = NULL;
+    rb->cap = rb->mask = 0;
+    rb->mirror = false;
+    atomic_store(&rb->tail, 0);
+    atomic_store(&rb->resv, 0);
+    atomic_store(&rb->readers, 0);
+    atomic_store(&rb->claimed, 0);
+}
+
+void rbb_set_notify(RingBufBcast *rb, RbEvent *ev) {
+    if (!rb) return;
+    rb->notify = ev ? ev : &rb->ev;
+}
+
+/* ===== 读者登记 ===== */
+
+int rbb_attach(RingBufBcast *rb, RbbPolicy policy, const char *name) {
+    if (!rb || !rb->data) return -1;
+
+    // 先占一个空槽（attach 可能来自多个线程）
+    unsigned c = atomic_load(&rb->claimed);
+    int id;
+    for (;;) {
+        for (id = 0; id < RBB_MAX_READERS && (c & (1u << id)); ++id) {}
+        if (id == RBB_MAX_READERS) return -1;
+        if (atomic_compare_exchange_weak(&rb->claimed, &c, c | (1u << id))) break;
+    }
+
+    RbbCursor *cu = &rb->cur[id];
+    atomic_store_explicit(&cu->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&cu->overruns, 0, memory_order_relaxed);
+    atomic_store_explicit(&cu->lag_max, 0, memory_order_relaxed);
+    cu->policy = policy;
+    cu->name = name ? name : "?";
+    atomic_store(&cu->pos, atomic_load(&rb->tail));
+
+    // 上线：之后开始的预留都会看到这个读者（seq_cst 与生产者发布 tail 后的栅栏配对）
+    atomic_fetch_or(&rb->readers, 1u << id);
+
+    // 上线前已经开始、没看到它的那次预留最多写到“现在的 tail 之后”，覆盖的是 tail-cap 之前的槽，
+    // 所以把 pos 挪到现在的 tail 就安全了；生产者若已把它（DROP）推得更靠前，就不往回挪
+    size_t t = atomic_load(&rb->tail);
+    size_t p = atomic_load(&cu->pos);
+    while ((ptrdiff_t)(t - p) > 0 &&
+           !atomic_compare_exchange_weak(&cu->pos, &p, t)) {}
+    cu->seen = atomic_load(&cu->pos);
+    return id;
+}
+
+void rbb_detach(RingBufBcast *rb, int id) {
+    if (!rbb_valid_id(rb, id)) return;
+    unsigned bit = 1u << id;
+    atomic_fetch_and(&rb->readers, ~bit);
+    atomic_fetch_and(&rb->claimed, ~bit);
+    rb_ev_signal(rb->notify); // 生产者可能正因为它而写不进去
+}
+
+/* ===== 生产者 ===== */
+
+size_t rbb_write_reserve(RingBufBcast *rb, RbSpan spans[2], size_t want) {
+    if (!spans) return 0;
+    rbb_clear_spans(spans);
+    if (!rb || !rb->data) return 0;
+    if (want == 0 || want > rb->cap) want = rb->cap;
+
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    unsigned act = atomic_load(&rb->readers);
+
+    // 第一遍：可写空间只看 BACKPRESSURE 读者；顺手记下每个读者的最大落后
+    size_t used = 0;
+    for (int i = 0; i < RBB_MAX_READERS; ++i) {
+        if (!(act & (1u << i))) continue;
+        RbbCursor *cu = &rb->cur[i];
+        size_t lag = t - atomic_load_explicit(&cu->pos, memory_order_acquire);
+        if (lag > rb->cap) lag = rb->cap; // 刚上线、pos 还是旧值
+        if (lag > atomic_load_explicit(&cu->lag_max, memory_order_relaxed))
+            atomic_store_explicit(&cu->lag_max, lag, memory_order_relaxed);
+        if (cu->policy == RBB_BACKPRESSURE && lag > used) used = lag;
+    }
+    size_t room = rb->cap - used;
+    if (room > want) room = want;
+    if (room == 0) return 0;
+
+    // 第二遍：写 room 字节会覆盖 [t+room-cap, …) 之前的槽，挡路的 DROP 读者推到那里
+    for (int i = 0; i < RBB_MAX_READERS; ++i) {
+        if (!(act & (1u << i))) continue;
+        RbbCursor *cu = &rb->cur[i];
+        if (cu->policy != RBB_DROP) continue;
+        size_t p = atomic_load_explicit(&cu->pos, memory_order_acquire);
+        for (;;) {
+            size_t lag = t - p;
+            if (lag > rb->cap) lag = rb->cap;
+            if (lag + room <= rb->cap) break;
+            size_t np = t + room - rb->cap;
+            // acq_rel：读者成功 consume（release）之前读的数据，排在我们覆盖之前
+            if (atomic_compare_exchange_weak_explicit(&cu->pos, &p, np,
+                                                      memory_order_acq_rel, memory_order_acquire)) {
+                atomic_fetch_add_explicit(&cu->dropped, np - p, memory_order_relaxed);
+                atomic_fetch_add_explicit(&cu->overruns, 1, memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    // 先发布预留位置再写数据（快照据此判断哪些槽正在被覆盖）。同 seqlock 的写端：
+    // release 栅栏只约束它之前的操作，挡不住后面的数据写被提前到 resv 之前，要用全栅栏
+    atomic_store_explicit(&rb->resv, t + room, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    return rbb_fill_spans(rb, t, room, spans);
+}
+
+size_t rbb_write_commit(RingBufBcast *rb, size_t n) {
+    if (!rb || !rb->data) return 0;
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t r = atomic_load_explicit(&rb->resv, memory_order_relaxed);
+    if (n > r - t) n = r - t; // 只能发布预留过的部分
+    if (n) {
+        atomic_store_explicit(&rb->tail, t + n, memory_order_release);
+        rb_ev_signal(rb->notify);
+    }
+    // 退回没写的预留（先发布 tail 再降 resv：快照看到的 resv 始终不小于 tail）
+    if (r != t + n) atomic_store_explicit(&rb->resv, t + n, memory_order_release);
+    return n;
+}
+
+size_t rbb_push(RingBufBcast *rb, const void *src, size_t n) {
+    if (!rb || !rb->data || !src || n == 0) return 0;
+    RbSpan sp[2];
+    size_t room = rbb_write_reserve(rb, sp, n);
+    if (room == 0) return 0;
+    memcpy(sp[0].ptr, src, sp[0].len);
+    if (sp[1].len) memcpy(sp[1].ptr, (const uint8_t*)src + sp[0].len, sp[1].len);
+    return rbb_write_commit(rb, room);
+}
+
+/* ===== 读者 ===== */
+
+/* 读者的可读区间 [p, p+used)：p 记进 seen，consume 从这里推进 */
+static size_t rbb_peek_range(RingBufBcast *rb, int id, size_t *pos) {
+    RbbCursor *cu = &rb->cur[id];
+    size_t p = atomic_load_explicit(&cu->pos, memory_order_acquire);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - p;
+    // pos 读得比 tail 早、这期间又被越过：先给最新的 cap 字节，consume 的 CAS 会发现
+    if (used > rb->cap) {
+        used = rb->cap;
+        p = t - used;
+    }
+    cu->seen = p;
+    *pos = p;
+    return used;
+}
+
+size_t rbb_peek_spans(RingBufBcast *rb, int id, RbSpan spans[2]) {
+    if (!spans) return 0;
+    rbb_clear_spans(spans);
+    if (!rbb_valid_id(rb, id)) return 0;
+    size_t p, used = rbb_peek_range(rb, id, &p);
+    if (used == 0) return 0;
+    return rbb_fill_spans(rb, p, used, spans);
+}
+
+bool rbb_consume(RingBufBcast *rb, int id, size_t n) {
+    if (!rbb_valid_id(rb, id)) return false;
+    RbbCursor *cu = &rb->cur[id];
+    size_t p = cu->seen;
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    if (n > t - p) n = t - p;
+    cu->seen = p + n; // 连续 consume 多次（每次一部分）也成立
+
+    if (cu->policy == RBB_BACKPRESSURE) {
+        // 生产者从不改 BACKPRESSURE 读者的 pos：数据读完再归还空间即可
+        atomic_store_explicit(&cu->pos, p + n, memory_order_release);
+        return true;
+    }
+    // DROP：pos 在 peek 之后被生产者推过，CAS 就会失败（这时 pos 已经是生产者给的新位置）
+    if (atomic_compare_exchange_strong_explicit(&cu->pos, &p, p + n,
+                                                memory_order_release, memory_order_relaxed))
+        return true;
+    cu->seen = p;
+    return false;
+}
+
+size_t rbb_skip(RingBufBcast *rb, int id, size_t n) {
+    if (!rbb_valid_id(rb, id)) return 0;
+    size_t p, used = rbb_peek_range(rb, id, &p);
+    if (n > used) n = used;
+    if (n) rbb_consume(rb, id, n); // 被越过也无妨：反正是要跳过的
+    return n;
+}
+
+size_t rbb_wait_readable(RingBufBcast *rb, int id, size_t min_bytes, int timeout_ms) {
+    if (!rbb_valid_id(rb, id)) return 0;
+    if (min_bytes == 0) min_bytes = 1;
+    if (min_bytes > rb->cap) min_bytes = rb->cap;
+    long long deadline = (timeout_ms > 0) ? rb_ev_now_ms() + timeout_ms : 0;
+
+    for (;;) {
+        size_t used = rbb_lag_of(rb, id);
+        if (used >= min_bytes || timeout_ms == 0) return used; // 快路径：不碰事件
+
+        // 先登记再复查：复查之后发布的数据一定会改变 seq
+        unsigned key = rb_ev_prepare(rb->notify);
+        used = rbb_lag_of(rb, id);
+        if (used >= min_bytes) {
+            rb_ev_cancel(rb->notify);
+            return used;
+        }
+        int wait_ms = -1;
+        if (timeout_ms > 0) {
+            long long left = deadline - rb_ev_now_ms();
+            if (left <= 0) {
+                rb_ev_cancel(rb->notify);
+                return used;
+            }
+            wait_ms = (int)left;
+        }
+        // 同 rbs_wait_readable：被叫醒但数据没变化（rbb_wake）时返回，让调用方检查外部状态
+        size_t before = used;
+        rb_ev_wait(rb->notify, key, wait_ms);
+        used = rbb_lag_of(rb, id);
+        if (used >= min_bytes || used == before) return used;
+    }
+}
+
+void rbb_wake(RingBufBcast *rb) {
+    if (rb && rb->notify) rb_ev_wake(rb->notify);
+}
+
+/* ===== 查询 ===== */
+
+size_t rbb_lag(const RingBufBcast *rb, int id) {
+    return rbb_valid_id(rb, id) ? rbb_lag_of(rb, id) : 0;
+}
+
+int rbb_slowest(const RingBufBcast *rb, size_t *lag) {
+    int who = -1;
+    size_t worst = 0;
+    if (rb && rb->data) {
+        unsigned act = atomic_load(&rb->readers);
+        for (int i = 0; i < RBB_MAX_READERS; ++i) {
+            if (!(act & (1u << i))) continue;
+            size_t l = rbb_lag_of(rb, i);
+            if (who < 0 || l > worst) { who = i; worst = l; }
+        }
+    }
+    if (lag) *lag = worst;
+    return who;
+}
+
+size_t rbb_capacity(const RingBufBcast *rb) { return rb ? rb->cap : 0; }
+
+size_t rbb_size(const RingBufBcast *rb) {
+    size_t lag;
+    rbb_slowest(rb, &lag);
+    return lag;
+}
+
+size_t rbb_free_space(const RingBufBcast *rb) {
+    if (!rb || !rb->data) return 0;
+    unsigned act = atomic_load(&rb->readers);
+    size_t used = 0;
+    for (int i = 0; i < RBB_MAX_READERS; ++i) {
+        if (!(act & (1u << i)) || rb->cur[i].policy != RBB_BACKPRESSURE) continue;
+        size_t l = rbb_lag_of(rb, i);
+        if (l > used) used = l;
+    }
+    return rb->cap - used;
+}
+
+/* ===== 快照 ===== */
+
+/* 从计数器pos对应的位置开始拷出n字节（自动分两段） */
+static void rbb_copy_out(const RingBufBcast *rb, size_t pos, uint8_t *p, size_t n) {
+    size_t start = pos & rb->mask;
+    size_t first = rbb_contig(rb, start, n);
+    memcpy(p, &rb->data[start], first);
+    if (n > first) {
+        memcpy(p + first, &rb->data[0], n - first);
+    }
+}
+
+size_t rbb_snapshot(const RingBufBcast *rb, void *dst, size_t n, size_t offset, bool latest, RbbSnapshot *snap) {
+    if (!rb || !rb->data || !dst || !snap) return 0;
+    memset(snap, 0, sizeof(*snap));
+
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t r = atomic_load_explicit(&rb->resv, memory_order_acquire);
+    // 环里还留着的：最近 cap 字节减去正在预留（可能正被覆盖）的部分；刚开始写不满 cap 时就是 t
+    size_t ahead = r - t;
+    size_t kept = ahead < rb->cap ? rb->cap - ahead : 0;
+    if (kept > t) kept = t;
+    snap->tail = t;
+    snap->resv2 = r;
+    if (offset >= kept) return 0;
+
+    size_t take = kept - offset < n ? kept - offset : n;
+    size_t start = latest ? t - offset - take : t - kept + offset;
+    rbb_copy_out(rb, start, (uint8_t*)dst, take);
+
+    // 复制的读操作排在重读 resv 之前。复制是普通 memcpy，与生产者的覆盖并发（seqlock 读端同样的良性竞争）：
+    // 读到新数据的字节一定落在下面算出的 lost 里，调用方丢掉这部分即可，不必把数据区做成原子读
+    atomic_thread_fence(memory_order_acquire);
+    size_t r2 = atomic_load_explicit(&rb->resv, memory_order_acquire);
+    // 位置 < r2-cap 的槽可能已被覆盖；都换成“落后 t 多少”再比较，计数器回绕时也成立
+    size_t ahead2 = r2 - t;
+    size_t back_ok = ahead2 < rb->cap ? rb->cap - ahead2 : 0; // 落后 t 不超过这么多的位置完好
+    size_t back_s = t - start;
+    size_t lost = back_s > back_ok ? back_s - back_ok : 0;
+    if (lost > take) lost = take;
+
+    snap->resv2 = r2;
+    snap->gen   = start / rb->cap;
+    snap->start = start;
+    snap->len   = take;
+    snap->lost  = lost;
+    snap->torn  = lost != 0;
+    return take;
+}
@@ -0,0 +1,217 @@
+#ifndef RINGBUF_BCAST_H
+#define RINGBUF_BCAST_H
+
+/*
+ * 单生产者/多消费者广播环（SPMC broadcast）：同一份字节流只写一次，
+ * 每个消费者（解析器、原始显示、日志、转发……）各有一个读游标，各读各的，互不影响。
+ *
+ * 与 RingBufSpsc 的区别：
+ * - 没有唯一的 head：每个读者一个自由增长的 pos（各占一条缓存行），数据只有一份，加读者不加内存也不加拷贝
+ * - 生产者预留空间时扫一遍在线读者，算出各自落后多少（同时记下每个读者的最大落后 lag_max）
+ * - 读者的策略决定它落后太多时怎么办：
+ *   RBB_BACKPRESSURE：生产者不覆盖它没读的数据，可写空间 = cap - 最慢的这类读者的落后量
+ *                     （生产者不等待，详见 rbs_push 的“满了怎么办”：写不下的部分由调用方丢弃/计数）
+ *   RBB_DROP：        生产者需要空间时直接把它的 pos（CAS）推到新数据之前，越过的字节计入它的 dropped；
+ *                     它永远拖不慢生产者，也拖不慢别的读者
+ * - 没有读者时生产者照写，环里始终保留最近 cap 字节（rbb_snapshot 可以看）
+ *
+ * DROP 读者的数据可能在 peek 之后、consume 之前被覆盖：rbb_consume 用 CAS 推进 pos，
+ * 失败就说明被越过了（pos 已被生产者改写），刚才读到的内容不可信，调用方应当丢弃/重置（如重置解析器）。
+ * consume 成功则刚才读到的字节在读取期间都完好（生产者要覆盖它们必须先 CAS 成功）。
+ *
+ * 线程约定：
+ * - 生产者（一个线程）：rbb_push / rbb_write_reserve / rbb_write_commit
+ * - 读者 id（同一时刻只由一个线程使用）：rbb_peek_spans / rbb_consume / rbb_skip / rbb_wait_readable
+ * - 任意线程：rbb_attach / rbb_detach（与生产者并发安全）/ rbb_lag / rbb_size / rbb_free_space
+ *           / rbb_slowest / rbb_capacity / rbb_snapshot / rbb_wake
+ * - rbb_init / rbb_free / rbb_set_notify 必须在所有线程都未运行时调用
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "ringbuf.h" // RbSpan
+#include "ringbuf_wait.h"
+
+#define RBB_MAX_READERS 16 // 读者数上限（位图一个字；网络桥的每个客户端也各占一个）
+#define RBB_CACHELINE   64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    RBB_BACKPRESSURE = 0, // 不丢：生产者的可写空间受它限制
+    RBB_DROP         = 1  // 可丢：落后超过容量时被生产者越过
+} RbbPolicy;
+
+/* 一个读游标（独占一条缓存行：读者推进 pos 不会让别的读者的缓存行失效；
+ * 生产者平时只读这条线，只在越过它或刷新 lag_max 时写） */
+typedef struct {
+    _Alignas(RBB_CACHELINE) atomic_size_t pos; // 读计数：读者推进；DROP 读者被越过时由生产者 CAS 推进
+    atomic_size_t dropped;   // 被越过、没读到的字节（生产者写）
+    atomic_size_t overruns;  // 被越过的次数（生产者写）
+    atomic_size_t lag_max;   // 生产者预留时看到的最大落后字节（生产者写）
+    size_t        seen;      // 读者私有：上次 peek 时的 pos（consume 据此发现 peek 之后被越过）
+    RbbPolicy     policy;    // attach 时设定
+    const char   *name;      // attach 时设定（统计/诊断显示用，不复制）
+} RbbCursor;
+
+typedef struct {
+    uint8_t      *data;   // 实际内存
+    size_t        cap;    // 容量（字节，2 的幂）
+    size_t        mask;   // cap - 1
+    bool          mirror; // data 后面紧跟同一块内存的镜像（rbb_init_mirror）
+
+    _Alignas(RBB_CACHELINE) atomic_size_t tail; // 写计数：只由生产者推进
+    atomic_size_t resv;       // 生产者已预留到的位置（>= tail），写数据之前先发布，快照据此判断覆盖
+    atomic_uint   readers;    // 在线读者位图（生产者只扫这些）
+    atomic_uint   claimed;    // 已占用的槽位图（attach/detach 之间）
+
+    RbEvent       ev;         // 自带的事件计数
+    RbEvent      *notify;     // 发布数据时通知的事件（默认 &ev，可共享给多个环；所有读者等的是同一个事件）
+
+    RbbCursor     cur[RBB_MAX_READERS];
+} RingBufBcast;
+
+/* 一次快照的结果（rbb_snapshot 填写） */
+typedef struct {
+    size_t tail;   // 开始复制前读到的写计数
+    size_t resv2;  // 复制完成后重读的预留位置
+    size_t gen;    // 窗口起点所在的“代”（start / cap）
+    size_t start;  // 窗口起点的流位置
+    size_t len;    // 复制的字节数
+    size_t lost;   // 窗口最前面在复制期间可能被覆盖的字节数；其余 len - lost 字节完整
+    bool   torn;   // lost > 0
+} RbbSnapshot;
+
+/* ===== 基础管理 ===== */
+
+/**
+ * @brief 初始化（分配内存），capacity 会向上取整为 2 的幂；初始没有读者
+ * @return true成功；false失败
+ */
+bool   rbb_init(RingBufBcast *rb, size_t capacity);
+
+/**
+ * @brief 以镜像映射内存初始化（见 ringbuf_vm.h），失败可回退 rbb_init
+ */
+bool   rbb_init_mirror(RingBufBcast *rb, size_t capacity);
+
+/**
+ * @brief 释放缓冲区并清零结构体
+ */
+void   rbb_free(RingBufBcast *rb);
+
+/**
+ * @brief 改用外部事件通知（NULL恢复自带的），同 rbs_set_notify
+ */
+void   rbb_set_notify(RingBufBcast *rb, RbEvent *ev);
+
+/* ===== 读者登记 ===== */
+
+/**
+ * @brief 登记一个读者，从当前 tail 开始读（只看到登记之后写入的数据）
+ * @param name 显示用的名字（不复制，须长期有效）
+ * @return 读者 id（0..RBB_MAX_READERS-1）；槽位用完返回 -1
+ */
+int    rbb_attach(RingBufBcast *rb, RbbPolicy policy, const char *name);
+
+/**
+ * @brief 注销读者：之后生产者不再等它也不再越过它；调用时该读者的线程不得再使用这个 id
+ */
+void   rbb_detach(RingBufBcast *rb, int id);
+
+/* ===== 生产者 ===== */
+
+/**
+ * @brief 写入n字节（不等待，同 rbs_push；DROP 读者挡路时被越过）
+ * @return 实际写入字节数（BACKPRESSURE 读者没读完时可能小于n）
+ */
+size_t rbb_push(RingBufBcast *rb, const void *src, size_t n);
+
+/**
+ * @brief 预留最多 want 字节的可写空间（最多两段）；want=0 表示能给多少给多少
+ *        只为 want 字节越过 DROP 读者：读一次设备最多读多少就传多少，不要无谓地挤掉慢读者
+ * @return 预留的字节数（0：BACKPRESSURE 读者没读完，spans 置空）
+ */
+size_t rbb_write_reserve(RingBufBcast *rb, RbSpan spans[2], size_t want);
+
+/**
+ * @brief 发布已写入预留区的n字节（release tail 并通知读者）；没用完的预留一并退回
+ *        （n=0 只退回预留：预留后没读到数据也要调用，否则快照窗口一直按预留量缩小）
+ */
+size_t rbb_write_commit(RingBufBcast *rb, size_t n);
+
+/* ===== 读者 ===== */
+
+/**
+ * @brief 查看读者 id 可读数据所在的最多两段连续区域（零拷贝，不移动 pos）
+ * @return 可读字节数
+ */
+size_t rbb_peek_spans(RingBufBcast *rb, int id, RbSpan spans[2]);
+
+/**
+ * @brief 消费 peek 到的前n字节
+ * @return true 成功；false 这期间被生产者越过（只会发生在 DROP 读者），pos 已在生产者推到的位置，
+ *         peek 到的内容可能已被覆盖，应当丢弃（解析器应 reset）
+ */
+bool   rbb_consume(RingBufBcast *rb, int id, size_t n);
+
+/**
+ * @brief 丢弃最前面的最多n字节（不读内容）
+ * @return 实际丢弃的字节数
+ */
+size_t rbb_skip(RingBufBcast *rb, int id, size_t n);
+
+/**
+ * @brief 阻塞等到读者 id 至少有min_bytes字节可读，语义同 rbs_wait_readable
+ */
+size_t rbb_wait_readable(RingBufBcast *rb, int id, size_t min_bytes, int timeout_ms);
+
+/**
+ * @brief 叫醒所有正在等待的读者
+ */
+void   rbb_wake(RingBufBcast *rb);
+
+/* ===== 查询（任意线程，近似值） ===== */
+
+/**
+ * @brief 读者 id 落后生产者的字节数（= 它的可读字节数）
+ */
+size_t rbb_lag(const RingBufBcast *rb, int id);
+
+/**
+ * @brief 最慢的在线读者
+ * @param lag 可为 NULL；写入它落后的字节数（没有读者时写 0）
+ * @return 读者 id；没有读者返回 -1
+ */
+int    rbb_slowest(const RingBufBcast *rb, size_t *lag);
+
+/**
+ * @brief 容量 / 最慢读者的可读字节数 / 生产者当前可写字节数（只受 BACKPRESSURE 读者限制）
+ */
+size_t rbb_capacity(const RingBufBcast *rb);
+size_t rbb_size(const RingBufBcast *rb);
+size_t rbb_free_space(const RingBufBcast *rb);
+
+/* ===== 快照（任意线程） ===== */
+
+/**
+ * @brief 复制一个窗口并报告复制期间是否被覆盖（不加锁，不改任何游标），思路同 rbs_snapshot
+ *        latest=false：窗口从环里最旧的数据（tail-cap，不足则 0）加 offset 起；latest=true：窗口以 tail-offset 结尾
+ *
+ *        位置 p 的槽要等生产者预留到 p+cap 之后才会被覆盖，生产者预留时先发布 resv 再写数据，
+ *        所以复制完（acquire 栅栏之后）重读 resv：[start, resv2-cap) 这段可能已被覆盖，记为 lost。
+ *        复制与覆盖并发时那部分字节可能是撕裂的（有意容忍的竞争，同 seqlock），只信 lost 之后的部分。
+ * @param dst 至少 n 字节
+ * @return 复制的字节数（= snap->len）；dst[snap->lost .. snap->len) 是完整的部分
+ */
+size_t rbb_snapshot(const RingBufBcast *rb, void *dst, size_t n, size_t offset, bool latest, RbbSnapshot *snap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RINGBUF_BCAST_H */
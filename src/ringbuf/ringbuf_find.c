@@ -0,0 +1,154 @@
+#include "ringbuf_find.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RB_FIND_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RB_FIND_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/* 模式长度达到这个值改用 Horspool */
+#define RB_FIND_LONG 32
+
+/* --- 首字节 memchr + memcmp（无 SIMD 时的短模式路径，也用来收尾） --- */
+static size_t rb_find_memchr(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m) {
+    if (m > n) return RB_FIND_NONE;
+    size_t limit = n - m;
+    size_t pos = 0;
+    while (pos <= limit) {
+        const uint8_t *hit = (const uint8_t*)memchr(hay + pos, pat[0], limit - pos + 1);
+        if (!hit) return RB_FIND_NONE;
+        pos = (size_t)(hit - hay);
+        if (memcmp(hit + 1, pat + 1, m - 1) == 0) return pos;
+        ++pos;
+    }
+    return RB_FIND_NONE;
+}
+
+#if defined(RB_FIND_SSE2)
+static inline unsigned rb_ctz32(unsigned x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctz(x);
+#endif
+}
+
+/*
+ * 一次看16个起点：首字节相等 且 尾字节相等 的位置才是候选，
+ * 随机数据里候选极少，绝大多数块一条 movemask 就跳过去了
+ */
+static size_t rb_find_simd(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m) {
+    const __m128i first = _mm_set1_epi8((char)pat[0]);
+    const __m128i last  = _mm_set1_epi8((char)pat[m - 1]);
+    size_t i = 0;
+    for (; i + m + 15 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(hay + i + m - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            unsigned bit = rb_ctz32(mask);
+            if (m <= 2 || memcmp(hay + i + bit + 1, pat + 1, m - 2) == 0) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    size_t r = rb_find_memchr(hay + i, n - i, pat, m);
+    return (r == RB_FIND_NONE) ? RB_FIND_NONE : i + r;
+}
+
+#elif defined(RB_FIND_NEON)
+static inline unsigned rb_ctz64(uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+/* 同 SSE2 版本；NEON 没有 movemask，用 shrn 把16字节比较结果压成64位（每字节4位） */
+static size_t rb_find_simd(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m) {
+    const uint8x16_t first = vdupq_n_u8(pat[0]);
+    const uint8x16_t last  = vdupq_n_u8(pat[m - 1]);
+    size_t i = 0;
+    for (; i + m + 15 <= n; i += 16) {
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(hay + i), first),
+                                 vceqq_u8(vld1q_u8(hay + i + m - 1), last));
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask) {
+            unsigned bit = rb_ctz64(mask) >> 2;
+            if (m <= 2 || memcmp(hay + i + bit + 1, pat + 1, m - 2) == 0) return i + bit;
+            mask &= ~((uint64_t)0xF << (bit * 4));
+        }
+    }
+    size_t r = rb_find_memchr(hay + i, n - i, pat, m);
+    return (r == RB_FIND_NONE) ? RB_FIND_NONE : i + r;
+}
+#endif
+
+/* --- Boyer-Moore-Horspool：按窗口末字节查表跳跃 --- */
+static size_t rb_find_horspool(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m) {
+    size_t skip[256];
+    for (size_t i = 0; i < 256; ++i) skip[i] = m;
+    for (size_t i = 0; i + 1 < m; ++i) skip[pat[i]] = m - 1 - i;
+
+    const uint8_t lastc = pat[m - 1];
+    size_t pos = 0;
+    while (pos <= n - m) {
+        uint8_t c = hay[pos + m - 1];
+        if (c == lastc && memcmp(hay + pos, pat, m - 1) == 0) return pos;
+        pos += skip[c];
+    }
+    return RB_FIND_NONE;
+}
+
+size_t rb_find(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m) {
+    if (m == 0) return 0; // 空模式视为命中0
+    if (!hay || !pat || m > n) return RB_FIND_NONE;
+    if (m == 1) {
+        const uint8_t *hit = (const uint8_t*)memchr(hay, pat[0], n);
+        return hit ? (size_t)(hit - hay) : RB_FIND_NONE;
+    }
+    if (m >= RB_FIND_LONG) return rb_find_horspool(hay, n, pat, m);
+#if defined(RB_FIND_SSE2) || defined(RB_FIND_NEON)
+    return rb_find_simd(hay, n, pat, m);
+#else
+    return rb_find_memchr(hay, n, pat, m);
+#endif
+}
+
+size_t rb_find_spans(const RbSpan spans[2], const uint8_t *pat, size_t m) {
+    if (!spans) return RB_FIND_NONE;
+    const uint8_t *a = spans[0].ptr, *b = spans[1].ptr;
+    size_t an = spans[0].len, bn = spans[1].len;
+    if (m == 0) return 0;
+    if (m > an + bn) return RB_FIND_NONE;
+
+    // 1) 完全落在第一段
+    size_t r = rb_find(a, an, pat, m);
+    if (r != RB_FIND_NONE || bn == 0) return r;
+
+    // 2) 跨接缝：起点在第一段最后 m-1 个字节里，末尾落在第二段
+    size_t s = (an >= m - 1) ? an - (m - 1) : 0;
+    for (; s < an; ++s) {
+        size_t k = an - s;              // 第一段里的部分
+        if (m - k > bn) continue;       // 第二段不够长
+        if (a[s] == pat[0] && memcmp(a + s, pat, k) == 0 && memcmp(b, pat + k, m - k) == 0)
+            return s;
+    }
+
+    // 3) 完全落在第二段
+    r = rb_find(b, bn, pat, m);
+    return (r == RB_FIND_NONE) ? RB_FIND_NONE : an + r;
+}
@@ -0,0 +1,41 @@
+#ifndef RINGBUF_FIND_H
+#define RINGBUF_FIND_H
+
+/*
+ * 字节序列检索引擎（rb_search / rbs_search 的底层实现）。
+ *
+ * 策略：
+ * - m == 1      ：memchr（libc 通常已向量化）
+ * - 2 <= m < 32 ：SSE2/NEON 同时比较“首字节+尾字节”，16 字节一批筛出候选，再 memcmp 验证；
+ *                 没有 SIMD 时退化为 memchr 找首字节 + memcmp
+ * - m >= 32     ：Boyer-Moore-Horspool（坏字符跳跃，模式越长跳得越远）
+ * - 环形缓冲的两段：分别在段内检索，跨接缝的起点单独逐个验证（最多 m-1 个）
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ringbuf.h" // RbSpan
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RB_FIND_NONE ((size_t)-1)
+
+/**
+ * @brief 在连续内存 hay[0..n) 中查找 pat[0..m)
+ * @return 首个命中的下标；未找到返回 RB_FIND_NONE（m==0 视为命中0）
+ */
+size_t rb_find(const uint8_t *hay, size_t n, const uint8_t *pat, size_t m);
+
+/**
+ * @brief 在逻辑上首尾相接的两段区域（spans[0] 后接 spans[1]）中查找，支持跨接缝命中
+ * @return 首个命中的逻辑下标（以 spans[0] 起点为0）；未找到返回 RB_FIND_NONE
+ */
+size_t rb_find_spans(const RbSpan spans[2], const uint8_t *pat, size_t m);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RINGBUF_FIND_H */
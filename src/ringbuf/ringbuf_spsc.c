@@ -0,0 +1,346 @@
+#include "ringbuf_spsc.h"
+#include "ringbuf_vm.h"
+#include "ringbuf_find.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* --- 小工具：向上取整到2的幂（溢出返回0） --- */
+static size_t rbs_round_pow2(size_t x) {
+    size_t p = 1;
+    while (p < x) {
+        if (p > ((size_t)-1 >> 1)) return 0;
+        p <<= 1;
+    }
+    return p;
+}
+
+/*
+ * 已用字节数：先读head再读tail。
+ * tail只增不减且总是>=head，所以差值不会下溢；
+ * 第三方线程读取时tail可能已超前，截到cap即可。
+ */
+static inline size_t rbs_used(const RingBufSpsc *rb) {
+    size_t h = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - h;
+    return (used > rb->cap) ? rb->cap : used;
+}
+
+/* 从真实下标start起、最多n字节中连续的那一段长度（镜像模式下整段都连续） */
+static inline size_t rbs_contig(const RingBufSpsc *rb, size_t start, size_t n) {
+    if (rb->mirror) return n;
+    size_t first = rb->cap - start;
+    return (first > n) ? n : first;
+}
+
+/* 从计数器pos对应的位置开始拷出n字节（自动分两段） */
+static void rbs_copy_out(const RingBufSpsc *rb, size_t pos, uint8_t *p, size_t n) {
+    size_t start = pos & rb->mask;
+    size_t first = rbs_contig(rb, start, n);
+    memcpy(p, &rb->data[start], first);
+    if (n > first) {
+        memcpy(p + first, &rb->data[0], n - first);
+    }
+}
+
+bool rbs_init(RingBufSpsc *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = rbs_round_pow2(capacity);
+    if (cap == 0) return false;
+    rb->data = (uint8_t*)malloc(cap);
+    if (!rb->data) return false;
+    rb->cap  = cap;
+    rb->mask = cap - 1;
+    rb->mirror = false;
+    rb->huge = RB_VM_HUGE_NONE;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    rb_ev_init(&rb->ev);
+    rb->notify = &rb->ev;
+    return true;
+}
+
+bool rbs_init_mirror(RingBufSpsc *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = capacity;
+    uint8_t *mem = (uint8_t*)rb_vm_map_mirror(&cap);
+    if (!mem) return false;
+    rb->data = mem;
+    rb->cap  = cap;
+    rb->mask = cap - 1;
+    rb->mirror = true;
+    rb->huge = RB_VM_HUGE_NONE;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    rb_ev_init(&rb->ev);
+    rb->notify = &rb->ev;
+    return true;
+}
+
+bool rbs_init_huge(RingBufSpsc *rb, size_t capacity) {
+    if (!rb || capacity == 0) return false;
+    size_t cap = rbs_round_pow2(capacity), hp = rb_vm_huge_page_size();
+    if (cap == 0) return false;
+    // 大页大小也是 2 的幂：cap >= hp 时映射大小正好等于 cap
+    RbVmHuge kind = RB_VM_HUGE_NONE;
+    size_t size = cap;
+    uint8_t *mem = (hp && cap >= hp) ? (uint8_t*)rb_vm_map_huge(&size, &kind) : NULL;
+    if (mem && size != cap) {
+        rb_vm_unmap_huge(mem, size);
+        mem = NULL;
+    }
+    if (!mem) return rbs_init(rb, cap);
+    rb->data = mem;
+    rb->cap  = cap;
+    rb->mask = cap - 1;
+    rb->mirror = false;
+    rb->huge = (uint8_t)kind;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    rb_ev_init(&rb->ev);
+    rb->notify = &rb->ev;
+    return true;
+}
+
+void rbs_free(RingBufSpsc *rb) {
+    if (!rb) return;
+    if (rb->data) {
+        if (rb->mirror)    rb_vm_unmap_mirror(rb->data, rb->cap);
+        else if (rb->huge) rb_vm_unmap_huge(rb->data, rb->cap);
+        else               free(rb->data);
+        rb->data = NULL;
+    }
+    if (rb->notify) rb_ev_destroy(&rb->ev);
+    rb->notify = NULL;
+    rb->cap = rb->mask = 0;
+    rb->mirror = false;
+    rb->huge = RB_VM_HUGE_NONE;
+    atomic_store(&rb->head, 0);
+    atomic_store(&rb->tail, 0);
+}
+
+void rbs_clear(RingBufSpsc *rb) {
+    if (!rb || !rb->data) return;
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    atomic_store_explicit(&rb->head, t, memory_order_release);
+}
+
+size_t rbs_capacity(const RingBufSpsc *rb) { return rb ? rb->cap : 0; }
+size_t rbs_size    (const RingBufSpsc *rb) { return (rb && rb->data) ? rbs_used(rb) : 0; }
+size_t rbs_free_space(const RingBufSpsc *rb) {
+    return (rb && rb->data) ? (rb->cap - rbs_used(rb)) : 0;
+}
+
+size_t rbs_push(RingBufSpsc *rb, const void *src, size_t n) {
+    if (!rb || !rb->data || !src || n == 0) return 0;
+
+    // tail是自己写的，relaxed即可；head要acquire，保证消费者读完的空间才被复用
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t h = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t free_bytes = rb->cap - (t - h);
+    if (free_bytes == 0) return 0;
+    if (n > free_bytes) n = free_bytes;
+
+    const uint8_t *p = (const uint8_t*)src;
+    size_t start = t & rb->mask;
+
+    // 第一段：从tail到数组末尾（镜像模式下就是全部）
+    size_t first = rbs_contig(rb, start, n);
+    memcpy(&rb->data[start], p, first);
+
+    // 第二段：从0开始
+    if (n > first) {
+        memcpy(&rb->data[0], p + first, n - first);
+    }
+
+    // 数据写完再发布tail，然后看看消费者是否在睡
+    atomic_store_explicit(&rb->tail, t + n, memory_order_release);
+    rb_ev_signal(rb->notify);
+    return n;
+}
+
+/* 把计数器pos起的n字节拆成最多两段（不检查越界） */
+static size_t rbs_fill_spans(const RingBufSpsc *rb, size_t pos, size_t n, RbSpan spans[2]) {
+    size_t start = pos & rb->mask;
+    size_t first = rbs_contig(rb, start, n);
+    spans[0].ptr = &rb->data[start];
+    spans[0].len = first;
+    if (n > first) {
+        spans[1].ptr = &rb->data[0];
+        spans[1].len = n - first;
+    }
+    return n;
+}
+
+size_t rbs_write_reserve(RingBufSpsc *rb, RbSpan spans[2]) {
+    if (!spans) return 0;
+    spans[0].ptr = spans[1].ptr = NULL;
+    spans[0].len = spans[1].len = 0;
+    if (!rb || !rb->data) return 0;
+
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t h = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t free_bytes = rb->cap - (t - h);
+    if (free_bytes == 0) return 0;
+    return rbs_fill_spans(rb, t, free_bytes, spans);
+}
+
+size_t rbs_write_commit(RingBufSpsc *rb, size_t n) {
+    if (!rb || !rb->data) return 0;
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t h = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t free_bytes = rb->cap - (t - h);
+    if (n > free_bytes) n = free_bytes;
+    if (n == 0) return 0;
+    atomic_store_explicit(&rb->tail, t + n, memory_order_release);
+    rb_ev_signal(rb->notify);
+    return n;
+}
+
+size_t rbs_pop(RingBufSpsc *rb, void *dst, size_t n) {
+    if (!rb || !rb->data || !dst || n == 0) return 0;
+
+    size_t h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - h;
+    if (used == 0) return 0;
+    if (n > used) n = used;
+
+    rbs_copy_out(rb, h, (uint8_t*)dst, n);
+
+    // 数据读完再归还空间
+    atomic_store_explicit(&rb->head, h + n, memory_order_release);
+    return n;
+}
+
+size_t rbs_peek(const RingBufSpsc *rb, void *dst, size_t n, size_t offset) {
+    if (!rb || !rb->data || !dst) return 0;
+
+    size_t h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - h;
+    if (offset >= used) return 0; // 起点越界，没得看
+
+    size_t remain = used - offset;
+    if (n > remain) n = remain;
+
+    rbs_copy_out(rb, h + offset, (uint8_t*)dst, n);
+    return n;
+}
+
+size_t rbs_snapshot(const RingBufSpsc *rb, void *dst, size_t n, size_t offset, bool latest, RbsSnapshot *snap) {
+    if (!rb || !rb->data || !dst || !snap) return 0;
+    memset(snap, 0, sizeof(*snap));
+
+    size_t h = atomic_load_explicit(&rb->head, memory_order_acquire);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    // 不是消费者线程：h 读得比 t 早，可能已经过时；t - cap 之前的位置肯定已被新数据占用
+    if (t - h > rb->cap) h = t - rb->cap;
+    size_t used = t - h;
+    snap->head = h;
+    snap->tail = t;
+    if (offset >= used) { snap->head2 = h; return 0; }
+
+    size_t take = used - offset < n ? used - offset : n;
+    size_t start = latest ? t - offset - take : h + offset;
+    rbs_copy_out(rb, start, (uint8_t*)dst, take);
+
+    // 复制的读操作排在重读 head 之前
+    atomic_thread_fence(memory_order_acquire);
+    size_t h2 = atomic_load_explicit(&rb->head, memory_order_acquire);
+    // 都换成相对 h 的距离再比较，计数器回绕时也成立
+    size_t moved = h2 - h, at = start - h;
+    size_t lost = moved > at ? moved - at : 0;
+    if (lost > take) lost = take;
+
+    snap->head2 = h2;
+    snap->gen   = start / rb->cap;
+    snap->start = start;
+    snap->len   = take;
+    snap->lost  = lost;
+    snap->torn  = lost != 0;
+    return take;
+}
+
+bool rbs_search(const RingBufSpsc *rb, const void *pattern, size_t m, size_t *out_index) {
+    if (!rb || !rb->data || !pattern) return false;
+    if (m == 0) { if (out_index) *out_index = 0; return true; } // 空模式视为命中0
+
+    RbSpan spans[2];
+    if (rbs_read_peek_spans(rb, spans) < m) return false;
+    size_t idx = rb_find_spans(spans, (const uint8_t*)pattern, m);
+    if (idx == RB_FIND_NONE) return false;
+    if (out_index) *out_index = idx;
+    return true;
+}
+
+size_t rbs_read_peek_spans(const RingBufSpsc *rb, RbSpan spans[2]) {
+    if (!spans) return 0;
+    spans[0].ptr = spans[1].ptr = NULL;
+    spans[0].len = spans[1].len = 0;
+    if (!rb || !rb->data) return 0;
+
+    size_t h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - h;
+    if (used == 0) return 0;
+    return rbs_fill_spans(rb, h, used, spans);
+}
+
+size_t rbs_read_consume(RingBufSpsc *rb, size_t n) {
+    return rbs_skip(rb, n);
+}
+
+size_t rbs_skip(RingBufSpsc *rb, size_t n) {
+    if (!rb || !rb->data) return 0;
+    size_t h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    size_t used = t - h;
+    if (n > used) n = used;
+    atomic_store_explicit(&rb->head, h + n, memory_order_release);
+    return n;
+}
+
+size_t rbs_wait_readable(RingBufSpsc *rb, size_t min_bytes, int timeout_ms) {
+    if (!rb || !rb->data) return 0;
+    if (min_bytes == 0) min_bytes = 1;
+    if (min_bytes > rb->cap) min_bytes = rb->cap;
+    long long deadline = (timeout_ms > 0) ? rb_ev_now_ms() + timeout_ms : 0;
+
+    for (;;) {
+        size_t used = rbs_used(rb);
+        if (used >= min_bytes || timeout_ms == 0) return used; // 快路径：不碰事件
+
+        // 先登记再复查：复查之后发布的数据一定会改变 seq
+        unsigned key = rb_ev_prepare(rb->notify);
+        used = rbs_used(rb);
+        if (used >= min_bytes) {
+            rb_ev_cancel(rb->notify);
+            return used;
+        }
+        int wait_ms = -1;
+        if (timeout_ms > 0) {
+            long long left = deadline - rb_ev_now_ms();
+            if (left <= 0) {
+                rb_ev_cancel(rb->notify);
+                return used;
+            }
+            wait_ms = (int)left;
+        }
+        // 被叫醒但数据仍不够 min_bytes 时重新等；rbs_wake 的唤醒也会走到这里，
+        // 所以序号变化但数据没变化时直接返回，让调用方检查外部状态
+        size_t before = used;
+        rb_ev_wait(rb->notify, key, wait_ms);
+        used = rbs_used(rb);
+        if (used == before) return used;
+    }
+}
+
+void rbs_wake(RingBufSpsc *rb) {
+    if (rb && rb->notify) rb_ev_wake(rb->notify);
+}
+
+void rbs_set_notify(RingBufSpsc *rb, RbEvent *ev) {
+    if (!rb || !rb->data) return;
+    rb->notify = ev ? ev : &rb->ev;
+}
@@ -0,0 +1,200 @@
+#ifndef RINGBUF_SPSC_H
+#define RINGBUF_SPSC_H
+
+/*
+ * 单生产者/单消费者（SPSC）无锁环形缓冲区。
+ * 适用场景：一个线程只写（如串口 reader_thread），另一个线程只读（如 printer_thread）。
+ *
+ * 与 RingBuf 的区别：
+ * - 没有共享的 size 字段：已用字节数 = tail - head，由两端各自读取计算
+ * - head 只由消费者写、tail 只由生产者写，二者都是 C11 原子变量
+ * - 布局按缓存行分开：只读字段（data/cap/mask）、head、tail、事件计数各占一条，
+ *   消费者推进 head 不会让生产者手里的 tail 行失效，反之亦然（否则两核每次推进都在抢同一条线）
+ * - 生产者写完数据后 release 发布 tail；消费者 acquire 读 tail 后才去读数据（反之亦然）
+ * - head/tail 是“自由增长”的计数器，真实下标 = 计数器 & mask，因此容量会向上取整为 2 的幂
+ *   （计数器回绕时差值依旧正确）
+ * - 可选镜像映射（rbs_init_mirror，见 ringbuf_vm.h）：任何可读/可写区域都是一段连续内存
+ * - 可选大页（rbs_init_huge）：几 MiB 以上的环少占 TLB
+ * - 消费者可以用 rbs_wait_readable 阻塞等数据（事件计数，见 ringbuf_wait.h）：
+ *   生产者只有在消费者真的睡下时才走唤醒的系统调用，平时发布数据只多一条栅栏
+ *
+ * 线程约定（违反即数据竞争）：
+ * - 生产者：rbs_push / rbs_write_reserve / rbs_write_commit
+ * - 消费者：rbs_pop / rbs_peek / rbs_search / rbs_clear / rbs_skip / rbs_read_peek_spans / rbs_read_consume
+ *           / rbs_wait_readable
+ * - 任意线程：rbs_capacity / rbs_size / rbs_free_space（只是某一时刻的近似值）/ rbs_wake
+ *           / rbs_snapshot（诊断用的只读拷贝，不写环的任何字段，不阻塞也不拖慢两端）
+ * - rbs_init / rbs_free / rbs_set_notify 必须在两端线程都未运行时调用
+ *
+ * 满了怎么办：rbs_push 只写入能放下的部分并立刻返回（永不等待消费者），
+ * 调用方可以把“没写进去的字节数”记为丢弃。生产者不能移动head，所以没有 rb_push_overwrite
+ * 那样的覆盖写；需要“保留最新数据”时由消费者用 rbs_skip 丢最旧的部分。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "ringbuf.h" // RbSpan
+#include "ringbuf_wait.h"
+
+#define RBS_CACHELINE 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t      *data;  // 实际内存
+    size_t        cap;   // 容量（字节，2 的幂）
+    size_t        mask;  // cap - 1
+    bool          mirror;// data 后面紧跟同一块内存的镜像（rbs_init_mirror）
+    uint8_t       huge;  // RbVmHuge：data 来自 rbs_init_huge 的大页（0：不是）
+    RbEvent      *notify;// 发布数据时通知的事件（默认 &ev，可共享给多个环）
+    _Alignas(RBS_CACHELINE) atomic_size_t head; // 读计数：只由消费者推进
+    _Alignas(RBS_CACHELINE) atomic_size_t tail; // 写计数：只由生产者推进
+    _Alignas(RBS_CACHELINE) RbEvent ev;         // 自带的事件计数（等待者计数由消费者改，不与 tail 同线）
+} RingBufSpsc;
+
+/* 一次快照的结果（rbs_snapshot 填写） */
+typedef struct {
+    size_t head;   // 开始复制前读到的读计数
+    size_t tail;   // 开始复制前读到的写计数
+    size_t head2;  // 复制完成后重读的读计数
+    size_t gen;    // 窗口起点所在的“代”（start / cap：这个下标第几次被写）
+    size_t start;  // 窗口起点的流位置（自由增长的字节计数，与 head/tail 同一坐标）
+    size_t len;    // 复制的字节数
+    size_t lost;   // 窗口最前面可能已被生产者覆盖的字节数（内容不可信）；其余 len - lost 字节完整
+    bool   torn;   // lost > 0
+} RbsSnapshot;
+
+/* ===== 基础管理 ===== */
+
+/**
+ * @brief 初始化（分配内存），capacity 会向上取整为 2 的幂
+ * @return true成功；false失败（capacity=0、过大或内存不足）
+ */
+bool   rbs_init(RingBufSpsc *rb, size_t capacity);
+
+/**
+ * @brief 以镜像映射内存初始化，语义同 rb_init_mirror（容量不小于页大小/分配粒度）
+ * @return true成功；false失败（平台不支持或映射失败，可回退 rbs_init）
+ */
+bool   rbs_init_mirror(RingBufSpsc *rb, size_t capacity);
+
+/**
+ * @brief 以大页内存初始化（见 rb_vm_map_huge）；容量小于一个大页或大页不可用时退回 rbs_init
+ *        是否真的用上了大页看 rb->huge
+ * @return true成功；false失败（同 rbs_init）
+ */
+bool   rbs_init_huge(RingBufSpsc *rb, size_t capacity);
+
+/**
+ * @brief 释放缓冲区（释放内存并清零结构体）
+ */
+void   rbs_free(RingBufSpsc *rb);
+
+/**
+ * @brief 清空缓冲区（消费者调用：丢弃当前所有可读数据）
+ */
+void   rbs_clear(RingBufSpsc *rb);
+
+/**
+ * @brief 获取容量/已用/剩余空间（并发时为近似值）
+ */
+size_t rbs_capacity(const RingBufSpsc *rb);
+size_t rbs_size    (const RingBufSpsc *rb);
+size_t rbs_free_space(const RingBufSpsc *rb);
+
+/* ===== 生产者 ===== */
+
+/**
+ * @brief 写入n字节（不等待）
+ * @return 实际写入字节数（空间不足时小于n）
+ */
+size_t rbs_push(RingBufSpsc *rb, const void *src, size_t n);
+
+/**
+ * @brief 预留可写空间（最多两段），语义同 rb_write_reserve
+ *        例：sp_read 直接读进 spans[0]，再 rbs_write_commit 发布
+ */
+size_t rbs_write_reserve(RingBufSpsc *rb, RbSpan spans[2]);
+
+/**
+ * @brief 发布已写入预留区的n字节（release tail，之后消费者可见）
+ */
+size_t rbs_write_commit(RingBufSpsc *rb, size_t n);
+
+/* ===== 消费者 ===== */
+
+/**
+ * @brief 读出n字节
+ * @return 实际读出字节数
+ */
+size_t rbs_pop (RingBufSpsc *rb, void *dst, size_t n);
+
+/**
+ * @brief 丢弃最前面的n字节（只推进head，O(1)）
+ * @return 实际丢弃字节数
+ */
+size_t rbs_skip(RingBufSpsc *rb, size_t n);
+
+/**
+ * @brief 从逻辑偏移offset处查看最多n字节（不移动head），语义同 rb_peek
+ */
+size_t rbs_peek(const RingBufSpsc *rb, void *dst, size_t n, size_t offset);
+
+/**
+ * @brief 在当前可读数据中检索pattern，语义同 rb_search
+ */
+bool   rbs_search(const RingBufSpsc *rb, const void *pattern, size_t m, size_t *out_index);
+
+/**
+ * @brief 查看可读数据所在的最多两段连续区域（不移动head），语义同 rb_read_peek_spans
+ */
+size_t rbs_read_peek_spans(const RingBufSpsc *rb, RbSpan spans[2]);
+
+/**
+ * @brief 消费最前面的n字节并归还空间给生产者（与 rbs_skip 相同，和 peek_spans 配对使用）
+ */
+size_t rbs_read_consume(RingBufSpsc *rb, size_t n);
+
+/* ===== 快照（任意线程） ===== */
+
+/**
+ * @brief 复制一个窗口并报告它在复制期间是否被覆盖（不加锁，不修改环，两端线程照常运行）
+ *        latest=false：窗口从 head+offset 起（同 rbs_peek）；latest=true：窗口以 tail-offset 结尾（最新的数据）
+ *
+ *        原理：位置 p 的字节所在的槽，要等消费者把 head 推过 p、生产者看到这块空间后才会被第 gen+1 代数据覆盖。
+ *        所以复制完（acquire 栅栏之后）重读 head：[start, head2) 这段可能已被覆盖，记为 lost；
+ *        head2 之后的部分在复制期间一直归消费者所有，生产者碰不到，内容与快照时刻一致。
+ * @param dst 至少 n 字节
+ * @return 复制的字节数（= snap->len）；dst[snap->lost .. snap->len) 是完整的部分
+ */
+size_t rbs_snapshot(const RingBufSpsc *rb, void *dst, size_t n, size_t offset, bool latest, RbsSnapshot *snap);
+
+/* ===== 等待 ===== */
+
+/**
+ * @brief 阻塞等到至少min_bytes字节可读（min_bytes=0按1算，超过容量按容量算），最多timeout_ms
+ *        （<0 一直等，0 不等）；数据早已就绪时不进内核
+ * @return 返回时的可读字节数（超时或被 rbs_wake 叫醒时可能小于min_bytes）
+ */
+size_t rbs_wait_readable(RingBufSpsc *rb, size_t min_bytes, int timeout_ms);
+
+/**
+ * @brief 叫醒正在 rbs_wait_readable 的消费者（如要它退出或重新检查外部状态）
+ */
+void   rbs_wake(RingBufSpsc *rb);
+
+/**
+ * @brief 改用外部事件通知（NULL恢复自带的）：多个环共享一个事件时，
+ *        一个消费者可以用 rb_ev_* 同时等待其中任意一个环有数据
+ */
+void   rbs_set_notify(RingBufSpsc *rb, RbEvent *ev);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RINGBUF_SPSC_H */
@@ -0,0 +1,129 @@
+#ifndef RINGBUF_TYPED_H
+#define RINGBUF_TYPED_H
+
+/*
+ * 按元素类型、编译期定长的环形队列（宏生成，全部 static inline）。
+ * 适用场景：帧描述符、带时间戳的样本、消息标记这类定长结构体的队列——
+ * 元素直接赋值进出，不走 RingBuf / RingBufSpsc 的字节 memcpy，也不用 malloc。
+ *
+ * 用法：
+ *   RB_TYPED_DEFINE(SampleRing, sample_ring, Sample, 256)        // 单线程
+ *   RB_TYPED_SPSC_DEFINE(MarkRing, mark_ring, Mark, 4096)        // 单生产者/单消费者
+ * 生成类型 SampleRing 与 sample_ring_init / _push / _pop / ... 一组函数；
+ * 类型名与函数前缀都由调用方给出，同一翻译单元里可以生成任意多个，
+ * 也可以和 ringbuf.h（RingBuf / rb_*）、ringbuf_spsc.h（rbs_*）同时包含，互不冲突。
+ *
+ * 设计：
+ * - 容量 CAP 必须是 2 的幂（编译期检查），下标 = 计数器 & (CAP - 1)，没有取模
+ * - head/tail 是自由增长的计数器（与 RingBufSpsc 相同），已用 = tail - head，不需要 count 字段
+ * - 存储就在结构体里（T data[CAP]），可以放静态区或嵌进别的结构体
+ * - 零拷贝：生产者 _reserve 拿到槽位指针原地填写、_commit 发布；消费者 _front / _at 原地读、_release 归还
+ *
+ * SPSC 版本（RB_TYPED_SPSC_DEFINE）：
+ * - head 只由消费者写、tail 只由生产者写，C11 原子变量，acquire/release 配对（同 RingBufSpsc）
+ * - head 与 tail 各占一条缓存行，两端线程互不伪共享
+ * - 生产者：_reserve / _commit / _push；消费者：_front / _at / _release / _pop / _clear；
+ *   任意线程：_size / _empty / _full / _capacity（某一时刻的近似值）
+ * 非 SPSC 版本是普通变量，只能在一个线程里用（或由调用方加锁）。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define RBT_CACHELINE 64
+
+/* 计数器读写策略：普通变量 / C11 原子 */
+#define RBT_PLAIN_LOAD(p, mo)      (*(p))
+#define RBT_PLAIN_STORE(p, v, mo)  (*(p) = (v))
+#define RBT_ATOMIC_LOAD(p, mo)     atomic_load_explicit((p), memory_order_##mo)
+#define RBT_ATOMIC_STORE(p, v, mo) atomic_store_explicit((p), (v), memory_order_##mo)
+
+/**
+ * @brief 生成单线程版本的定长环
+ * @param Type   生成的结构体类型名
+ * @param prefix 生成的函数前缀（prefix_init、prefix_push ...）
+ * @param T      元素类型
+ * @param CAP    容量（元素个数，2 的幂）
+ */
+#define RB_TYPED_DEFINE(Type, prefix, T, CAP) \
+    RBT_DEFINE_(Type, prefix, T, CAP, size_t, , RBT_PLAIN_LOAD, RBT_PLAIN_STORE)
+
+/**
+ * @brief 生成单生产者/单消费者版本的定长环（参数同 RB_TYPED_DEFINE）
+ */
+#define RB_TYPED_SPSC_DEFINE(Type, prefix, T, CAP) \
+    RBT_DEFINE_(Type, prefix, T, CAP, atomic_size_t, _Alignas(RBT_CACHELINE), RBT_ATOMIC_LOAD, RBT_ATOMIC_STORE)
+
+/* 内部：两个版本共用的函数体，只差计数器类型、对齐与读写策略 */
+#define RBT_DEFINE_(Type, prefix, T, CAP, CTR, ALIGN, LOAD, STORE)                          \
+    _Static_assert((CAP) > 0 && ((CAP) & ((CAP) - 1)) == 0, #Type ": CAP 必须是 2 的幂");     \
+                                                                                             \
+    typedef struct {                                                                         \
+        T data[CAP];                                                                         \
+        ALIGN CTR head; /* 读计数：只由消费者推进 */                                           \
+        ALIGN CTR tail; /* 写计数：只由生产者推进 */                                           \
+    } Type;                                                                                  \
+                                                                                             \
+    /* 清空（两端线程都未运行时调用） */                                                      \
+    static inline void prefix##_init(Type *q) {                                              \
+        STORE(&q->head, (size_t)0, relaxed);                                                 \
+        STORE(&q->tail, (size_t)0, relaxed);                                                 \
+    }                                                                                        \
+    static inline size_t prefix##_capacity(void) { return (size_t)(CAP); }                   \
+    static inline size_t prefix##_size(const Type *q) {                                      \
+        size_t h = LOAD((CTR *)&q->head, acquire);                                           \
+        return LOAD((CTR *)&q->tail, acquire) - h;                                           \
+    }                                                                                        \
+    static inline bool prefix##_empty(const Type *q) { return prefix##_size(q) == 0; }       \
+    static inline bool prefix##_full(const Type *q) { return prefix##_size(q) >= (CAP); }    \
+                                                                                             \
+    /* 生产者：下一个空槽（满了返回 NULL），填好后 _commit */                                  \
+    static inline T *prefix##_reserve(Type *q) {                                             \
+        size_t t = LOAD(&q->tail, relaxed);                                                  \
+        if (t - LOAD(&q->head, acquire) >= (CAP))                                            \
+            return NULL;                                                                     \
+        return &q->data[t & ((CAP) - 1)];                                                    \
+    }                                                                                        \
+    static inline void prefix##_commit(Type *q) {                                            \
+        STORE(&q->tail, LOAD(&q->tail, relaxed) + 1, release);                               \
+    }                                                                                        \
+    /* 生产者：拷入一个元素（满了返回 false） */                                              \
+    static inline bool prefix##_push(Type *q, const T *v) {                                  \
+        T *slot = prefix##_reserve(q);                                                       \
+        if (!slot)                                                                           \
+            return false;                                                                    \
+        *slot = *v;                                                                          \
+        prefix##_commit(q);                                                                  \
+        return true;                                                                         \
+    }                                                                                        \
+                                                                                             \
+    /* 消费者：队头后第 i 个元素（不移除；i 超出已用返回 NULL） */                             \
+    static inline T *prefix##_at(Type *q, size_t i) {                                        \
+        size_t h = LOAD(&q->head, relaxed);                                                  \
+        if (i >= LOAD(&q->tail, acquire) - h)                                                \
+            return NULL;                                                                     \
+        return &q->data[(h + i) & ((CAP) - 1)];                                              \
+    }                                                                                        \
+    static inline T *prefix##_front(Type *q) { return prefix##_at(q, 0); }                   \
+    /* 消费者：归还队头 n 个（n 不超过已用） */                                                \
+    static inline void prefix##_release(Type *q, size_t n) {                                 \
+        STORE(&q->head, LOAD(&q->head, relaxed) + n, release);                               \
+    }                                                                                        \
+    /* 消费者：取出队头（空了返回 false；out 可为 NULL，只丢弃） */                            \
+    static inline bool prefix##_pop(Type *q, T *out) {                                       \
+        T *slot = prefix##_front(q);                                                         \
+        if (!slot)                                                                           \
+            return false;                                                                    \
+        if (out)                                                                             \
+            *out = *slot;                                                                    \
+        prefix##_release(q, 1);                                                              \
+        return true;                                                                         \
+    }                                                                                        \
+    /* 消费者：丢弃全部已发布的元素 */                                                        \
+    static inline void prefix##_clear(Type *q) {                                             \
+        STORE(&q->head, LOAD(&q->tail, acquire), release);                                   \
+    }
+
+#endif /* RINGBUF_TYPED_H */
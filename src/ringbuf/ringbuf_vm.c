@@ -0,0 +1,235 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // memfd_create、MAP_HUGETLB
+#endif
+#include "ringbuf_vm.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* --- 小工具：向上取整到2的幂，且不小于gran（溢出返回0） --- */
+static inline size_t rb_vm_round(size_t x, size_t gran) {
+    size_t p = 1;
+    if (x < gran) x = gran;
+    while (p < x) {
+        if (p > ((size_t)-1 >> 2)) return 0; // 还要留出 2*size 的地址空间
+        p <<= 1;
+    }
+    return p;
+}
+
+#if defined(_WIN32)
+/* ---------------- Windows 实现 ---------------- */
+#include <windows.h>
+
+void *rb_vm_map_mirror(size_t *inout_size) {
+    if (!inout_size || *inout_size == 0) return NULL;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t size = rb_vm_round(*inout_size, si.dwAllocationGranularity);
+    if (size == 0) return NULL;
+
+    HANDLE map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                    (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+    if (!map) return NULL;
+
+    // 先保留 2*size 的地址再释放，然后把两个视图钉到这段地址上；
+    // 释放与映射之间别的线程可能抢走地址，所以失败就重试几次
+    void *result = NULL;
+    for (int tries = 0; tries < 16 && !result; ++tries) {
+        uint8_t *addr = (uint8_t*)VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+        if (!addr) break;
+        VirtualFree(addr, 0, MEM_RELEASE);
+
+        void *v1 = MapViewOfFileEx(map, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+        if (!v1) continue;
+        void *v2 = MapViewOfFileEx(map, FILE_MAP_ALL_ACCESS, 0, 0, size, addr + size);
+        if (!v2) {
+            UnmapViewOfFile(v1);
+            continue;
+        }
+        result = v1;
+    }
+    CloseHandle(map); // 视图仍持有映射对象
+    if (result) *inout_size = size;
+    return result;
+}
+
+void rb_vm_unmap_mirror(void *base, size_t size) {
+    if (!base) return;
+    UnmapViewOfFile((uint8_t*)base + size);
+    UnmapViewOfFile(base);
+}
+
+size_t rb_vm_huge_page_size(void) {
+    return (size_t)GetLargePageMinimum();
+}
+
+void *rb_vm_map_huge(size_t *inout_size, RbVmHuge *kind) {
+    size_t hp = rb_vm_huge_page_size();
+    if (!inout_size || *inout_size == 0 || hp == 0) return NULL;
+    size_t size = (*inout_size + hp - 1) / hp * hp;
+    // 没有“锁定内存页”权限时直接失败（大页不可换出，必须一次提交）
+    void *p = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!p) return NULL;
+    *inout_size = size;
+    if (kind) *kind = RB_VM_HUGE_EXPLICIT;
+    return p;
+}
+
+void rb_vm_unmap_huge(void *base, size_t size) {
+    (void)size;
+    if (base) VirtualFree(base, 0, MEM_RELEASE);
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+/* ---------------- POSIX 实现（Linux / macOS） ---------------- */
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// 一个只存在于内存中的文件，作为两次映射共享的“物理页”
+static int rb_vm_shared_fd(size_t size) {
+    int fd = -1;
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    fd = memfd_create("ringbuf", MFD_CLOEXEC);
+#endif
+    if (fd < 0) {
+        char name[64];
+        static unsigned seq = 0;
+        snprintf(name, sizeof(name), "/ringbuf-%ld-%u", (long)getpid(), ++seq);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) return -1;
+        shm_unlink(name); // 立即去名，fd 关闭后自动回收
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void *rb_vm_map_mirror(size_t *inout_size) {
+    if (!inout_size || *inout_size == 0) return NULL;
+    long pg = sysconf(_SC_PAGESIZE);
+    size_t size = rb_vm_round(*inout_size, pg > 0 ? (size_t)pg : 4096);
+    if (size == 0) return NULL;
+
+    int fd = rb_vm_shared_fd(size);
+    if (fd < 0) return NULL;
+
+    // 先占住 2*size 的连续地址，再用 MAP_FIXED 把同一个 fd 映射到前后两半
+    uint8_t *base = (uint8_t*)mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    void *a = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *b = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd); // 映射仍然有效
+    if (a != base || b != base + size) {
+        munmap(base, 2 * size);
+        return NULL;
+    }
+    *inout_size = size;
+    return base;
+}
+
+void rb_vm_unmap_mirror(void *base, size_t size) {
+    if (!base) return;
+    munmap(base, 2 * size);
+}
+
+size_t rb_vm_huge_page_size(void) {
+#if defined(__linux__)
+    static size_t cached = (size_t)-1;
+    if (cached != (size_t)-1) return cached;
+    size_t kb = 0;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f) {
+        char line[128];
+        while (fgets(line, sizeof(line), f))
+            if (sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) break;
+        fclose(f);
+    }
+    cached = kb ? kb * 1024 : (size_t)2 << 20; // 没有 hugetlbfs 时按 x86/arm64 的 2M 透明大页算
+    return cached;
+#else
+    return 0; // macOS 的超级页需要 Mach 接口，这里不支持
+#endif
+}
+
+#if defined(__linux__)
+// 透明大页被设成 never 时 madvise 仍会成功，只能看 sysfs
+static int rb_vm_thp_enabled(void) {
+    char buf[128] = {0};
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!f) return 0;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = 0;
+    return strstr(buf, "[never]") == NULL;
+}
+#endif
+
+void *rb_vm_map_huge(size_t *inout_size, RbVmHuge *kind) {
+    size_t hp = rb_vm_huge_page_size();
+    if (!inout_size || *inout_size == 0 || hp == 0) return NULL;
+    size_t size = (*inout_size + hp - 1) / hp * hp;
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        *inout_size = size;
+        if (kind) *kind = RB_VM_HUGE_EXPLICIT;
+        return p;
+    }
+#endif
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (!rb_vm_thp_enabled()) return NULL;
+    // 多映射一个大页再裁掉头尾，使起点按大页对齐（不对齐的部分内核合并不了）
+    uint8_t *raw = (uint8_t*)mmap(NULL, size + hp, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    uint8_t *base = (uint8_t*)(((uintptr_t)raw + hp - 1) & ~(uintptr_t)(hp - 1));
+    if (base > raw) munmap(raw, (size_t)(base - raw));
+    if (raw + size + hp > base + size) munmap(base + size, (size_t)(raw + size + hp - (base + size)));
+    if (madvise(base, size, MADV_HUGEPAGE) != 0) {
+        munmap(base, size);
+        return NULL;
+    }
+    *inout_size = size;
+    if (kind) *kind = RB_VM_HUGE_THP;
+    return base;
+#else
+    (void)kind;
+    return NULL;
+#endif
+}
+
+void rb_vm_unmap_huge(void *base, size_t size) {
+    if (base) munmap(base, size);
+}
+
+#else
+/* ---------------- 其它平台：不支持 ---------------- */
+void *rb_vm_map_mirror(size_t *inout_size) {
+    (void)inout_size;
+    return NULL;
+}
+
+void rb_vm_unmap_mirror(void *base, size_t size) {
+    (void)base;
+    (void)size;
+}
+
+size_t rb_vm_huge_page_size(void) { return 0; }
+
+void *rb_vm_map_huge(size_t *inout_size, RbVmHuge *kind) {
+    (void)inout_size;
+    (void)kind;
+    return NULL;
+}
+
+void rb_vm_unmap_huge(void *base, size_t size) {
+    (void)base;
+    (void)size;
+}
+#endif
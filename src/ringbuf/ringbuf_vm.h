@@ -0,0 +1,66 @@
+#ifndef RINGBUF_VM_H
+#define RINGBUF_VM_H
+
+/*
+ * 虚拟内存“镜像”映射：把同一块物理页在虚拟地址上首尾相接映射两次。
+ *
+ *   虚拟地址： [ base, base+size )  [ base+size, base+2*size )
+ *   物理页：   [        P         ]  [         同一块 P        ]
+ *
+ * 于是 base[i] 与 base[i+size] 是同一个字节：从任意下标开始、长度不超过 size 的区域
+ * 在虚拟地址上都是连续的，环形缓冲区不再需要“第一段/第二段”拆分。
+ *
+ * 平台：Linux（memfd_create + mmap）、其它 POSIX（shm_open + mmap）、
+ *      Windows（CreateFileMapping + MapViewOfFileEx）。不支持时返回 NULL，调用方可回退 malloc。
+ *
+ * 另：大页内存（rb_vm_map_huge）。几 MiB 以上的环按 4K 页要占上千个 TLB 项，生产者和消费者
+ * 在环上扫过时不断 TLB miss；换成 2M 大页后整个环只要几项。只给大环用（小于一个大页没有意义）。
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 申请镜像映射内存
+ * @param inout_size 输入期望大小；输出实际大小（向上取整为2的幂，且不小于页/分配粒度）
+ * @return 基址（可访问 2*size 字节）；失败返回NULL
+ */
+void *rb_vm_map_mirror(size_t *inout_size);
+
+/**
+ * @brief 释放 rb_vm_map_mirror 得到的内存（size 为其输出的实际大小）
+ */
+void  rb_vm_unmap_mirror(void *base, size_t size);
+
+typedef enum {
+    RB_VM_HUGE_NONE     = 0, // 不是大页内存
+    RB_VM_HUGE_EXPLICIT = 1, // 预留的大页：Linux hugetlbfs（MAP_HUGETLB）/ Windows MEM_LARGE_PAGES
+    RB_VM_HUGE_THP      = 2  // Linux 透明大页（按大页对齐 + madvise，由内核尽力合并）
+} RbVmHuge;
+
+/**
+ * @brief 平台的大页大小（Linux 读 /proc/meminfo，Windows GetLargePageMinimum）；不支持返回 0
+ */
+size_t rb_vm_huge_page_size(void);
+
+/**
+ * @brief 申请大页内存：先试预留的大页，不行（没有预留 / 没有权限）在 Linux 上再试透明大页
+ *        Windows 需要进程有 SeLockMemoryPrivilege（“锁定内存页”）；macOS 及其它平台返回 NULL
+ * @param inout_size 输入期望大小；输出实际大小（向上取整为大页大小的整数倍）
+ * @param kind 可为 NULL；成功时写入用的是哪种大页
+ * @return 基址；大页不可用时返回NULL（调用方回退 malloc）
+ */
+void *rb_vm_map_huge(size_t *inout_size, RbVmHuge *kind);
+
+/**
+ * @brief 释放 rb_vm_map_huge 得到的内存（size 为其输出的实际大小）
+ */
+void  rb_vm_unmap_huge(void *base, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RINGBUF_VM_H */
@@ -0,0 +1,161 @@
+#include "ringbuf_wait.h"
+#include <limits.h>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <time.h>
+#endif
+
+#if defined(_WIN32)
+/* ---------------- Windows：WaitOnAddress ---------------- */
+#include <windows.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "Synchronization.lib")
+#endif
+
+static bool rb_ev_block(RbEvent *ev, unsigned key, int timeout_ms) {
+    DWORD ms = (timeout_ms < 0) ? INFINITE : (DWORD)timeout_ms;
+    if (WaitOnAddress((volatile VOID*)&ev->seq, &key, sizeof(key), ms)) return true;
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+static void rb_ev_kick(RbEvent *ev) {
+    atomic_fetch_add_explicit(&ev->seq, 1, memory_order_release);
+    WakeByAddressAll((PVOID)&ev->seq);
+}
+
+long long rb_ev_now_ms(void) { return (long long)GetTickCount64(); }
+
+uint64_t rb_ev_now_ns(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)((double)c.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+
+void rb_ev_sleep_ms(unsigned ms) { Sleep(ms); }
+
+#elif defined(__linux__)
+/* ---------------- Linux：futex ---------------- */
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static bool rb_ev_block(RbEvent *ev, unsigned key, int timeout_ms) {
+    struct timespec ts, *pts = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec  = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        pts = &ts;
+    }
+    // seq 已不等于 key 时内核立即返回 EAGAIN
+    long r = syscall(SYS_futex, (unsigned*)&ev->seq, FUTEX_WAIT_PRIVATE, key, pts, NULL, 0);
+    return !(r < 0 && errno == ETIMEDOUT);
+}
+
+static void rb_ev_kick(RbEvent *ev) {
+    atomic_fetch_add_explicit(&ev->seq, 1, memory_order_release);
+    syscall(SYS_futex, (unsigned*)&ev->seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+#endif
+
+#if !defined(_WIN32)
+long long rb_ev_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t rb_ev_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void rb_ev_sleep_ms(unsigned ms) {
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+#endif
+
+#if !defined(_WIN32) && !defined(__linux__)
+/* ---------------- 其它 POSIX：互斥量 + 条件变量 ---------------- */
+#include <errno.h>
+
+static bool rb_ev_block(RbEvent *ev, unsigned key, int timeout_ms) {
+    struct timespec dl;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &dl);
+        dl.tv_sec  += timeout_ms / 1000;
+        dl.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (dl.tv_nsec >= 1000000000L) { dl.tv_sec++; dl.tv_nsec -= 1000000000L; }
+    }
+    bool woke = true;
+    pthread_mutex_lock(&ev->mu);
+    // seq 在锁内加一，所以这里检查后不会漏掉 broadcast
+    while (atomic_load_explicit(&ev->seq, memory_order_relaxed) == key) {
+        int rc = (timeout_ms < 0) ? pthread_cond_wait(&ev->cv, &ev->mu)
+                                  : pthread_cond_timedwait(&ev->cv, &ev->mu, &dl);
+        if (rc == ETIMEDOUT) { woke = false; break; }
+    }
+    pthread_mutex_unlock(&ev->mu);
+    return woke;
+}
+
+static void rb_ev_kick(RbEvent *ev) {
+    pthread_mutex_lock(&ev->mu);
+    atomic_fetch_add_explicit(&ev->seq, 1, memory_order_release);
+    pthread_cond_broadcast(&ev->cv);
+    pthread_mutex_unlock(&ev->mu);
+}
+#endif
+
+void rb_ev_init(RbEvent *ev) {
+    if (!ev) return;
+    atomic_init(&ev->seq, 0);
+    atomic_init(&ev->waiters, 0);
+#if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_init(&ev->mu, NULL);
+    pthread_cond_init(&ev->cv, NULL);
+#endif
+}
+
+void rb_ev_destroy(RbEvent *ev) {
+    if (!ev) return;
+#if !defined(_WIN32) && !defined(__linux__)
+    pthread_cond_destroy(&ev->cv);
+    pthread_mutex_destroy(&ev->mu);
+#endif
+}
+
+unsigned rb_ev_prepare(RbEvent *ev) {
+    atomic_fetch_add_explicit(&ev->waiters, 1, memory_order_seq_cst);
+    unsigned key = atomic_load_explicit(&ev->seq, memory_order_acquire);
+    // 登记必须先于调用方随后对条件（如 tail）的读取
+    atomic_thread_fence(memory_order_seq_cst);
+    return key;
+}
+
+void rb_ev_cancel(RbEvent *ev) {
+    atomic_fetch_sub_explicit(&ev->waiters, 1, memory_order_relaxed);
+}
+
+bool rb_ev_wait(RbEvent *ev, unsigned key, int timeout_ms) {
+    bool woke = rb_ev_block(ev, key, timeout_ms);
+    atomic_fetch_sub_explicit(&ev->waiters, 1, memory_order_relaxed);
+    return woke;
+}
+
+void rb_ev_signal(RbEvent *ev) {
+    // 数据发布（调用方的 release store）必须先于对 waiters 的读取
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ev->waiters, memory_order_relaxed) == 0) return;
+    rb_ev_kick(ev);
+}
+
+void rb_ev_wake(RbEvent *ev) {
+    if (!ev) return;
+    rb_ev_kick(ev);
+}
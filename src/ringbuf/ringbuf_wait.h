@@ -0,0 +1,92 @@
+#ifndef RINGBUF_WAIT_H
+#define RINGBUF_WAIT_H
+
+/*
+ * 事件计数（eventcount）：让消费者在“没有数据”时真正睡下去，而不是 sleep 轮询。
+ *
+ * 消费者：                               生产者（每次发布数据后）：
+ *   key = rb_ev_prepare(ev);               发布 tail（release）
+ *   if (条件已满足) rb_ev_cancel(ev);       rb_ev_signal(ev);
+ *   else rb_ev_wait(ev, key, timeout);       └ 没有挂起者：一条 fence + 一次读，直接返回
+ *                                            └ 有挂起者：seq+1 并唤醒
+ *
+ * prepare 先登记为等待者再读 seq，之后才检查条件；生产者先发布数据再检查等待者。
+ * 两边中间都有 seq_cst 栅栏，所以“检查条件后、睡下去前”发布的数据一定会让 seq 变化，
+ * rb_ev_wait 发现 seq 已变立即返回，不会丢唤醒。
+ *
+ * 平台：Linux futex，Windows WaitOnAddress（Win8+，链接 Synchronization.lib），
+ *      其它 POSIX 用 pthread 互斥量 + 条件变量（只在有等待者时才加锁）。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#if !defined(_WIN32) && !defined(__linux__)
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    atomic_uint seq;     // 唤醒序号：每次有效唤醒 +1（futex / WaitOnAddress 等的就是这个字）
+    atomic_uint waiters; // 已登记（prepare 之后、wait/cancel 之前）的等待者数
+#if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+#endif
+} RbEvent;
+
+/**
+ * @brief 初始化/销毁（销毁时不得有等待者）
+ */
+void     rb_ev_init(RbEvent *ev);
+void     rb_ev_destroy(RbEvent *ev);
+
+/**
+ * @brief 等待方第一步：登记并取得当前序号，之后再检查等待条件
+ */
+unsigned rb_ev_prepare(RbEvent *ev);
+
+/**
+ * @brief 条件已满足，放弃等待（撤销登记）
+ */
+void     rb_ev_cancel(RbEvent *ev);
+
+/**
+ * @brief 序号仍为key时睡眠，最多timeout_ms（<0 一直等），返回时已撤销登记
+ * @return true被唤醒（或序号已变）；false超时
+ */
+bool     rb_ev_wait(RbEvent *ev, unsigned key, int timeout_ms);
+
+/**
+ * @brief 发布方：发布数据之后调用；没有等待者时只有一条栅栏和一次原子读
+ */
+void     rb_ev_signal(RbEvent *ev);
+
+/**
+ * @brief 单调时钟（毫秒），供带超时的循环等待计算剩余时间
+ */
+long long rb_ev_now_ms(void);
+
+/**
+ * @brief 单调时钟（纳秒，Windows QPC / POSIX CLOCK_MONOTONIC），测延迟、打时间戳用；各模块共用这一个时钟
+ */
+uint64_t rb_ev_now_ns(void);
+
+/**
+ * @brief 睡 ms 毫秒（不可被事件唤醒；要等数据请用 rb_ev_wait）
+ */
+void     rb_ev_sleep_ms(unsigned ms);
+
+/**
+ * @brief 无条件唤醒所有等待者（如通知消费者退出或重新检查外部状态）
+ */
+void     rb_ev_wake(RbEvent *ev);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RINGBUF_WAIT_H */
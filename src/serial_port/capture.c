@@ -0,0 +1,466 @@
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ringbuf/ringbuf.h"
+#include "../ringbuf/ringbuf_wait.h" // rb_ev_now_ns / rb_ev_sleep_ms
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define CAP_REPLAY_RB (64 * 1024) // 回放用的环，与在线的 g_rb 一样大
+
+/* ---------------- 小端编解码 ---------------- */
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+static uint64_t get_u64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/* ---------------- 头部 ---------------- */
+// 协议描述逐字段编码（不直接写结构体：填充与枚举宽度随编译器变）
+static void cap_put_proto(uint8_t *out, const ProtoDesc *d)
+{
+    memcpy(out, d->name, sizeof(d->name));
+    out[sizeof(d->name) - 1] = 0;
+    uint8_t *q = out + 24;
+    q[0] = (uint8_t)d->framing;
+    memcpy(q + 1, d->hdr, PROTO_HDR_MAX);
+    q[5] = d->hdr_len;
+    q[6] = d->len_off;
+    q[7] = d->len_size;
+    q[8] = d->len_be;
+    put_u16(q + 9, (uint16_t)d->len_adj);
+    put_u16(q + 11, d->max_body);
+    q[13] = (uint8_t)d->chk;
+    q[14] = (uint8_t)d->cover;
+    q[15] = d->chk_be;
+}
+
+static bool cap_get_proto(const uint8_t *in, ProtoDesc *d)
+{
+    memset(d, 0, sizeof(*d));
+    memcpy(d->name, in, sizeof(d->name));
+    d->name[sizeof(d->name) - 1] = 0;
+    const uint8_t *q = in + 24;
+    d->framing = (ProtoFraming)q[0];
+    memcpy(d->hdr, q + 1, PROTO_HDR_MAX);
+    d->hdr_len = q[5];
+    d->len_off = q[6];
+    d->len_size = q[7];
+    d->len_be = q[8] != 0;
+    d->len_adj = (int16_t)get_u16(q + 9);
+    d->max_body = get_u16(q + 11);
+    d->chk = (ProtoChk)q[13];
+    d->cover = (ProtoCover)q[14];
+    d->chk_be = q[15] != 0;
+    return d->framing <= PF_SLIP && d->chk <= PC_CRC32C && d->cover <= PCOV_ALL && proto_valid(d);
+}
+
+void cap_put_file_hdr(uint8_t *out, uint64_t start_unix_ns, const ProtoDesc *proto)
+{
+    ProtoDesc def;
+    if (!proto)
+    {
+        proto_default(&def);
+        proto = &def;
+    }
+    memset(out, 0, CAP_FILE_HDR);
+    memcpy(out, CAP_MAGIC, 8); // 含结尾 0
+    put_u32(out + 8, CAP_VERSION);
+    put_u32(out + 12, CAP_FILE_HDR);
+    put_u64(out + 16, start_unix_ns);
+    cap_put_proto(out + CAP_FILE_HDR_V1, proto);
+}
+
+void cap_put_rec_hdr(uint8_t *out, unsigned type, uint32_t len, uint64_t t_ns)
+{
+    put_u16(out, (uint16_t)type);
+    put_u16(out + 2, 0);
+    put_u32(out + 4, len);
+    put_u64(out + 8, t_ns);
+}
+
+bool cap_get_rec_hdr(const uint8_t *in, size_t n, unsigned *type, uint32_t *len, uint64_t *t_ns)
+{
+    if (!in || n < CAP_REC_HDR)
+        return false;
+    unsigned t = get_u16(in);
+    if (t < CAP_REC_DATA || t > CAP_REC_FOOTER)
+        return false;
+    if (type)
+        *type = t;
+    if (len)
+        *len = get_u32(in + 4);
+    if (t_ns)
+        *t_ns = get_u64(in + 8);
+    return true;
+}
+
+/* ---------------- 写端：索引 ---------------- */
+
+// 帧校验通过：fp.end_pos 就是一个干净的帧边界
+static void capx_on_frame(const uint8_t *payload, size_t len, void *user)
+{
+    (void)payload;
+    (void)len;
+    CapIndexer *x = (CapIndexer *)user;
+    uint64_t pos = x->fp.end_pos;
+    if (pos < x->next_mark || x->npend >= CAP_INDEX_BATCH)
+        return;
+    CapIndexEntry *e = &x->pend[x->npend++];
+    e->rec_off = x->chunk_off;
+    e->stream_pos = pos;
+    e->t_ns = x->chunk_t;
+    e->skip = (uint32_t)(pos - x->chunk_base);
+    x->next_mark = pos + CAP_INDEX_STRIDE;
+}
+
+void capx_init(CapIndexer *x, const ProtoDesc *proto)
+{
+    if (!x)
+        return;
+    memset(x, 0, sizeof(*x));
+    fp_init(&x->fp, capx_on_frame, x);
+    if (proto)
+        fp_set_proto(&x->fp, proto);
+}
+
+void capx_free(CapIndexer *x)
+{
+    if (!x)
+        return;
+    free(x->idx_offs);
+    x->idx_offs = NULL;
+    x->nidx = x->idx_cap = 0;
+}
+
+void capx_begin_chunk(CapIndexer *x, uint64_t rec_off, uint64_t t_ns)
+{
+    x->chunk_off = rec_off;
+    x->chunk_base = x->fp.bytes;
+    x->chunk_t = t_ns;
+}
+
+void capx_feed(CapIndexer *x, const uint8_t *p, size_t n)
+{
+    fp_feed(&x->fp, p, n);
+}
+
+bool capx_batch_full(const CapIndexer *x)
+{
+    return x->npend >= CAP_INDEX_BATCH;
+}
+
+size_t capx_encode_index(CapIndexer *x, uint8_t *out, uint64_t rec_off, uint64_t t_ns)
+{
+    if (x->npend == 0)
+        return 0;
+    if (x->nidx == x->idx_cap)
+    {
+        size_t nc = x->idx_cap ? x->idx_cap * 2 : 64;
+        uint64_t *p = (uint64_t *)realloc(x->idx_offs, nc * sizeof(*p));
+        if (!p)
+            return 0; // 放弃这批索引（回放时退化为更稀疏的索引）
+        x->idx_offs = p;
+        x->idx_cap = nc;
+    }
+    x->idx_offs[x->nidx++] = rec_off;
+
+    size_t len = x->npend * CAP_INDEX_ENTRY;
+    cap_put_rec_hdr(out, CAP_REC_INDEX, (uint32_t)len, t_ns);
+    uint8_t *q = out + CAP_REC_HDR;
+    for (size_t i = 0; i < x->npend; ++i, q += CAP_INDEX_ENTRY)
+    {
+        put_u64(q, x->pend[i].rec_off);
+        put_u64(q + 8, x->pend[i].stream_pos);
+        put_u64(q + 16, x->pend[i].t_ns);
+        put_u32(q + 24, x->pend[i].skip);
+        put_u32(q + 28, 0);
+    }
+    x->npend = 0;
+    return CAP_REC_HDR + len;
+}
+
+size_t capx_encode_footer(CapIndexer *x, uint64_t rec_off, uint64_t t_ns, uint8_t **out)
+{
+    size_t len = x->nidx * 8;
+    size_t total = CAP_REC_HDR + len + CAP_TRAILER;
+    uint8_t *p = (uint8_t *)malloc(total);
+    *out = p;
+    if (!p)
+        return 0;
+    cap_put_rec_hdr(p, CAP_REC_FOOTER, (uint32_t)len, t_ns);
+    for (size_t i = 0; i < x->nidx; ++i)
+        put_u64(p + CAP_REC_HDR + i * 8, x->idx_offs[i]);
+    put_u64(p + CAP_REC_HDR + len, rec_off);
+    memcpy(p + CAP_REC_HDR + len + 8, CAP_END_MAGIC, 8);
+    return total;
+}
+
+/* ---------------- 读端：映射 ---------------- */
+bool cap_map(CapFile *cf, const char *path)
+{
+    if (!cf || !path)
+        return false;
+    memset(cf, 0, sizeof(*cf));
+#ifdef _WIN32
+    cf->fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                         FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (cf->fh == INVALID_HANDLE_VALUE)
+    {
+        cf->fh = NULL;
+        return false;
+    }
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(cf->fh, &sz) || sz.QuadPart < CAP_FILE_HDR_V1)
+    {
+        cap_unmap(cf);
+        return false;
+    }
+    cf->size = (size_t)sz.QuadPart;
+    cf->map = CreateFileMappingA(cf->fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (cf->map)
+        cf->base = (const uint8_t *)MapViewOfFile(cf->map, FILE_MAP_READ, 0, 0, 0);
+#else
+    cf->fd = open(path, O_RDONLY);
+    if (cf->fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(cf->fd, &st) != 0 || st.st_size < CAP_FILE_HDR_V1)
+    {
+        cap_unmap(cf);
+        return false;
+    }
+    cf->size = (size_t)st.st_size;
+    void *m = mmap(NULL, cf->size, PROT_READ, MAP_PRIVATE, cf->fd, 0);
+    if (m != MAP_FAILED)
+    {
+        cf->base = (const uint8_t *)m;
+        madvise(m, cf->size, MADV_SEQUENTIAL); // 回放基本是顺序读
+    }
+#endif
+    if (!cf->base || memcmp(cf->base, CAP_MAGIC, 8) != 0)
+    {
+        cap_unmap(cf);
+        return false;
+    }
+    uint32_t ver = get_u32(cf->base + 8);
+    cf->hdr_len = get_u32(cf->base + 12);
+    bool ok;
+    if (ver == 1)
+    {
+        proto_default(&cf->proto); // 版本 1 只支持默认协议
+        ok = cf->hdr_len >= CAP_FILE_HDR_V1;
+    }
+    else
+        ok = ver == CAP_VERSION && cf->hdr_len >= CAP_FILE_HDR &&
+             cap_get_proto(cf->base + CAP_FILE_HDR_V1, &cf->proto);
+    if (!ok || cf->hdr_len > cf->size)
+    {
+        cap_unmap(cf);
+        return false;
+    }
+    cf->start_unix_ns = get_u64(cf->base + 16);
+    return true;
+}
+
+void cap_unmap(CapFile *cf)
+{
+    if (!cf)
+        return;
+#ifdef _WIN32
+    if (cf->base)
+        UnmapViewOfFile(cf->base);
+    if (cf->map)
+        CloseHandle(cf->map);
+    if (cf->fh)
+        CloseHandle(cf->fh);
+    cf->map = cf->fh = NULL;
+#else
+    if (cf->base)
+        munmap((void *)cf->base, cf->size);
+    if (cf->fd >= 0)
+        close(cf->fd);
+    cf->fd = -1;
+#endif
+    cf->base = NULL;
+    cf->size = 0;
+}
+
+/* ---------------- 读端：查找 ---------------- */
+
+// off 处是否有一条完整记录
+static bool cap_rec_at(const CapFile *cf, uint64_t off, unsigned *type, uint32_t *len, uint64_t *t_ns)
+{
+    if (off > cf->size || cf->size - off < CAP_REC_HDR)
+        return false;
+    uint32_t l = 0;
+    if (!cap_get_rec_hdr(cf->base + off, CAP_REC_HDR, type, &l, t_ns))
+        return false;
+    if (cf->size - off - CAP_REC_HDR < l)
+        return false; // 截断的尾记录
+    if (len)
+        *len = l;
+    return true;
+}
+
+// 在一条 INDEX 记录里更新“不晚于 t_ns 的最后一个点”；返回 false 表示已越过 t_ns，可以停了
+static bool cap_scan_index(const CapFile *cf, uint64_t off, uint32_t len, uint64_t t_ns,
+                           uint64_t *rec_off, uint32_t *skip)
+{
+    const uint8_t *q = cf->base + off + CAP_REC_HDR;
+    for (uint32_t i = 0; i + CAP_INDEX_ENTRY <= len; i += CAP_INDEX_ENTRY)
+    {
+        if (get_u64(q + i + 16) > t_ns)
+            return false;
+        *rec_off = get_u64(q + i);
+        *skip = get_u32(q + i + 24);
+    }
+    return true;
+}
+
+void cap_seek(const CapFile *cf, uint64_t t_ns, uint64_t *rec_off, uint32_t *skip)
+{
+    *rec_off = cf ? cf->hdr_len : CAP_FILE_HDR;
+    *skip = 0;
+    if (!cf || !cf->base || t_ns == 0)
+        return;
+
+    unsigned type;
+    uint32_t len;
+    // 有尾部：直接从 FOOTER 列出的 INDEX 记录里找
+    if (cf->size >= cf->hdr_len + CAP_REC_HDR + CAP_TRAILER &&
+        memcmp(cf->base + cf->size - 8, CAP_END_MAGIC, 8) == 0)
+    {
+        uint64_t foff = get_u64(cf->base + cf->size - CAP_TRAILER);
+        if (cap_rec_at(cf, foff, &type, &len, NULL) && type == CAP_REC_FOOTER)
+        {
+            const uint8_t *offs = cf->base + foff + CAP_REC_HDR;
+            for (uint32_t i = 0; i + 8 <= len; i += 8)
+            {
+                uint64_t ioff = get_u64(offs + i);
+                uint32_t ilen;
+                if (!cap_rec_at(cf, ioff, &type, &ilen, NULL) || type != CAP_REC_INDEX)
+                    continue;
+                if (!cap_scan_index(cf, ioff, ilen, t_ns, rec_off, skip))
+                    break;
+            }
+            return;
+        }
+    }
+    // 没有尾部：顺序跳过记录头找 INDEX（只读记录头，不碰数据）
+    for (uint64_t off = cf->hdr_len; cap_rec_at(cf, off, &type, &len, NULL); off += CAP_REC_HDR + len)
+    {
+        if (type == CAP_REC_INDEX && !cap_scan_index(cf, off, len, t_ns, rec_off, skip))
+            break;
+    }
+}
+
+/* ---------------- 读端：回放 ---------------- */
+
+// 把环里的数据喂给解析器并整体消费
+static void cap_drain(RingBuf *rb, FrameParser *fp)
+{
+    RbSpan sp[2];
+    size_t n = rb_read_peek_spans(rb, sp);
+    if (!n)
+        return;
+    fp_feed(fp, sp[0].ptr, sp[0].len);
+    fp_feed(fp, sp[1].ptr, sp[1].len);
+    rb_read_consume(rb, n);
+}
+
+bool cap_replay(const CapFile *cf, uint64_t from_ns, bool wire, FrameCallback cb, void *user,
+                CapReplayStats *st)
+{
+    if (!cf || !cf->base || !st)
+        return false;
+    memset(st, 0, sizeof(*st));
+    RingBuf rb;
+    if (!rb_init_pow2(&rb, CAP_REPLAY_RB))
+        return false;
+    FrameParser fp;
+    fp_init(&fp, cb, user);
+    fp_set_proto(&fp, &cf->proto);
+
+    uint64_t off;
+    uint32_t skip;
+    cap_seek(cf, from_ns, &off, &skip);
+
+    bool first = true;
+    uint64_t t_first = 0, t_last = 0;
+    uint64_t w0 = rb_ev_now_ns();
+    unsigned type;
+    uint32_t len;
+    uint64_t t;
+    for (; cap_rec_at(cf, off, &type, &len, &t); off += CAP_REC_HDR + len)
+    {
+        if (type != CAP_REC_DATA)
+            continue;
+        if (first)
+        {
+            t_first = t;
+            first = false;
+        }
+        else if (wire && t > t_first)
+        {
+            // 按抓包时间节奏：等到与第一块的相对时刻
+            uint64_t due = w0 + (t - t_first), now = rb_ev_now_ns();
+            if (due > now)
+                rb_ev_sleep_ms((unsigned)((due - now) / 1000000u)); // 不足 1ms 的间隔不睡，节奏精度 1ms
+        }
+        t_last = t;
+
+        const uint8_t *p = cf->base + off + CAP_REC_HDR + skip;
+        size_t n = len - (skip < len ? skip : len);
+        skip = 0;
+        st->bytes += n;
+        st->chunks++;
+        while (n)
+        {
+            size_t k = rb_push(&rb, p, n);
+            p += k;
+            n -= k;
+            cap_drain(&rb, &fp);
+        }
+    }
+    st->seconds = (double)(rb_ev_now_ns() - w0) * 1e-9;
+    st->span_ns = t_last - t_first;
+    st->frames = fp.frames;
+    st->chk_fail = fp.chk_fail;
+    st->noise = fp.noise_bytes;
+    rb_free(&rb);
+    return true;
+}
@@ -0,0 +1,147 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// 抓包文件格式（.spcap）：带时间戳的数据块 + 稀疏帧边界索引，可 mmap 回放
+//
+//   文件头   80B : "SPCAP01\0" | u32 版本 | u32 头长 | u64 开始时刻（Unix ns） | u64 保留 | 协议 48B
+//     协议   48B : name[24] | u8 framing | hdr[4] | u8 hdr_len | u8 len_off | u8 len_size | u8 len_be
+//                  | i16 len_adj | u16 max_body | u8 chk | u8 cover | u8 chk_be | 填 0 到 48B（见 ProtoDesc）
+//     版本 1 的文件头只有前 32B、没有协议，按默认 AA55 协议读；记录从“头长”处开始
+//   记录     16B 头 + 负载 : u16 类型 | u16 保留 | u32 负载长度 | u64 时间戳（相对开始，单调时钟 ns）
+//     DATA   负载 = 一次串口读到的原始字节
+//     INDEX  负载 = CapIndexEntry[]（每条 32B），指向帧边界（某一帧校验通过后的下一个字节）
+//     FOOTER 负载 = u64[]，所有 INDEX 记录的文件偏移
+//   尾部     16B : u64 FOOTER 记录偏移 | "SPCAPEND"
+//
+// - 所有整数小端；记录首尾相接、不填充
+// - 索引每隔约 CAP_INDEX_STRIDE 字节流取一个帧边界，攒够 CAP_INDEX_BATCH 条写一条 INDEX 记录
+// - 从帧边界开始喂解析器不会丢帧也不会误判，所以可以按时间直接跳到文件中间回放
+// - 索引与回放都用文件头里记录的协议分帧，抓包之后再切换 proto 不影响回放
+// - 没有尾部（写入中途崩溃）时回放照样可用，查找时改为顺序扫描记录头
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame_parser.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define CAP_MAGIC "SPCAP01"
+#define CAP_END_MAGIC "SPCAPEND"
+#define CAP_VERSION 2
+#define CAP_FILE_HDR_V1 32
+#define CAP_PROTO_BYTES 48
+#define CAP_FILE_HDR (CAP_FILE_HDR_V1 + CAP_PROTO_BYTES)
+#define CAP_REC_HDR 16
+#define CAP_TRAILER 16
+#define CAP_INDEX_ENTRY 32
+#define CAP_INDEX_STRIDE (64u * 1024) // 字节流上相邻两个索引点的最小间隔
+#define CAP_INDEX_BATCH 256           // 每条 INDEX 记录的条目数
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    enum
+    {
+        CAP_REC_DATA = 1,
+        CAP_REC_INDEX = 2,
+        CAP_REC_FOOTER = 3
+    };
+
+    typedef struct
+    {
+        uint64_t rec_off;    // 所在 DATA 记录的文件偏移
+        uint64_t stream_pos; // 边界在整个数据流中的位置
+        uint64_t t_ns;       // 该 DATA 记录的时间戳
+        uint32_t skip;       // 边界在该记录负载中的偏移（可能等于负载长度：下一条记录开头）
+    } CapIndexEntry;
+
+    // 编码文件头 / 记录头（out 至少 CAP_FILE_HDR / CAP_REC_HDR 字节）；proto 为 NULL 记默认协议
+    void cap_put_file_hdr(uint8_t *out, uint64_t start_unix_ns, const ProtoDesc *proto);
+    void cap_put_rec_hdr(uint8_t *out, unsigned type, uint32_t len, uint64_t t_ns);
+
+    // 解码记录头；n 为可用字节数，不足或类型非法返回 false
+    bool cap_get_rec_hdr(const uint8_t *in, size_t n, unsigned *type, uint32_t *len, uint64_t *t_ns);
+
+    /* ---------------- 写端：索引生成（日志写线程使用） ---------------- */
+
+    typedef struct
+    {
+        FrameParser fp;       // 只用来找帧边界
+        uint64_t next_mark;   // 流位置到这里之后取下一个索引点
+        uint64_t chunk_off;   // 当前 DATA 记录的文件偏移
+        uint64_t chunk_base;  // 当前 DATA 记录负载起点的流位置
+        uint64_t chunk_t;     // 当前 DATA 记录的时间戳
+        CapIndexEntry pend[CAP_INDEX_BATCH];
+        size_t npend;
+        uint64_t *idx_offs; // 已写出的 INDEX 记录偏移（FOOTER 用）
+        size_t nidx, idx_cap;
+    } CapIndexer;
+
+    // proto：找帧边界用的协议（与写进文件头的相同；NULL 为默认协议）
+    void capx_init(CapIndexer *x, const ProtoDesc *proto);
+    void capx_free(CapIndexer *x);
+
+    // 开始一条 DATA 记录，随后可分段 capx_feed 它的负载
+    void capx_begin_chunk(CapIndexer *x, uint64_t rec_off, uint64_t t_ns);
+    void capx_feed(CapIndexer *x, const uint8_t *p, size_t n);
+
+    // 待写的索引条目是否攒满一批
+    bool capx_batch_full(const CapIndexer *x);
+
+    // 把待写条目编码为一条 INDEX 记录（rec_off 为它将写到的文件偏移）；返回字节数，没有条目返回 0
+    // out 至少 CAP_REC_HDR + CAP_INDEX_BATCH * CAP_INDEX_ENTRY 字节
+    size_t capx_encode_index(CapIndexer *x, uint8_t *out, uint64_t rec_off, uint64_t t_ns);
+
+    // 编码 FOOTER 记录 + 尾部（rec_off 为 FOOTER 将写到的文件偏移）；*out 由调用方 free
+    size_t capx_encode_footer(CapIndexer *x, uint64_t rec_off, uint64_t t_ns, uint8_t **out);
+
+    /* ---------------- 读端：映射与回放 ---------------- */
+
+    typedef struct
+    {
+        const uint8_t *base;
+        size_t size;
+        uint64_t start_unix_ns;
+        uint32_t hdr_len; // 第一条记录的偏移
+        ProtoDesc proto;  // 抓包时的协议（版本 1 文件为默认协议）
+#ifdef _WIN32
+        HANDLE fh, map;
+#else
+        int fd;
+#endif
+    } CapFile;
+
+    typedef struct
+    {
+        uint64_t bytes;    // 回放的数据字节
+        uint64_t chunks;   // DATA 记录数
+        uint64_t frames;   // 解析出的帧
+        uint64_t chk_fail; // 校验失败
+        uint64_t noise;    // 噪声字节
+        uint64_t span_ns;  // 回放覆盖的抓包时间跨度
+        double seconds;    // 实际耗时
+    } CapReplayStats;
+
+    // 只读映射整个文件并校验文件头
+    bool cap_map(CapFile *cf, const char *path);
+    void cap_unmap(CapFile *cf);
+
+    // 找时间戳不晚于 t_ns 的最后一个索引点（t_ns=0 或找不到时返回第一条记录，skip=0）
+    void cap_seek(const CapFile *cf, uint64_t t_ns, uint64_t *rec_off, uint32_t *skip);
+
+    // 从 t_ns 处回放：wire=true 按抓包时间节奏，false 全速；
+    // 数据经 RingBuf + FrameParser（与在线解析同一套流水线，按 cf->proto 分帧），帧通过 cb 交付
+    bool cap_replay(const CapFile *cf, uint64_t from_ns, bool wire, FrameCallback cb, void *user,
+                    CapReplayStats *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_H
@@ -0,0 +1,150 @@
+#include "crc.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+#include <nmmintrin.h>
+#define CRC32C_HW 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_HW 1
+#else
+#define CRC32C_HW 0
+#endif
+
+static uint16_t t16[8][256];
+static uint32_t t32[8][256];
+static uint32_t t32c[8][256];
+static atomic_int g_state = 0; // 0 未生成，1 生成中，2 就绪
+
+static void build_reflected(uint32_t t[8][256], uint32_t poly)
+{
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? (c >> 1) ^ poly : c >> 1;
+        t[0][i] = c;
+    }
+    // t[k][i]：字节 i 后面再跟 k 个零字节的效果
+    for (int k = 1; k < 8; ++k)
+        for (int i = 0; i < 256; ++i)
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+}
+
+static void build_crc16(void)
+{
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint16_t c = (uint16_t)(i << 8);
+        for (int k = 0; k < 8; ++k)
+            c = (uint16_t)((c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1);
+        t16[0][i] = c;
+    }
+    for (int k = 1; k < 8; ++k)
+        for (int i = 0; i < 256; ++i)
+            t16[k][i] = (uint16_t)((t16[k - 1][i] << 8) ^ t16[0][t16[k - 1][i] >> 8]);
+}
+
+void crc_init(void)
+{
+    if (atomic_load_explicit(&g_state, memory_order_acquire) == 2)
+        return;
+    int expect = 0;
+    if (atomic_compare_exchange_strong(&g_state, &expect, 1))
+    {
+        build_crc16();
+        build_reflected(t32, 0xEDB88320u);
+        build_reflected(t32c, 0x82F63B78u);
+        atomic_store_explicit(&g_state, 2, memory_order_release);
+        return;
+    }
+    while (atomic_load_explicit(&g_state, memory_order_acquire) != 2)
+        ; // 另一个线程正在生成（几微秒）
+}
+
+// 每个计算入口先确认表已生成：就绪后只多一次 acquire 读，调用方不必记得先 crc_init
+static inline void crc_ensure(void)
+{
+    if (atomic_load_explicit(&g_state, memory_order_acquire) != 2)
+        crc_init();
+}
+
+static inline uint32_t load32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t crc16_update(uint16_t crc, const uint8_t *p, size_t n)
+{
+    crc_ensure();
+    while (n >= 8)
+    {
+        unsigned c = (unsigned)crc ^ ((unsigned)p[0] << 8 | p[1]);
+        crc = (uint16_t)(t16[7][c >> 8] ^ t16[6][c & 0xFF] ^ t16[5][p[2]] ^ t16[4][p[3]] ^
+                         t16[3][p[4]] ^ t16[2][p[5]] ^ t16[1][p[6]] ^ t16[0][p[7]]);
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        crc = (uint16_t)((crc << 8) ^ t16[0][(crc >> 8) ^ *p++]);
+    return crc;
+}
+
+static uint32_t crc32_sb8(const uint32_t t[8][256], uint32_t crc, const uint8_t *p, size_t n)
+{
+    crc = ~crc;
+    while (n >= 8)
+    {
+        uint32_t lo = crc ^ load32le(p), hi = load32le(p + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n)
+{
+    crc_ensure();
+    return crc32_sb8(t32, crc, p, n);
+}
+
+uint32_t crc32c_update(uint32_t crc, const uint8_t *p, size_t n)
+{
+#if CRC32C_HW
+    crc = ~crc;
+    while (n >= 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+#if defined(__x86_64__) || defined(_M_X64)
+        crc = (uint32_t)_mm_crc32_u64(crc, v);
+#else
+        crc = __crc32cd(crc, v);
+#endif
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        crc = _mm_crc32_u8(crc, *p++);
+#else
+        crc = __crc32cb(crc, *p++);
+#endif
+    }
+    return ~crc;
+#else
+    crc_ensure();
+    return crc32_sb8(t32c, crc, p, n);
+#endif
+}
+
+int crc32c_hw(void)
+{
+    return CRC32C_HW;
+}
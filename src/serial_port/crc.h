@@ -0,0 +1,44 @@
+#ifndef CRC_H
+#define CRC_H
+
+// CRC 内核（帧协议引擎用）
+//
+// - CRC16-CCITT（多项式 0x1021，初值 0xFFFF，不反射，即 CCITT-FALSE）
+// - CRC32（IEEE 802.3，反射多项式 0xEDB88320，初值/结果异或 0xFFFFFFFF）
+// - CRC32C（Castagnoli，0x82F63B78）：编译目标带 SSE4.2 / ARMv8 CRC 扩展时用硬件指令
+// 全部是 slice-by-8：每次查 8 张表处理 8 字节；表在第一次计算（或 crc_init）时生成，不需要调用方先初始化
+//
+// 校验值："123456789" -> CRC16 0x29B1，CRC32 0xCBF43926，CRC32C 0xE3069283
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // 提前生成查找表（可选：省掉第一次计算时的生成开销；可重复调用、可多线程同时调用）
+    void crc_init(void);
+
+    // 分段计算：crc = crc16_update(crc, p, n)，首段传 CRC16_INIT，结果直接可用
+#define CRC16_INIT 0xFFFFu
+    uint16_t crc16_update(uint16_t crc, const uint8_t *p, size_t n);
+
+    // 分段计算：首段传 0，结果直接可用（内部处理初值与结果异或）
+    uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n);
+    uint32_t crc32c_update(uint32_t crc, const uint8_t *p, size_t n);
+
+    // 一次算完
+    static inline uint16_t crc16_ccitt(const uint8_t *p, size_t n) { return crc16_update(CRC16_INIT, p, n); }
+    static inline uint32_t crc32_ieee(const uint8_t *p, size_t n) { return crc32_update(0, p, n); }
+    static inline uint32_t crc32c(const uint8_t *p, size_t n) { return crc32c_update(0, p, n); }
+
+    // CRC32C 是否走硬件指令（编译期决定）
+    int crc32c_hw(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC_H
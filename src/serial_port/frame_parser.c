@@ -0,0 +1,451 @@
+#include "frame_parser.h"
+#include "crc.h"
+#include <string.h>
+
+/* ---------------- 校验函数表 ---------------- */
+typedef uint32_t (*ChkFn)(const uint8_t *p, size_t n);
+
+static uint32_t chk_none(const uint8_t *p, size_t n)
+{
+    (void)p;
+    (void)n;
+    return 0;
+}
+static uint32_t chk_sum8(const uint8_t *p, size_t n)
+{
+    uint32_t s = 0;
+    for (size_t i = 0; i < n; ++i)
+        s += p[i];
+    return s & 0xFFu;
+}
+static uint32_t chk_xor8(const uint8_t *p, size_t n)
+{
+    uint8_t x = 0;
+    for (size_t i = 0; i < n; ++i)
+        x ^= p[i];
+    return x;
+}
+static uint32_t chk_crc16(const uint8_t *p, size_t n) { return crc16_ccitt(p, n); }
+static uint32_t chk_crc32(const uint8_t *p, size_t n) { return crc32_ieee(p, n); }
+static uint32_t chk_crc32c(const uint8_t *p, size_t n) { return crc32c(p, n); }
+
+static const ChkFn k_chk_fn[] = {chk_none, chk_sum8, chk_xor8, chk_crc16, chk_crc32, chk_crc32c};
+
+// 读 w 字节整数（长度字段 / 校验值）
+static uint32_t get_uint(const uint8_t *p, size_t w, bool be)
+{
+    uint32_t v = 0;
+    for (size_t i = 0; i < w; ++i)
+        v |= (uint32_t)p[be ? i : w - 1 - i] << (8 * (w - 1 - i));
+    return v;
+}
+
+// 校验 buf[from, to) 与紧随其后的校验值；通过则计数交付 body
+static size_t fp_deliver(FrameParser *fp, size_t from, size_t to, const uint8_t *body, size_t blen,
+                         uint64_t end_pos)
+{
+    const ProtoDesc *d = &fp->proto;
+    size_t ck = proto_chk_size(d->chk);
+    if (ck && k_chk_fn[d->chk](fp->buf + from, to - from) != get_uint(fp->buf + to, ck, d->chk_be))
+    {
+        fp->chk_fail++;
+        return 0;
+    }
+    fp->end_pos = end_pos;
+    fp->frames++;
+    if (fp->cb)
+        fp->cb(body, blen, fp->user);
+    return 1;
+}
+
+/* ---------------- 默认协议：AA 55 | LEN | PAYLOAD | SUM8 ---------------- */
+static size_t fp_feed_aa55(FrameParser *fp, const uint8_t *data, size_t n)
+{
+    size_t frames = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        switch (fp->state)
+        {
+        case FP_HUNT_AA:
+        {
+            // 噪声整段跳过
+            const uint8_t *hit = (const uint8_t *)memchr(data + i, 0xAA, n - i);
+            if (!hit)
+            {
+                fp->noise_bytes += n - i;
+                i = n;
+                break;
+            }
+            size_t skip = (size_t)(hit - (data + i));
+            fp->noise_bytes += skip;
+            i += skip + 1;
+            fp->state = FP_HUNT_55;
+            break;
+        }
+        case FP_HUNT_55:
+        {
+            uint8_t b = data[i++];
+            if (b == 0x55)
+                fp->state = FP_LEN;
+            else if (b == 0xAA)
+                fp->noise_bytes += 1; // 前一个 AA 是噪声，这个 AA 可能才是帧头
+            else
+            {
+                fp->noise_bytes += 2;
+                fp->state = FP_HUNT_AA;
+            }
+            break;
+        }
+        case FP_LEN:
+            fp->len = data[i++];
+            fp->got = 0;
+            fp->chk = fp->len;
+            fp->state = fp->len ? FP_PAYLOAD : FP_CHK;
+            break;
+        case FP_PAYLOAD:
+        {
+            // 能拿多少拿多少，边拷贝边累加校验和
+            size_t k = (size_t)(fp->len - fp->got);
+            if (k > n - i)
+                k = n - i;
+            const uint8_t *src = data + i;
+            uint8_t *dst = fp->buf + fp->got;
+            unsigned s = 0;
+            for (size_t j = 0; j < k; ++j)
+            {
+                dst[j] = src[j];
+                s += src[j];
+            }
+            fp->chk += s;
+            fp->got = (uint8_t)(fp->got + k);
+            i += k;
+            if (fp->got == fp->len)
+                fp->state = FP_CHK;
+            break;
+        }
+        case FP_CHK:
+        {
+            uint8_t b = data[i++];
+            if (b == (uint8_t)(fp->chk & 0xFFu))
+            {
+                fp->end_pos = fp->bytes - (n - i); // bytes 已包含本次的 n
+                fp->frames++;
+                frames++;
+                if (fp->cb)
+                    fp->cb(fp->buf, fp->len, fp->user);
+            }
+            else
+            {
+                // 校验失败，放弃这帧（与旧的 try_pop_one_frame 行为一致）
+                fp->chk_fail++;
+            }
+            fp->state = FP_HUNT_AA;
+            break;
+        }
+        default:
+            fp->state = FP_HUNT_AA;
+            break;
+        }
+    }
+    return frames;
+}
+
+/* ---------------- 通用长度字段协议 ---------------- */
+
+// 帧头不匹配：丢掉最前面的字节，直到 buf 剩下的部分仍是帧头的前缀
+static void fp_hdr_resync(FrameParser *fp)
+{
+    const ProtoDesc *d = &fp->proto;
+    size_t s = 1;
+    while (s < fp->fill && memcmp(fp->buf + s, d->hdr, fp->fill - s) != 0)
+        ++s;
+    fp->noise_bytes += s;
+    memmove(fp->buf, fp->buf + s, fp->fill - s);
+    fp->fill -= s;
+}
+
+static size_t fp_feed_len(FrameParser *fp, const uint8_t *data, size_t n)
+{
+    const ProtoDesc *d = &fp->proto;
+    const size_t ck = proto_chk_size(d->chk);
+    const size_t fields = (size_t)d->hdr_len + d->len_off + d->len_size;
+    size_t frames = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        switch (fp->state)
+        {
+        case FP_HDR:
+        {
+            if (fp->fill == 0)
+            {
+                const uint8_t *hit = (const uint8_t *)memchr(data + i, d->hdr[0], n - i);
+                if (!hit)
+                {
+                    fp->noise_bytes += n - i;
+                    i = n;
+                    break;
+                }
+                size_t skip = (size_t)(hit - (data + i));
+                fp->noise_bytes += skip;
+                i += skip + 1;
+                fp->buf[fp->fill++] = d->hdr[0];
+            }
+            else
+            {
+                uint8_t b = data[i++];
+                fp->buf[fp->fill++] = b;
+                if (b != d->hdr[fp->fill - 1])
+                    fp_hdr_resync(fp);
+            }
+            if (fp->fill == d->hdr_len)
+            {
+                fp->need = fields;
+                fp->state = FP_FIELDS;
+            }
+            break;
+        }
+        case FP_FIELDS:
+        case FP_BODY:
+        {
+            size_t k = fp->need - fp->fill;
+            if (k > n - i)
+                k = n - i;
+            memcpy(fp->buf + fp->fill, data + i, k);
+            fp->fill += k;
+            i += k;
+            if (fp->fill < fp->need)
+                break;
+            if (fp->state == FP_FIELDS)
+            {
+                long body = (long)get_uint(fp->buf + fields - d->len_size, d->len_size, d->len_be) + d->len_adj;
+                if (body < 0 || body > (long)d->max_body)
+                {
+                    // 长度不可信：当作噪声，重新找头（同校验失败，不回头重扫已收字节）
+                    fp->oversize++;
+                    fp->noise_bytes += fp->fill;
+                    fp->fill = 0;
+                    fp->state = FP_HDR;
+                    break;
+                }
+                fp->need = fields + (size_t)body + ck;
+                fp->state = FP_BODY;
+                if (fp->fill < fp->need)
+                    break;
+            }
+            size_t end = fp->need - ck;
+            size_t from = (d->cover == PCOV_ALL) ? 0 : (d->cover == PCOV_BODY) ? fields : d->hdr_len;
+            frames += fp_deliver(fp, from, end, fp->buf + fields, end - fields, fp->bytes - (n - i));
+            fp->fill = 0;
+            fp->state = FP_HDR;
+            break;
+        }
+        default:
+            fp->fill = 0;
+            fp->state = FP_HDR;
+            break;
+        }
+    }
+    return frames;
+}
+
+/* ---------------- 分隔符协议：COBS / SLIP ---------------- */
+
+// 解码后的帧：末尾 ck 字节是校验。coded 表示两个分隔符之间确实出现过编码字节：
+// COBS 的 "01 00" 是合法的空帧，而 SLIP 的连续 END 与帧间空闲无法区分
+static size_t fp_delim_done(FrameParser *fp, size_t len, bool coded, uint64_t end_pos)
+{
+    size_t ck = proto_chk_size(fp->proto.chk);
+    if (len == 0 && !coded)
+        return 0; // 连续分隔符 / 帧间空闲
+    if (len < ck)
+    {
+        fp->chk_fail++;
+        return 0;
+    }
+    if (len - ck > fp->proto.max_body)
+    {
+        fp->oversize++;
+        return 0;
+    }
+    return fp_deliver(fp, 0, len - ck, fp->buf, len - ck, end_pos);
+}
+
+// 原地 COBS 解码 buf[0, n)；编码错误返回 SIZE_MAX
+static size_t cobs_decode_inplace(uint8_t *buf, size_t n)
+{
+    size_t r = 0, w = 0;
+    while (r < n)
+    {
+        uint8_t code = buf[r++];
+        if (code == 0 || r + code - 1 > n)
+            return (size_t)-1;
+        size_t k = (size_t)code - 1;
+        memmove(buf + w, buf + r, k);
+        w += k;
+        r += k;
+        if (code != 0xFF && r < n)
+            buf[w++] = 0;
+    }
+    return w;
+}
+
+static size_t fp_feed_cobs(FrameParser *fp, const uint8_t *data, size_t n)
+{
+    size_t frames = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        const uint8_t *hit = (const uint8_t *)memchr(data + i, 0x00, n - i);
+        size_t k = hit ? (size_t)(hit - (data + i)) : n - i;
+        if (!fp->over)
+        {
+            if (fp->fill + k > sizeof(fp->buf))
+                fp->over = true;
+            else
+                memcpy(fp->buf + fp->fill, data + i, k);
+            fp->fill += k;
+        }
+        i += k;
+        if (!hit)
+            break;
+        ++i; // 分隔符
+        if (fp->over)
+            fp->oversize++;
+        else if (fp->fill)
+        {
+            size_t len = cobs_decode_inplace(fp->buf, fp->fill);
+            if (len == (size_t)-1)
+                fp->chk_fail++;
+            else
+                frames += fp_delim_done(fp, len, true, fp->bytes - (n - i));
+        }
+        fp->fill = 0;
+        fp->over = false;
+    }
+    return frames;
+}
+
+#define SLIP_END 0xC0
+#define SLIP_ESC 0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+static size_t fp_feed_slip(FrameParser *fp, const uint8_t *data, size_t n)
+{
+    size_t frames = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        uint8_t b = data[i++];
+        if (b == SLIP_END)
+        {
+            if (fp->over)
+                fp->oversize++;
+            else if (!fp->esc)
+                frames += fp_delim_done(fp, fp->fill, false, fp->bytes - (n - i));
+            else
+                fp->chk_fail++; // 转义符后直接结束
+            fp->fill = 0;
+            fp->esc = fp->over = false;
+            continue;
+        }
+        if (fp->esc)
+        {
+            b = (b == SLIP_ESC_END) ? SLIP_END : (b == SLIP_ESC_ESC) ? SLIP_ESC : b;
+            fp->esc = false;
+        }
+        else if (b == SLIP_ESC)
+        {
+            fp->esc = true;
+            continue;
+        }
+        else
+        {
+            // 普通字节成段拷贝：找到下一个特殊字节为止
+            size_t j = i;
+            while (j < n && data[j] != SLIP_END && data[j] != SLIP_ESC)
+                ++j;
+            size_t k = j - i + 1; // 含 b
+            if (!fp->over && fp->fill + k <= sizeof(fp->buf))
+            {
+                fp->buf[fp->fill] = b;
+                memcpy(fp->buf + fp->fill + 1, data + i, k - 1);
+                fp->fill += k;
+            }
+            else
+                fp->over = true;
+            i = j;
+            continue;
+        }
+        if (!fp->over && fp->fill < sizeof(fp->buf))
+            fp->buf[fp->fill++] = b;
+        else
+            fp->over = true;
+    }
+    return frames;
+}
+
+/* ---------------- 对外接口 ---------------- */
+
+// 与默认协议等价才走专用代码（1 字节长度，max_body >= 255 等于不设上限）
+static bool is_plain_aa55(const ProtoDesc *d)
+{
+    return d->framing == PF_LENGTH && d->hdr_len == 2 && d->hdr[0] == 0xAA && d->hdr[1] == 0x55 &&
+           d->len_off == 0 && d->len_size == 1 && d->len_adj == 0 && d->max_body >= 255 && d->chk == PC_SUM8 &&
+           d->cover == PCOV_LEN_BODY;
+}
+
+void fp_init(FrameParser *fp, FrameCallback cb, void *user)
+{
+    if (!fp)
+        return;
+    memset(fp, 0, sizeof(*fp));
+    ProtoDesc d;
+    proto_default(&d);
+    fp_set_proto(fp, &d);
+    fp->cb = cb;
+    fp->user = user;
+}
+
+bool fp_set_proto(FrameParser *fp, const ProtoDesc *d)
+{
+    if (!fp || !proto_valid(d))
+        return false;
+    crc_init();
+    fp->proto = *d;
+    switch (d->framing)
+    {
+    case PF_COBS:
+        fp->feed = fp_feed_cobs;
+        break;
+    case PF_SLIP:
+        fp->feed = fp_feed_slip;
+        break;
+    default:
+        fp->feed = is_plain_aa55(d) ? fp_feed_aa55 : fp_feed_len;
+        break;
+    }
+    fp_reset(fp);
+    return true;
+}
+
+void fp_reset(FrameParser *fp)
+{
+    if (!fp)
+        return;
+    fp->state = (fp->feed == fp_feed_aa55) ? FP_HUNT_AA : (fp->feed == fp_feed_len) ? FP_HDR : FP_DELIM;
+    fp->len = fp->got = 0;
+    fp->chk = 0;
+    fp->fill = fp->need = 0;
+    fp->esc = fp->over = false;
+}
+
+size_t fp_feed(FrameParser *fp, const uint8_t *data, size_t n)
+{
+    if (!fp || !data || n == 0)
+        return 0;
+    fp->bytes += n;
+    return fp->feed(fp, data, n);
+}
@@ -0,0 +1,87 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "proto.h"
+
+// 增量帧解析器：默认 AA 55 | LEN(1) | PAYLOAD[len] | CHK(1) ，CHK = (LEN + sum(PAYLOAD)) & 0xFF
+// 其他协议（2/4 字节长度、CRC16/CRC32、COBS/SLIP）见 proto.h，用 fp_set_proto 切换
+//
+// - 状态跨调用保存：数据可以任意切块喂入（一次一个字节或一次 64 KiB 都行）
+// - 每个输入字节只看一次，总开销与输入字节数成线性
+// - 找帧头时用 memchr 跳过噪声；负载整块 memcpy 到解析器自己的缓冲
+// - 收到完整且校验正确的帧后通过回调交付（payload 指针只在回调内有效）
+// - 解码函数在 fp_set_proto 时按描述选定：默认协议走专用的逐状态代码（边收边算校验和），
+//   其他长度字段协议走通用代码但只在每帧头尾解释描述（负载整块拷贝，CRC 整块 slice-by-8）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef void (*FrameCallback)(const uint8_t *payload, size_t len, void *user);
+
+    typedef enum
+    {
+        FP_HUNT_AA = 0, // 找 0xAA
+        FP_HUNT_55,     // 已见 0xAA，等 0x55
+        FP_LEN,         // 等 LEN
+        FP_PAYLOAD,     // 收负载
+        FP_CHK,         // 等 CHK
+        // 通用长度字段协议
+        FP_HDR,    // 匹配帧头
+        FP_FIELDS, // 收 PRE + LEN
+        FP_BODY,   // 收 BODY + CHK
+        // 分隔符协议（COBS/SLIP）
+        FP_DELIM
+    } FpState;
+
+    typedef struct FrameParser FrameParser;
+    typedef size_t (*FpFeedFn)(FrameParser *fp, const uint8_t *data, size_t n);
+
+    struct FrameParser
+    {
+        FpFeedFn feed;   // 按协议选定的解码函数
+        ProtoDesc proto; // 当前协议
+        FpState state;
+        uint8_t len;  // 默认协议：当前帧负载长度
+        uint8_t got;  // 默认协议：已收负载字节
+        unsigned chk; // 默认协议：运行中的校验和（LEN + 已收负载）
+        size_t fill;  // 通用/分隔符：buf 中已有字节（从帧头起）
+        size_t need;  // 通用：当前阶段结束时 fill 应达到的值
+        bool esc;     // SLIP：上一个字节是转义符
+        bool over;    // 分隔符：本帧超长，丢到下一个分隔符为止
+        uint8_t buf[PROTO_MAX_FRAME];
+
+        FrameCallback cb;
+        void *user;
+        uint64_t end_pos; // 最近交付的帧结束后的流位置（= 下一帧可能的起点，回调内可读）
+
+        // 统计（只由调用 fp_feed 的线程写）
+        uint64_t bytes;       // 喂入总字节
+        uint64_t frames;      // 交付的完整帧
+        uint64_t chk_fail;    // 校验失败（或 COBS 编码错误）丢弃的帧
+        uint64_t noise_bytes; // 找帧头时跳过的字节
+        uint64_t oversize;    // 长度超过 max_body 被丢弃的帧
+    };
+
+    // 初始化为默认协议（cb 可为 NULL，只做统计）
+    void fp_init(FrameParser *fp, FrameCallback cb, void *user);
+
+    // 切换协议（丢弃未完成的帧，统计保留）；描述不合法返回 false 且不改变当前协议
+    bool fp_set_proto(FrameParser *fp, const ProtoDesc *d);
+
+    // 丢弃未完成的帧，回到找帧头状态（统计保留）
+    void fp_reset(FrameParser *fp);
+
+    // 喂入 n 字节；返回本次交付的帧数
+    size_t fp_feed(FrameParser *fp, const uint8_t *data, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_PARSER_H
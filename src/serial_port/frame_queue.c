@@ -0,0 +1,83 @@
+#include "frame_queue.h"
+#include <stdlib.h>
+
+bool fq_init(FrameQueue *q, size_t nslots)
+{
+    if (!q || nslots == 0)
+        return false;
+    size_t n = 1;
+    while (n < nslots)
+        n <<= 1;
+    q->slots = (FqSlot *)calloc(n, sizeof(FqSlot));
+    if (!q->slots)
+        return false;
+    q->mask = n - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    rb_ev_init(&q->ev);
+    return true;
+}
+
+void fq_free(FrameQueue *q)
+{
+    if (!q || !q->slots)
+        return;
+    rb_ev_destroy(&q->ev);
+    free(q->slots);
+    q->slots = NULL;
+}
+
+FqSlot *fq_reserve(FrameQueue *q)
+{
+    size_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (t - h > q->mask)
+        return NULL; // 满
+    return &q->slots[t & q->mask];
+}
+
+void fq_publish(FrameQueue *q)
+{
+    size_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, t + 1, memory_order_release);
+    rb_ev_signal(&q->ev);
+}
+
+size_t fq_readable(const FrameQueue *q)
+{
+    size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return t - h;
+}
+
+FqSlot *fq_at(FrameQueue *q, size_t i)
+{
+    size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+    return &q->slots[(h + i) & q->mask];
+}
+
+void fq_release(FrameQueue *q, size_t n)
+{
+    size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->head, h + n, memory_order_release);
+}
+
+size_t fq_wait(FrameQueue *q, int timeout_ms)
+{
+    size_t n = fq_readable(q);
+    if (n)
+        return n;
+    unsigned key = rb_ev_prepare(&q->ev);
+    if ((n = fq_readable(q)) != 0)
+    {
+        rb_ev_cancel(&q->ev);
+        return n;
+    }
+    rb_ev_wait(&q->ev, key, timeout_ms);
+    return fq_readable(q);
+}
+
+void fq_wake(FrameQueue *q)
+{
+    rb_ev_wake(&q->ev);
+}
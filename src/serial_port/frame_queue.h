@@ -0,0 +1,73 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+// 帧槽队列：解析线程（printer）-> 渲染线程 的无锁 SPSC 队列，槽位预先分配
+//
+// - 每个槽装一帧或一段不超过 FQ_SLOT_BYTES 的原始数据；更长的帧只保留前 FQ_SLOT_BYTES 字节（total 记原长）
+// - 生产者 fq_reserve 拿空槽、填好后 fq_publish；满了返回 NULL，由调用者丢弃并计数（从不等待）
+// - 消费者 fq_wait 等有槽可读，fq_at 按序取、fq_release 批量归还
+// - 槽数向上取整为 2 的幂；计数器自由增长，用 mask 取下标（与 RingBufSpsc 同样的做法）
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "../ringbuf/ringbuf_wait.h"
+
+#define FQ_SLOT_BYTES 256 // 单槽数据上限
+#define FQ_TAG_MAX 32     // 来源标签（多串口组的端口名）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    enum
+    {
+        FQ_RAW = 0,   // 原始字节（非解析模式）
+        FQ_FRAME = 1, // 一帧负载
+        FQ_GAP = 2    // 原始显示被接收线程越过：之前刚展示的一段可能混入新数据（无数据）
+    };
+
+    typedef struct
+    {
+        uint16_t len;         // data 中的字节
+        uint32_t total;       // 帧的原始长度（>= len）
+        uint8_t kind;         // FQ_RAW / FQ_FRAME / FQ_GAP
+        char tag[FQ_TAG_MAX]; // 空串表示单串口
+        uint8_t data[FQ_SLOT_BYTES];
+    } FqSlot;
+
+    typedef struct
+    {
+        FqSlot *slots;
+        size_t mask;        // 槽数 - 1
+        atomic_size_t head; // 只由消费者推进
+        atomic_size_t tail; // 只由生产者推进
+        RbEvent ev;         // 发布时通知消费者
+    } FrameQueue;
+
+    bool fq_init(FrameQueue *q, size_t nslots);
+    void fq_free(FrameQueue *q);
+
+    // 生产者：取一个空槽（满了返回 NULL）；填好后 fq_publish 发布
+    FqSlot *fq_reserve(FrameQueue *q);
+    void fq_publish(FrameQueue *q);
+
+    // 消费者：可读槽数 / 第 i 个可读槽 / 归还前 n 个
+    size_t fq_readable(const FrameQueue *q);
+    FqSlot *fq_at(FrameQueue *q, size_t i);
+    void fq_release(FrameQueue *q, size_t n);
+
+    // 消费者：等到至少有一个槽可读、超时或 fq_wake；返回可读槽数
+    size_t fq_wait(FrameQueue *q, int timeout_ms);
+
+    // 任意线程：叫醒 fq_wait
+    void fq_wake(FrameQueue *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,562 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // O_DIRECT
+#endif
+#include "log_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LW_IDLE_MS 200 // 没有待写数据时最多睡这么久（只为检查 run）
+
+static size_t lw_round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+void lw_default_config(LwConfig *cfg)
+{
+    if (!cfg)
+        return;
+    cfg->queue_bytes = 1u << 20;
+    cfg->block_bytes = 64u * 1024;
+    cfg->flush_ms = 200;
+    cfg->direct = false;
+    cfg->capture = false;
+    cfg->src = NULL;
+    cfg->src_policy = RBB_DROP;
+    cfg->proto = NULL;
+}
+
+/* ---------------- 平台相关：文件与线程 ---------------- */
+#ifdef _WIN32
+static uint8_t *lw_alloc(size_t n)
+{
+    return (uint8_t *)VirtualAlloc(NULL, n, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE); // 页对齐
+}
+static void lw_dealloc(uint8_t *p) { VirtualFree(p, 0, MEM_RELEASE); }
+
+static bool lw_sys_open(LogWriter *lw, const char *path, bool direct, bool trunc)
+{
+    DWORD access = direct ? (GENERIC_READ | GENERIC_WRITE) : FILE_APPEND_DATA;
+    DWORD flags = direct ? (FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING) : FILE_ATTRIBUTE_NORMAL;
+    lw->fh = CreateFileA(path, access, FILE_SHARE_READ, NULL, trunc ? CREATE_ALWAYS : OPEN_ALWAYS, flags, NULL);
+    if (lw->fh == INVALID_HANDLE_VALUE)
+    {
+        lw->fh = NULL;
+        return false;
+    }
+    if (!direct)
+        return true;
+    // 追加：从最后一个不完整的块开始，把这块已有的内容读回缓冲
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(lw->fh, &sz))
+        return false;
+    lw->off = (uint64_t)sz.QuadPart & ~(uint64_t)(LW_ALIGN - 1);
+    size_t tail = (size_t)((uint64_t)sz.QuadPart - lw->off);
+    if (tail)
+    {
+        OVERLAPPED ov = {0};
+        DWORD rd = 0;
+        ov.Offset = (DWORD)lw->off;
+        ov.OffsetHigh = (DWORD)(lw->off >> 32);
+        if (!ReadFile(lw->fh, lw->buf, LW_ALIGN, &rd, &ov) || rd < tail)
+            return false;
+    }
+    lw->fill = lw->synced = tail;
+    return true;
+}
+
+// direct：在 off 处写 n 字节（n 已对齐）；否则追加
+static bool lw_sys_write(LogWriter *lw, const uint8_t *p, size_t n, uint64_t off)
+{
+    DWORD wr = 0;
+    if (!lw->direct)
+        return WriteFile(lw->fh, p, (DWORD)n, &wr, NULL) && wr == n;
+    OVERLAPPED ov = {0};
+    ov.Offset = (DWORD)off;
+    ov.OffsetHigh = (DWORD)(off >> 32);
+    return WriteFile(lw->fh, p, (DWORD)n, &wr, &ov) && wr == n;
+}
+
+static void lw_sys_close(LogWriter *lw, uint64_t size)
+{
+    if (!lw->fh)
+        return;
+    if (lw->direct)
+    {
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)size;
+        if (SetFilePointerEx(lw->fh, pos, NULL, FILE_BEGIN))
+            SetEndOfFile(lw->fh); // 去掉尾块补零
+    }
+    CloseHandle(lw->fh);
+    lw->fh = NULL;
+}
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+static uint8_t *lw_alloc(size_t n)
+{
+    void *p = NULL;
+    return posix_memalign(&p, LW_ALIGN, n) == 0 ? (uint8_t *)p : NULL;
+}
+static void lw_dealloc(uint8_t *p) { free(p); }
+
+static bool lw_sys_open(LogWriter *lw, const char *path, bool direct, bool trunc)
+{
+    int tr = trunc ? O_TRUNC : 0;
+#ifdef O_DIRECT
+    if (direct)
+    {
+        lw->fd = open(path, O_RDWR | O_CREAT | O_DIRECT | tr, 0644);
+        if (lw->fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(lw->fd, &st) != 0)
+            return false;
+        lw->off = (uint64_t)st.st_size & ~(uint64_t)(LW_ALIGN - 1);
+        size_t tail = (size_t)((uint64_t)st.st_size - lw->off);
+        if (tail && pread(lw->fd, lw->buf, LW_ALIGN, (off_t)lw->off) < (ssize_t)tail)
+            return false;
+        lw->fill = lw->synced = tail;
+        return true;
+    }
+#endif
+    lw->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | tr, 0644);
+    if (lw->fd < 0)
+        return false;
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (direct)
+        fcntl(lw->fd, F_NOCACHE, 1); // macOS：不进页缓存（不要求对齐，仍按追加方式写）
+#endif
+    lw->direct = false;
+    return true;
+}
+
+static bool lw_sys_write(LogWriter *lw, const uint8_t *p, size_t n, uint64_t off)
+{
+    size_t done = 0;
+    while (done < n)
+    {
+        ssize_t w = lw->direct ? pwrite(lw->fd, p + done, n - done, (off_t)(off + done))
+                               : write(lw->fd, p + done, n - done);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        done += (size_t)w;
+    }
+    return true;
+}
+
+static void lw_sys_close(LogWriter *lw, uint64_t size)
+{
+    if (lw->fd < 0)
+        return;
+    if (lw->direct && ftruncate(lw->fd, (off_t)size) != 0)
+        perror("log ftruncate");
+    close(lw->fd);
+    lw->fd = -1;
+}
+#endif
+
+/* ---------------- 写线程 ---------------- */
+
+// 把 buf 写出去：whole 表示写满整块（之后缓冲清空）；否则写出当前尾巴
+static void lw_flush(LogWriter *lw, bool whole)
+{
+    size_t n = lw->fill;
+    size_t len = lw->direct ? lw_round_up(n, LW_ALIGN) : n;
+    if (len > n)
+        memset(lw->buf + n, 0, len - n); // direct 尾块补零，之后在同一偏移覆盖
+    if (lw_sys_write(lw, lw->buf, len, lw->off))
+    {
+        atomic_fetch_add(&lw->written, (unsigned long)(n - lw->synced));
+        atomic_fetch_add(&lw->writes, 1);
+        if (!lw->direct || whole)
+        {
+            lw->off += len;
+            lw->fill = lw->synced = 0;
+        }
+        else
+            lw->synced = n;
+        return;
+    }
+    // 写失败：丢掉还没落盘的部分，继续服务（磁盘满之类的情况恢复后能接着写）
+    atomic_fetch_add(&lw->errors, 1);
+    atomic_fetch_add(&lw->dropped, (unsigned long)(n - lw->synced));
+    lw->fill = lw->synced;
+}
+
+// 追加到合并缓冲，写满整块就落盘
+static void lw_put(LogWriter *lw, const uint8_t *p, size_t n)
+{
+    const size_t block = lw->cfg.block_bytes;
+    while (n)
+    {
+        if (lw->fill == lw->synced)
+            lw->dirty_ms = rb_ev_now_ms();
+        size_t k = block - lw->fill;
+        if (k > n)
+            k = n;
+        memcpy(lw->buf + lw->fill, p, k);
+        lw->fill += k;
+        p += k;
+        n -= k;
+        if (lw->fill == block)
+            lw_flush(lw, true);
+    }
+}
+
+// 文件中的逻辑写位置（下一个字节将落在这里）
+static uint64_t lw_pos(const LogWriter *lw) { return lw->off + lw->fill; }
+
+// 把队列里逻辑偏移 pos 起的 n 字节追加到缓冲；index 时同时喂给抓包索引
+static void lw_put_spans(LogWriter *lw, const RbSpan sp[2], size_t pos, size_t n, bool index)
+{
+    for (int k = 0; k < 2 && n; ++k)
+    {
+        if (pos >= sp[k].len)
+        {
+            pos -= sp[k].len;
+            continue;
+        }
+        size_t c = sp[k].len - pos;
+        if (c > n)
+            c = n;
+        lw_put(lw, sp[k].ptr + pos, c);
+        if (index)
+            capx_feed(&lw->capx, sp[k].ptr + pos, c);
+        n -= c;
+        pos = 0;
+    }
+}
+
+static void lw_emit_index(LogWriter *lw, uint64_t t_ns)
+{
+    uint8_t rec[CAP_REC_HDR + CAP_INDEX_BATCH * CAP_INDEX_ENTRY];
+    size_t n = capx_encode_index(&lw->capx, rec, lw_pos(lw), t_ns);
+    lw_put(lw, rec, n);
+}
+
+// 原始模式：队列里的字节原样写
+static void lw_take_raw(LogWriter *lw)
+{
+    RbSpan sp[2];
+    size_t avail = rbs_read_peek_spans(&lw->q, sp);
+    lw_put_spans(lw, sp, 0, avail, false);
+    rbs_read_consume(&lw->q, avail);
+}
+
+// 挂在广播环上：从自己的游标直接拷进合并缓冲（这是日志唯一的一次拷贝）
+// 每次最多拷到块满，consume 成功才算数（之后才会 flush）：DROP 游标被接收线程越过时，
+// 刚拷进去的这批可能混入新数据，整批作废，下一轮从生产者推到的位置重读；被越过的字节计入 dropped
+static void lw_take_src(LogWriter *lw)
+{
+    RbSpan sp[2];
+    size_t avail = rbb_peek_spans(lw->src, lw->src_id, sp);
+    size_t pos = 0;
+    while (pos < avail)
+    {
+        size_t fill0 = lw->fill;
+        size_t n = lw->cfg.block_bytes - fill0;
+        if (n > avail - pos)
+            n = avail - pos;
+        if (fill0 == lw->synced)
+            lw->dirty_ms = rb_ev_now_ms();
+        size_t c0 = pos < sp[0].len ? sp[0].len - pos : 0;
+        if (c0 > n)
+            c0 = n;
+        if (c0)
+            memcpy(lw->buf + fill0, sp[0].ptr + pos, c0);
+        if (n > c0)
+            memcpy(lw->buf + fill0 + c0, sp[1].ptr + (pos + c0 - sp[0].len), n - c0);
+        if (!rbb_consume(lw->src, lw->src_id, n))
+            break; // fill 还没推进：刚拷的这批作废
+        lw->fill = fill0 + n;
+        pos += n;
+        if (lw->fill == lw->cfg.block_bytes)
+            lw_flush(lw, true);
+    }
+    size_t lost = atomic_load_explicit(&lw->src->cur[lw->src_id].dropped, memory_order_relaxed);
+    if (lost != lw->src_lost)
+    {
+        atomic_fetch_add(&lw->dropped, (unsigned long)(lost - lw->src_lost));
+        lw->src_lost = lost;
+    }
+}
+
+// 待写数据量与等待：自己的队列或广播环上的游标
+static size_t lw_pending(const LogWriter *lw)
+{
+    return lw->src ? rbb_lag(lw->src, lw->src_id) : rbs_size(&lw->q);
+}
+
+static size_t lw_wait(LogWriter *lw, size_t want, int wait_ms)
+{
+    return lw->src ? rbb_wait_readable(lw->src, lw->src_id, want, wait_ms) : rbs_wait_readable(&lw->q, want, wait_ms);
+}
+
+// 抓包模式：队列里都是完整的 DATA 记录（lw_submit 整条一次发布），边写边建索引
+static void lw_take_capture(LogWriter *lw)
+{
+    RbSpan sp[2];
+    size_t avail = rbs_read_peek_spans(&lw->q, sp);
+    size_t pos = 0;
+    while (avail - pos >= CAP_REC_HDR)
+    {
+        uint8_t hdr[CAP_REC_HDR];
+        unsigned type;
+        uint32_t len;
+        uint64_t t;
+        rbs_peek(&lw->q, hdr, CAP_REC_HDR, pos);
+        if (!cap_get_rec_hdr(hdr, CAP_REC_HDR, &type, &len, &t) || avail - pos - CAP_REC_HDR < len)
+            break;
+        capx_begin_chunk(&lw->capx, lw_pos(lw), t);
+        lw_put(lw, hdr, CAP_REC_HDR);
+        lw_put_spans(lw, sp, pos + CAP_REC_HDR, len, true);
+        pos += CAP_REC_HDR + len;
+        if (capx_batch_full(&lw->capx))
+            lw_emit_index(lw, t);
+    }
+    rbs_read_consume(&lw->q, pos);
+}
+
+// 抓包收尾：剩余索引 + FOOTER + 尾部
+static void lw_finish_capture(LogWriter *lw)
+{
+    uint64_t t = rb_ev_now_ns() - lw->t0_ns;
+    lw_emit_index(lw, t);
+    uint8_t *foot = NULL;
+    size_t n = capx_encode_footer(&lw->capx, lw_pos(lw), t, &foot);
+    lw_put(lw, foot, n);
+    free(foot);
+}
+
+static void lw_run(LogWriter *lw)
+{
+    for (;;)
+    {
+        bool running = atomic_load(&lw->run);
+        long long now = rb_ev_now_ms();
+        int wait = LW_IDLE_MS;
+        if (lw->fill > lw->synced)
+        {
+            long long left = (long long)lw->cfg.flush_ms - (now - lw->dirty_ms);
+            wait = left < 0 ? 0 : (int)(left < LW_IDLE_MS ? left : LW_IDLE_MS);
+        }
+        // 空闲时来 1 字节就醒；有未写数据后等到够填满这一块（或到期），不为每次 submit 都醒来
+        size_t want = (lw->fill > lw->synced) ? lw->cfg.block_bytes - lw->fill : 1;
+        // 挂在广播环上时别等到环快满才醒：DROP 游标会被越过
+        if (lw->src && want > rbb_capacity(lw->src) / 2)
+            want = rbb_capacity(lw->src) / 2;
+        size_t avail = running ? lw_wait(lw, want, wait) : lw_pending(lw);
+        if (avail)
+        {
+            if (lw->cfg.capture)
+                lw_take_capture(lw);
+            else if (lw->src)
+                lw_take_src(lw);
+            else
+                lw_take_raw(lw);
+        }
+        // 广播环的生产者不会停：关闭时写完这一刻已有的数据就走
+        if (!running && (lw->src || rbs_size(&lw->q) == 0))
+        {
+            if (lw->cfg.capture)
+                lw_finish_capture(lw);
+            if (lw->fill > lw->synced)
+                lw_flush(lw, false);
+            break;
+        }
+        if (lw->fill > lw->synced && rb_ev_now_ms() - lw->dirty_ms >= (long long)lw->cfg.flush_ms)
+            lw_flush(lw, false);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI lw_thread(LPVOID arg)
+{
+    lw_run((LogWriter *)arg);
+    return 0;
+}
+#else
+static void *lw_thread(void *arg)
+{
+    lw_run((LogWriter *)arg);
+    return NULL;
+}
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+// 释放自己的队列或摘掉广播环上的游标
+static void lw_release_queue(LogWriter *lw)
+{
+    if (lw->src)
+        rbb_detach(lw->src, lw->src_id);
+    else
+        rbs_free(&lw->q);
+}
+
+bool lw_open(LogWriter *lw, const char *path, const LwConfig *cfg)
+{
+    if (!lw || !path)
+        return false;
+    memset(lw, 0, sizeof(*lw));
+#ifndef _WIN32
+    lw->fd = -1;
+#endif
+    if (cfg)
+        lw->cfg = *cfg;
+    else
+        lw_default_config(&lw->cfg);
+    if (lw->cfg.queue_bytes == 0 || lw->cfg.block_bytes == 0)
+        lw_default_config(&lw->cfg);
+    lw->cfg.block_bytes = lw_round_up(lw->cfg.block_bytes, LW_ALIGN);
+    strncpy(lw->path, path, sizeof(lw->path) - 1);
+
+    lw->buf = lw_alloc(lw->cfg.block_bytes);
+    if (!lw->buf)
+        return false;
+    lw->src = lw->cfg.capture ? NULL : lw->cfg.src;
+    lw->src_id = -1;
+    if (lw->src)
+    {
+        // 先挂上游标再开文件：log on 之后收到的字节一个不漏
+        lw->src_id = rbb_attach(lw->src, lw->cfg.src_policy, "log");
+        if (lw->src_id < 0)
+        {
+            lw_dealloc(lw->buf);
+            return false;
+        }
+    }
+    else if (!rbs_init_mirror(&lw->q, lw->cfg.queue_bytes) && !rbs_init(&lw->q, lw->cfg.queue_bytes))
+    {
+        lw_dealloc(lw->buf);
+        return false;
+    }
+
+    lw->direct = lw->cfg.direct;
+    if (!lw_sys_open(lw, path, lw->direct, lw->cfg.capture))
+    {
+        if (lw->direct)
+        {
+            // 文件系统不支持（如 tmpfs 拒绝 O_DIRECT）：回退普通追加写
+            fprintf(stderr, "log: direct I/O unavailable for %s, using buffered writes\n", path);
+            lw->direct = false; // 先清标志：direct 模式的关闭会截到 size（这里是 0），把已有日志清空
+            lw_sys_close(lw, 0);
+            lw->off = 0;
+            lw->fill = lw->synced = 0;
+        }
+        if (!lw->direct && !lw_sys_open(lw, path, false, lw->cfg.capture))
+        {
+            lw_sys_close(lw, 0);
+            lw_release_queue(lw);
+            lw_dealloc(lw->buf);
+            return false;
+        }
+    }
+
+    if (lw->cfg.capture)
+    {
+        // 抓包文件总是新建：先写文件头，再启动写线程
+        struct timespec ts;
+        timespec_get(&ts, TIME_UTC);
+        uint8_t hdr[CAP_FILE_HDR];
+        cap_put_file_hdr(hdr, (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec, lw->cfg.proto);
+        capx_init(&lw->capx, lw->cfg.proto);
+        lw->t0_ns = rb_ev_now_ns();
+        lw_put(lw, hdr, sizeof(hdr));
+    }
+
+    atomic_store(&lw->run, true);
+#ifdef _WIN32
+    lw->th = CreateThread(NULL, 0, lw_thread, lw, 0, NULL);
+    bool ok = (lw->th != NULL);
+#else
+    bool ok = (pthread_create(&lw->th, NULL, lw_thread, lw) == 0);
+#endif
+    if (!ok)
+    {
+        lw_sys_close(lw, lw->off + lw->fill);
+        lw_release_queue(lw);
+        lw_dealloc(lw->buf);
+        return false;
+    }
+    return true;
+}
+
+size_t lw_submit(LogWriter *lw, const void *data, size_t n)
+{
+    if (!lw || !data || n == 0 || lw->src)
+        return 0;
+    if (lw->cfg.capture)
+    {
+        // 记录头 + 数据一次发布，写线程看到的总是整条记录；放不下就整条丢弃
+        RbSpan sp[2];
+        size_t room = rbs_write_reserve(&lw->q, sp);
+        if (n > UINT32_MAX || room < CAP_REC_HDR + n)
+        {
+            atomic_fetch_add(&lw->dropped, (unsigned long)n);
+            return 0;
+        }
+        uint8_t hdr[CAP_REC_HDR];
+        cap_put_rec_hdr(hdr, CAP_REC_DATA, (uint32_t)n, rb_ev_now_ns() - lw->t0_ns);
+        const uint8_t *parts[2] = {hdr, (const uint8_t *)data};
+        size_t lens[2] = {CAP_REC_HDR, n};
+        int k = 0;
+        size_t at = 0;
+        for (int i = 0; i < 2; ++i)
+        {
+            const uint8_t *p = parts[i];
+            size_t left = lens[i];
+            while (left)
+            {
+                size_t c = sp[k].len - at;
+                if (c > left)
+                    c = left;
+                memcpy(sp[k].ptr + at, p, c);
+                p += c;
+                left -= c;
+                at += c;
+                if (at == sp[k].len)
+                {
+                    ++k;
+                    at = 0;
+                }
+            }
+        }
+        rbs_write_commit(&lw->q, CAP_REC_HDR + n);
+        return n;
+    }
+    size_t w = rbs_push(&lw->q, data, n);
+    if (w < n)
+        atomic_fetch_add(&lw->dropped, (unsigned long)(n - w));
+    return w;
+}
+
+void lw_close(LogWriter *lw)
+{
+    if (!lw || !lw->buf)
+        return;
+    atomic_store(&lw->run, false);
+    if (lw->src)
+        rbb_wake(lw->src);
+    else
+        rbs_wake(&lw->q);
+#ifdef _WIN32
+    WaitForSingleObject(lw->th, INFINITE);
+    CloseHandle(lw->th);
+    lw->th = NULL;
+#else
+    pthread_join(lw->th, NULL);
+#endif
+    lw_sys_close(lw, lw->off + lw->fill);
+    lw_release_queue(lw);
+    lw_dealloc(lw->buf);
+    lw->buf = NULL;
+    if (lw->cfg.capture)
+        capx_free(&lw->capx);
+}
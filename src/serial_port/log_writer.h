@@ -0,0 +1,102 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+// 异步日志写线程：接收线程只把数据推进一个 SPSC 环（不等待、不进内核），
+// 写线程把数据攒成大块再写盘，慢盘不会拖慢串口接收。
+//
+// - 队列满时丢弃新数据并单独计数（dropped），与串口环的丢弃分开统计
+// - 攒满 block_bytes 写一次；不满一块时最多攒 flush_ms 就写出去
+// - direct 模式（Linux O_DIRECT / Windows FILE_FLAG_NO_BUFFERING）绕过页缓存：
+//   缓冲与文件偏移按 LW_ALIGN 对齐；不满一块的尾巴先补零写成整块，之后同一偏移被覆盖重写，
+//   关闭时截断到真实长度（所以运行中从外部看文件尾可能带着补零）
+// - capture 模式下队列里传的是带时间戳的 DATA 记录（接收线程打时间戳），写线程顺带生成帧边界索引
+// - macOS 没有 O_DIRECT，direct 退化为 F_NOCACHE（不缓存，但不要求对齐）
+// - 原始模式可以直接挂在接收广播环上（cfg.src）：写线程用自己的读游标从环里取，
+//   接收线程不再为日志复制一份，也不用自己的队列；capture 模式要接收线程打时间戳，仍走 lw_submit
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../ringbuf/ringbuf_spsc.h"
+#include "../ringbuf/ringbuf_bcast.h"
+#include "capture.h"
+
+#define LW_ALIGN 4096 // direct 模式的缓冲/偏移/长度对齐（覆盖常见的 512B/4KiB 扇区）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        size_t queue_bytes; // 接收线程 -> 写线程 队列容量（默认 1 MiB）
+        size_t block_bytes; // 合并写块大小，向上对齐到 LW_ALIGN（默认 64 KiB）
+        unsigned flush_ms;  // 不满一块时最多攒多久（默认 200ms）
+        bool direct;        // 绕过页缓存
+        bool capture;       // 写 .spcap 抓包格式（时间戳 + 帧边界索引，见 capture.h）而不是原始字节；文件总是新建
+        RingBufBcast *src;  // 非 NULL 且不是 capture：写线程自己挂在这个环上读（不用 queue_bytes、不调 lw_submit）
+        RbbPolicy src_policy; // src 读游标的策略：RBB_DROP 慢盘丢日志（计入 dropped），RBB_BACKPRESSURE 慢盘挤占接收环
+        const ProtoDesc *proto; // capture：帧协议（写进文件头并用来建索引；NULL 为默认），只在 lw_open 时读
+    } LwConfig;
+
+    typedef struct
+    {
+        RingBufSpsc q; // 接收线程唯一生产者，写线程唯一消费者（挂在 src 上时不分配）
+        RingBufBcast *src; // 实际生效的 cfg.src（capture 模式为 NULL）
+        int src_id;        // 在 src 上的读游标
+        size_t src_lost;   // 已计入 dropped 的 src 游标被越过字节
+        LwConfig cfg;
+        uint8_t *buf; // 合并缓冲（block_bytes，按 LW_ALIGN 对齐）
+        size_t fill;  // buf 中的有效字节
+        size_t synced; // buf 中已写到文件的字节（direct 模式的补零尾块）
+        uint64_t off; // 下一次写的文件偏移（direct: 块对齐）
+        bool direct;  // 实际生效的 direct（打开失败会回退）
+        long long dirty_ms; // 缓冲里出现未写数据的时刻
+        uint64_t t0_ns;     // 抓包时间零点（单调时钟）
+        CapIndexer capx;    // 抓包模式：写线程边写边找帧边界
+#ifdef _WIN32
+        HANDLE fh;
+        HANDLE th;
+#else
+        int fd;
+        pthread_t th;
+#endif
+        atomic_bool run;
+        char path[256];
+
+        // 统计：写线程写，任意线程原子读
+        atomic_ulong written; // 已写入文件的日志字节（不含补零）
+        atomic_ulong writes;  // 写系统调用次数
+        atomic_ulong errors;  // 写失败次数（这部分数据计入 dropped）
+        atomic_ulong dropped; // 队列满 / 写失败丢失的字节（接收线程与写线程都会加）
+    } LogWriter;
+
+    // 默认配置
+    void lw_default_config(LwConfig *cfg);
+
+    // 打开（追加到 path 末尾）并启动写线程；cfg 为 NULL 用默认配置
+    // 挂在 cfg->src 上时从打开这一刻的数据开始记；读者槽位用完则失败
+    bool lw_open(LogWriter *lw, const char *path, const LwConfig *cfg);
+
+    // 接收线程调用：把数据交给写线程，不等待；返回实际入队字节数（其余计入 dropped）
+    // 挂在 src 上时不用调用（返回 0）
+    size_t lw_submit(LogWriter *lw, const void *data, size_t n);
+
+    // 停止写线程：队列里剩余的数据全部写完（挂在 src 上时写完此刻已收到的数据），截断补零，关闭文件
+    // 调用时不得有线程正在 lw_submit
+    void lw_close(LogWriter *lw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_WRITER_H
@@ -1,6 +1,12 @@
 // main.c — 串口小终端：环形缓冲输入、实时展示、发送字符串/十六进制、日志落盘、AA55帧解析
-// 架构：read_thread -> rb_push_overwrite()；print_thread -> (raw/parse) 输出
-// 帧格式：AA 55 | LEN(1) | PAYLOAD[len] | CHK(1) ，CHK = (LEN + sum(PAYLOAD)) & 0xFF
+// 架构：read_thread -> sp_read_wait（事件驱动）直接写入单写多读的广播环；解析、原始显示、日志各有一个读游标，
+//       print_thread 原地解析/原始显示（可同时开），原始日志由日志写线程自己从环里取
+// 发送：txs/txx 只把消息推进 TX 队列，tx_queue 的写线程合并后写串口
+// 展示：printer 只解析，帧/原始数据放进帧槽队列；render_thread 批量格式化，一批一次写控制台
+// 多串口：gopen 打开一组端口，由 sp_group 的少量 I/O 线程服务，printer 线程统一解析
+// 统计：reader / printer 各写自己那块缓存行对齐的计数器与直方图，stat 查看，stat export 周期导出
+// 压测：stress 用伪终端（或虚拟串口对）的另一端灌带时间戳的探针帧，统计端到端延迟/丢帧/各线程 CPU
+// 帧格式：AA 55 | LEN(1) | PAYLOAD[len] | CHK(1) ，CHK = (LEN + sum(PAYLOAD)) & 0xFF（默认；proto 命令可换）
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,11 +24,28 @@ static void ms_sleep(unsigned ms) { Sleep(ms); }
 static void ms_sleep(unsigned ms) { usleep(ms * 1000); }
 #endif
 
-#include "D:\C_Learn\src\ringbuf\ringbuf.h"
+#include "../ringbuf/ringbuf_bcast.h"
+#include "../ringbuf/hex_codec.h"
 #include "serial_port.h"
+#include "frame_parser.h"
+#include "sp_group.h"
+#include "log_writer.h"
+#include "capture.h"
+#include "tx_queue.h"
+#include "frame_queue.h"
+#include "stress.h"
+#include "sp_stats.h"
+#include "net_bridge.h"
+#include "sp_thread.h"
 
 #define RB_CAP (64 * 1024) // 64 KiB 环形缓冲，更适合串口吞吐
+#define RX_CHUNK (16 * 1024) // reader 一次最多读这么多：只为这么多字节越过落后的 DROP 读者
 #define LINE_MAX 4096
+#define PRINTER_WAIT_MS 200 // printer 空闲时最多睡这么久（只为检查退出标志）
+#define TX_SEND_WAIT_MS 1000 // TX 队列满时 txs/txx 最多等这么久
+#define TX_DRAIN_MS 1000     // 关串口前最多等这么久把 TX 队列写完
+#define FQ_SLOTS 4096           // printer -> render 帧槽数
+#define RENDER_BUF (64 * 1024)  // render 的输出缓冲：攒满或一批结束写一次
 
 typedef enum
 {
@@ -30,25 +53,87 @@ typedef enum
     VIEW_HEX = 1
 } ViewMode;
 
-static RingBuf g_rb;
+// 接收广播环：reader_thread 唯一生产者；读者：解析游标（printer，BACKPRESSURE：解析不丢字节，
+// 环满时由 reader 丢新数据并计数）、原始显示游标（printer，DROP，只在要显示原始字节时挂上）、
+// 原始日志游标（日志写线程，log on 时挂上）。数据只有一份，多一个读者只多一条缓存行
+static RingBufBcast g_rb;
+static int g_cur_parse = -1;          // 解析游标：统计里的“消费”“滞后”都按它算
+static atomic_int g_cur_raw = -1;     // 原始显示游标（printer 挂/摘，命令线程只读）
+static RbEvent g_rx_ev;  // g_rb 与多串口组的环共享：任何一个环有新数据都叫醒 printer
 static SerialPort g_sp;
+static TxQueue g_txq; // 命令线程唯一发送方，写线程唯一消费者；随 g_sp 打开/关闭
 static atomic_bool g_run_reader = false;
 static atomic_bool g_run_printer = false;
+static atomic_bool g_run_render = false;
 static atomic_bool g_live = true;
 static atomic_bool g_parse = false; // 新增：帧解析开关
+static atomic_bool g_raw_too = false; // 解析时同时显示原始字节（非解析模式总是显示原始字节）
+static atomic_bool g_parse_reset = false; // 让 printer 丢弃解析器里未完成的帧
+static ProtoDesc g_proto;                     // 当前帧协议（命令线程持有）
+static ProtoDesc g_proto_next;                // 交给 printer 的新协议：g_proto_change 非 0 时不许命令线程改写
+static atomic_int g_proto_change = 0;          // 0 空闲，1 待取（命令线程可撤回），2 printer 正在读
 static ViewMode g_view = VIEW_ASCII;
 
-static FILE *g_logf = NULL;
-static atomic_ulong g_total_rx = 0;
-static atomic_ulong g_total_tx = 0;
-static atomic_ulong g_drop_bytes = 0;
+// 日志：原始日志的写线程挂在 g_rb 上自己取；抓包日志要 reader 打时间戳，reader 只 lw_submit（不进内核）。
+// 写线程批量落盘；g_log_tap + g_log_busy 保证关日志时 reader 不在提交
+static LogWriter g_log;
+static atomic_bool g_log_on = false;
+static atomic_bool g_log_tap = false; // reader 需要 lw_submit（抓包模式）
+static atomic_bool g_log_busy = false;
+static atomic_ulong g_log_lost = 0; // 已关闭的日志会话累计丢失字节（当前会话见 g_log.dropped）
+
+// 统计：g_stats.rd 只由 reader 写，g_stats.pr 只由 printer 写（单写者，不用原子读改写）；
+// g_total_tx 由 TX 写线程累加，单独占一条缓存行
+static SpStats g_stats;
+static SpsLine g_total_tx;
+static SpsExport g_export; // stat export 的导出线程（命令线程 start/stop）
+
+// 展示：printer 唯一生产者，render_thread 唯一消费者；控制台跟不上时丢弃并计数（不拖慢解析）
+static FrameQueue g_fq;
+// 展示丢弃计数：printer 写，独占一条缓存行（不与命令线程改的开关、render 的状态同线）
+static struct
+{
+    SPS_ALIGNED atomic_ulong frames;
+    atomic_ulong bytes; // 非解析模式丢弃的原始字节
+} g_show_drop;
+
+// 压测：命令线程 start/stop，printer（st_on_frame）与 render（st_on_display）只在 g_st_on 时记账；
+// g_st 是静态的、从不释放，关掉开关后迟到的一次记账也是安全的
+static Stress g_st;
+static atomic_bool g_st_on = false;
+
+// 网络桥：命令线程 start/stop；每个远程客户端在 g_rb 上各挂一个 DROP 游标，慢客户端只丢自己的
+static NetBridge g_net;
+static bool g_net_on = false;
 
 #ifdef _WIN32
-static HANDLE hReader = NULL, hPrinter = NULL;
+static HANDLE hReader = NULL, hPrinter = NULL, hRender = NULL;
 #else
-static pthread_t thReader, thPrinter;
+static pthread_t thReader, thPrinter, thRender;
 #endif
 
+// 线程调度配置（thread 命令，命令线程读写）：立即作用到正在运行的线程
+enum
+{
+    TH_READER = 0,
+    TH_PRINTER,
+    TH_RENDER,
+    TH_COUNT
+};
+static const char *const k_th_names[TH_COUNT] = {"reader", "printer", "render"};
+static SptConfig g_thcfg[TH_COUNT];
+
+/* ------------------ 串口 ------------------ */
+// 关串口前先停 TX 写线程（它还在用 g_sp）
+static void close_port(void)
+{
+    size_t lost = txq_stop(&g_txq, TX_DRAIN_MS);
+    if (lost)
+        printf("TX 队列未发出 %zu 字节（已丢弃）\n", lost);
+    if (sp_is_open(&g_sp))
+        sp_close(&g_sp);
+}
+
 /* ------------------ 工具 ------------------ */
 static void chomp(char *s)
 {
@@ -59,204 +144,394 @@ static void chomp(char *s)
         s[--n] = 0;
 }
 
-static int is_hex(char c) { return isxdigit((unsigned char)c); }
-static unsigned char hexpair_to_byte(char hi, char lo)
-{
-    unsigned v = 0;
-    if (hi >= '0' && hi <= '9')
-        v = (hi - '0') << 4;
-    else
-        v = ((unsigned)(toupper(hi) - 'A') + 10) << 4;
-    if (lo >= '0' && lo <= '9')
-        v |= (lo - '0');
-    else
-        v |= ((unsigned)(toupper(lo) - 'A') + 10);
-    return (unsigned char)v;
-}
+// 解码十六进制（空白与 0x 前缀都容忍）；调用方 free(*out)，失败返回 0
 static size_t parse_hex_bytes(const char *line, unsigned char **out)
 {
-    if (!line || !out)
-        return 0;
-    *out = NULL;
-    char buf[LINE_MAX];
-    size_t j = 0;
-    for (size_t i = 0; line[i] && j + 1 < sizeof(buf); ++i)
-    {
-        unsigned char c = (unsigned char)line[i];
-        if (isspace(c))
-            continue;
-        if (c == '0' && (line[i + 1] == 'x' || line[i + 1] == 'X') && is_hex(line[i + 2]))
-        {
-            i += 1;
-            continue;
-        }
-        if (!is_hex(c))
-            return 0;
-        buf[j++] = (char)c;
-    }
-    buf[j] = 0;
-    if (j == 0)
+    size_t len = strlen(line);
+    *out = (unsigned char *)malloc(HEX_DECODE_MAX(len));
+    if (!*out)
         return 0;
-    int odd = (j % 2) ? 1 : 0;
-    size_t bytes = (j + odd) / 2;
-    unsigned char *mem = (unsigned char *)malloc(bytes);
-    if (!mem)
-        return 0;
-    size_t bi = 0, i = 0;
-    if (odd)
-        mem[bi++] = hexpair_to_byte('0', buf[i++]);
-    while (i + 1 < j)
+    size_t n = hex_decode(*out, line, len, NULL);
+    if (n == 0)
     {
-        mem[bi++] = hexpair_to_byte(buf[i], buf[i + 1]);
-        i += 2;
+        free(*out);
+        *out = NULL;
     }
-    *out = mem;
-    return bytes;
+    return n;
 }
 
-static void print_hex_bytes(const unsigned char *p, size_t n)
+/* ------------------ 格式化（查表） ------------------ */
+static char g_ascii[256];   // 可打印字符原样，其余 '.'
+
+static void init_fmt_tables(void)
 {
+    for (int i = 0; i < 256; ++i)
+        g_ascii[i] = isprint(i) ? (char)i : '.';
+}
+
+// 输出最多 3*n 字符
+static size_t fmt_bytes(char *o, const unsigned char *p, size_t n, ViewMode v)
+{
+    if (v == VIEW_HEX)
+        return hex_encode_spaced(o, p, n);
     for (size_t i = 0; i < n; ++i)
+        o[i] = g_ascii[p[i]];
+    return n;
+}
+
+// 帧头："\n[FRAME len=N] " 或 "\n[<tag> FRAME len=N] "；输出最多 FQ_TAG_MAX + 24 字符
+static size_t fmt_frame_head(char *o, const char *tag, size_t len)
+{
+    char *s = o;
+    *s++ = '\n';
+    *s++ = '[';
+    for (size_t i = 0; tag && tag[i] && i < FQ_TAG_MAX; ++i)
+        *s++ = tag[i];
+    if (tag && tag[0])
+        *s++ = ' ';
+    memcpy(s, "FRAME len=", 10);
+    s += 10;
+    char d[20];
+    int k = 0;
+    do
+    {
+        d[k++] = (char)('0' + len % 10);
+        len /= 10;
+    } while (len);
+    while (k)
+        *s++ = d[--k];
+    *s++ = ']';
+    *s++ = ' ';
+    return (size_t)(s - o);
+}
+
+#define SLOT_TEXT_MAX (FQ_TAG_MAX + 24 + 3 * FQ_SLOT_BYTES) // 一个槽格式化后的最大长度
+
+static size_t fmt_slot(char *o, const FqSlot *sl, ViewMode v)
+{
+    size_t n = 0;
+    if (sl->kind == FQ_FRAME)
+        n = fmt_frame_head(o, sl->tag, sl->total);
+    else if (sl->kind == FQ_GAP)
     {
-        printf("%02X ", p[i]);
+        static const char gap[] = "\n[显示跟不上被越过，上面一段可能混入了新数据]\n";
+        memcpy(o, gap, sizeof(gap) - 1);
+        return sizeof(gap) - 1;
     }
+    return n + fmt_bytes(o + n, sl->data, sl->len, v);
 }
-static void print_ascii(const unsigned char *p, size_t n)
+
+// 直接写控制台（命令线程用：dump、回放）
+static void print_bytes(const unsigned char *p, size_t n, ViewMode v)
 {
-    for (size_t i = 0; i < n; ++i)
+    char buf[3 * 1024];
+    while (n)
     {
-        unsigned char c = p[i];
-        putchar(isprint(c) ? c : '.');
+        size_t c = n < 1024 ? n : 1024;
+        fwrite(buf, 1, fmt_bytes(buf, p, c, v), stdout);
+        p += c;
+        n -= c;
     }
 }
+static void print_hex_bytes(const unsigned char *p, size_t n) { print_bytes(p, n, VIEW_HEX); }
+static void print_ascii(const unsigned char *p, size_t n) { print_bytes(p, n, VIEW_ASCII); }
 
-/* 空间不够时丢弃最旧数据（永不阻塞） */
-static void rb_push_overwrite(RingBuf *rb, const void *src, size_t n)
+/* ------------------ 展示队列 ------------------ */
+// printer 调用：以下两个函数从不等待，队列满就丢
+static void show_frame(const char *tag, const uint8_t *payload, size_t len)
 {
-    size_t freeb = rb_free_space(rb);
-    if (n >= rb->cap)
+    FqSlot *sl = fq_reserve(&g_fq);
+    if (!sl)
     {
-        const unsigned char *p = (const unsigned char *)src + (n - rb->cap);
-        rb_clear(rb);
-        rb_push(rb, p, rb->cap);
-        g_drop_bytes += (unsigned long)(n - rb->cap);
+        g_show_drop.frames++;
         return;
     }
-    if (n > freeb)
+    sl->kind = FQ_FRAME;
+    sl->total = (uint32_t)len;
+    if (len > FQ_SLOT_BYTES)
+        len = FQ_SLOT_BYTES; // 长帧只展示开头
+    sl->len = (uint16_t)len;
+    strncpy(sl->tag, tag ? tag : "", FQ_TAG_MAX - 1);
+    sl->tag[FQ_TAG_MAX - 1] = 0;
+    memcpy(sl->data, payload, len);
+    fq_publish(&g_fq);
+}
+
+static void show_raw(const uint8_t *p, size_t n)
+{
+    while (n)
     {
-        size_t need = n - freeb;
-        unsigned char tmp[1024];
-        while (need)
+        FqSlot *sl = fq_reserve(&g_fq);
+        if (!sl)
         {
-            size_t step = need > sizeof(tmp) ? sizeof(tmp) : need;
-            size_t got = rb_pop(rb, tmp, step);
-            if (got == 0)
-                break;
-            need -= got;
-            g_drop_bytes += (unsigned long)got;
+            g_show_drop.bytes += (unsigned long)n;
+            return;
         }
+        size_t c = n < FQ_SLOT_BYTES ? n : FQ_SLOT_BYTES;
+        sl->kind = FQ_RAW;
+        sl->len = (uint16_t)c;
+        sl->total = (uint32_t)c;
+        sl->tag[0] = 0;
+        memcpy(sl->data, p, c);
+        fq_publish(&g_fq);
+        p += c;
+        n -= c;
     }
-    rb_push(rb, src, n);
 }
 
-/* ------------------ 帧解析工具 ------------------ */
-// CHK = (LEN + sum(PAYLOAD)) & 0xFF
-static unsigned calc_chk(uint8_t len, const uint8_t *payload)
+// 原始显示游标 consume 失败：已入队的那一段不可信，在显示里标出来
+static void show_gap(void)
 {
-    unsigned s = len;
-    for (unsigned i = 0; i < len; ++i)
-        s += payload[i];
-    return s & 0xFFu;
+    FqSlot *sl = fq_reserve(&g_fq);
+    if (!sl)
+        return;
+    sl->kind = FQ_GAP;
+    sl->len = 0;
+    sl->total = 0;
+    sl->tag[0] = 0;
+    fq_publish(&g_fq);
 }
 
-/*
- * 从环缓冲里尝试弹出一帧：
- *  1  -> 成功取出，若 out/out_len 非空则拷贝负载
- *  0  -> 目前没有完整帧（或丢弃了部分噪声），可继续循环或等待新字节
- * -1  -> 数据不足（保持现场）
- */
-static int try_pop_one_frame(RingBuf *rb, uint8_t *out, size_t *out_len)
+/* ------------------ 帧解析 ------------------ */
+// printer_thread 专用的增量解析器；状态跨调用保存，每个字节只处理一次
+static FrameParser g_fp;
+
+static void on_frame(const uint8_t *payload, size_t len, void *user)
 {
-    static const uint8_t HDR[2] = {0xAA, 0x55};
+    (void)user;
+    sps_frame(&g_stats, g_fp.end_pos);
+    if (atomic_load(&g_st_on))
+        st_on_frame(&g_st, payload, len);
+    show_frame(NULL, payload, len);
+}
 
-    // 找到帧头偏移
-    size_t idx = 0;
-    if (!rb_search(rb, HDR, 2, &idx))
-    {
-        // 没有帧头：丢弃当前所有噪声，避免无尽积压
-        size_t junk = rb_size(rb);
-        if (junk > 0)
-        {
-            uint8_t tmp[256];
-            while (junk)
-            {
-                size_t step = junk > sizeof(tmp) ? sizeof(tmp) : junk;
-                rb_pop(rb, tmp, step);
-                junk -= step;
-            }
-        }
+// 回放（命令线程）：不经展示队列，直接格式化输出
+static void on_replay_frame(const uint8_t *payload, size_t len, void *user)
+{
+    (void)user;
+    char head[FQ_TAG_MAX + 24];
+    fwrite(head, 1, fmt_frame_head(head, NULL, len), stdout);
+    print_bytes(payload, len, g_view);
+}
+
+/* ------------------ 多串口组 ------------------ */
+// 命令线程负责 gopen/gclose，printer 线程负责 spg_service；
+// g_grp_on + g_grp_busy 保证 gclose 释放端口时 printer 不在服务中
+static SpGroup g_grp;
+static atomic_bool g_grp_on = false;
+static atomic_bool g_grp_busy = false;
+
+static void on_group_frame(const SpgPort *port, const uint8_t *payload, size_t len, void *user)
+{
+    (void)user;
+    if (!atomic_load(&g_live))
+        return; // 只统计不展示
+    show_frame(port->sp.name, payload, len);
+}
+
+// printer 线程调用：返回本轮消费的字节数
+static size_t service_group(void)
+{
+    if (!atomic_load(&g_grp_on))
         return 0;
-    }
+    atomic_store(&g_grp_busy, true);
+    size_t n = 0;
+    if (atomic_load(&g_grp_on))
+        n = spg_service(&g_grp, 0);
+    atomic_store(&g_grp_busy, false);
+    return n;
+}
 
-    // 丢掉帧头之前的噪声
-    if (idx > 0)
-    {
-        uint8_t tmp[256];
-        size_t left = idx;
-        while (left)
-        {
-            size_t step = left > sizeof(tmp) ? sizeof(tmp) : left;
-            rb_pop(rb, tmp, step);
-            left -= step;
-        }
-    }
+// printer 线程调用：组里待处理的字节数
+static size_t group_pending(void)
+{
+    if (!atomic_load(&g_grp_on))
+        return 0;
+    atomic_store(&g_grp_busy, true);
+    size_t n = 0;
+    if (atomic_load(&g_grp_on))
+        n = spg_pending(&g_grp);
+    atomic_store(&g_grp_busy, false);
+    return n;
+}
 
-    // 至少需要 AA 55 LEN 三字节
-    if (rb_size(rb) < 3)
-        return -1;
+static void close_group(void)
+{
+    if (!atomic_load(&g_grp_on))
+        return;
+    atomic_store(&g_grp_on, false);
+    while (atomic_load(&g_grp_busy))
+        ms_sleep(1);
+    spg_stop(&g_grp);
+}
 
-    // PEEK 出 LEN
-    uint8_t len = 0;
-    if (rb_peek(rb, &len, 1, 2) != 1)
-        return -1;
+/* ------------------ 日志 ------------------ */
+static void close_log(void)
+{
+    if (!atomic_load(&g_log_on))
+        return;
+    atomic_store(&g_log_on, false);
+    atomic_store(&g_log_tap, false);
+    while (atomic_load(&g_log_busy))
+        ms_sleep(1);
+    lw_close(&g_log); // 写完队列里剩余的数据
+    g_log_lost += (unsigned long)g_log.dropped;
+}
 
-    size_t total = 2 + 1 + len + 1; // HDR + LEN + PAYLOAD + CHK
-    if (rb_size(rb) < total)
-        return -1;
+// wait：原始日志不丢（慢盘时挤占接收环，reader 丢的是新数据）；默认慢盘只丢日志
+static bool open_log(const char *path, bool direct, bool capture, bool wait)
+{
+    close_log();
+    LwConfig cfg;
+    lw_default_config(&cfg);
+    cfg.direct = direct;
+    cfg.capture = capture;
+    cfg.src = &g_rb;
+    cfg.src_policy = wait ? RBB_BACKPRESSURE : RBB_DROP;
+    cfg.proto = &g_proto; // 抓包文件记下当前协议，回放时按它分帧
+    if (!lw_open(&g_log, path, &cfg))
+        return false;
+    atomic_store(&g_log_tap, capture);
+    atomic_store(&g_log_on, true);
+    return true;
+}
 
-    // POP 出整帧
-    uint8_t frame[2 + 1 + 255 + 1];
-    size_t got = rb_pop(rb, frame, total);
-    if (got != total)
-        return -1;
+/* ------------------ 网络桥 ------------------ */
+static void close_net(void)
+{
+    if (!g_net_on)
+        return;
+    nb_stop(&g_net);
+    g_net_on = false;
+}
 
-    // 校验头（极端竞争下的保险）
-    if (!(frame[0] == 0xAA && frame[1] == 0x55))
+// 接收环通过 TCP（raw / telnet）转发，可选同时发往 UDP 组播
+static bool open_net(uint16_t tcp_port, NbMode mode, const char *group, uint16_t udp_port)
+{
+    close_net();
+    nb_init(&g_net, NULL);
+    int ch = nb_add_channel(&g_net, &g_rb, &g_sp, "rx");
+    if (ch < 0 || !nb_listen_tcp(&g_net, ch, NULL, tcp_port, mode) ||
+        (group && !nb_multicast(&g_net, ch, group, udp_port)) || !nb_start(&g_net))
     {
-        // 丢 1 字节后继续
-        uint8_t dummy;
-        rb_pop(rb, &dummy, 1);
-        return 0;
+        printf("网络桥启动失败：%s\n", g_net.err[0] ? g_net.err : "?");
+        nb_stop(&g_net);
+        return false;
     }
+    g_net_on = true;
+    return true;
+}
 
-    // 校验 CHK
-    unsigned chk = calc_chk(frame[2], &frame[3]);
-    if (((uint8_t)chk) != frame[total - 1])
+static void print_net(void)
+{
+    if (!g_net_on)
     {
-        // 校验失败，放弃这帧（也可选择更激进的丢弃策略）
-        return 0;
+        puts("网络桥未开启。");
+        return;
     }
+    const NbChannel *c = &g_net.ch[0];
+    unsigned long sends = g_net.sends;
+    printf("网络桥：TCP %u（%s）  客户端 %lu  接受 %lu  拒绝 %lu\n", (unsigned)c->tcp_port,
+           c->mode == NB_TELNET ? "telnet" : "raw", (unsigned long)g_net.clients, (unsigned long)g_net.accepted,
+           (unsigned long)g_net.rejected);
+    printf("  发出 %lu 字节 / %lu 次发送（平均 %.0f 字节/次）  组播报文 %lu  已断开客户端丢弃 %lu 字节\n",
+           (unsigned long)g_net.bytes, sends, sends ? (double)g_net.bytes / (double)sends : 0.0,
+           (unsigned long)g_net.datagrams, (unsigned long)g_net.dropped);
+    NbClientInfo ci;
+    for (int i = 0; i < NB_MAX_CLIENTS + NB_MAX_CHANNELS; ++i)
+    {
+        if (!nb_client_info(&g_net, i, &ci))
+            continue;
+        printf("  %-22s %-6s lag=%zu  lag_max=%zu  bytes=%lu  sends=%lu  dropped=%lu  overruns=%lu%s\n", ci.peer,
+               ci.udp ? "udp" : (ci.telnet ? "telnet" : "raw"), ci.lag, ci.lag_max, ci.bytes, ci.sends, ci.dropped,
+               ci.overruns, ci.suspended ? "  (suspended)" : "");
+    }
+}
+
+/* ------------------ 线程调度 ------------------ */
+static SptThread thread_handle(int i)
+{
+#ifdef _WIN32
+    return i == TH_READER ? hReader : i == TH_PRINTER ? hPrinter : hRender;
+#else
+    return i == TH_READER ? thReader : i == TH_PRINTER ? thPrinter : thRender;
+#endif
+}
+
+static void print_threads(void)
+{
+    char buf[48];
+    printf("逻辑 CPU：%d\n", spt_cpu_count());
+    for (int i = 0; i < TH_COUNT; ++i)
+        printf("  %-8s %s\n", k_th_names[i], spt_describe(&g_thcfg[i], buf, sizeof(buf)));
+}
 
-    // 输出负载
-    if (out && out_len)
+// thread <名字|all> [cpu N|any] [rt [N]|normal]：没给的项保持原样
+static void thread_cmd(char *args)
+{
+    char *who = strtok(args, " \t");
+    int first = -1, last = -1;
+    for (int i = 0; who && i < TH_COUNT; ++i)
+        if (!strcmp(who, k_th_names[i]))
+            first = last = i;
+    if (who && !strcmp(who, "all"))
+        first = 0, last = TH_COUNT - 1;
+    SptConfig c = first >= 0 ? g_thcfg[first] : g_thcfg[0];
+    bool bad = first < 0, cpu_set = false, prio_set = false;
+    for (char *tok = strtok(NULL, " \t"); tok && !bad; tok = strtok(NULL, " \t"))
+    {
+        if (!strcmp(tok, "cpu"))
+        {
+            char *v = strtok(NULL, " \t");
+            cpu_set = true;
+            if (v && !strcmp(v, "any"))
+                c.cpu = -1;
+            else if (v && isdigit((unsigned char)v[0]))
+                c.cpu = atoi(v);
+            else
+                bad = true;
+        }
+        else if (!strcmp(tok, "rt"))
+        {
+            c.prio = SPT_REALTIME;
+            c.rt_prio = 0;
+            prio_set = true;
+        }
+        else if (!strcmp(tok, "normal"))
+        {
+            c.prio = SPT_NORMAL;
+            prio_set = true;
+        }
+        else if (prio_set && c.prio == SPT_REALTIME && isdigit((unsigned char)tok[0]))
+            c.rt_prio = atoi(tok);
+        else
+            bad = true;
+    }
+    if (bad || (!cpu_set && !prio_set))
+    {
+        printf("用法：thread <reader|printer|render|all> [cpu N|any] [rt [1-99]|normal] | thread\n");
+        return;
+    }
+    for (int i = first; i <= last; ++i)
     {
-        size_t n = frame[2];
-        if (*out_len < n)
-            n = *out_len;
-        memcpy(out, &frame[3], n);
-        *out_len = n;
+        SptConfig n = g_thcfg[i];
+        if (cpu_set)
+            n.cpu = c.cpu;
+        if (prio_set)
+        {
+            n.prio = c.prio;
+            n.rt_prio = c.rt_prio;
+        }
+        char err[128] = {0}, buf[48];
+        if (!spt_apply(thread_handle(i), &n, err, sizeof(err)))
+        {
+            printf("%s：%s\n", k_th_names[i], err);
+            spt_apply(thread_handle(i), &g_thcfg[i], NULL, 0); // 回到原来的配置，显示的与实际一致
+            continue;
+        }
+        g_thcfg[i] = n;
+        printf("%-8s %s\n", k_th_names[i], spt_describe(&n, buf, sizeof(buf)));
     }
-    return 1;
 }
 
 /* ------------------ 线程：串口读取 ------------------ */
@@ -268,7 +543,7 @@ static void *reader_thread(void *arg)
 {
 #endif
     (void)arg;
-    unsigned char buf[4096];
+    unsigned char spill[4096]; // 只在环满时使用：读走并丢弃，避免驱动缓冲积压
     while (atomic_load(&g_run_reader))
     {
         if (!sp_is_open(&g_sp))
@@ -276,22 +551,48 @@ static void *reader_thread(void *arg)
             ms_sleep(100);
             continue;
         }
-        long r = sp_read(&g_sp, buf, sizeof(buf));
-        if (r < 0)
+        // 事件驱动：没有数据时阻塞在 poll / WaitCommEvent 上，最多 200ms 回来检查退出标志。
+        // 先等数据再预留：预留会把落后的 DROP 读者推到预留区之前、并缩小快照窗口，不能为还没到的数据占着
+        int w = sp_wait_readable(&g_sp, 200);
+        if (w < 0)
         {
+            sps_rx_error(&g_stats);
             ms_sleep(10);
             continue;
         }
-        if (r == 0)
+        if (w == 0)
+            continue; // 等待超时
+        // 零拷贝：直接读进环内第一段可写区域
+        RbSpan sp[2];
+        bool full = (rbb_write_reserve(&g_rb, sp, RX_CHUNK) == 0);
+        unsigned char *dst = full ? spill : sp[0].ptr;
+        size_t room = full ? sizeof(spill) : sp[0].len;
+        long r = sp_read(&g_sp, dst, room); // 数据已到：有多少读多少，不再等
+        if (r <= 0)
         {
+            if (!full)
+                rbb_write_commit(&g_rb, 0); // 退回预留
+            if (r < 0)
+            {
+                sps_rx_error(&g_stats);
+                ms_sleep(10);
+            }
             continue;
-        } // 短超时
-        rb_push_overwrite(&g_rb, buf, (size_t)r);
-        g_total_rx += (unsigned long)r;
-        if (g_logf)
+        }
+        if (atomic_load(&g_log_tap))
         {
-            fwrite(buf, 1, (size_t)r, g_logf);
-            fflush(g_logf);
+            atomic_store(&g_log_busy, true);
+            if (atomic_load(&g_log_tap))
+                lw_submit(&g_log, dst, (size_t)r); // 队列满时计入日志丢弃，不影响接收
+            atomic_store(&g_log_busy, false);
+        }
+        // 环满（BACKPRESSURE 读者没读完）时丢弃新数据，reader 永不等待任何读者
+        if (full)
+            sps_rx_drop(&g_stats, (size_t)r);
+        else
+        {
+            sps_rx_commit(&g_stats, (size_t)r, rbb_lag(&g_rb, g_cur_parse) + (size_t)r); // 标记先于数据对 printer 可见
+            rbb_write_commit(&g_rb, (size_t)r);
         }
     }
 #ifdef _WIN32
@@ -302,6 +603,24 @@ static void *reader_thread(void *arg)
 }
 
 /* ------------------ 线程：展示（原始/解析） ------------------ */
+// printer 无事可做时睡下：直到解析游标至少有 min_bytes 字节（原始显示游标与它同步推进，不用单独等）、
+// 组里有新数据，或命令线程 rb_ev_wake（改了 live/parse 等状态）；生产者只在这里真的睡着时才发唤醒
+static void printer_idle(size_t min_bytes)
+{
+    if (!atomic_load(&g_grp_on))
+    {
+        rbb_wait_readable(&g_rb, g_cur_parse, min_bytes, PRINTER_WAIT_MS);
+        return;
+    }
+    unsigned key = rb_ev_prepare(&g_rx_ev);
+    if (rbb_lag(&g_rb, g_cur_parse) >= min_bytes || group_pending() > 0)
+    {
+        rb_ev_cancel(&g_rx_ev);
+        return;
+    }
+    rb_ev_wait(&g_rx_ev, key, PRINTER_WAIT_MS);
+}
+
 #ifdef _WIN32
 static DWORD WINAPI printer_thread(LPVOID arg)
 {
@@ -310,73 +629,132 @@ static void *printer_thread(void *arg)
 {
 #endif
     (void)arg;
-    unsigned char buf[4096];
 
     while (atomic_load(&g_run_printer))
     {
-        if (!atomic_load(&g_live))
+        int pending = 1;
+        if (atomic_compare_exchange_strong(&g_proto_change, &pending, 2))
         {
-            ms_sleep(50);
-            continue;
+            fp_set_proto(&g_fp, &g_proto_next); // 命令线程已校验过
+            atomic_store(&g_proto_change, 0);
         }
+        size_t gbytes = service_group(); // 多串口组（未打开时为 0）
 
-        if (atomic_load(&g_parse))
+        // 原始显示游标只在需要时挂着：不显示时不让生产者为它做越过的记账
+        bool live = atomic_load(&g_live), parse = atomic_load(&g_parse);
+        bool raw = live && (!parse || atomic_load(&g_raw_too));
+        int raw_id = atomic_load(&g_cur_raw);
+        if (raw != (raw_id >= 0))
         {
-            // 解析模式：尽可能多地吃完整帧
-            int progressed = 0;
-            for (;;)
+            if (raw)
+                raw_id = rbb_attach(&g_rb, RBB_DROP, "display");
+            else
             {
-                uint8_t payload[512];
-                size_t n = sizeof(payload);
-                int ret = try_pop_one_frame(&g_rb, payload, &n);
-                if (ret == 1)
-                {
-                    // 打印一帧
-                    if (g_view == VIEW_ASCII)
-                    {
-                        printf("\n[FRAME len=%zu] ", n);
-                        print_ascii(payload, n);
-                    }
-                    else
-                    {
-                        printf("\n[FRAME len=%zu] ", n);
-                        print_hex_bytes(payload, n);
-                    }
-                    fflush(stdout);
-                    progressed = 1;
-                    continue; // 看看是否还有下一帧
-                }
-                else if (ret == 0)
-                {
-                    break; // 当前没有完整帧（或丢了噪声），休息一下
-                }
-                else
-                { // -1 数据不足
-                    break;
-                }
+                rbb_detach(&g_rb, raw_id);
+                raw_id = -1;
             }
-            if (!progressed)
-                ms_sleep(20);
+            atomic_store(&g_cur_raw, raw_id);
+        }
+
+        if (!live)
+        {
+            // 不展示时解析游标丢弃最旧数据（O(1) 推进），让 reader 始终有空间写新数据；
+            // 环里始终留着最新的内容，dump 随时可看
+            size_t used = rbb_lag(&g_rb, g_cur_parse), keep = rbb_capacity(&g_rb) / 2;
+            if (used > keep)
+                sps_skip(&g_stats, rbb_skip(&g_rb, g_cur_parse, used - keep));
+            if (!gbytes)
+                printer_idle(keep + 1);
             continue;
         }
 
-        // 非解析模式：弹块打印
-        size_t avail = rb_size(&g_rb);
+        // 两个游标各自 peek：同一份数据，解析器与原始显示各读各的
+        RbSpan sp[2], rs[2];
+        size_t avail = rbb_peek_spans(&g_rb, g_cur_parse, sp);
+        size_t ravail = raw_id >= 0 ? rbb_peek_spans(&g_rb, raw_id, rs) : 0;
+        if (avail == 0 && ravail == 0)
+        {
+            if (!gbytes)
+                printer_idle(1);
+            continue;
+        }
+        if (ravail)
+        {
+            show_raw(rs[0].ptr, rs[0].len);
+            show_raw(rs[1].ptr, rs[1].len);
+            if (!rbb_consume(&g_rb, raw_id, ravail)) // 被越过的字节记在游标的 dropped 里（stat 可见）
+                show_gap();
+        }
         if (avail == 0)
+            continue;
+
+        if (parse)
         {
-            ms_sleep(20);
+            // 解析模式：把当前所有可读数据原地喂给解析器，然后整体消费
+            if (atomic_exchange(&g_parse_reset, false))
+                fp_reset(&g_fp);
+            sps_batch(&g_stats, avail, g_fp.bytes);
+            fp_feed(&g_fp, sp[0].ptr, sp[0].len);
+            fp_feed(&g_fp, sp[1].ptr, sp[1].len);
+            rbb_consume(&g_rb, g_cur_parse, avail);
+            sps_consume(&g_stats, avail);
+            sps_set(&g_stats.pr.frames, g_fp.frames);
+            sps_set(&g_stats.pr.chk_fail, g_fp.chk_fail);
+            sps_set(&g_stats.pr.noise_bytes, g_fp.noise_bytes);
+            sps_set(&g_stats.pr.oversize, g_fp.oversize);
             continue;
         }
-        size_t want = (avail > sizeof(buf)) ? sizeof(buf) : avail;
-        size_t got = rb_pop(&g_rb, buf, want);
-        if (got)
+
+        // 非解析模式：原始显示游标已经展示过，解析游标只跟着推进（统计的消费/滞后仍按它算）
+        sps_batch(&g_stats, avail, 0);
+        rbb_consume(&g_rb, g_cur_parse, avail);
+        sps_consume(&g_stats, avail);
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* ------------------ 线程：渲染 ------------------ */
+// 把所有已就绪的槽格式化进一个大缓冲，一批只写一次控制台；
+// 控制台慢时队列会满，丢弃发生在 printer 入队处，解析不受影响
+#ifdef _WIN32
+static DWORD WINAPI render_thread(LPVOID arg)
+{
+#else
+static void *render_thread(void *arg)
+{
+#endif
+    (void)arg;
+    static char out[RENDER_BUF];
+    static uint64_t probe_t[FQ_SLOTS]; // 压测：本批探针帧的写出时刻，刷到控制台后再记延迟
+    while (atomic_load(&g_run_render))
+    {
+        size_t n = fq_wait(&g_fq, PRINTER_WAIT_MS);
+        if (n == 0)
+            continue;
+        ViewMode v = g_view;
+        bool st_on = atomic_load(&g_st_on);
+        size_t fill = 0, np = 0;
+        for (size_t i = 0; i < n; ++i)
         {
-            if (g_view == VIEW_ASCII)
-                print_ascii(buf, got);
-            else
-                print_hex_bytes(buf, got);
-            fflush(stdout);
+            if (sizeof(out) - fill < SLOT_TEXT_MAX)
+            {
+                fwrite(out, 1, fill, stdout);
+                fill = 0;
+            }
+            const FqSlot *sl = fq_at(&g_fq, i);
+            if (st_on && sl->kind == FQ_FRAME && np < FQ_SLOTS && st_probe_time(sl->data, sl->len, &probe_t[np]))
+                ++np;
+            fill += fmt_slot(out + fill, sl, v);
         }
+        fq_release(&g_fq, n); // 已拷进 out，槽可以还给 printer 了
+        fwrite(out, 1, fill, stdout);
+        fflush(stdout);
+        for (size_t k = 0; k < np; ++k)
+            st_on_display(&g_st, probe_t[k]);
     }
 #ifdef _WIN32
     return 0;
@@ -385,46 +763,298 @@ static void *printer_thread(void *arg)
 #endif
 }
 
+/* ------------------ 统计 ------------------ */
+// stat：广播环上每个读者一行（* 标出最慢的那个）
+static void print_readers(void)
+{
+    size_t worst = 0;
+    int slow = rbb_slowest(&g_rb, &worst);
+    unsigned act = atomic_load(&g_rb.readers);
+    for (int i = 0; i < RBB_MAX_READERS; ++i)
+    {
+        if (!(act & (1u << i)))
+            continue;
+        const RbbCursor *cu = &g_rb.cur[i];
+        printf("  %c%-8s %-4s lag=%zu  lag_max=%zu  dropped=%zu  overruns=%zu\n", i == slow ? '*' : ' ', cu->name,
+               cu->policy == RBB_DROP ? "drop" : "wait", rbb_lag(&g_rb, i), (size_t)cu->lag_max, (size_t)cu->dropped,
+               (size_t)cu->overruns);
+    }
+}
+
+// 环上丢掉的字节：reader 环满丢弃 + printer 不展示时丢弃的最旧数据
+static uint64_t ring_drops(void)
+{
+    return sps_get(&g_stats.rd.drop_bytes) + sps_get(&g_stats.pr.skip_bytes);
+}
+
+// stat：一个直方图一行；scale 把记录单位换成显示单位（ns -> us 传 1000）
+static void print_hist(const char *name, const SpHist *h, double scale)
+{
+    static SpHistSnap s; // 只在命令线程用
+    sph_snapshot(h, &s);
+    if (!s.count)
+    {
+        printf("%s: (无样本)\n", name);
+        return;
+    }
+    printf("%s: n=%llu  avg=%.1f  p50<=%.1f  p90<=%.1f  p99<=%.1f  p999<=%.1f  max=%.1f\n", name,
+           (unsigned long long)s.count, sph_mean(&s) / scale, (double)sph_pct(&s, 0.50) / scale,
+           (double)sph_pct(&s, 0.90) / scale, (double)sph_pct(&s, 0.99) / scale, (double)sph_pct(&s, 0.999) / scale,
+           (double)s.max / scale);
+}
+
+// 导出的直方图（名字即 JSON 键 / CSV 列前缀）
+enum
+{
+    EX_READ_SIZE = 0,
+    EX_PARSE,
+    EX_LAG,
+    EX_LAG_BYTES,
+    EX_HIST_COUNT
+};
+static const char *const k_ex_hist_names[EX_HIST_COUNT] = {"read_size", "parse_us", "lag_us", "lag_bytes"};
+static const double k_ex_hist_scale[EX_HIST_COUNT] = {1, 1000, 1000, 1};
+
+// 导出的计数器（累计值）
+enum
+{
+    EX_T_MS = 0,
+    EX_UP_MS,
+    EX_RX_BYTES,
+    EX_READS,
+    EX_READ_ERRORS,
+    EX_DROP_BYTES,
+    EX_SKIP_BYTES,
+    EX_RING_USED,
+    EX_RING_HWM,
+    EX_FRAMES,
+    EX_CHK_FAIL,
+    EX_NOISE_BYTES,
+    EX_OVERSIZE,
+    EX_SHOW_DROP,
+    EX_TX_BYTES,
+    EX_COUNT
+};
+static const char *const k_ex_names[EX_COUNT] = {"t_ms",     "up_ms",       "rx_bytes",   "reads",
+                                                 "read_errors", "drop_bytes", "skip_bytes", "ring_used",
+                                                 "ring_hwm", "frames",      "chk_fail",   "noise_bytes",
+                                                 "oversize", "show_drop_frames", "tx_bytes"};
+
+// 导出线程：每行 = 累计计数器 + 本区间（与上一行之差）的直方图
+static void stats_emit(FILE *f, bool csv, bool first, void *user)
+{
+    (void)user;
+    static SpHistSnap prev[EX_HIST_COUNT], now, d; // 只在导出线程用
+    const SpsReader *rd = &g_stats.rd;
+    const SpsParser *pr = &g_stats.pr;
+    const SpHist *h[EX_HIST_COUNT] = {&rd->read_size, &pr->parse_ns, &pr->lag_ns, &pr->lag_bytes};
+    uint64_t v[EX_COUNT] = {sps_wall_ms(),
+                            (rb_ev_now_ns() - g_stats.t0) / 1000000u,
+                            sps_get(&rd->rx_bytes),
+                            sps_get(&rd->reads),
+                            sps_get(&rd->read_errors),
+                            sps_get(&rd->drop_bytes),
+                            sps_get(&pr->skip_bytes),
+                            rbb_size(&g_rb),
+                            sps_get(&rd->ring_hwm),
+                            sps_get(&pr->frames),
+                            sps_get(&pr->chk_fail),
+                            sps_get(&pr->noise_bytes),
+                            sps_get(&pr->oversize),
+                            (unsigned long)g_show_drop.frames,
+                            (unsigned long)g_total_tx.v};
+    if (first)
+    {
+        memset(prev, 0, sizeof(prev));
+        if (csv)
+        {
+            for (int i = 0; i < EX_COUNT; ++i)
+                fprintf(f, i ? ",%s" : "%s", k_ex_names[i]);
+            for (int i = 0; i < EX_HIST_COUNT; ++i)
+                sph_write_csv_header(f, k_ex_hist_names[i]);
+            fputc('\n', f);
+        }
+    }
+    for (int i = 0; i < EX_COUNT; ++i)
+    {
+        if (csv)
+            fprintf(f, i ? ",%llu" : "%llu", (unsigned long long)v[i]);
+        else
+            fprintf(f, "%s\"%s\":%llu", i ? "," : "{", k_ex_names[i], (unsigned long long)v[i]);
+    }
+    for (int i = 0; i < EX_HIST_COUNT; ++i)
+    {
+        sph_snapshot(h[i], &now);
+        sph_delta(&d, &now, &prev[i]);
+        prev[i] = now;
+        if (csv)
+            sph_write_csv(f, &d, k_ex_hist_scale[i]);
+        else
+            sph_write_json(f, k_ex_hist_names[i], &d, k_ex_hist_scale[i]);
+    }
+    fputs(csv ? "\n" : "}\n", f);
+}
+
+/* ------------------ 压测 ------------------ */
+// 报告里的丢弃/校验失败/CPU 是相对 stress start 那一刻的增量
+enum
+{
+    ST_TH_READER = 0,
+    ST_TH_PRINTER,
+    ST_TH_RENDER,
+    ST_TH_TX,
+    ST_TH_GEN,
+    ST_TH_COUNT
+};
+static const char *const k_st_th_names[ST_TH_COUNT] = {"reader", "printer", "render", "tx", "gen"};
+static double g_st_cpu0[ST_TH_COUNT];
+static unsigned long g_st_show0;
+static uint64_t g_st_drop0, g_st_chk0, g_st_noise0;
+
+// 各线程累计 CPU（毫秒，取不到为 -1）；发生器退出后用它自己最后记下的值
+static void stress_cpu(double ms[ST_TH_COUNT])
+{
+#ifdef _WIN32
+    ms[ST_TH_READER] = st_thread_cpu_ms(hReader);
+    ms[ST_TH_PRINTER] = st_thread_cpu_ms(hPrinter);
+    ms[ST_TH_RENDER] = st_thread_cpu_ms(hRender);
+#else
+    ms[ST_TH_READER] = st_thread_cpu_ms(thReader);
+    ms[ST_TH_PRINTER] = st_thread_cpu_ms(thPrinter);
+    ms[ST_TH_RENDER] = st_thread_cpu_ms(thRender);
+#endif
+    ms[ST_TH_TX] = txq_running(&g_txq) ? st_thread_cpu_ms(g_txq.th) : -1;
+    ms[ST_TH_GEN] = st_running(&g_st) ? st_thread_cpu_ms(g_st.th) : g_st.cpu_ms;
+}
+
+static void stress_report(void)
+{
+    double sec = st_elapsed(&g_st);
+    double wall_ms = (double)(rb_ev_now_ns() - g_st.t_start) / 1e6;
+    unsigned long long sent = g_st.sent, rx = g_st.rx, lost = g_st.lost;
+    printf("stress: %s %.2fs  proto=%s  rate=%u/s  payload=%u  noise=%u%%\n", st_running(&g_st) ? "运行中" : "已停",
+           sec, g_st.proto.name, g_st.cfg.rate, g_st.cfg.payload, g_st.cfg.noise_pct);
+    printf("  sent=%llu frames (%.0f/s, %.2f MB/s 含噪声 %llu B)  write_errors=%lu\n", sent,
+           sec > 0 ? (double)sent / sec : 0.0, sec > 0 ? (double)g_st.sent_bytes / sec / 1e6 : 0.0,
+           (unsigned long long)g_st.noise_bytes, (unsigned long)g_st.write_errors);
+    long long flight = (long long)(sent - rx - lost);
+    printf("  recv=%llu frames (%.0f/s)  lost=%llu  reorder=%llu  in_flight=%lld\n", rx,
+           sec > 0 ? (double)rx / sec : 0.0, lost, (unsigned long long)g_st.reorder, flight > 0 ? flight : 0);
+    printf("  drops: ring=%llu B  show=%lu frames  chk_fail=%llu  noise=%llu B\n",
+           (unsigned long long)(ring_drops() - g_st_drop0), (unsigned long)g_show_drop.frames - g_st_show0,
+           (unsigned long long)(sps_get(&g_stats.pr.chk_fail) - g_st_chk0),
+           (unsigned long long)(sps_get(&g_stats.pr.noise_bytes) - g_st_noise0));
+    print_hist("  parse   latency(us)", &g_st.parse, 1000);
+    print_hist("  display latency(us)", &g_st.display, 1000);
+    double cpu[ST_TH_COUNT];
+    stress_cpu(cpu);
+    printf("  cpu(ms):");
+    for (int i = 0; i < ST_TH_COUNT; ++i)
+    {
+        if (cpu[i] < 0 || g_st_cpu0[i] < 0)
+            continue;
+        double d = cpu[i] - g_st_cpu0[i];
+        printf("  %s=%.0f (%.1f%%)", k_st_th_names[i], d, wall_ms > 0 ? d * 100.0 / wall_ms : 0.0);
+    }
+    printf("\n");
+}
+
+// 停发生器，给接收端一点时间收完已写出的帧，打印报告，再关对端（pty 时连同接收端）
+static void stress_stop(bool report)
+{
+    if (!atomic_load(&g_st_on))
+        return;
+    st_stop(&g_st);
+    for (int i = 0; i < 100 && g_st.rx + g_st.lost < g_st.sent && rbb_size(&g_rb); ++i)
+        ms_sleep(10);
+    if (report)
+        stress_report();
+    atomic_store(&g_st_on, false);
+    bool pty = g_st.pty;
+    st_close(&g_st);
+    if (pty)
+        close_port(); // 从端已挂断
+}
+
 /* ------------------ 命令行 ------------------ */
 static void print_help(void)
 {
     printf(
         "命令：\n"
-        "  open <port> <baud>    打开串口（Win: COM3  Linux/mac: /dev/ttyUSB0）\n"
+        "  open <port> <baud> [default|lowlat|bulk] [rxbuf [txbuf]]  打开串口（Win: COM3  Linux/mac: /dev/ttyUSB0）\n"
+        "                        波特率任意（如 3000000 / 12000000）；lowlat 有字节即唤醒（请求/应答设备），\n"
+        "                        bulk 凑批再唤醒（连续数据流）；rxbuf/txbuf 为驱动缓冲字节数（Windows）\n"
         "  close                 关闭串口\n"
-        "  txs <字符串>          发送字符串（原样字节）\n"
+        "  txs <字符串>          发送字符串（原样字节；入队后由写线程合并发送）\n"
         "  txx <hex...>          发送十六进制，如：txx 55 AA 01 02 0D 0A\n"
         "  live on|off           实时打印开关（默认 on）\n"
         "  mode ascii|hex        打印模式（ASCII/HEX）\n"
-        "  parse on|off          帧解析开关（AA 55 | LEN | PAYLOAD | CHK）\n"
-        "  log on [file]         开启日志到文件（默认 serial.log）\n"
+        "  parse on|off          帧解析开关（默认协议 AA 55 | LEN | PAYLOAD | CHK）\n"
+        "  raw on|off            解析时同时显示原始字节（两者各读各的，互不影响）\n"
+        "  proto [名字|描述]     查看/切换帧协议，如 proto aa55-le16-crc16 / proto cobs-crc32 /\n"
+        "                        proto len hdr=A55A size=2 be chk=crc32 cover=body max=1024\n"
+        "  log on [file] [direct] [wait]  开启日志到文件（默认 serial.log；direct 绕过页缓存；\n"
+        "                        wait 慢盘时不丢日志，改为挤占接收环，默认慢盘只丢日志）\n"
+        "  log cap [file] [direct] 抓包格式日志（默认 capture.spcap：时间戳 + 帧边界索引）\n"
         "  log off               关闭日志\n"
-        "  dump [N]              从缓冲 peek 最多 N 字节（不消费，默认 256）\n"
-        "  size/free             查看环形缓冲使用情况\n"
-        "  stat                  统计：累计收/发、丢弃字节\n"
+        "  replay <file> [wire|max] [from_sec]  回放抓包（wire 按原节奏，max 全速只统计）\n"
+        "  dump [N] [new]        快照复制最多 N 字节（不消费、不阻塞收发，默认 256，从最旧的数据起；new 取最新的）\n"
+        "  size/free             查看环形缓冲使用情况（size 按最慢的读者算）\n"
+        "  stat                  统计：累计收/发、丢弃字节、读调用大小/环高水位、各读者滞后/丢弃、帧数/校验失败/噪声字节、\n"
+        "                        解析延迟与消费滞后直方图、展示丢弃、TX 队列与延迟\n"
+        "  stat export <file> [interval_ms] [json|csv]  周期追加一行统计（默认 1000 ms、JSON lines）；stat export off 停止\n"
         "  rtscts on|off         硬件流控\n"
+        "  stress start [rate] [payload] [noise%%] [seconds] [peer]  压测：向伪终端（Windows 给出虚拟串口对的另一端 peer）\n"
+        "                        灌带时间戳的探针帧（默认 1000 帧/秒、64 字节、无噪声、10 秒；rate=0 尽快），\n"
+        "                        统计端到端延迟、丢帧与各线程 CPU；stress 查看，stress stop 结束\n"
+        "  net start <tcp_port> [raw|telnet] [udp <group> <port>]  网络桥：把接收流转发给 TCP 客户端\n"
+        "                        （raw 原样，telnet 为 RFC 2217 风格、只读），可同时发往 UDP 组播（报文带 8 字节流位置）\n"
+        "  net [stop]            查看网络桥客户端与攒批效果 / 关闭网络桥\n"
+        "  thread [reader|printer|render|all] [cpu N|any] [rt [1-99]|normal]\n"
+        "                        查看/设置线程绑核与实时优先级（SCHED_FIFO / TIME_CRITICAL；配合 stress 看尾延迟）\n"
+        "  gopen [-t N] <baud> <port...>  多串口组：N 个 I/O 线程（默认 2）服务所有端口\n"
+        "  gstat                 多串口组逐端口统计\n"
+        "  gclose                关闭多串口组\n"
         "  exit/quit             退出\n");
 }
 
 int main(void)
 {
-    if (!rb_init(&g_rb, RB_CAP))
+    // 优先用镜像映射（环内数据总是连续的），不支持时回退普通内存
+    if (!rbb_init_mirror(&g_rb, RB_CAP) && !rbb_init(&g_rb, RB_CAP))
     {
         fprintf(stderr, "ring buffer init failed\n");
         return 1;
     }
+    g_cur_parse = rbb_attach(&g_rb, RBB_BACKPRESSURE, "parser");
+    if (!fq_init(&g_fq, FQ_SLOTS))
+    {
+        fprintf(stderr, "frame queue init failed\n");
+        return 1;
+    }
+    sps_init(&g_stats);
+    init_fmt_tables();
+    rb_ev_init(&g_rx_ev);
+    rbb_set_notify(&g_rb, &g_rx_ev);
     memset(&g_sp, 0, sizeof(g_sp));
     atomic_store(&g_run_reader, true);
     atomic_store(&g_run_printer, true);
+    atomic_store(&g_run_render, true);
     atomic_store(&g_live, true);
     atomic_store(&g_parse, false);
+    fp_init(&g_fp, on_frame, NULL);
+    proto_default(&g_proto);
+    for (int i = 0; i < TH_COUNT; ++i)
+        spt_default_config(&g_thcfg[i]);
 
 #ifdef _WIN32
     hReader = CreateThread(NULL, 0, reader_thread, NULL, 0, NULL);
     hPrinter = CreateThread(NULL, 0, printer_thread, NULL, 0, NULL);
+    hRender = CreateThread(NULL, 0, render_thread, NULL, 0, NULL);
 #else
     pthread_create(&thReader, NULL, reader_thread, NULL);
     pthread_create(&thPrinter, NULL, printer_thread, NULL);
+    pthread_create(&thRender, NULL, render_thread, NULL);
 #endif
 
     printf("串口小终端就绪。输入 help 查看命令。\n");
@@ -432,6 +1062,7 @@ int main(void)
 
     for (;;)
     {
+        rb_ev_wake(&g_rx_ev); // 上一条命令可能改了 live/parse/组状态，让 printer 立即重新检查
         printf("\nser> ");
         fflush(stdout);
         if (!fgets(line, sizeof(line), stdin))
@@ -466,31 +1097,49 @@ int main(void)
         {
             if (!*args)
             {
-                printf("用法：open <port> <baud>\n");
+                printf("用法：open <port> <baud> [default|lowlat|bulk] [rxbuf [txbuf]]\n");
                 continue;
             }
-            char port[128] = {0};
-            int baud = 115200;
-            int got = sscanf(args, "%127s %d", port, &baud);
-            if (got < 1)
+            SpConfig spc;
+            sp_default_config(&spc, 115200);
+            spc.async = true;
+            char *port = strtok(args, " \t");
+            char *tok = strtok(NULL, " \t");
+            if (tok)
+                spc.baud = atoi(tok);
+            tok = strtok(NULL, " \t");
+            if (tok && sp_profile_parse(tok, &spc.profile))
+                tok = strtok(NULL, " \t");
+            if (tok)
+            {
+                spc.rx_buf = spc.tx_buf = (unsigned)strtoul(tok, NULL, 0);
+                if ((tok = strtok(NULL, " \t")) != NULL)
+                    spc.tx_buf = (unsigned)strtoul(tok, NULL, 0);
+            }
+            if (!port || spc.baud <= 0)
             {
-                printf("用法：open <port> <baud>\n");
+                printf("用法：open <port> <baud> [default|lowlat|bulk] [rxbuf [txbuf]]\n");
                 continue;
             }
             if (sp_is_open(&g_sp))
+            {
+                close_port();
+            }
+            if (!sp_open_ex(&g_sp, port, &spc))
+                printf("打开失败。\n");
+            else if (!txq_start(&g_txq, &g_sp, &g_total_tx.v))
             {
                 sp_close(&g_sp);
+                printf("打开失败（TX 队列）。\n");
             }
-            if (sp_open(&g_sp, port, baud))
-                printf("打开成功：%s @ %d 8N1\n", port, baud);
             else
-                printf("打开失败。\n");
+                printf("打开成功：%s @ %d 8N1 (%s)\n", port, g_sp.baud, sp_profile_name(g_sp.profile));
         }
         else if (!strcmp(cmd, "close"))
         {
             if (sp_is_open(&g_sp))
             {
-                sp_close(&g_sp);
+                close_port();
                 puts("已关闭。");
             }
             else
@@ -508,10 +1157,11 @@ int main(void)
                 printf("未打开串口。\n");
                 continue;
             }
-            long w = sp_write(&g_sp, args, strlen(args));
-            if (w > 0)
-                g_total_tx += (unsigned long)w;
-            printf("已发 %ld 字节\n", w);
+            size_t n = strlen(args);
+            if (txq_send(&g_txq, args, n, TX_SEND_WAIT_MS))
+                printf("已入队 %zu 字节\n", n);
+            else
+                printf("发送队列满，丢弃 %zu 字节\n", n);
         }
         else if (!strcmp(cmd, "txx"))
         {
@@ -532,10 +1182,10 @@ int main(void)
                 printf("解析失败。\n");
                 continue;
             }
-            long w = sp_write(&g_sp, bytes, n);
-            if (w > 0)
-                g_total_tx += (unsigned long)w;
-            printf("已发 %ld/%zu 字节\n", w, n);
+            if (txq_send(&g_txq, bytes, n, TX_SEND_WAIT_MS))
+                printf("已入队 %zu 字节\n", n);
+            else
+                printf("发送队列满，丢弃 %zu 字节\n", n);
             free(bytes);
         }
         else if (!strcmp(cmd, "live"))
@@ -574,37 +1224,112 @@ int main(void)
                 continue;
             }
             if (!strcmp(args, "on"))
+            {
+                atomic_store(&g_parse_reset, true); // 从干净状态开始找帧头
                 atomic_store(&g_parse, true);
+            }
             else if (!strcmp(args, "off"))
                 atomic_store(&g_parse, false);
             else
                 printf("用法：parse on|off\n");
         }
+        else if (!strcmp(cmd, "raw"))
+        {
+            if (!*args)
+            {
+                printf("raw = %s\n", atomic_load(&g_raw_too) ? "on" : "off");
+                continue;
+            }
+            if (!strcmp(args, "on"))
+                atomic_store(&g_raw_too, true);
+            else if (!strcmp(args, "off"))
+                atomic_store(&g_raw_too, false);
+            else
+                printf("用法：raw on|off\n");
+        }
+        else if (!strcmp(cmd, "proto"))
+        {
+            char desc[160];
+            if (!*args)
+            {
+                proto_describe(&g_proto, desc, sizeof(desc));
+                printf("当前 %s\n内置：", desc);
+                for (size_t i = 0; proto_builtin_name(i); ++i)
+                    printf("%s ", proto_builtin_name(i));
+                printf("\n");
+                continue;
+            }
+            ProtoDesc d;
+            char err[160];
+            if (!proto_parse(args, &d, err, sizeof(err)))
+            {
+                printf("协议描述有误：%s\n", err);
+                continue;
+            }
+            // 交给 printer 切换（它独占 g_fp），等它取走
+            g_proto_next = d;
+            atomic_store(&g_proto_change, 1);
+            rb_ev_wake(&g_rx_ev);
+            for (int i = 0; i < 1000 && atomic_load(&g_proto_change) == 1; ++i)
+                ms_sleep(1);
+            int pending = 1;
+            if (atomic_compare_exchange_strong(&g_proto_change, &pending, 0))
+            {
+                // printer 一直没来取：撤回，g_proto_next 没被读过，下次可放心改写
+                printf("printer 无响应，协议未切换\n");
+                continue;
+            }
+            while (atomic_load(&g_proto_change) != 0) // 已被取走，fp_set_proto 很快结束
+                ms_sleep(1);
+            g_proto = d;
+            proto_describe(&g_proto, desc, sizeof(desc));
+            printf("协议 -> %s%s\n", desc, atomic_load(&g_grp_on) ? "（已打开的多串口组不变，重新 gopen 生效）" : "");
+        }
         else if (!strcmp(cmd, "log"))
         {
             if (!*args)
             {
-                printf("用法：log on [file] | log off\n");
+                printf("用法：log on [file] [direct] [wait] | log cap [file] [direct] | log off\n");
                 continue;
             }
-            if (!strncmp(args, "on", 2))
+            char w[4][256] = {{0}};
+            int nw = sscanf(args, "%255s %255s %255s %255s", w[0], w[1], w[2], w[3]);
+            if (!strcmp(w[0], "on") || !strcmp(w[0], "cap"))
             {
-                char path[256] = "serial.log";
-                sscanf(args + 2, "%255s", path);
-                if (g_logf)
-                    fclose(g_logf);
-                g_logf = fopen(path, "ab");
-                if (g_logf)
-                    printf("日志开启 -> %s\n", path);
+                bool capture = !strcmp(w[0], "cap");
+                const char *path = capture ? "capture.spcap" : "serial.log";
+                bool direct = false, wait = false, bad = false, named = false;
+                // direct / wait 是关键字，出现在哪个位置都行；其余的那个词是文件名
+                for (int i = 1; i < nw; ++i)
+                {
+                    if (!strcmp(w[i], "direct"))
+                        direct = true;
+                    else if (!strcmp(w[i], "wait"))
+                        wait = true;
+                    else if (!named)
+                    {
+                        path = w[i];
+                        named = true;
+                    }
+                    else
+                        bad = true;
+                }
+                if (bad)
+                {
+                    printf("用法：log on [file] [direct] [wait] | log cap [file] [direct] | log off\n");
+                    continue;
+                }
+                if (open_log(path, direct, capture, wait))
+                    printf("%s开启 -> %s%s%s\n", capture ? "抓包" : "日志", path, g_log.direct ? "（direct I/O）" : "",
+                           g_log.src && wait ? "（不丢日志：慢盘时挤占接收环）" : "");
                 else
                     printf("无法打开日志文件。\n");
             }
-            else if (!strcmp(args, "off"))
+            else if (!strcmp(w[0], "off") && nw == 1)
             {
-                if (g_logf)
+                if (atomic_load(&g_log_on))
                 {
-                    fclose(g_logf);
-                    g_logf = NULL;
+                    close_log();
                     puts("日志关闭。");
                 }
                 else
@@ -612,60 +1337,141 @@ int main(void)
             }
             else
             {
-                printf("用法：log on [file] | log off\n");
+                printf("用法：log on [file] [direct] [wait] | log cap [file] [direct] | log off\n");
             }
         }
         else if (!strcmp(cmd, "dump"))
         {
+            // dump [N] [new]：快照复制，不阻塞 reader 与任何读者；new 取最新的 N 字节（默认从环里最旧的数据起）
             size_t n = 256;
+            bool latest = false;
+            char *end = args;
             if (*args)
             {
-                char *end = NULL;
                 unsigned long tmp = strtoul(args, &end, 0);
                 if (end != args)
                     n = (size_t)tmp;
+                while (*end && isspace((unsigned char)*end))
+                    ++end;
+                latest = !strcmp(end, "new");
             }
             if (n == 0)
             {
                 puts("(N=0)");
                 continue;
             }
-            size_t avail = rb_size(&g_rb);
-            if (n > avail)
-                n = avail;
-            unsigned char *buf = (unsigned char *)malloc(n ? n : 1);
+            if (n > rbb_capacity(&g_rb))
+                n = rbb_capacity(&g_rb);
+            unsigned char *buf = (unsigned char *)malloc(n);
             if (!buf)
             {
                 fprintf(stderr, "内存不足\n");
                 continue;
             }
-            size_t got = rb_peek(&g_rb, buf, n, 0);
+            // 数据在流动时最旧的那一段正被新数据覆盖，重试几次；最新的数据一般一次就完整
+            RbbSnapshot snap;
+            size_t got = 0;
+            for (int tries = 0; tries < 3; ++tries)
+            {
+                got = rbb_snapshot(&g_rb, buf, n, 0, latest, &snap);
+                if (!snap.torn)
+                    break;
+            }
+            printf("[snapshot gen=%zu pos=%zu len=%zu tail=%zu resv=%zu%s]\n", snap.gen, snap.start, got, snap.tail,
+                   snap.resv2, snap.torn ? " 复制期间被覆盖" : "");
+            if (snap.torn)
+                printf("（前 %zu 字节已被新数据覆盖，略去，只显示其后完整的 %zu 字节）\n", snap.lost, got - snap.lost);
             if (g_view == VIEW_ASCII)
-                print_ascii(buf, got);
+                print_ascii(buf + snap.lost, got - snap.lost);
             else
-                print_hex_bytes(buf, got);
+                print_hex_bytes(buf + snap.lost, got - snap.lost);
             putchar('\n');
             free(buf);
         }
         else if (!strcmp(cmd, "size"))
         {
-            printf("size = %zu\n", rb_size(&g_rb));
+            printf("size = %zu\n", rbb_size(&g_rb));
         }
         else if (!strcmp(cmd, "free"))
         {
-            printf("free = %zu\n", rb_free_space(&g_rb));
+            printf("free = %zu\n", rbb_free_space(&g_rb));
         }
         else if (!strcmp(cmd, "stat"))
         {
-            printf("RX=%lu  TX=%lu  dropped(oldest)=%lu  rb(size=%zu free=%zu cap=%zu)\n",
-                   (unsigned long)g_total_rx, (unsigned long)g_total_tx,
-                   (unsigned long)g_drop_bytes, rb_size(&g_rb), rb_free_space(&g_rb), rb_capacity(&g_rb));
+            if (!strncmp(args, "export", 6))
+            {
+                char path[256] = {0}, fmt[8] = "json";
+                unsigned interval = 1000;
+                if (sscanf(args + 6, "%255s %u %7s", path, &interval, fmt) < 1 || !interval ||
+                    (strcmp(fmt, "json") && strcmp(fmt, "csv")))
+                {
+                    printf("用法：stat export <file> [interval_ms] [json|csv] | stat export off\n");
+                    continue;
+                }
+                bool was = sps_export_running(&g_export);
+                sps_export_stop(&g_export); // 换文件/间隔时先停旧的
+                if (!strcmp(path, "off"))
+                {
+                    if (was)
+                        printf("导出关闭（%s 共 %lu 行）。\n", g_export.path, (unsigned long)g_export.lines);
+                    else
+                        puts("导出本就未开。");
+                    continue;
+                }
+                if (sps_export_start(&g_export, path, interval, !strcmp(fmt, "csv"), stats_emit, NULL))
+                    printf("统计导出 -> %s（每 %u ms 一行 %s）\n", path, interval, fmt);
+                else
+                    printf("无法打开导出文件。\n");
+                continue;
+            }
+            const SpsReader *rd = &g_stats.rd;
+            const SpsParser *pr = &g_stats.pr;
+            unsigned long long reads = sps_get(&rd->reads), rx = sps_get(&rd->rx_bytes);
+            printf("RX=%llu  TX=%lu  dropped=%llu (ring_full=%llu live_off=%llu)\n", rx, (unsigned long)g_total_tx.v,
+                   (unsigned long long)ring_drops(), (unsigned long long)sps_get(&rd->drop_bytes),
+                   (unsigned long long)sps_get(&pr->skip_bytes));
+            printf("rb: size=%zu  free=%zu  cap=%zu  hwm=%llu  reads=%llu (%.1f B/read)  read_errors=%llu\n",
+                   rbb_size(&g_rb), rbb_free_space(&g_rb), rbb_capacity(&g_rb),
+                   (unsigned long long)sps_get(&rd->ring_hwm), reads, reads ? (double)rx / reads : 0.0,
+                   (unsigned long long)sps_get(&rd->read_errors));
+            print_readers();
+            printf("proto=%s  frames=%llu  chk_fail=%llu  noise=%llu  oversize=%llu\n", g_proto.name,
+                   (unsigned long long)sps_get(&pr->frames), (unsigned long long)sps_get(&pr->chk_fail),
+                   (unsigned long long)sps_get(&pr->noise_bytes), (unsigned long long)sps_get(&pr->oversize));
+            print_hist("read size(B)", &rd->read_size, 1);
+            print_hist("parse latency(us)", &pr->parse_ns, 1000);
+            print_hist("consumer lag(us)", &pr->lag_ns, 1000);
+            print_hist("consumer lag(B)", &pr->lag_bytes, 1);
+            if (sps_get(&rd->mark_drops))
+                printf("（标记环满 %llu 次：这些提交没有延迟样本）\n", (unsigned long long)sps_get(&rd->mark_drops));
+            printf("show: queued=%zu  dropped_frames=%lu  dropped_bytes=%lu\n", fq_readable(&g_fq),
+                   (unsigned long)g_show_drop.frames, (unsigned long)g_show_drop.bytes);
+            bool log_on = atomic_load(&g_log_on);
+            unsigned long log_drop = (unsigned long)g_log_lost + (log_on ? (unsigned long)g_log.dropped : 0);
+            if (log_on)
+                printf("log=%s  written=%lu  writes=%lu  errors=%lu  log_dropped=%lu\n", g_log.path,
+                       (unsigned long)g_log.written, (unsigned long)g_log.writes,
+                       (unsigned long)g_log.errors, log_drop);
+            else
+                printf("log=off  log_dropped=%lu\n", log_drop);
+            unsigned long tx_msgs = (unsigned long)g_txq.msgs_done, tx_writes = (unsigned long)g_txq.writes;
+            unsigned long tx_bytes = (unsigned long)g_txq.bytes;
+            printf("tx: queued=%zu  msgs=%lu  writes=%lu (%.1f B/write)  partial=%lu  errors=%lu  rejected=%lu  "
+                   "cts_stall=%lu  %.0f B/s\n",
+                   txq_pending(&g_txq), tx_msgs, tx_writes, tx_writes ? (double)tx_bytes / tx_writes : 0.0,
+                   (unsigned long)g_txq.partial, (unsigned long)g_txq.errors, (unsigned long)g_txq.rejected,
+                   (unsigned long)g_txq.cts_wait, txq_running(&g_txq) ? txq_rate(&g_txq) : 0.0);
+            if (tx_msgs)
+                print_hist("tx latency(us)", &g_txq.lat_ns, 1000);
+            if (sps_export_running(&g_export))
+                printf("export=%s  %s  every %u ms  lines=%lu\n", g_export.path, g_export.csv ? "csv" : "json",
+                       g_export.interval_ms, (unsigned long)g_export.lines);
         }
         else if (!strcmp(cmd, "rtscts"))
         {
             if (!*args)
             {
-                printf("当前：%s\n", g_sp.rtscts ? "on" : "off");
+                printf("当前：%s\n", atomic_load(&g_sp.rtscts) ? "on" : "off");
                 continue;
             }
             if (!sp_is_open(&g_sp))
@@ -679,6 +1485,229 @@ int main(void)
             else
                 printf("设置失败（平台/驱动可能不支持）。\n");
         }
+        else if (!strcmp(cmd, "replay"))
+        {
+            char path[256] = {0}, speed[16] = "max";
+            double from = 0;
+            if (sscanf(args, "%255s %15s %lf", path, speed, &from) < 1)
+            {
+                printf("用法：replay <file> [wire|max] [from_sec]\n");
+                continue;
+            }
+            CapFile cf;
+            if (!cap_map(&cf, path))
+            {
+                printf("无法打开抓包文件（不存在或格式不对）：%s\n", path);
+                continue;
+            }
+            bool wire = !strcmp(speed, "wire");
+            CapReplayStats st;
+            printf("抓包协议：%s\n", cf.proto.name);
+            // wire 模式像在线解析一样打印帧；max 模式只统计
+            cap_replay(&cf, (uint64_t)(from * 1e9), wire, wire ? on_replay_frame : NULL, NULL, &st);
+            cap_unmap(&cf);
+            printf("\nreplay: %llu 字节 / %llu 块，frames=%llu chk_fail=%llu noise=%llu\n",
+                   (unsigned long long)st.bytes, (unsigned long long)st.chunks, (unsigned long long)st.frames,
+                   (unsigned long long)st.chk_fail, (unsigned long long)st.noise);
+            printf("抓包时长 %.3fs，回放耗时 %.3fs（%.1f MB/s）\n", (double)st.span_ns * 1e-9, st.seconds,
+                   st.seconds > 0 ? (double)st.bytes / st.seconds / 1e6 : 0.0);
+        }
+        else if (!strcmp(cmd, "stress"))
+        {
+            if (!*args || !strcmp(args, "stat"))
+            {
+                if (atomic_load(&g_st_on))
+                    stress_report();
+                else
+                    puts("压测未开始。");
+                continue;
+            }
+            if (!strcmp(args, "stop"))
+            {
+                if (atomic_load(&g_st_on))
+                    stress_stop(true);
+                else
+                    puts("压测未开始。");
+                continue;
+            }
+            if (strncmp(args, "start", 5) != 0)
+            {
+                printf("用法：stress start [rate] [payload] [noise%%] [seconds] [peer_port] | stress [stat] | stress stop\n");
+                continue;
+            }
+            StressConfig sc = {1000, 64, 0, 10};
+            char peer[128] = {0};
+            sscanf(args + 5, "%u %u %u %u %127s", &sc.rate, &sc.payload, &sc.noise_pct, &sc.seconds, peer);
+            stress_stop(false);
+            st_init(&g_st);
+            if (peer[0])
+            {
+                // 虚拟串口对 / 回环线：接收端由用户先 open，发生器打开另一端
+                if (!sp_is_open(&g_sp))
+                {
+                    puts("请先 open 接收端串口。");
+                    continue;
+                }
+                if (!st_open_port(&g_st, peer, g_sp.baud))
+                {
+                    printf("无法打开对端 %s\n", peer);
+                    continue;
+                }
+            }
+            else
+            {
+#ifdef _WIN32
+                puts("Windows 没有伪终端：请给出虚拟串口对（com0com 等）的另一端，如 stress start 1000 64 0 10 COM11");
+                continue;
+#else
+                if (!st_open_pty(&g_st))
+                {
+                    puts("无法创建伪终端。");
+                    continue;
+                }
+                SpConfig spc;
+                sp_default_config(&spc, 115200);
+                spc.async = true;
+                close_port();
+                if (!sp_open_ex(&g_sp, g_st.slave_name, &spc) || !txq_start(&g_txq, &g_sp, &g_total_tx.v))
+                {
+                    printf("无法打开伪终端从端 %s\n", g_st.slave_name);
+                    if (sp_is_open(&g_sp))
+                        sp_close(&g_sp);
+                    st_close(&g_st);
+                    continue;
+                }
+                printf("伪终端：%s（接收端已切换到它）\n", g_st.slave_name);
+#endif
+            }
+            // 只有 live + parse 时 printer 才解析；从干净的解析状态开始
+            if (!atomic_load(&g_live) || !atomic_load(&g_parse))
+                puts("压测走完整接收链路：live 与 parse 已打开。");
+            atomic_store(&g_live, true);
+            atomic_store(&g_parse_reset, true);
+            atomic_store(&g_parse, true);
+            g_st_drop0 = ring_drops();
+            g_st_show0 = (unsigned long)g_show_drop.frames;
+            g_st_chk0 = sps_get(&g_stats.pr.chk_fail);
+            g_st_noise0 = sps_get(&g_stats.pr.noise_bytes);
+            stress_cpu(g_st_cpu0);
+            g_st_cpu0[ST_TH_GEN] = 0;
+            atomic_store(&g_st_on, true);
+            if (!st_start(&g_st, &g_proto, &sc))
+            {
+                printf("启动失败：payload 应在 %d~%u 之间（协议 %s），noise 不超过 %d%%\n", ST_PROBE_BYTES,
+                       (unsigned)g_proto.max_body, g_proto.name, ST_MAX_NOISE_PCT);
+                stress_stop(false);
+                continue;
+            }
+            printf("压测开始：%u 帧/秒  负载 %u 字节  噪声 %u%%  %u 秒（协议 %s）；stress 查看，stress stop 结束\n",
+                   sc.rate, sc.payload, sc.noise_pct, sc.seconds, g_proto.name);
+        }
+        else if (!strcmp(cmd, "thread"))
+        {
+            if (!*args)
+                print_threads();
+            else
+                thread_cmd(args);
+        }
+        else if (!strcmp(cmd, "net"))
+        {
+            if (!*args)
+            {
+                print_net();
+                continue;
+            }
+            if (!strcmp(args, "stop"))
+            {
+                if (g_net_on)
+                {
+                    close_net();
+                    puts("网络桥已关闭。");
+                }
+                else
+                    puts("网络桥未开启。");
+                continue;
+            }
+            unsigned tcp_port = 0, udp_port = 0;
+            char mode[16] = "raw", kw[8] = {0}, group[64] = {0};
+            int n = sscanf(args, "start %u %15s %7s %63s %u", &tcp_port, mode, kw, group, &udp_port);
+            bool udp = n >= 3 && !strcmp(kw, "udp");
+            if (n < 1 || tcp_port == 0 || tcp_port > 65535 || (strcmp(mode, "raw") && strcmp(mode, "telnet")) ||
+                (n >= 3 && (!udp || n < 5 || udp_port == 0 || udp_port > 65535)))
+            {
+                printf("用法：net start <tcp_port> [raw|telnet] [udp <group> <port>] | net | net stop\n");
+                continue;
+            }
+            if (open_net((uint16_t)tcp_port, strcmp(mode, "telnet") ? NB_RAW : NB_TELNET, udp ? group : NULL,
+                         (uint16_t)udp_port))
+            {
+                printf("网络桥：TCP %u（%s）", tcp_port, mode);
+                if (udp)
+                    printf("，组播 %s:%u", group, udp_port);
+                puts("；net 查看，net stop 关闭");
+            }
+        }
+        else if (!strcmp(cmd, "gopen"))
+        {
+            unsigned nthreads = 2;
+            int baud = 0, used = 0;
+            if (sscanf(args, "-t %u %n", &nthreads, &used) == 1)
+                args += used;
+            if (sscanf(args, "%d %n", &baud, &used) != 1 || baud <= 0 || !args[used])
+            {
+                printf("用法：gopen [-t N] <baud> <port1> [port2 ...]\n");
+                continue;
+            }
+            args += used;
+            close_group();
+            spg_init(&g_grp, nthreads, on_group_frame, NULL);
+            spg_set_notify(&g_grp, &g_rx_ev);
+            spg_set_proto(&g_grp, &g_proto);
+            for (char *tok = strtok(args, " \t"); tok; tok = strtok(NULL, " \t"))
+            {
+                if (spg_add(&g_grp, tok, baud) < 0)
+                    printf("跳过：%s（打开失败或超过 %d 个端口）\n", tok, SPG_MAX_PORTS);
+            }
+            if (spg_count(&g_grp) == 0)
+            {
+                puts("没有可用端口。");
+                continue;
+            }
+            if (!spg_start(&g_grp))
+            {
+                puts("启动 I/O 线程失败。");
+                continue;
+            }
+            atomic_store(&g_grp_on, true);
+            printf("多串口组：%zu 个端口 @ %d 8N1，%u 个 I/O 线程\n", spg_count(&g_grp), baud, g_grp.nthreads);
+        }
+        else if (!strcmp(cmd, "gstat"))
+        {
+            if (!atomic_load(&g_grp_on))
+            {
+                puts("多串口组未打开。");
+                continue;
+            }
+            printf("%-24s %10s %8s %8s %8s %8s %s\n", "port", "RX", "dropped", "frames", "chk_fail", "noise", "");
+            for (size_t i = 0; i < spg_count(&g_grp); ++i)
+            {
+                const SpgPort *gp = spg_port(&g_grp, i);
+                printf("%-24s %10lu %8lu %8lu %8lu %8lu %s\n", gp->sp.name,
+                       (unsigned long)gp->rx_bytes, (unsigned long)gp->drop_bytes,
+                       (unsigned long)gp->frames, (unsigned long)gp->chk_fail,
+                       (unsigned long)gp->noise_bytes, atomic_load(&gp->failed) ? "FAILED" : "");
+            }
+        }
+        else if (!strcmp(cmd, "gclose"))
+        {
+            if (atomic_load(&g_grp_on))
+            {
+                close_group();
+                puts("多串口组已关闭。");
+            }
+            else
+                puts("多串口组未打开。");
+        }
         else
         {
             printf("未知命令：%s  （help 查看帮助）\n", cmd);
@@ -686,8 +1715,13 @@ int main(void)
     }
 
     // 收尾
+    stress_stop(false);
+    close_net();
+    sps_export_stop(&g_export);
+    close_group();
     atomic_store(&g_run_reader, false);
     atomic_store(&g_run_printer, false);
+    rb_ev_wake(&g_rx_ev);
     ms_sleep(100);
 #ifdef _WIN32
     if (hReader)
@@ -704,11 +1738,23 @@ int main(void)
     pthread_join(thReader, NULL);
     pthread_join(thPrinter, NULL);
 #endif
-    if (g_logf)
-        fclose(g_logf);
-    if (sp_is_open(&g_sp))
-        sp_close(&g_sp);
-    rb_free(&g_rb);
+    // printer 停了才停 render（它是队列唯一的生产者）
+    atomic_store(&g_run_render, false);
+    fq_wake(&g_fq);
+#ifdef _WIN32
+    if (hRender)
+    {
+        WaitForSingleObject(hRender, 500);
+        CloseHandle(hRender);
+    }
+#else
+    pthread_join(thRender, NULL);
+#endif
+    close_log();
+    close_port();
+    rbb_free(&g_rb);
+    fq_free(&g_fq);
+    rb_ev_destroy(&g_rx_ev);
     puts("bye.");
     return 0;
 }
@@ -0,0 +1,931 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // sendmmsg
+#endif
+#ifdef _WIN32
+// winsock2.h 必须在 windows.h（net_bridge.h -> serial_port.h）之前
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#include "net_bridge.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#define NB_IOV 64         // 一次发送最多这么多段（telnet 转义会把一段拆成多段）
+#define NB_IDLE_MS 50     // 没有待发数据时最多睡这么久（顺带看新连接 / 客户端消息 / run）
+#define NB_UDP_HDR 8      // 组播报头：8 字节大端流位置
+#define NB_UDP_BATCH 16   // 一次最多发几个组播报文
+#define NB_RECV_BYTES 512 // 客户端发来的数据一次读多少（只解析 telnet 命令）
+#define NB_POLL_MAX (NB_MAX_CHANNELS + NB_MAX_CLIENTS + NB_MAX_CHANNELS)
+#define NB_SINKS (NB_MAX_CLIENTS + NB_MAX_CHANNELS)
+
+// Telnet / RFC 2217
+#define TN_SE 240
+#define TN_SB 250
+#define TN_WILL 251
+#define TN_WONT 252
+#define TN_DO 253
+#define TN_DONT 254
+#define TN_IAC 255
+#define TN_BINARY 0
+#define TN_SGA 3
+#define TN_COMPORT 44
+#define CP_SIGNATURE 0
+#define CP_SET_BAUDRATE 1
+#define CP_SET_DATASIZE 2
+#define CP_SET_PARITY 3
+#define CP_SET_STOPSIZE 4
+#define CP_SET_CONTROL 5
+#define CP_FLOW_SUSPEND 8
+#define CP_FLOW_RESUME 9
+#define CP_SET_LINESTATE_MASK 10
+#define CP_SET_MODEMSTATE_MASK 11
+#define CP_PURGE_DATA 12
+#define CP_SERVER_OFFSET 100 // 服务器回报 = 客户端命令 + 100
+
+static const uint8_t k_iac = TN_IAC; // telnet 转义时插进 iovec 的第二个 0xFF
+static const char k_signature[] = "C_Learn serial bridge";
+
+/* ---------------- 平台相关：套接字 ---------------- */
+#ifdef _WIN32
+typedef SOCKET nb_sock;
+typedef WSABUF NbIov;
+typedef WSAPOLLFD NbPollFd;
+#define NB_IOV_SET(v, p, n) ((v).buf = (CHAR *)(p), (v).len = (ULONG)(n))
+#define NB_IOV_LEN(v) ((size_t)(v).len)
+#define NB_SOCK(x) ((nb_sock)(x))
+
+static bool nb_would_block(void) { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void nb_close_sock(intptr_t s) { closesocket(NB_SOCK(s)); }
+static bool nb_set_nonblock(intptr_t s)
+{
+    u_long on = 1;
+    return ioctlsocket(NB_SOCK(s), FIONBIO, &on) == 0;
+}
+static int nb_poll(NbPollFd *pf, int n, int timeout_ms) { return WSAPoll(pf, (ULONG)n, timeout_ms); }
+
+// >0 发出的字节；0 发不动（缓冲满）；-1 出错
+static long nb_sendv(intptr_t s, NbIov *iov, int n)
+{
+    DWORD sent = 0;
+    if (WSASend(NB_SOCK(s), iov, (DWORD)n, &sent, 0, NULL, NULL) == 0)
+        return (long)sent;
+    return nb_would_block() ? 0 : -1;
+}
+#else
+typedef int nb_sock;
+typedef struct iovec NbIov;
+typedef struct pollfd NbPollFd;
+#define NB_IOV_SET(v, p, n) ((v).iov_base = (void *)(p), (v).iov_len = (n))
+#define NB_IOV_LEN(v) ((v).iov_len)
+#define NB_SOCK(x) ((nb_sock)(x))
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS：改用 SO_NOSIGPIPE（见 nb_tune_tcp）
+#endif
+
+static bool nb_would_block(void) { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void nb_close_sock(intptr_t s) { close(NB_SOCK(s)); }
+static bool nb_set_nonblock(intptr_t s)
+{
+    int fl = fcntl(NB_SOCK(s), F_GETFL, 0);
+    return fl >= 0 && fcntl(NB_SOCK(s), F_SETFL, fl | O_NONBLOCK) == 0;
+}
+static int nb_poll(NbPollFd *pf, int n, int timeout_ms) { return poll(pf, (nfds_t)n, timeout_ms); }
+
+static long nb_sendv(intptr_t s, NbIov *iov, int n)
+{
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = (size_t)n;
+    ssize_t w = sendmsg(NB_SOCK(s), &mh, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (w >= 0)
+        return (long)w;
+    return nb_would_block() ? 0 : -1;
+}
+#endif
+
+static void nb_tune_tcp(intptr_t s)
+{
+    int on = 1;
+    // 何时发由攒批决定，不要 Nagle 再攒一遍
+    setsockopt(NB_SOCK(s), IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+    setsockopt(NB_SOCK(s), SOL_SOCKET, SO_NOSIGPIPE, (const char *)&on, sizeof(on));
+#endif
+}
+
+static bool nb_parse_addr(const char *host, uint16_t port, struct sockaddr_in *sa)
+{
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    sa->sin_port = htons(port);
+    if (!host || !*host)
+    {
+        sa->sin_addr.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+    return inet_pton(AF_INET, host, &sa->sin_addr) == 1;
+}
+
+/* ---------------- 发送端管理（I/O 线程） ---------------- */
+
+static void nb_close_sink(NetBridge *nb, NbSink *s)
+{
+    if (s->fd == -1)
+        return;
+    NbChannel *c = &nb->ch[s->ch];
+    const RbbCursor *cu = &c->rb->cur[s->cur];
+    atomic_fetch_add(&nb->dropped, (unsigned long)cu->dropped + (unsigned long)s->skipped);
+    atomic_store(&s->live, false);
+    rbb_detach(c->rb, s->cur);
+    nb_close_sock(s->fd);
+    s->fd = -1;
+    if (!s->udp)
+        atomic_fetch_sub(&nb->clients, 1);
+}
+
+// 落后太多时先跳到只剩 1/4：发送途中被生产者越过的机会就很小了
+static void nb_catch_up(NbSink *s, RingBufBcast *rb)
+{
+    size_t cap = rbb_capacity(rb), lag = rbb_lag(rb, s->cur);
+    if (lag > cap / 4 * 3)
+        atomic_fetch_add(&s->skipped, (unsigned long)rbb_skip(rb, s->cur, lag - cap / 4));
+}
+
+static void nb_account(NetBridge *nb, NbSink *s, size_t data)
+{
+    atomic_fetch_add(&s->bytes, (unsigned long)data);
+    atomic_fetch_add(&s->sends, 1);
+    atomic_fetch_add(&nb->bytes, (unsigned long)data);
+    atomic_fetch_add(&nb->sends, 1);
+}
+
+// TCP：一次 sendmsg / WSASend 把环里的区间（telnet 时连同转义）整批发出
+static void nb_send_tcp(NetBridge *nb, NbSink *s)
+{
+    RingBufBcast *rb = nb->ch[s->ch].rb;
+    nb_catch_up(s, rb);
+    RbSpan sp[2];
+    if (rbb_peek_spans(rb, s->cur, sp) == 0 && !s->iac_owed)
+        return;
+
+    NbIov iov[NB_IOV];
+    bool esc[NB_IOV]; // 这一段是转义用的常量 0xFF（不算负载）
+    int n = 0;
+    size_t total = 0;
+    if (s->iac_owed)
+    {
+        NB_IOV_SET(iov[n], &k_iac, 1);
+        esc[n++] = true;
+        total += 1;
+    }
+    for (int k = 0; k < 2 && n < NB_IOV - 1; ++k)
+    {
+        const uint8_t *p = sp[k].ptr, *end = sp[k].ptr + sp[k].len;
+        while (p < end && n < NB_IOV - 1)
+        {
+            // telnet：每段到 0xFF（含）为止，后面跟一个常量 0xFF
+            const uint8_t *ff = s->telnet ? (const uint8_t *)memchr(p, TN_IAC, (size_t)(end - p)) : NULL;
+            const uint8_t *stop = ff ? ff + 1 : end;
+            NB_IOV_SET(iov[n], p, (size_t)(stop - p));
+            esc[n++] = false;
+            total += (size_t)(stop - p);
+            p = stop;
+            if (ff)
+            {
+                NB_IOV_SET(iov[n], &k_iac, 1);
+                esc[n++] = true;
+                total += 1;
+            }
+        }
+        if (p < end)
+            break; // 段数用完：剩下的下一轮发
+    }
+
+    long w = nb_sendv(s->fd, iov, n);
+    if (w < 0)
+    {
+        nb_close_sink(nb, s);
+        return;
+    }
+    if (w == 0)
+    {
+        s->want_out = true;
+        return;
+    }
+
+    // 把发出的字节数换算回环里的负载字节；转义的 0xFF 没发出去就欠着，下次先发
+    size_t left = (size_t)w, data = 0;
+    bool owed = false;
+    for (int i = 0; i < n; ++i)
+    {
+        size_t len = NB_IOV_LEN(iov[i]);
+        if (esc[i])
+        {
+            if (left == 0)
+            {
+                owed = true;
+                break;
+            }
+            --left;
+            continue;
+        }
+        size_t c = left < len ? left : len;
+        data += c;
+        left -= c;
+        if (c < len)
+            break;
+    }
+    s->iac_owed = owed;
+    if (data && !rbb_consume(rb, s->cur, data))
+        atomic_fetch_add(&s->overruns, 1);
+    nb_account(nb, s, data);
+    if ((size_t)w < total)
+        s->want_out = true; // 内核缓冲满：等 POLLOUT
+}
+
+static void nb_put_be64(uint8_t *p, uint64_t v)
+{
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = (uint8_t)v;
+}
+
+// UDP：把可读数据切成报文，每个报文 = 报头 + 指向环的一到两段
+static void nb_send_udp(NetBridge *nb, NbSink *s)
+{
+    RingBufBcast *rb = nb->ch[s->ch].rb;
+    nb_catch_up(s, rb);
+    RbSpan sp[2];
+    size_t avail = rbb_peek_spans(rb, s->cur, sp);
+    if (avail == 0)
+        return;
+    uint64_t pos = rb->cur[s->cur].seen; // peek 的起点就是第一个字节的流位置
+
+    uint8_t hdr[NB_UDP_BATCH][NB_UDP_HDR];
+    NbIov iov[NB_UDP_BATCH][3];
+    int niov[NB_UDP_BATCH];
+    size_t plen[NB_UDP_BATCH];
+    int cnt = 0, k = 0;
+    size_t at = 0, off = 0;
+    while (cnt < NB_UDP_BATCH && off < avail)
+    {
+        size_t want = avail - off < nb->cfg.udp_payload ? avail - off : nb->cfg.udp_payload;
+        nb_put_be64(hdr[cnt], pos + off);
+        NB_IOV_SET(iov[cnt][0], hdr[cnt], NB_UDP_HDR);
+        niov[cnt] = 1;
+        plen[cnt] = want;
+        while (want)
+        {
+            if (at == sp[k].len)
+            {
+                ++k;
+                at = 0;
+            }
+            size_t c = sp[k].len - at < want ? sp[k].len - at : want;
+            NB_IOV_SET(iov[cnt][niov[cnt]], sp[k].ptr + at, c);
+            ++niov[cnt];
+            at += c;
+            want -= c;
+        }
+        off += plen[cnt];
+        ++cnt;
+    }
+
+    int sent = 0;
+#if defined(__linux__)
+    struct mmsghdr mm[NB_UDP_BATCH];
+    memset(mm, 0, sizeof(mm));
+    for (int i = 0; i < cnt; ++i)
+    {
+        mm[i].msg_hdr.msg_iov = iov[i];
+        mm[i].msg_hdr.msg_iovlen = (size_t)niov[i];
+    }
+    int r = sendmmsg(NB_SOCK(s->fd), mm, (unsigned)cnt, MSG_DONTWAIT);
+    if (r > 0)
+        sent = r;
+    else if (r < 0 && !nb_would_block())
+        sent = -1;
+    if (sent > 0)
+        atomic_fetch_add(&s->sends, 1), atomic_fetch_add(&nb->sends, 1);
+#else
+    for (; sent < cnt; ++sent)
+    {
+        long w = nb_sendv(s->fd, iov[sent], niov[sent]);
+        if (w <= 0)
+        {
+            if (w < 0 && sent == 0)
+                sent = -1;
+            break;
+        }
+        atomic_fetch_add(&s->sends, 1);
+        atomic_fetch_add(&nb->sends, 1);
+    }
+#endif
+    if (sent < 0)
+    {
+        // 组播发不出去（如网卡没有路由）：不断开，丢掉这批继续
+        rbb_skip(rb, s->cur, avail);
+        atomic_fetch_add(&s->skipped, (unsigned long)avail);
+        return;
+    }
+    size_t data = 0;
+    for (int i = 0; i < sent; ++i)
+        data += plen[i];
+    if (sent < cnt)
+        s->want_out = true;
+    if (data && !rbb_consume(rb, s->cur, data))
+        atomic_fetch_add(&s->overruns, 1);
+    atomic_fetch_add(&s->bytes, (unsigned long)data);
+    atomic_fetch_add(&nb->bytes, (unsigned long)data);
+    atomic_fetch_add(&nb->datagrams, (unsigned long)sent);
+}
+
+// 所有到期的发送端发一轮；返回离下一个攒批到期还有多少 ms，没有待发的返回 -1
+static int nb_flush_all(NetBridge *nb, long long now)
+{
+    int next = -1;
+    for (int i = 0; i < NB_SINKS; ++i)
+    {
+        NbSink *s = &nb->sinks[i];
+        if (s->fd == -1 || s->suspended || s->want_out)
+            continue;
+        RingBufBcast *rb = nb->ch[s->ch].rb;
+        size_t lag = rbb_lag(rb, s->cur);
+        if (lag == 0 && !s->iac_owed)
+        {
+            s->since_ms = 0;
+            continue;
+        }
+        if (!s->since_ms)
+            s->since_ms = now;
+        size_t batch = s->udp ? nb->cfg.udp_payload : nb->cfg.batch_bytes;
+        long long due = s->since_ms + nb->cfg.flush_ms;
+        if (lag < batch && now < due)
+        {
+            int left = (int)(due - now);
+            if (next < 0 || left < next)
+                next = left;
+            continue;
+        }
+        if (s->udp)
+            nb_send_udp(nb, s);
+        else
+            nb_send_tcp(nb, s);
+        s->since_ms = (s->fd != -1 && rbb_lag(rb, s->cur)) ? now : 0;
+        if (s->since_ms && !s->want_out)
+            next = 0; // 一轮没发完（段数上限）：马上再来
+    }
+    return next;
+}
+
+/* ---------------- Telnet / RFC 2217（I/O 线程） ---------------- */
+
+// 直接发一条控制消息（很短）；发不全就断开，免得插在数据流中间
+static void nb_tn_send(NetBridge *nb, NbSink *s, const uint8_t *msg, size_t n)
+{
+    uint8_t buf[64];
+    size_t k = 0;
+    if (s->iac_owed)
+    {
+        buf[k++] = TN_IAC; // 先把欠着的转义补上
+        s->iac_owed = false;
+    }
+    memcpy(buf + k, msg, n);
+    NbIov v;
+    NB_IOV_SET(v, buf, k + n);
+    if (nb_sendv(s->fd, &v, 1) != (long)(k + n))
+        nb_close_sink(nb, s);
+}
+
+static void nb_tn_option(NetBridge *nb, NbSink *s, uint8_t verb, uint8_t opt)
+{
+    // 只答复我们不支持的（拒绝），已同意的不再回应，避免协商来回打转
+    if (verb == TN_DO && opt != TN_BINARY && opt != TN_SGA && opt != TN_COMPORT)
+    {
+        uint8_t m[3] = {TN_IAC, TN_WONT, opt};
+        nb_tn_send(nb, s, m, sizeof(m));
+    }
+    else if (verb == TN_WILL && opt != TN_BINARY)
+    {
+        uint8_t m[3] = {TN_IAC, TN_DONT, opt};
+        nb_tn_send(nb, s, m, sizeof(m));
+    }
+}
+
+// 回报 IAC SB COM-PORT-OPTION <cmd+100> <val...> IAC SE（值里的 0xFF 转义）
+static void nb_cp_reply(NetBridge *nb, NbSink *s, uint8_t cmd, const uint8_t *val, size_t n)
+{
+    uint8_t m[64];
+    size_t k = 0;
+    m[k++] = TN_IAC;
+    m[k++] = TN_SB;
+    m[k++] = TN_COMPORT;
+    m[k++] = (uint8_t)(cmd + CP_SERVER_OFFSET);
+    for (size_t i = 0; i < n && k + 4 < sizeof(m); ++i)
+    {
+        m[k++] = val[i];
+        if (val[i] == TN_IAC)
+            m[k++] = TN_IAC;
+    }
+    m[k++] = TN_IAC;
+    m[k++] = TN_SE;
+    nb_tn_send(nb, s, m, k);
+}
+
+// 客户端的 COM-PORT 命令：只读旁路，设置类命令一律回报端口当前的值
+static void nb_comport(NetBridge *nb, NbSink *s)
+{
+    if (s->sb_len == 0)
+        return;
+    const SerialPort *sp = nb->ch[s->ch].sp;
+    uint8_t cmd = s->sb[0], v = s->sb_len > 1 ? s->sb[1] : 0;
+    switch (cmd)
+    {
+    case CP_SIGNATURE:
+        nb_cp_reply(nb, s, cmd, (const uint8_t *)k_signature, sizeof(k_signature) - 1);
+        break;
+    case CP_SET_BAUDRATE:
+    {
+        uint32_t baud = sp ? (uint32_t)sp->baud : 0;
+        uint8_t b[4] = {(uint8_t)(baud >> 24), (uint8_t)(baud >> 16), (uint8_t)(baud >> 8), (uint8_t)baud};
+        nb_cp_reply(nb, s, cmd, b, sizeof(b));
+        break;
+    }
+    case CP_SET_DATASIZE:
+    {
+        uint8_t b = 8;
+        nb_cp_reply(nb, s, cmd, &b, 1);
+        break;
+    }
+    case CP_SET_PARITY:
+    case CP_SET_STOPSIZE:
+    {
+        uint8_t b = 1; // NONE / 1 位停止位（本终端总是 8N1）
+        nb_cp_reply(nb, s, cmd, &b, 1);
+        break;
+    }
+    case CP_SET_CONTROL:
+    {
+        // 0~3 是流控查询/设置：回报当前流控（1 无，3 硬件）；其余（BREAK/DTR/RTS）原样回报
+        uint8_t b = v <= 3 ? (uint8_t)(sp && atomic_load(&sp->rtscts) ? 3 : 1) : v;
+        nb_cp_reply(nb, s, cmd, &b, 1);
+        break;
+    }
+    case CP_FLOW_SUSPEND:
+        s->suspended = true;
+        break;
+    case CP_FLOW_RESUME:
+        s->suspended = false;
+        break;
+    case CP_SET_LINESTATE_MASK:
+    case CP_SET_MODEMSTATE_MASK:
+    case CP_PURGE_DATA:
+        nb_cp_reply(nb, s, cmd, &v, 1);
+        break;
+    default:
+        break;
+    }
+}
+
+// 收方向：客户端的数据一律丢弃，只解析 IAC 命令
+enum
+{
+    TNS_DATA = 0,
+    TNS_IAC,
+    TNS_OPT,
+    TNS_SB_OPT,
+    TNS_SB,
+    TNS_SB_IAC
+};
+
+static void nb_telnet_input(NetBridge *nb, NbSink *s, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n && s->fd != -1; ++i)
+    {
+        uint8_t b = p[i];
+        switch (s->tn_state)
+        {
+        case TNS_DATA:
+            if (b == TN_IAC)
+                s->tn_state = TNS_IAC;
+            break;
+        case TNS_IAC:
+            if (b >= TN_WILL)
+            {
+                s->tn_opt = b;
+                s->tn_state = TNS_OPT;
+            }
+            else if (b == TN_SB)
+                s->tn_state = TNS_SB_OPT;
+            else
+                s->tn_state = TNS_DATA; // IAC IAC（数据）或其它单字节命令
+            break;
+        case TNS_OPT:
+            nb_tn_option(nb, s, s->tn_opt, b);
+            s->tn_state = TNS_DATA;
+            break;
+        case TNS_SB_OPT:
+            s->tn_opt = b;
+            s->sb_len = 0;
+            s->tn_state = TNS_SB;
+            break;
+        case TNS_SB:
+            if (b == TN_IAC)
+                s->tn_state = TNS_SB_IAC;
+            else if (s->sb_len < sizeof(s->sb))
+                s->sb[s->sb_len++] = b;
+            break;
+        case TNS_SB_IAC:
+            if (b == TN_SE)
+            {
+                if (s->tn_opt == TN_COMPORT)
+                    nb_comport(nb, s);
+                s->tn_state = TNS_DATA;
+            }
+            else
+            {
+                if (b == TN_IAC && s->sb_len < sizeof(s->sb))
+                    s->sb[s->sb_len++] = b;
+                s->tn_state = b == TN_IAC ? TNS_SB : TNS_DATA;
+            }
+            break;
+        }
+    }
+}
+
+static void nb_read_client(NetBridge *nb, NbSink *s)
+{
+    uint8_t buf[NB_RECV_BYTES];
+    long r = (long)recv(NB_SOCK(s->fd), (char *)buf, sizeof(buf), 0);
+    if (r == 0 || (r < 0 && !nb_would_block()))
+    {
+        nb_close_sink(nb, s); // 对端关闭 / 出错
+        return;
+    }
+    if (r > 0 && s->telnet)
+        nb_telnet_input(nb, s, buf, (size_t)r);
+}
+
+static void nb_accept(NetBridge *nb, int ci)
+{
+    NbChannel *c = &nb->ch[ci];
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    intptr_t fd = (intptr_t)accept(NB_SOCK(c->lfd), (struct sockaddr *)&sa, &len);
+    if (fd == -1)
+        return;
+    NbSink *s = NULL;
+    for (int i = 0; i < NB_MAX_CLIENTS && !s; ++i)
+        if (nb->sinks[i].fd == -1)
+            s = &nb->sinks[i];
+    int cur = s ? rbb_attach(c->rb, RBB_DROP, "net") : -1;
+    if (cur < 0 || !nb_set_nonblock(fd))
+    {
+        if (cur >= 0)
+            rbb_detach(c->rb, cur);
+        nb_close_sock(fd);
+        atomic_fetch_add(&nb->rejected, 1);
+        return;
+    }
+    nb_tune_tcp(fd);
+
+    memset(s->sb, 0, sizeof(s->sb));
+    s->fd = fd;
+    s->ch = ci;
+    s->cur = cur;
+    s->udp = false;
+    s->telnet = c->mode == NB_TELNET;
+    s->want_out = s->iac_owed = s->suspended = false;
+    s->since_ms = 0;
+    s->tn_state = TNS_DATA;
+    s->sb_len = 0;
+    char ip[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &sa.sin_addr, ip, sizeof(ip));
+    snprintf(s->peer, sizeof(s->peer), "%s:%u", ip, (unsigned)ntohs(sa.sin_port));
+    atomic_store(&s->bytes, 0);
+    atomic_store(&s->sends, 0);
+    atomic_store(&s->skipped, 0);
+    atomic_store(&s->overruns, 0);
+    atomic_store(&s->live, true);
+    atomic_fetch_add(&nb->accepted, 1);
+    atomic_fetch_add(&nb->clients, 1);
+
+    if (s->telnet)
+    {
+        // 服务器一侧：二进制、抑制 GA、COM-PORT-OPTION；也请客户端二进制发送
+        static const uint8_t hello[] = {TN_IAC, TN_WILL, TN_BINARY, TN_IAC, TN_DO, TN_BINARY,
+                                        TN_IAC, TN_WILL, TN_SGA,    TN_IAC, TN_WILL, TN_COMPORT};
+        nb_tn_send(nb, s, hello, sizeof(hello));
+    }
+}
+
+/* ---------------- I/O 线程 ---------------- */
+
+// 没有待发数据：睡在第一个通道环的事件上（通道共享 notify 时任何一个有数据都会叫醒），最多 NB_IDLE_MS
+static void nb_idle(NetBridge *nb)
+{
+    RbEvent *ev = nb->ch[0].rb->notify;
+    unsigned key = rb_ev_prepare(ev);
+    for (int i = 0; i < NB_SINKS; ++i)
+    {
+        const NbSink *s = &nb->sinks[i];
+        if (s->fd != -1 && !s->suspended && rbb_lag(nb->ch[s->ch].rb, s->cur))
+        {
+            rb_ev_cancel(ev);
+            return;
+        }
+    }
+    rb_ev_wait(ev, key, NB_IDLE_MS);
+}
+
+static void nb_run(NetBridge *nb)
+{
+    NbPollFd pf[NB_POLL_MAX];
+    int who[NB_POLL_MAX]; // >= 0：发送端下标；< 0：-(通道 + 1) 的监听套接字
+    while (atomic_load(&nb->run))
+    {
+        int wait = nb_flush_all(nb, rb_ev_now_ms());
+
+        int n = 0;
+        bool blocked = false;
+        for (int c = 0; c < nb->nch; ++c)
+        {
+            if (nb->ch[c].lfd == -1)
+                continue;
+            pf[n].fd = NB_SOCK(nb->ch[c].lfd);
+            pf[n].events = POLLIN;
+            pf[n].revents = 0;
+            who[n++] = -(c + 1);
+        }
+        for (int i = 0; i < NB_SINKS; ++i)
+        {
+            NbSink *s = &nb->sinks[i];
+            if (s->fd == -1)
+                continue;
+            blocked |= s->want_out;
+            short ev = (short)((s->udp ? 0 : POLLIN) | (s->want_out ? POLLOUT : 0));
+            if (!ev)
+                continue;
+            pf[n].fd = NB_SOCK(s->fd);
+            pf[n].events = ev;
+            pf[n].revents = 0;
+            who[n++] = i;
+        }
+
+        int r;
+        if (wait < 0 && !blocked)
+        {
+            // 空闲：先不等地看一眼套接字，没事就睡到环上有新数据
+            r = n ? nb_poll(pf, n, 0) : 0;
+            if (r == 0)
+            {
+                nb_idle(nb);
+                continue;
+            }
+        }
+        else
+            r = n ? nb_poll(pf, n, wait < 0 ? NB_IDLE_MS : wait) : 0;
+        if (r <= 0)
+            continue;
+
+        for (int k = 0; k < n; ++k)
+        {
+            if (!pf[k].revents)
+                continue;
+            if (who[k] < 0)
+            {
+                nb_accept(nb, -who[k] - 1);
+                continue;
+            }
+            NbSink *s = &nb->sinks[who[k]];
+            if (pf[k].revents & POLLOUT)
+                s->want_out = false;
+            if (pf[k].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                if (s->udp)
+                    s->want_out = false;
+                else
+                    nb_read_client(nb, s);
+            }
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI nb_thread(LPVOID arg)
+{
+    nb_run((NetBridge *)arg);
+    return 0;
+}
+#else
+static void *nb_thread(void *arg)
+{
+    nb_run((NetBridge *)arg);
+    return NULL;
+}
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+void nb_default_config(NbConfig *cfg)
+{
+    if (!cfg)
+        return;
+    cfg->batch_bytes = 1448;
+    cfg->flush_ms = 2;
+    cfg->udp_payload = 1400;
+    cfg->udp_ttl = 1;
+}
+
+void nb_init(NetBridge *nb, const NbConfig *cfg)
+{
+    if (!nb)
+        return;
+    memset(nb, 0, sizeof(*nb));
+    if (cfg)
+        nb->cfg = *cfg;
+    else
+        nb_default_config(&nb->cfg);
+    if (!nb->cfg.batch_bytes || !nb->cfg.udp_payload)
+        nb_default_config(&nb->cfg);
+    for (int i = 0; i < NB_SINKS; ++i)
+        nb->sinks[i].fd = -1;
+#ifdef _WIN32
+    WSADATA wd;
+    WSAStartup(MAKEWORD(2, 2), &wd);
+#endif
+}
+
+int nb_add_channel(NetBridge *nb, RingBufBcast *rb, const SerialPort *sp, const char *name)
+{
+    if (!nb || !rb || !rb->data || nb->started || nb->nch == NB_MAX_CHANNELS)
+        return -1;
+    NbChannel *c = &nb->ch[nb->nch];
+    c->rb = rb;
+    c->sp = sp;
+    snprintf(c->name, sizeof(c->name), "%s", name ? name : "?");
+    c->lfd = -1;
+    c->udp = -1;
+    return nb->nch++;
+}
+
+bool nb_listen_tcp(NetBridge *nb, int ch, const char *bind_addr, uint16_t port, NbMode mode)
+{
+    if (!nb || ch < 0 || ch >= nb->nch || nb->started || nb->ch[ch].lfd != -1)
+        return false;
+    struct sockaddr_in sa;
+    if (!nb_parse_addr(bind_addr, port, &sa))
+    {
+        snprintf(nb->err, sizeof(nb->err), "地址无效：%s", bind_addr);
+        return false;
+    }
+    intptr_t fd = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd == -1)
+    {
+        snprintf(nb->err, sizeof(nb->err), "socket 失败");
+        return false;
+    }
+    int on = 1;
+    setsockopt(NB_SOCK(fd), SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+    if (bind(NB_SOCK(fd), (struct sockaddr *)&sa, sizeof(sa)) != 0 || listen(NB_SOCK(fd), 8) != 0 ||
+        !nb_set_nonblock(fd))
+    {
+        snprintf(nb->err, sizeof(nb->err), "无法监听 TCP 端口 %u", (unsigned)port);
+        nb_close_sock(fd);
+        return false;
+    }
+    nb->ch[ch].lfd = fd;
+    nb->ch[ch].tcp_port = port;
+    nb->ch[ch].mode = mode;
+    return true;
+}
+
+bool nb_multicast(NetBridge *nb, int ch, const char *group, uint16_t port)
+{
+    if (!nb || ch < 0 || ch >= nb->nch || nb->started || nb->ch[ch].udp != -1)
+        return false;
+    struct sockaddr_in sa;
+    if (!group || !*group || !nb_parse_addr(group, port, &sa))
+    {
+        snprintf(nb->err, sizeof(nb->err), "组播地址无效：%s", group ? group : "");
+        return false;
+    }
+    intptr_t fd = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd == -1)
+    {
+        snprintf(nb->err, sizeof(nb->err), "socket 失败");
+        return false;
+    }
+    int ttl = (int)nb->cfg.udp_ttl;
+    setsockopt(NB_SOCK(fd), IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
+    // connect 之后每次发送不用再带目的地址（sendmsg / sendmmsg / WSASend 都一样）
+    if (connect(NB_SOCK(fd), (struct sockaddr *)&sa, sizeof(sa)) != 0 || !nb_set_nonblock(fd))
+    {
+        snprintf(nb->err, sizeof(nb->err), "无法发往 %s:%u", group, (unsigned)port);
+        nb_close_sock(fd);
+        return false;
+    }
+    NbChannel *c = &nb->ch[ch];
+    int idx = NB_MAX_CLIENTS + ch;
+    NbSink *s = &nb->sinks[idx];
+    int cur = rbb_attach(c->rb, RBB_DROP, "mcast");
+    if (cur < 0)
+    {
+        snprintf(nb->err, sizeof(nb->err), "环上的读者槽位已用完");
+        nb_close_sock(fd);
+        return false;
+    }
+    s->fd = fd;
+    s->ch = ch;
+    s->cur = cur;
+    s->udp = true;
+    s->telnet = false;
+    snprintf(s->peer, sizeof(s->peer), "%s:%u", group, (unsigned)port);
+    atomic_store(&s->live, true);
+    c->udp = idx;
+    return true;
+}
+
+bool nb_start(NetBridge *nb)
+{
+    if (!nb || nb->started || nb->nch == 0)
+        return false;
+    atomic_store(&nb->run, true);
+#ifdef _WIN32
+    nb->th = CreateThread(NULL, 0, nb_thread, nb, 0, NULL);
+    nb->started = (nb->th != NULL);
+#else
+    nb->started = (pthread_create(&nb->th, NULL, nb_thread, nb) == 0);
+#endif
+    if (!nb->started)
+        snprintf(nb->err, sizeof(nb->err), "无法创建线程");
+    return nb->started;
+}
+
+void nb_stop(NetBridge *nb)
+{
+    if (!nb)
+        return;
+    if (nb->started)
+    {
+        atomic_store(&nb->run, false);
+        rb_ev_wake(nb->ch[0].rb->notify);
+#ifdef _WIN32
+        WaitForSingleObject(nb->th, INFINITE);
+        CloseHandle(nb->th);
+        nb->th = NULL;
+#else
+        pthread_join(nb->th, NULL);
+#endif
+        nb->started = false;
+    }
+    for (int i = 0; i < NB_SINKS; ++i)
+        nb_close_sink(nb, &nb->sinks[i]);
+    for (int c = 0; c < nb->nch; ++c)
+    {
+        if (nb->ch[c].lfd != -1)
+            nb_close_sock(nb->ch[c].lfd);
+        nb->ch[c].lfd = -1;
+        nb->ch[c].udp = -1;
+    }
+    nb->nch = 0;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool nb_client_info(const NetBridge *nb, int i, NbClientInfo *info)
+{
+    if (!nb || i < 0 || i >= NB_SINKS || !info)
+        return false;
+    const NbSink *s = &nb->sinks[i];
+    if (!atomic_load(&s->live))
+        return false;
+    const NbChannel *c = &nb->ch[s->ch];
+    const RbbCursor *cu = &c->rb->cur[s->cur];
+    memcpy(info->peer, s->peer, sizeof(info->peer));
+    info->channel = c->name;
+    info->udp = s->udp;
+    info->telnet = s->telnet;
+    info->suspended = s->suspended;
+    info->lag = rbb_lag(c->rb, s->cur);
+    info->lag_max = cu->lag_max;
+    info->bytes = s->bytes;
+    info->sends = s->sends;
+    info->dropped = (unsigned long)cu->dropped + (unsigned long)s->skipped;
+    info->overruns = s->overruns;
+    return true;
+}
@@ -0,0 +1,168 @@
+#ifndef NET_BRIDGE_H
+#define NET_BRIDGE_H
+
+// 网络桥：把一个或多个接收广播环（RingBufBcast）的字节流转发给远程客户端，远程看实验台设备
+//
+// - 每个通道 = 一个环 + 可选的 TCP 监听端口 + 可选的 UDP 组播目的地址
+// - 每个 TCP 客户端 / 每个组播目的地各挂一个 RBB_DROP 读游标：慢客户端只丢自己的数据，
+//   不拖慢串口接收，也不拖慢别的客户端；环里的数据只有一份，不为每个客户端复制
+// - 零拷贝：sendmsg / WSASend 的 iovec 直接指向环里的 peek 区间（最多两段），内核一次拷走
+// - 攒批：不足 batch_bytes 时最多攒 flush_ms（TCP 关掉 Nagle，由这里决定何时发）
+// - 所有套接字非阻塞，一个 I/O 线程服务全部客户端；发不动（EAGAIN）的客户端等 POLLOUT，其余照常发
+// - 客户端落后超过环容量的 3/4 时先跳到只剩 1/4（计入 skipped），避免发送途中被生产者越过
+//
+// TCP 模式：
+// - NB_RAW：原样字节流，客户端发来的数据丢弃（只读旁路）
+// - NB_TELNET：RFC 2217 风格（Telnet COM-PORT-OPTION）：数据里的 0xFF 转义成 IAC IAC（用指向常量 0xFF 的
+//   iovec 插进去，仍不拷贝）；客户端的 SET-BAUDRATE / DATASIZE / PARITY / STOPSIZE / CONTROL 一律回报端口
+//   当前设置（只读，不改端口），FLOWCONTROL-SUSPEND / RESUME 暂停 / 恢复向它发送
+//
+// UDP 组播：每个报文 = 8 字节大端流位置（第一个负载字节在整个流里的偏移）+ 最多 udp_payload 字节负载；
+// 接收端看位置是否连续就知道丢没丢、丢了多少。Linux 上一次 sendmmsg 发出多个报文
+//
+// 线程约定：nb_init / nb_add_channel / nb_listen_tcp / nb_multicast / nb_start / nb_stop 在同一线程（命令线程）调用；
+// 通道在 nb_start 之前配好，运行中不增删；统计与 nb_client_info 任意线程可读（近似值）
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../ringbuf/ringbuf_bcast.h"
+#include "serial_port.h"
+
+#define NB_MAX_CHANNELS 4
+#define NB_MAX_CLIENTS 12 // 所有通道合计（每个还要占环上一个读者槽位）
+#define NB_PEER_MAX 48
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        NB_RAW = 0,
+        NB_TELNET = 1 // RFC 2217 风格
+    } NbMode;
+
+    typedef struct
+    {
+        unsigned batch_bytes; // 攒够这么多再发（默认 1448，约一个 TCP 段）
+        unsigned flush_ms;    // 不够一批时最多攒多久（默认 2ms）
+        unsigned udp_payload; // 组播报文最大负载（默认 1400，不超过常见 MTU）
+        unsigned udp_ttl;     // 组播 TTL（默认 1：不出本网段）
+    } NbConfig;
+
+    // 一个发送端：TCP 客户端或组播目的地
+    typedef struct
+    {
+        intptr_t fd;     // 平台套接字（Windows SOCKET / POSIX fd），-1 表示空
+        int ch;          // 通道下标
+        int cur;         // 在通道环上的读游标
+        bool udp;
+        bool telnet;
+        bool want_out;   // 上次发送 EAGAIN：等 POLLOUT 再发
+        bool iac_owed;   // telnet：数据里的 0xFF 已发出，转义用的第二个 0xFF 还欠着
+        bool suspended;  // telnet：客户端发了 FLOWCONTROL-SUSPEND
+        long long since_ms; // 有未发数据的起始时刻（0：没有）
+        uint8_t tn_state;    // telnet 收方向解析状态
+        uint8_t tn_opt;
+        uint8_t sb[16];      // 子协商内容（COM-PORT-OPTION 之后的命令与参数）
+        uint8_t sb_len;
+        char peer[NB_PEER_MAX];
+
+        atomic_bool live;          // 命令线程据此决定显示哪些（I/O 线程写）
+        atomic_ulong bytes;        // 发出的负载字节（不含 telnet 转义与 UDP 报头）
+        atomic_ulong sends;        // 发送系统调用次数
+        atomic_ulong skipped;      // 落后太多被主动跳过的字节
+        atomic_ulong overruns;     // 发送途中被生产者越过（那一批可能混入新数据）
+    } NbSink;
+
+    typedef struct
+    {
+        RingBufBcast *rb;
+        const SerialPort *sp; // telnet 回报用（可为 NULL：回报 0 / 默认值）
+        char name[32];
+        intptr_t lfd;         // TCP 监听套接字，-1 表示不开
+        uint16_t tcp_port;
+        NbMode mode;
+        int udp;              // 组播发送端在 sinks 里的下标，-1 表示不开
+    } NbChannel;
+
+    typedef struct
+    {
+        NbConfig cfg;
+        NbChannel ch[NB_MAX_CHANNELS];
+        int nch;
+        NbSink sinks[NB_MAX_CLIENTS + NB_MAX_CHANNELS]; // 前 NB_MAX_CLIENTS 个给 TCP 客户端，其后给组播
+        atomic_bool run;
+#ifdef _WIN32
+        HANDLE th;
+#else
+        pthread_t th;
+#endif
+        bool started;
+        char err[128]; // 最近一次失败的原因（nb_* 返回 false 时）
+
+        // 统计：I/O 线程写，任意线程原子读
+        atomic_ulong accepted;  // 接受过的 TCP 连接
+        atomic_ulong rejected;  // 客户端满或读者槽位用完被拒
+        atomic_ulong clients;   // 当前 TCP 客户端数
+        atomic_ulong bytes;     // 所有发送端发出的负载字节
+        atomic_ulong sends;     // 发送系统调用次数（攒批效果：bytes / sends）
+        atomic_ulong datagrams; // 组播报文数
+        atomic_ulong dropped;   // 已断开的客户端被越过 / 跳过的字节（在线的见 nb_client_info）
+    } NetBridge;
+
+    // 一个发送端的快照（nb_client_info 填写）
+    typedef struct
+    {
+        char peer[NB_PEER_MAX];
+        const char *channel;
+        bool udp;
+        bool telnet;
+        bool suspended;
+        size_t lag;           // 还没发给它的字节
+        size_t lag_max;
+        unsigned long bytes;
+        unsigned long sends;
+        unsigned long dropped; // 被生产者越过 + 主动跳过
+        unsigned long overruns;
+    } NbClientInfo;
+
+    // 默认配置
+    void nb_default_config(NbConfig *cfg);
+
+    // 清零并设配置（cfg 为 NULL 用默认配置）；Windows 上初始化 Winsock
+    void nb_init(NetBridge *nb, const NbConfig *cfg);
+
+    // 加一个通道（环必须已 rbb_init），返回通道下标，满了返回 -1
+    int nb_add_channel(NetBridge *nb, RingBufBcast *rb, const SerialPort *sp, const char *name);
+
+    // 通道 ch 在 bind_addr:port（bind_addr 为 NULL 或 "" 表示所有地址）上监听 TCP
+    bool nb_listen_tcp(NetBridge *nb, int ch, const char *bind_addr, uint16_t port, NbMode mode);
+
+    // 通道 ch 发往组播（或单播）地址 group:port；从调用这一刻的数据开始发
+    bool nb_multicast(NetBridge *nb, int ch, const char *group, uint16_t port);
+
+    // 启动 I/O 线程
+    bool nb_start(NetBridge *nb);
+
+    // 停线程，断开所有客户端，关监听，摘掉所有读游标（nb_init 之后未 start 也可调用）
+    void nb_stop(NetBridge *nb);
+
+    // 第 i 个发送端是否在线；在线时填 info（i < NB_MAX_CLIENTS + NB_MAX_CHANNELS）
+    bool nb_client_info(const NetBridge *nb, int i, NbClientInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_BRIDGE_H
@@ -0,0 +1,371 @@
+#include "proto.h"
+#include "crc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char *const k_chk_names[] = {"none", "sum8", "xor8", "crc16", "crc32", "crc32c"};
+static const char *const k_cover_names[] = {"lenbody", "body", "all"};
+static const char *const k_framing_names[] = {"len", "cobs", "slip"};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+void proto_default(ProtoDesc *d)
+{
+    if (!d)
+        return;
+    memset(d, 0, sizeof(*d));
+    strcpy(d->name, "aa55");
+    d->framing = PF_LENGTH;
+    d->hdr[0] = 0xAA;
+    d->hdr[1] = 0x55;
+    d->hdr_len = 2;
+    d->len_size = 1;
+    d->max_body = 255;
+    d->chk = PC_SUM8;
+    d->cover = PCOV_LEN_BODY;
+}
+
+size_t proto_chk_size(ProtoChk c)
+{
+    switch (c)
+    {
+    case PC_SUM8:
+    case PC_XOR8:
+        return 1;
+    case PC_CRC16_CCITT:
+        return 2;
+    case PC_CRC32:
+    case PC_CRC32C:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool proto_valid(const ProtoDesc *d)
+{
+    if (!d || (unsigned)d->chk >= COUNT(k_chk_names) || (unsigned)d->cover >= COUNT(k_cover_names))
+        return false;
+    size_t ck = proto_chk_size(d->chk);
+    switch (d->framing)
+    {
+    case PF_LENGTH:
+        if (d->hdr_len < 1 || d->hdr_len > PROTO_HDR_MAX)
+            return false;
+        if (d->len_size != 1 && d->len_size != 2 && d->len_size != 4)
+            return false;
+        return (size_t)d->hdr_len + d->len_off + d->len_size + d->max_body + ck <= PROTO_MAX_FRAME;
+    case PF_COBS:
+    case PF_SLIP:
+    {
+        // 解析器缓冲放的是解码前的数据：COBS 每 254 字节多 1 个开销字节
+        size_t raw = d->max_body + ck;
+        return raw + raw / 254 + 2 <= PROTO_MAX_FRAME;
+    }
+    default:
+        return false;
+    }
+}
+
+/* ---------------- 校验与编码 ---------------- */
+
+uint32_t proto_checksum(ProtoChk c, const uint8_t *p, size_t n)
+{
+    uint32_t v = 0;
+    switch (c)
+    {
+    case PC_SUM8:
+        for (size_t i = 0; i < n; ++i)
+            v += p[i];
+        return v & 0xFFu;
+    case PC_XOR8:
+        for (size_t i = 0; i < n; ++i)
+            v ^= p[i];
+        return v;
+    case PC_CRC16_CCITT:
+        return crc16_ccitt(p, n);
+    case PC_CRC32:
+        return crc32_ieee(p, n);
+    case PC_CRC32C:
+        return crc32c(p, n);
+    default:
+        return 0;
+    }
+}
+
+// 写 w 字节整数（长度字段 / 校验值）
+static size_t put_uint(uint8_t *o, uint32_t v, size_t w, bool be)
+{
+    for (size_t i = 0; i < w; ++i)
+        o[i] = (uint8_t)(v >> (8 * (be ? w - 1 - i : i)));
+    return w;
+}
+
+static size_t encode_len(const ProtoDesc *d, const uint8_t *body, size_t n, uint8_t *out, size_t cap)
+{
+    size_t ck = proto_chk_size(d->chk);
+    size_t pre = (size_t)d->hdr_len + d->len_off;
+    long field = (long)n - d->len_adj;
+    if (field < 0 || (d->len_size < 4 && ((unsigned long)field >> (8 * d->len_size))))
+        return 0; // 长度字段放不下
+    if (pre + d->len_size + n + ck > cap)
+        return 0;
+    memcpy(out, d->hdr, d->hdr_len);
+    memset(out + d->hdr_len, 0, d->len_off);
+    size_t k = pre + put_uint(out + pre, (uint32_t)field, d->len_size, d->len_be);
+    memcpy(out + k, body, n);
+    k += n;
+    size_t from = (d->cover == PCOV_ALL) ? 0 : (d->cover == PCOV_BODY) ? k - n : d->hdr_len;
+    return k + put_uint(out + k, proto_checksum(d->chk, out + from, k - from), ck, d->chk_be);
+}
+
+static size_t encode_cobs(const uint8_t *in, size_t n, uint8_t *out, size_t cap)
+{
+    if (n + n / 254 + 2 > cap)
+        return 0;
+    size_t w = 1, code_at = 0;
+    uint8_t code = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (in[i] == 0)
+        {
+            out[code_at] = code;
+            code_at = w++;
+            code = 1;
+            continue;
+        }
+        out[w++] = in[i];
+        if (++code == 0xFF)
+        {
+            out[code_at] = code;
+            code_at = w++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    out[w++] = 0x00;
+    return w;
+}
+
+static size_t encode_slip(const uint8_t *in, size_t n, uint8_t *out, size_t cap)
+{
+    if (2 * n + 2 > cap)
+        return 0;
+    size_t w = 0;
+    out[w++] = 0xC0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (in[i] == 0xC0 || in[i] == 0xDB)
+        {
+            out[w++] = 0xDB;
+            out[w++] = (in[i] == 0xC0) ? 0xDC : 0xDD;
+        }
+        else
+            out[w++] = in[i];
+    }
+    out[w++] = 0xC0;
+    return w;
+}
+
+size_t proto_encode(const ProtoDesc *d, const uint8_t *body, size_t n, uint8_t *out, size_t cap)
+{
+    if (!d || (!body && n) || !out || n > d->max_body || !proto_valid(d))
+        return 0;
+    if (d->framing == PF_LENGTH)
+        return encode_len(d, body, n, out, cap);
+    // COBS / SLIP：先拼上校验再整体编码
+    uint8_t raw[PROTO_MAX_FRAME];
+    size_t ck = proto_chk_size(d->chk);
+    if (n + ck > sizeof(raw))
+        return 0;
+    memcpy(raw, body, n);
+    size_t m = n + put_uint(raw + n, proto_checksum(d->chk, body, n), ck, d->chk_be);
+    return (d->framing == PF_COBS) ? encode_cobs(raw, m, out, cap) : encode_slip(raw, m, out, cap);
+}
+
+/* ---------------- 内置协议 ---------------- */
+
+static void set_len16(ProtoDesc *d, const char *name, ProtoChk chk)
+{
+    proto_default(d);
+    strcpy(d->name, name);
+    d->len_size = 2;
+    d->max_body = PROTO_MAX_FRAME - 16;
+    d->chk = chk;
+}
+
+static void set_delim(ProtoDesc *d, const char *name, ProtoFraming f, ProtoChk chk)
+{
+    proto_default(d);
+    strcpy(d->name, name);
+    d->framing = f;
+    d->hdr_len = 0;
+    d->len_size = 0;
+    d->max_body = 2048;
+    d->chk = chk;
+}
+
+static const char *const k_builtin[] = {
+    "aa55", "aa55-le16-crc16", "aa55-le16-crc32", "cobs", "cobs-crc16", "cobs-crc32", "slip", "slip-crc16",
+};
+
+bool proto_builtin(const char *name, ProtoDesc *d)
+{
+    if (!name || !d)
+        return false;
+    if (!strcmp(name, "aa55"))
+        proto_default(d);
+    else if (!strcmp(name, "aa55-le16-crc16"))
+        set_len16(d, name, PC_CRC16_CCITT);
+    else if (!strcmp(name, "aa55-le16-crc32"))
+        set_len16(d, name, PC_CRC32);
+    else if (!strcmp(name, "cobs"))
+        set_delim(d, name, PF_COBS, PC_NONE);
+    else if (!strcmp(name, "cobs-crc16"))
+        set_delim(d, name, PF_COBS, PC_CRC16_CCITT);
+    else if (!strcmp(name, "cobs-crc32"))
+        set_delim(d, name, PF_COBS, PC_CRC32);
+    else if (!strcmp(name, "slip"))
+        set_delim(d, name, PF_SLIP, PC_NONE);
+    else if (!strcmp(name, "slip-crc16"))
+        set_delim(d, name, PF_SLIP, PC_CRC16_CCITT);
+    else
+        return false;
+    return true;
+}
+
+const char *proto_builtin_name(size_t i)
+{
+    return i < COUNT(k_builtin) ? k_builtin[i] : NULL;
+}
+
+/* ---------------- 文本描述 ---------------- */
+
+static int find_name(const char *const *names, size_t n, const char *s)
+{
+    for (size_t i = 0; i < n; ++i)
+        if (!strcmp(names[i], s))
+            return (int)i;
+    return -1;
+}
+
+static bool parse_hdr(const char *s, ProtoDesc *d)
+{
+    size_t n = strlen(s);
+    if (n == 0 || n % 2 || n / 2 > PROTO_HDR_MAX)
+        return false;
+    for (size_t i = 0; i < n; i += 2)
+    {
+        char b[3] = {s[i], s[i + 1], 0};
+        if (!isxdigit((unsigned char)b[0]) || !isxdigit((unsigned char)b[1]))
+            return false;
+        d->hdr[i / 2] = (uint8_t)strtoul(b, NULL, 16);
+    }
+    d->hdr_len = (uint8_t)(n / 2);
+    return true;
+}
+
+static bool fail(char *err, size_t errlen, const char *msg, const char *tok)
+{
+    if (err && errlen)
+        snprintf(err, errlen, "%s: %s", msg, tok);
+    return false;
+}
+
+bool proto_parse(const char *text, ProtoDesc *d, char *err, size_t errlen)
+{
+    if (!text || !d)
+        return false;
+    ProtoDesc t;
+    char tok[64];
+    int used = 0;
+    const char *p = text;
+    bool first = true;
+    bool custom = false;
+    while (sscanf(p, "%63s%n", tok, &used) == 1)
+    {
+        p += used;
+        if (first)
+        {
+            first = false;
+            int f = find_name(k_framing_names, COUNT(k_framing_names), tok);
+            if (f == PF_LENGTH)
+                proto_default(&t);
+            else if (f > 0)
+                set_delim(&t, tok, (ProtoFraming)f, PC_NONE);
+            else if (!proto_builtin(tok, &t))
+                return fail(err, errlen, "未知协议", tok);
+            if (f >= 0)
+                strcpy(t.name, "custom");
+            continue;
+        }
+        custom = true;
+        char *eq = strchr(tok, '=');
+        const char *val = eq ? eq + 1 : "";
+        if (eq)
+            *eq = 0;
+        if (!strcmp(tok, "hdr"))
+        {
+            if (t.framing != PF_LENGTH || !parse_hdr(val, &t))
+                return fail(err, errlen, "帧头应为 1~4 字节十六进制", val);
+        }
+        else if (!strcmp(tok, "off"))
+            t.len_off = (uint8_t)atoi(val);
+        else if (!strcmp(tok, "size"))
+            t.len_size = (uint8_t)atoi(val);
+        else if (!strcmp(tok, "be") || !strcmp(tok, "le"))
+            t.len_be = (tok[0] == 'b');
+        else if (!strcmp(tok, "adj"))
+            t.len_adj = (int16_t)atoi(val);
+        else if (!strcmp(tok, "max"))
+            t.max_body = (uint16_t)atoi(val);
+        else if (!strcmp(tok, "chk"))
+        {
+            int c = find_name(k_chk_names, COUNT(k_chk_names), val);
+            if (c < 0)
+                return fail(err, errlen, "未知校验", val);
+            t.chk = (ProtoChk)c;
+        }
+        else if (!strcmp(tok, "cover"))
+        {
+            int c = find_name(k_cover_names, COUNT(k_cover_names), val);
+            if (c < 0)
+                return fail(err, errlen, "未知覆盖范围", val);
+            t.cover = (ProtoCover)c;
+        }
+        else if (!strcmp(tok, "chkbe") || !strcmp(tok, "chkle"))
+            t.chk_be = (tok[3] == 'b');
+        else
+            return fail(err, errlen, "未知参数", tok);
+    }
+    if (first)
+        return fail(err, errlen, "缺少协议名", "");
+    if (custom && strcmp(t.name, "custom"))
+        strcat(t.name, "*"); // 在内置协议上改过参数
+    if (!proto_valid(&t))
+        return fail(err, errlen, "参数不自洽（长度字段宽度 / 帧长上限）", text);
+    *d = t;
+    return true;
+}
+
+void proto_describe(const ProtoDesc *d, char *out, size_t n)
+{
+    if (!d || !out || !n)
+        return;
+    const char *chk = k_chk_names[d->chk];
+    if (d->framing != PF_LENGTH)
+    {
+        snprintf(out, n, "%s: %s chk=%s%s max=%u", d->name, k_framing_names[d->framing], chk,
+                 (proto_chk_size(d->chk) > 1) ? (d->chk_be ? " chkbe" : " chkle") : "", (unsigned)d->max_body);
+        return;
+    }
+    char hdr[PROTO_HDR_MAX * 2 + 1] = {0};
+    for (int i = 0; i < d->hdr_len; ++i)
+        snprintf(hdr + 2 * i, 3, "%02X", d->hdr[i]);
+    snprintf(out, n, "%s: len hdr=%s off=%u size=%u %s adj=%d max=%u chk=%s cover=%s%s", d->name, hdr,
+             (unsigned)d->len_off, (unsigned)d->len_size, d->len_be ? "be" : "le", (int)d->len_adj,
+             (unsigned)d->max_body, chk, k_cover_names[d->cover],
+             (proto_chk_size(d->chk) > 1) ? (d->chk_be ? " chkbe" : " chkle") : "");
+}
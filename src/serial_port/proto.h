@@ -0,0 +1,101 @@
+#ifndef PROTO_H
+#define PROTO_H
+
+// 帧协议描述：frame_parser 按描述选出专用解码函数（设置时选一次，喂数据时不再解释描述）
+//
+//   PF_LENGTH：HDR[hdr_len] | PRE[len_off] | LEN[len_size] | BODY[LEN + len_adj] | CHK
+//             回调交付 BODY；PRE 是帧头与长度字段之间的固定字节（地址/命令等）
+//   PF_COBS  ：COBS 编码、0x00 分隔；解码后末尾 chk 宽度的字节是校验，其余交付
+//   PF_SLIP  ：SLIP（RFC 1055，0xC0 分隔，0xDB 转义）；校验同 COBS
+//
+// 校验覆盖范围（只对 PF_LENGTH 有意义；COBS/SLIP 总是覆盖解码后的全部数据）：
+//   PCOV_LEN_BODY 帧头之后到 BODY 末尾，即 PRE + LEN + BODY（默认 AA55 协议即 LEN + PAYLOAD）
+//   PCOV_BODY     只有 BODY
+//   PCOV_ALL      从帧头第一个字节起
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROTO_HDR_MAX 4
+#define PROTO_MAX_FRAME 4096 // 单帧（含头尾）上限，解析器缓冲大小
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        PF_LENGTH = 0,
+        PF_COBS,
+        PF_SLIP
+    } ProtoFraming;
+
+    typedef enum
+    {
+        PC_NONE = 0,
+        PC_SUM8,        // 字节和 & 0xFF
+        PC_XOR8,        // 字节异或
+        PC_CRC16_CCITT, // 见 crc.h
+        PC_CRC32,
+        PC_CRC32C
+    } ProtoChk;
+
+    typedef enum
+    {
+        PCOV_LEN_BODY = 0,
+        PCOV_BODY,
+        PCOV_ALL
+    } ProtoCover;
+
+    typedef struct
+    {
+        char name[24];
+        ProtoFraming framing;
+        uint8_t hdr[PROTO_HDR_MAX];
+        uint8_t hdr_len;  // 1..PROTO_HDR_MAX（PF_LENGTH）
+        uint8_t len_off;  // 长度字段在帧头之后的偏移
+        uint8_t len_size; // 1 / 2 / 4
+        bool len_be;      // 长度字段大端
+        int16_t len_adj;  // BODY 长度 = 长度字段值 + len_adj（长度字段按整帧计时为负）
+        uint16_t max_body; // BODY 上限（超过视为错帧，重新找头）
+        ProtoChk chk;
+        ProtoCover cover;
+        bool chk_be; // 多字节校验值大端（默认小端）
+    } ProtoDesc;
+
+    // 默认协议：AA 55 | LEN(1) | PAYLOAD | CHK(1)，CHK = (LEN + sum(PAYLOAD)) & 0xFF
+    void proto_default(ProtoDesc *d);
+
+    // 校验值字节数
+    size_t proto_chk_size(ProtoChk c);
+
+    // 描述是否自洽（长度字段宽度、帧长上限等）
+    bool proto_valid(const ProtoDesc *d);
+
+    // 内置协议：按名字找（"aa55" / "aa55-le16-crc16" / "cobs-crc32" / ...），i 从 0 起枚举
+    bool proto_builtin(const char *name, ProtoDesc *d);
+    const char *proto_builtin_name(size_t i);
+
+    // 文本描述：内置名字后面可跟 key=value 覆盖（或以 len/cobs/slip 开头从默认值起），如
+    //   "len hdr=A55A off=1 size=2 be adj=0 max=1024 chk=crc16 cover=body chkbe"
+    //   "cobs chk=crc32"
+    // 失败时 err 写原因
+    bool proto_parse(const char *text, ProtoDesc *d, char *err, size_t errlen);
+
+    // 校验值（按 c 计算 p[0..n)，结果放在低位）
+    uint32_t proto_checksum(ProtoChk c, const uint8_t *p, size_t n);
+
+    // 按描述编码一帧：body 即解析器会交付的内容；返回写入 out 的字节数，
+    // body 超过 max_body、长度字段放不下或 cap 不够时返回 0（SLIP 最坏需要 2 * (n + 校验) + 2 字节）
+    size_t proto_encode(const ProtoDesc *d, const uint8_t *body, size_t n, uint8_t *out, size_t cap);
+
+    // 一行描述（给 proto 命令显示）
+    void proto_describe(const ProtoDesc *d, char *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROTO_H
@@ -1,6 +1,42 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // realpath
+#endif
 #include "serial_port.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+void sp_default_config(SpConfig *cfg, int baud)
+{
+    if (!cfg)
+        return;
+    cfg->baud = baud;
+    cfg->async = false;
+    cfg->rx_buf = SP_DEFAULT_BUF;
+    cfg->tx_buf = SP_DEFAULT_BUF;
+    cfg->profile = SP_PROFILE_DEFAULT;
+}
+
+static const char *const k_profile_names[] = {"default", "lowlat", "bulk"};
+
+const char *sp_profile_name(SpProfile p)
+{
+    return ((unsigned)p < sizeof(k_profile_names) / sizeof(k_profile_names[0])) ? k_profile_names[p] : "?";
+}
+
+bool sp_profile_parse(const char *name, SpProfile *out)
+{
+    for (unsigned i = 0; name && i < sizeof(k_profile_names) / sizeof(k_profile_names[0]); ++i)
+    {
+        if (!strcmp(name, k_profile_names[i]))
+        {
+            if (out)
+                *out = (SpProfile)i;
+            return true;
+        }
+    }
+    return false;
+}
 
 #ifdef _WIN32
 /* ---------------- Windows 实现 ---------------- */
@@ -29,16 +65,49 @@ static void build_port_path(const char *name, char path[128])
     }
 }
 
-bool sp_open(SerialPort *sp, const char *name, int baud)
+#define SP_BULK_GAP_MS 5 // bulk 模式的字符间隔超时
+
+// 事件驱动模式下的读超时：有数据立即完成（bulk：凑到字符间隔）；没有数据最多等 timeout_ms（<0 近似无限）
+static bool set_read_wait_timeouts(SerialPort *sp, int timeout_ms)
 {
-    if (!sp || !name)
+    if (sp->rd_timeout == timeout_ms)
+        return true;
+    COMMTIMEOUTS to = {0};
+    if (timeout_ms == 0)
+    {
+        to.ReadIntervalTimeout = MAXDWORD; // 立即返回已有数据
+    }
+    else if (sp->profile == SP_PROFILE_BULK)
+    {
+        // 吞吐：收到首字节后继续收，直到缓冲满或出现 SP_BULK_GAP_MS 的字符间隔
+        to.ReadIntervalTimeout = SP_BULK_GAP_MS;
+        to.ReadTotalTimeoutConstant = (timeout_ms < 0) ? (MAXDWORD - 1) : (DWORD)timeout_ms;
+    }
+    else
+    {
+        to.ReadIntervalTimeout = MAXDWORD;
+        to.ReadTotalTimeoutMultiplier = MAXDWORD;
+        to.ReadTotalTimeoutConstant = (timeout_ms < 0) ? (MAXDWORD - 1) : (DWORD)timeout_ms;
+    }
+    to.WriteTotalTimeoutConstant = 100;
+    to.WriteTotalTimeoutMultiplier = 0;
+    if (!SetCommTimeouts(sp->h, &to))
         return false;
+    sp->rd_timeout = timeout_ms;
+    return true;
+}
+
+static bool sp_open_impl(SerialPort *sp, const char *name, const SpConfig *cfg)
+{
+    if (!sp || !name || !cfg || cfg->baud <= 0)
+        return false;
+    bool async = cfg->async;
     memset(sp, 0, sizeof(*sp));
     char path[128];
     build_port_path(name, path);
 
     HANDLE h = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
-                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                           OPEN_EXISTING, async ? FILE_FLAG_OVERLAPPED : FILE_ATTRIBUTE_NORMAL, NULL);
     if (h == INVALID_HANDLE_VALUE)
     {
         fprintf(stderr, "CreateFile '%s' failed (err=%lu)\n", path, GetLastError());
@@ -53,7 +122,7 @@ bool sp_open(SerialPort *sp, const char *name, int baud)
         CloseHandle(h);
         return false;
     }
-    dcb.BaudRate = map_baud(baud);
+    dcb.BaudRate = map_baud(cfg->baud);
     dcb.ByteSize = 8;
     dcb.StopBits = ONESTOPBIT;
     dcb.Parity = NOPARITY;
@@ -68,29 +137,84 @@ bool sp_open(SerialPort *sp, const char *name, int baud)
 
     if (!SetCommState(h, &dcb))
     {
-        fprintf(stderr, "SetCommState failed\n");
+        fprintf(stderr, "SetCommState failed (baud=%d, err=%lu)\n", cfg->baud, GetLastError());
         CloseHandle(h);
         return false;
     }
+    GetCommState(h, &dcb); // 读回驱动实际采用的波特率
 
-    // 设置短超时（让 ReadFile 周期性返回）
-    COMMTIMEOUTS to = {0};
-    to.ReadIntervalTimeout = 50;      // ms
-    to.ReadTotalTimeoutConstant = 50; // ms
-    to.ReadTotalTimeoutMultiplier = 0;
-    to.WriteTotalTimeoutConstant = 100;
-    to.WriteTotalTimeoutMultiplier = 0;
-    SetCommTimeouts(h, &to);
-
-    // 建议放大驱动缓冲
-    SetupComm(h, 1 << 15, 1 << 15); // 32 KB
+    // 驱动缓冲：高波特率下放大可减少溢出（只是建议值，驱动可以不理）
+    if (cfg->rx_buf || cfg->tx_buf)
+        SetupComm(h, cfg->rx_buf ? cfg->rx_buf : SP_DEFAULT_BUF, cfg->tx_buf ? cfg->tx_buf : SP_DEFAULT_BUF);
 
     sp->h = h;
+    sp->baud = (int)dcb.BaudRate;
     strncpy(sp->name, name, sizeof(sp->name) - 1);
-    sp->rtscts = false;
+    atomic_store(&sp->rtscts, false);
+    sp->async = async;
+    sp->profile = cfg->profile;
+
+    if (!async)
+    {
+        // 设置短超时（让 ReadFile 周期性返回）
+        COMMTIMEOUTS to = {0};
+        to.ReadIntervalTimeout = 50;      // ms
+        to.ReadTotalTimeoutConstant = 50; // ms
+        to.ReadTotalTimeoutMultiplier = 0;
+        if (cfg->profile == SP_PROFILE_LOWLAT)
+        {
+            // 有字节立即返回，没有数据最多等 50ms
+            to.ReadIntervalTimeout = MAXDWORD;
+            to.ReadTotalTimeoutMultiplier = MAXDWORD;
+        }
+        else if (cfg->profile == SP_PROFILE_BULK)
+        {
+            to.ReadIntervalTimeout = SP_BULK_GAP_MS;
+            to.ReadTotalTimeoutConstant = 100;
+        }
+        to.WriteTotalTimeoutConstant = 100;
+        to.WriteTotalTimeoutMultiplier = 0;
+        SetCommTimeouts(h, &to);
+        return true;
+    }
+
+    // 事件驱动：读完成投递到完成端口；同步完成时不再重复投递
+    sp->rd_timeout = -2; // 强制首次设置
+    sp->iocp = CreateIoCompletionPort(h, NULL, (ULONG_PTR)sp, 1);
+    if (!sp->iocp || !set_read_wait_timeouts(sp, 0))
+    {
+        fprintf(stderr, "IOCP setup failed (err=%lu)\n", GetLastError());
+        if (sp->iocp)
+            CloseHandle(sp->iocp);
+        CloseHandle(h);
+        memset(sp, 0, sizeof(*sp));
+        return false;
+    }
+    SetFileCompletionNotificationModes(h, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS);
+    SetCommMask(h, EV_RXCHAR); // sp_wait_readable 用
     return true;
 }
 
+bool sp_open(SerialPort *sp, const char *name, int baud)
+{
+    SpConfig cfg;
+    sp_default_config(&cfg, baud);
+    return sp_open_impl(sp, name, &cfg);
+}
+
+bool sp_open_async(SerialPort *sp, const char *name, int baud)
+{
+    SpConfig cfg;
+    sp_default_config(&cfg, baud);
+    cfg.async = true;
+    return sp_open_impl(sp, name, &cfg);
+}
+
+bool sp_open_ex(SerialPort *sp, const char *name, const SpConfig *cfg)
+{
+    return sp_open_impl(sp, name, cfg);
+}
+
 void sp_close(SerialPort *sp)
 {
     if (!sp)
@@ -100,6 +224,11 @@ void sp_close(SerialPort *sp)
         CloseHandle(sp->h);
         sp->h = NULL;
     }
+    if (sp->iocp)
+    {
+        CloseHandle(sp->iocp);
+        sp->iocp = NULL;
+    }
 }
 
 long sp_write(SerialPort *sp, const void *buf, size_t n)
@@ -107,21 +236,105 @@ long sp_write(SerialPort *sp, const void *buf, size_t n)
     if (!sp || !sp->h || !buf || n == 0)
         return 0;
     DWORD wr = 0;
-    if (!WriteFile(sp->h, buf, (DWORD)n, &wr, NULL))
+    if (!sp->async)
+    {
+        if (!WriteFile(sp->h, buf, (DWORD)n, &wr, NULL))
+            return -1;
+        return (long)wr;
+    }
+    // 重叠写：事件句柄最低位置 1，完成不投递到读用的完成端口
+    OVERLAPPED ov = {0};
+    HANDLE ev = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!ev)
         return -1;
-    return (long)wr;
+    ov.hEvent = (HANDLE)((ULONG_PTR)ev | 1);
+    BOOL ok = WriteFile(sp->h, buf, (DWORD)n, NULL, &ov);
+    if (ok || GetLastError() == ERROR_IO_PENDING)
+        ok = GetOverlappedResult(sp->h, &ov, &wr, TRUE); // 受 WriteTotalTimeoutConstant 约束
+    CloseHandle(ev);
+    return ok ? (long)wr : -1;
 }
 
 long sp_read(SerialPort *sp, void *buf, size_t n)
 {
     if (!sp || !sp->h || !buf || n == 0)
         return 0;
+    if (sp->async)
+        return sp_read_wait(sp, buf, n, 0);
     DWORD rd = 0;
     if (!ReadFile(sp->h, buf, (DWORD)n, &rd, NULL))
         return -1;
     return (long)rd; // 可能为0（超时）
 }
 
+long sp_read_wait(SerialPort *sp, void *buf, size_t n, int timeout_ms)
+{
+    if (!sp || !sp->h || !buf || n == 0)
+        return 0;
+    if (!sp->async)
+        return sp_read(sp, buf, n);
+    // 超时交给驱动（COMMTIMEOUTS），读请求总会自己完成，不需要 CancelIo
+    if (!set_read_wait_timeouts(sp, timeout_ms))
+        return -1;
+
+    memset(&sp->ov_rd, 0, sizeof(sp->ov_rd));
+    DWORD rd = 0;
+    if (ReadFile(sp->h, buf, (DWORD)n, &rd, &sp->ov_rd))
+        return (long)rd; // 同步完成（已有数据）
+    if (GetLastError() != ERROR_IO_PENDING)
+        return -1;
+
+    ULONG_PTR key = 0;
+    LPOVERLAPPED pov = NULL;
+    if (!GetQueuedCompletionStatus(sp->iocp, &rd, &key, &pov, INFINITE))
+        return -1;
+    return (long)rd; // 0 表示超时
+}
+
+int sp_wait_readable(SerialPort *sp, int timeout_ms)
+{
+    if (!sp || !sp->h)
+        return -1;
+    if (!sp->async)
+        return 1;
+    // 同 sp_write：事件句柄最低位置 1，完成不投递到读用的完成端口
+    OVERLAPPED ov = {0};
+    HANDLE ev = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!ev)
+        return -1;
+    ov.hEvent = (HANDLE)((ULONG_PTR)ev | 1);
+    DWORD mask = 0, n = 0;
+    int r = 0;
+    if (WaitCommEvent(sp->h, &mask, &ov))
+        r = 1; // 等之前已有事件
+    else if (GetLastError() != ERROR_IO_PENDING)
+        r = -1;
+    else
+    {
+        // 已在驱动缓冲里的字节不会再触发 EV_RXCHAR：挂上等待之后先看一眼
+        DWORD errs = 0, w = WAIT_TIMEOUT;
+        COMSTAT cs = {0};
+        if (ClearCommError(sp->h, &errs, &cs) && cs.cbInQue > 0)
+            r = 1;
+        else
+        {
+            w = WaitForSingleObject(ev, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+            r = w == WAIT_OBJECT_0 ? 1 : (w == WAIT_TIMEOUT ? 0 : -1);
+        }
+        if (w != WAIT_OBJECT_0)
+            SetCommMask(sp->h, EV_RXCHAR); // 重设掩码让挂起的 WaitCommEvent 立即结束
+        GetOverlappedResult(sp->h, &ov, &n, TRUE); // ov 在栈上：等请求真正结束再返回
+    }
+    CloseHandle(ev);
+    return r;
+}
+
+bool sp_set_read_batch(SerialPort *sp, unsigned min_bytes)
+{
+    (void)min_bytes;
+    return sp && sp->h && sp->async;
+}
+
 bool sp_set_rtscts(SerialPort *sp, bool enable)
 {
     if (!sp || !sp->h)
@@ -134,10 +347,20 @@ bool sp_set_rtscts(SerialPort *sp, bool enable)
     dcb.fRtsControl = enable ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_DISABLE;
     bool ok = SetCommState(sp->h, &dcb) ? true : false;
     if (ok)
-        sp->rtscts = enable;
+        atomic_store(&sp->rtscts, enable);
     return ok;
 }
 
+int sp_get_cts(SerialPort *sp)
+{
+    if (!sp || !sp->h)
+        return -1;
+    DWORD st = 0;
+    if (!GetCommModemStatus(sp->h, &st))
+        return -1;
+    return (st & MS_CTS_ON) ? 1 : 0;
+}
+
 bool sp_is_open(const SerialPort *sp)
 {
     return sp && sp->h;
@@ -149,6 +372,32 @@ bool sp_is_open(const SerialPort *sp)
 #include <fcntl.h>
 #include <termios.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <limits.h>
+
+#if defined(__linux__)
+// termios2 / BOTHER：任意整数波特率。<asm/termbits.h> 与 <termios.h> 冲突，这里自己声明（通用布局，NCCS=19）
+struct termios2
+{
+    tcflag_t c_iflag, c_oflag, c_cflag, c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed, c_ospeed;
+};
+#ifndef TCGETS2
+#define TCGETS2 _IOR('T', 0x2A, struct termios2)
+#define TCSETS2 _IOW('T', 0x2B, struct termios2)
+#endif
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#include <linux/serial.h> // serial_struct / ASYNC_LOW_LATENCY
+#elif defined(__APPLE__)
+#include <IOKit/serial/ioss.h> // IOSSIOSPEED
+#endif
+
+#define SP_BULK_VMIN 64 // bulk 模式：事件驱动下凑够这么多字节才唤醒（零头等读超时取走）
 
 static speed_t map_baud(int baud)
 {
@@ -176,15 +425,117 @@ static speed_t map_baud(int baud)
     case 921600:
         return B921600;
 #endif
-    default:
+#ifdef B1000000
+    case 1000000:
+        return B1000000;
+#endif
+#ifdef B2000000
+    case 2000000:
+        return B2000000;
+#endif
+#ifdef B3000000
+    case 3000000:
+        return B3000000;
+#endif
+#ifdef B4000000
+    case 4000000:
+        return B4000000;
+#endif
+    default: // 其余走 set_custom_baud
         return 0;
     }
 }
 
-bool sp_open(SerialPort *sp, const char *name, int baud)
+// 非标准波特率：在 tcsetattr 之后设置（tcsetattr 会按 c_cflag 里的占位速率重设）
+static bool set_custom_baud(int fd, int baud)
 {
-    if (!sp || !name)
+#if defined(__linux__)
+    struct termios2 t2;
+    if (ioctl(fd, TCGETS2, &t2) != 0)
         return false;
+    t2.c_cflag &= ~(tcflag_t)CBAUD;
+    t2.c_cflag |= BOTHER;
+    t2.c_ispeed = t2.c_ospeed = (speed_t)baud;
+    return ioctl(fd, TCSETS2, &t2) == 0;
+#elif defined(__APPLE__)
+    speed_t s = (speed_t)baud;
+    return ioctl(fd, IOSSIOSPEED, &s) == 0;
+#else
+    (void)fd;
+    (void)baud;
+    return false;
+#endif
+}
+
+// 驱动实际采用的波特率（读不出时返回 want）
+static int read_baud(int fd, int want)
+{
+#if defined(__linux__)
+    struct termios2 t2;
+    if (ioctl(fd, TCGETS2, &t2) == 0 && t2.c_ospeed)
+        return (int)t2.c_ospeed;
+#else
+    (void)fd;
+#endif
+    return want;
+}
+
+// 改了 termios 的其他位之后调用：非标准波特率重新设一遍，避免被 tcsetattr 冲掉
+static bool restore_custom_baud(SerialPort *sp)
+{
+    return !sp->custom_baud || set_custom_baud(sp->fd, sp->baud);
+}
+
+#if defined(__linux__)
+// FTDI 芯片攒够 62 字节或 latency_timer 到期才往 USB 上送（默认 16ms），低延迟时改成 1ms
+// 只有 ftdi_sio 驱动有这个属性；通常要 root 权限才能写
+static void set_ftdi_latency(const char *name, unsigned ms)
+{
+    char real[PATH_MAX], path[PATH_MAX + 64];
+    if (!realpath(name, real)) // /dev/serial/by-id/... 之类的链接
+        return;
+    const char *base = strrchr(real, '/');
+    snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", base ? base + 1 : real);
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        if (errno != ENOENT)
+            fprintf(stderr, "latency_timer: %s: %s\n", path, strerror(errno));
+        return;
+    }
+    fprintf(f, "%u\n", ms);
+    fclose(f);
+}
+#endif
+
+// 驱动层的延迟设置（只有 Linux 有；失败不影响打开）
+static void apply_profile(int fd, const char *name, SpProfile profile)
+{
+#if defined(__linux__)
+    if (profile == SP_PROFILE_DEFAULT)
+        return;
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) == 0) // pty / 部分 USB 驱动不支持，忽略
+    {
+        if (profile == SP_PROFILE_LOWLAT)
+            ss.flags |= ASYNC_LOW_LATENCY;
+        else
+            ss.flags &= ~ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &ss);
+    }
+    set_ftdi_latency(name, profile == SP_PROFILE_LOWLAT ? 1u : 16u);
+#else
+    (void)fd;
+    (void)name;
+    (void)profile;
+#endif
+}
+
+static bool sp_open_impl(SerialPort *sp, const char *name, const SpConfig *cfg)
+{
+    if (!sp || !name || !cfg || cfg->baud <= 0)
+        return false;
+    bool async = cfg->async;
     memset(sp, 0, sizeof(*sp));
 
     int fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
@@ -203,13 +554,10 @@ bool sp_open(SerialPort *sp, const char *name, int baud)
     }
 
     cfmakeraw(&tio); // 原始模式
-    speed_t s = map_baud(baud);
-    if (s == 0)
-    {
-        fprintf(stderr, "不支持的波特率: %d\n", baud);
-        close(fd);
-        return false;
-    }
+    speed_t s = map_baud(cfg->baud);
+    bool custom = (s == 0);
+    if (custom)
+        s = B38400; // 占位，tcsetattr 之后再设真实速率
     cfsetispeed(&tio, s);
     cfsetospeed(&tio, s);
 
@@ -223,9 +571,16 @@ bool sp_open(SerialPort *sp, const char *name, int baud)
     tio.c_cflag &= ~CRTSCTS;
 #endif
 
-    // 非阻塞 + 短等待：VTIME 单位 0.1s；VMIN=0 则 read 最多等待 VTIME
+    // 非阻塞 + 短等待：VTIME 单位 0.1s；VMIN=0 则有字节即返回，没有数据最多等待 VTIME
+    // （同步模式下 VMIN>0 会在没有数据时永远阻塞，所以 bulk 只作用于事件驱动模式）
     tio.c_cc[VMIN] = 0;
     tio.c_cc[VTIME] = 1; // 100ms
+    if (async)
+    {
+        // 事件驱动：VTIME=0 时 poll 要等到至少 VMIN 字节才报可读（默认 1 字节即唤醒）
+        tio.c_cc[VMIN] = (cfg->profile == SP_PROFILE_BULK) ? SP_BULK_VMIN : 1;
+        tio.c_cc[VTIME] = 0;
+    }
 
     if (tcsetattr(fd, TCSANOW, &tio) != 0)
     {
@@ -233,16 +588,51 @@ bool sp_open(SerialPort *sp, const char *name, int baud)
         close(fd);
         return false;
     }
-    // 置回阻塞模式（可选）
-    int flags = fcntl(fd, F_GETFL, 0);
-    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    if (custom && !set_custom_baud(fd, cfg->baud))
+    {
+        fprintf(stderr, "不支持的波特率: %d (%s)\n", cfg->baud, strerror(errno));
+        close(fd);
+        return false;
+    }
+    // 驱动缓冲（cfg->rx_buf / tx_buf）：tty 层的缓冲由内核管理，不可调
+    apply_profile(fd, name, cfg->profile);
+    // 置回阻塞模式（可选）；事件驱动模式保持非阻塞，由 poll 等待
+    if (!async)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
 
     sp->fd = fd;
     strncpy(sp->name, name, sizeof(sp->name) - 1);
-    sp->rtscts = false;
+    atomic_store(&sp->rtscts, false);
+    sp->async = async;
+    sp->custom_baud = custom;
+    sp->profile = cfg->profile;
+    sp->baud = read_baud(fd, cfg->baud);
     return true;
 }
 
+bool sp_open(SerialPort *sp, const char *name, int baud)
+{
+    SpConfig cfg;
+    sp_default_config(&cfg, baud);
+    return sp_open_impl(sp, name, &cfg);
+}
+
+bool sp_open_async(SerialPort *sp, const char *name, int baud)
+{
+    SpConfig cfg;
+    sp_default_config(&cfg, baud);
+    cfg.async = true;
+    return sp_open_impl(sp, name, &cfg);
+}
+
+bool sp_open_ex(SerialPort *sp, const char *name, const SpConfig *cfg)
+{
+    return sp_open_impl(sp, name, cfg);
+}
+
 void sp_close(SerialPort *sp)
 {
     if (!sp)
@@ -258,10 +648,31 @@ long sp_write(SerialPort *sp, const void *buf, size_t n)
 {
     if (!sp || sp->fd < 0 || !buf || n == 0)
         return 0;
-    ssize_t w = write(sp->fd, buf, n);
-    if (w < 0)
-        return -1;
-    return (long)w;
+    if (!sp->async)
+    {
+        ssize_t w = write(sp->fd, buf, n);
+        if (w < 0)
+            return -1;
+        return (long)w;
+    }
+    // 非阻塞 fd：写不动时 poll 等可写，最多等 100ms（与 Windows 写超时一致）
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t done = 0;
+    while (done < n)
+    {
+        ssize_t w = write(sp->fd, p + done, n - done);
+        if (w > 0)
+        {
+            done += (size_t)w;
+            continue;
+        }
+        if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return done ? (long)done : -1;
+        struct pollfd pfd = {sp->fd, POLLOUT, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            break;
+    }
+    return (long)done;
 }
 
 long sp_read(SerialPort *sp, void *buf, size_t n)
@@ -278,6 +689,58 @@ long sp_read(SerialPort *sp, void *buf, size_t n)
     return (long)r;
 }
 
+long sp_read_wait(SerialPort *sp, void *buf, size_t n, int timeout_ms)
+{
+    if (!sp || sp->fd < 0 || !buf || n == 0)
+        return 0;
+    if (!sp->async)
+        return sp_read(sp, buf, n);
+    struct pollfd pfd = {sp->fd, POLLIN, 0};
+    int pr = poll(&pfd, 1, timeout_ms);
+    if (pr < 0)
+        return (errno == EINTR) ? 0 : -1;
+    bool hup = pr > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+    if (hup && !(pfd.revents & POLLIN))
+        return -1;
+    // 超时也读一次：VMIN>1 时 poll 要凑够 VMIN 才报可读，不足的零头在超时后取走
+    long r = sp_read(sp, buf, n);
+    return (r == 0 && hup) ? -1 : r; // 挂断后 read 返回 0，别让调用者空转
+}
+
+int sp_wait_readable(SerialPort *sp, int timeout_ms)
+{
+    if (!sp || sp->fd < 0)
+        return -1;
+    struct pollfd pfd = {sp->fd, POLLIN, 0};
+    int pr = poll(&pfd, 1, timeout_ms);
+    if (pr < 0)
+        return (errno == EINTR) ? 0 : -1;
+    if (pr > 0 && (pfd.revents & POLLIN) && !(pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
+        return 1;
+    // 超时：VMIN>1 时 poll 要凑够 VMIN 才报可读，不足门限的零头也要取走；
+    // 挂断：缓冲里还有数据就先读完，没有了才报错（否则 read 返回 0，调用者空转）
+    int avail = 0;
+    if (ioctl(sp->fd, FIONREAD, &avail) == 0 && avail > 0)
+        return 1;
+    return pr > 0 ? -1 : 0;
+}
+
+bool sp_set_read_batch(SerialPort *sp, unsigned min_bytes)
+{
+    if (!sp || sp->fd < 0 || !sp->async)
+        return false;
+    struct termios tio;
+    if (tcgetattr(sp->fd, &tio) != 0)
+        return false;
+    if (min_bytes < 1)
+        min_bytes = 1;
+    if (min_bytes > 255)
+        min_bytes = 255;
+    tio.c_cc[VMIN] = (cc_t)min_bytes;
+    tio.c_cc[VTIME] = 0;
+    return tcsetattr(sp->fd, TCSANOW, &tio) == 0 && restore_custom_baud(sp);
+}
+
 bool sp_set_rtscts(SerialPort *sp, bool enable)
 {
     if (!sp || sp->fd < 0)
@@ -294,12 +757,22 @@ bool sp_set_rtscts(SerialPort *sp, bool enable)
     (void)enable;
     return false;
 #endif
-    bool ok = (tcsetattr(sp->fd, TCSANOW, &tio) == 0);
+    bool ok = (tcsetattr(sp->fd, TCSANOW, &tio) == 0) && restore_custom_baud(sp);
     if (ok)
-        sp->rtscts = enable;
+        atomic_store(&sp->rtscts, enable);
     return ok;
 }
 
+int sp_get_cts(SerialPort *sp)
+{
+    if (!sp || sp->fd < 0)
+        return -1;
+    int st = 0;
+    if (ioctl(sp->fd, TIOCMGET, &st) != 0)
+        return -1; // pty 等不支持 modem 线的设备
+    return (st & TIOCM_CTS) ? 1 : 0;
+}
+
 bool sp_is_open(const SerialPort *sp)
 {
     return sp && sp->fd > 0;
@@ -1,34 +1,75 @@
 #ifndef SERIAL_PORT_H
 #define SERIAL_PORT_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+// 读取延迟/吞吐取舍（SpConfig.profile）
+typedef enum
+{
+    SP_PROFILE_DEFAULT = 0, // 兼顾：POSIX VTIME=100ms 兜底，Windows 50ms 间隔超时
+    SP_PROFILE_LOWLAT = 1,  // 低延迟：有字节即返回；Linux 另开 ASYNC_LOW_LATENCY、FTDI latency_timer=1ms
+    SP_PROFILE_BULK = 2     // 吞吐：凑够一批（VMIN / 字符间隔超时）再唤醒，系统调用更少
+} SpProfile;
+
 #ifdef _WIN32
 #include <windows.h>
 typedef struct
 {
     HANDLE h;
     char name[128];
-    bool rtscts;
+    atomic_bool rtscts; // 硬件流控开关：sp_set_rtscts 改，发送线程随时读
+    bool async;       // sp_open_async 打开：FILE_FLAG_OVERLAPPED + 完成端口
+    int baud;         // 驱动实际采用的波特率
+    SpProfile profile;
+    HANDLE iocp;      // 读完成通知
+    OVERLAPPED ov_rd; // 读请求
+    int rd_timeout;   // 当前 COMMTIMEOUTS 对应的读等待（ms），避免每次都 SetCommTimeouts
 } SerialPort;
 #else
 typedef struct
 {
     int fd;
     char name[128];
-    bool rtscts;
+    atomic_bool rtscts; // 硬件流控开关：sp_set_rtscts 改，发送线程随时读
+    bool async;       // sp_open_async 打开：保持 O_NONBLOCK，用 poll 等数据
+    bool custom_baud; // 非标准波特率（Linux termios2/BOTHER，macOS IOSSIOSPEED）
+    int baud;         // 驱动实际采用的波特率
+    SpProfile profile;
 } SerialPort;
 #endif
 
+#define SP_DEFAULT_BUF (32 * 1024) // 驱动收/发缓冲默认大小
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    // 打开参数（sp_open_ex）
+    typedef struct
+    {
+        int baud;        // 任意正整数；标准值走 cfsetspeed，其余走 termios2/BOTHER 或 IOSSIOSPEED（Windows 直接填 DCB）
+        bool async;      // 事件驱动读取模式（同 sp_open_async）
+        unsigned rx_buf; // 驱动接收缓冲（Windows SetupComm；POSIX 驱动缓冲不可调，忽略）
+        unsigned tx_buf; // 驱动发送缓冲（同上）
+        SpProfile profile; // 读取延迟/吞吐取舍
+    } SpConfig;
+
+    // 默认参数：8N1、同步模式、收发缓冲 SP_DEFAULT_BUF、SP_PROFILE_DEFAULT
+    void sp_default_config(SpConfig *cfg, int baud);
+
+    // 名字 <-> 取值（"default" / "lowlat" / "bulk"）；不认识的名字返回 false
+    const char *sp_profile_name(SpProfile p);
+    bool sp_profile_parse(const char *name, SpProfile *out);
+
+    // 按 cfg 打开；波特率不被驱动接受时失败（sp->baud 为驱动实际采用的值）
+    bool sp_open_ex(SerialPort *sp, const char *name, const SpConfig *cfg);
+
     // 打开串口：name 例子 Windows: "COM3"  Linux: "/dev/ttyUSB0"  macOS: "/dev/tty.usbserial-xxx"
-    // 只支持常见波特率（115200 / 921600 等），8N1，默认不启用硬件流控（可后续 sp_set_rtscts）
+    // 波特率任意（2M / 3M / 12M 等高速适配器也可），8N1，默认不启用硬件流控（可后续 sp_set_rtscts）
     bool sp_open(SerialPort *sp, const char *name, int baud);
 
     // 关闭串口
@@ -38,11 +79,33 @@ extern "C"
     long sp_write(SerialPort *sp, const void *buf, size_t n);
 
     // 读串口（带短超时，通常几十毫秒就返回；返回已读字节数，超时0，错误<0）
+    // 事件驱动模式下不等待：有多少读多少，没有数据立即返回 0
     long sp_read(SerialPort *sp, void *buf, size_t n);
 
+    // 以事件驱动读取模式打开（参数同 sp_open）：
+    // POSIX 用 poll 等待数据到达（VMIN 控制凑够多少字节才唤醒），Windows 用重叠 ReadFile + 完成端口
+    bool sp_open_async(SerialPort *sp, const char *name, int baud);
+
+    // 等数据到达再读：最多等 timeout_ms（<0 一直等），返回已读字节数，超时0，错误<0
+    // 一有数据就返回（或凑够 sp_set_read_batch 设定的字节数）；同步模式下等价于 sp_read
+    long sp_read_wait(SerialPort *sp, void *buf, size_t n, int timeout_ms);
+
+    // 只等数据到达、不读：最多等 timeout_ms（<0 一直等），有数据可读返回 1，超时 0，错误/挂断 <0
+    // 用于先等再取缓冲（如在环上预留空间）的读法；之后用 sp_read 取走已到的数据
+    // POSIX：poll（VMIN 门限下超时后，不足门限的零头也算可读）；Windows 事件驱动模式：WaitCommEvent(EV_RXCHAR)，
+    // 同步模式不支持带超时的等待，直接返回 1（交给 sp_read 自己的短超时）
+    int sp_wait_readable(SerialPort *sp, int timeout_ms);
+
+    // 事件驱动模式的批量唤醒门限（POSIX: VMIN，1..255；超时后不足门限的零头照样读出）
+    // Windows 驱动有数据即完成读请求，此设置无效但返回 true；同步模式返回 false
+    bool sp_set_read_batch(SerialPort *sp, unsigned min_bytes);
+
     // 切换 RTS/CTS 硬件流控
     bool sp_set_rtscts(SerialPort *sp, bool enable);
 
+    // 读 CTS 线状态：1 有效（对端允许发送），0 拉低，-1 不可读（未打开 / 虚拟串口不支持）
+    int sp_get_cts(SerialPort *sp);
+
     // 是否已打开
     bool sp_is_open(const SerialPort *sp);
 
@@ -0,0 +1,450 @@
+#include "sp_group.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
+#define SPG_WAIT_MS 200       // 等待上限，只为周期性检查 run
+#define SPG_DRAIN_ROUNDS 4    // 一次就绪最多连读几轮，避免一个端口霸占线程
+
+static void spg_on_frame(const uint8_t *payload, size_t len, void *user)
+{
+    SpgPort *p = (SpgPort *)user;
+    if (p->grp->cb)
+        p->grp->cb(p, payload, len, p->grp->user);
+}
+
+void spg_init(SpGroup *g, unsigned nthreads, SpgFrameCallback cb, void *user)
+{
+    if (!g)
+        return;
+    memset(g, 0, sizeof(*g));
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > SPG_MAX_THREADS)
+        nthreads = SPG_MAX_THREADS;
+    g->want_threads = nthreads;
+    g->cb = cb;
+    g->user = user;
+    proto_default(&g->proto);
+    atomic_init(&g->run, false);
+}
+
+int spg_add(SpGroup *g, const char *name, int baud)
+{
+    if (!g || !name || g->nports >= SPG_MAX_PORTS || atomic_load(&g->run))
+        return -1;
+    SpgPort *p = &g->ports[g->nports];
+    memset(p, 0, sizeof(*p));
+    if (!rbs_init_mirror(&p->rb, SPG_RB_CAP) && !rbs_init(&p->rb, SPG_RB_CAP))
+    {
+        fprintf(stderr, "port %s: ring buffer init failed\n", name);
+        return -1;
+    }
+    if (!sp_open_async(&p->sp, name, baud))
+    {
+        rbs_free(&p->rb);
+        return -1;
+    }
+    if (g->notify)
+        rbs_set_notify(&p->rb, g->notify);
+    p->grp = g;
+    p->index = (unsigned)g->nports;
+    fp_init(&p->fp, spg_on_frame, p);
+    fp_set_proto(&p->fp, &g->proto);
+    return (int)g->nports++;
+}
+
+/* 生产者侧：把读到的 r 字节记账（full 表示读进的是丢弃缓冲） */
+static void spg_account(SpgPort *p, bool full, long r)
+{
+    if (full)
+        atomic_fetch_add(&p->drop_bytes, (unsigned long)r);
+    else
+        rbs_write_commit(&p->rb, (size_t)r);
+    atomic_fetch_add(&p->rx_bytes, (unsigned long)r);
+}
+
+#ifdef _WIN32
+/* ---------------- Windows：每端口一个在途重叠读，线程等事件 ---------------- */
+
+// 有数据立即完成，没有数据一直挂着（由 spg_stop 的 CancelIoEx 结束）
+static bool spg_arm_timeouts(SpgPort *p)
+{
+    COMMTIMEOUTS to = {0};
+    to.ReadIntervalTimeout = MAXDWORD;
+    to.ReadTotalTimeoutMultiplier = MAXDWORD;
+    to.ReadTotalTimeoutConstant = MAXDWORD - 1;
+    to.WriteTotalTimeoutConstant = 100;
+    if (!SetCommTimeouts(p->sp.h, &to))
+        return false;
+    p->sp.rd_timeout = -1; // 与 sp_read_wait 的缓存保持一致
+    return true;
+}
+
+static bool spg_issue_read(SpgPort *p)
+{
+    RbSpan sp[2];
+    bool full = (rbs_write_reserve(&p->rb, sp) == 0);
+    uint8_t *dst = full ? p->spill : sp[0].ptr;
+    size_t room = full ? sizeof(p->spill) : sp[0].len;
+
+    HANDLE ev = (HANDLE)((ULONG_PTR)p->ov.hEvent & ~(ULONG_PTR)1);
+    memset(&p->ov, 0, sizeof(p->ov));
+    p->ov.hEvent = (HANDLE)((ULONG_PTR)ev | 1);
+    p->pend_room = room;
+    p->pend_spill = full;
+    // 同步完成时事件同样被置位，统一在等待循环里收取结果
+    if (!ReadFile(p->sp.h, dst, (DWORD)room, NULL, &p->ov) && GetLastError() != ERROR_IO_PENDING)
+    {
+        p->pending = false;
+        return false;
+    }
+    p->pending = true;
+    return true;
+}
+
+static DWORD WINAPI spg_worker(LPVOID arg)
+{
+    SpgWorker *w = (SpgWorker *)arg;
+    SpGroup *g = w->grp;
+    SpgPort *mine[MAXIMUM_WAIT_OBJECTS];
+    HANDLE evs[MAXIMUM_WAIT_OBJECTS];
+    DWORD n = 0;
+
+    evs[n] = g->stop_ev;
+    mine[n++] = NULL;
+    for (size_t i = w->index; i < g->nports && n < MAXIMUM_WAIT_OBJECTS; i += g->nthreads)
+    {
+        SpgPort *p = &g->ports[i];
+        HANDLE ev = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (!ev)
+        {
+            atomic_store(&p->failed, true);
+            continue;
+        }
+        p->ov.hEvent = ev;
+        if (!spg_arm_timeouts(p) || !spg_issue_read(p))
+        {
+            atomic_store(&p->failed, true);
+            CloseHandle(ev);
+            p->ov.hEvent = NULL;
+            continue;
+        }
+        evs[n] = ev;
+        mine[n++] = p;
+    }
+
+    while (atomic_load(&g->run) && n > 1)
+    {
+        DWORD rc = WaitForMultipleObjects(n, evs, FALSE, SPG_WAIT_MS);
+        if (rc == WAIT_TIMEOUT || rc == WAIT_OBJECT_0)
+            continue;
+        if (rc < WAIT_OBJECT_0 + 1 || rc >= WAIT_OBJECT_0 + n)
+            break;
+        DWORD k = rc - WAIT_OBJECT_0;
+        SpgPort *p = mine[k];
+        DWORD got = 0;
+        bool ok = GetOverlappedResult(p->sp.h, &p->ov, &got, FALSE) != 0;
+        p->pending = false;
+        if (ok && got > 0)
+            spg_account(p, p->pend_spill, (long)got);
+        if (!ok || !spg_issue_read(p))
+        {
+            // 设备断开：摘掉这个端口，剩下的继续服务
+            atomic_store(&p->failed, true);
+            CloseHandle(evs[k]);
+            p->ov.hEvent = NULL;
+            evs[k] = evs[n - 1];
+            mine[k] = mine[n - 1];
+            --n;
+        }
+    }
+
+    // 退出前收回在途请求，缓冲（环内存）之后才能释放
+    for (DWORD k = 1; k < n; ++k)
+    {
+        SpgPort *p = mine[k];
+        if (p->pending)
+        {
+            DWORD got = 0;
+            CancelIoEx(p->sp.h, &p->ov);
+            GetOverlappedResult(p->sp.h, &p->ov, &got, TRUE);
+            p->pending = false;
+        }
+        CloseHandle(evs[k]);
+        p->ov.hEvent = NULL;
+    }
+    return 0;
+}
+
+#else
+/* ---------------- POSIX：就绪后非阻塞地把驱动缓冲读空 ---------------- */
+
+// 返回 false 表示端口已失效
+static bool spg_drain(SpgPort *p)
+{
+    uint8_t spill[4096];
+    for (int round = 0; round < SPG_DRAIN_ROUNDS; ++round)
+    {
+        RbSpan sp[2];
+        bool full = (rbs_write_reserve(&p->rb, sp) == 0);
+        uint8_t *dst = full ? spill : sp[0].ptr;
+        size_t room = full ? sizeof(spill) : sp[0].len;
+        long r = sp_read(&p->sp, dst, room); // async 模式：不等待
+        if (r < 0)
+            return false;
+        if (r == 0)
+            break;
+        spg_account(p, full, r);
+        if ((size_t)r < room)
+            break; // 驱动缓冲已读空
+    }
+    return true;
+}
+
+#if defined(__linux__)
+static void *spg_worker(void *arg)
+{
+    SpgWorker *w = (SpgWorker *)arg;
+    SpGroup *g = w->grp;
+    size_t live = 0;
+    for (size_t i = w->index; i < g->nports; i += g->nthreads)
+    {
+        struct epoll_event ev = {0};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &g->ports[i];
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, g->ports[i].sp.fd, &ev) == 0)
+            ++live;
+        else
+            atomic_store(&g->ports[i].failed, true);
+    }
+
+    struct epoll_event evs[SPG_MAX_PORTS];
+    while (atomic_load(&g->run) && live > 0)
+    {
+        int n = epoll_wait(w->epfd, evs, SPG_MAX_PORTS, SPG_WAIT_MS);
+        for (int k = 0; k < n; ++k)
+        {
+            SpgPort *p = (SpgPort *)evs[k].data.ptr;
+            bool ok = true;
+            if (evs[k].events & EPOLLIN)
+                ok = spg_drain(p);
+            // 挂断时 EPOLLIN 也一直置位（read 返回 0），先把剩余数据读走再摘掉
+            if (evs[k].events & (EPOLLERR | EPOLLHUP))
+                ok = false;
+            if (!ok)
+            {
+                // 设备断开：摘掉这个端口，避免电平触发的 HUP 空转
+                epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->sp.fd, NULL);
+                atomic_store(&p->failed, true);
+                --live;
+            }
+        }
+    }
+    return NULL;
+}
+#else
+static void *spg_worker(void *arg)
+{
+    SpgWorker *w = (SpgWorker *)arg;
+    SpGroup *g = w->grp;
+    struct pollfd pfd[SPG_MAX_PORTS];
+    SpgPort *mine[SPG_MAX_PORTS];
+    nfds_t n = 0;
+    for (size_t i = w->index; i < g->nports; i += g->nthreads)
+    {
+        pfd[n].fd = g->ports[i].sp.fd;
+        pfd[n].events = POLLIN;
+        mine[n++] = &g->ports[i];
+    }
+
+    while (atomic_load(&g->run) && n > 0)
+    {
+        int rc = poll(pfd, n, SPG_WAIT_MS);
+        if (rc <= 0)
+            continue;
+        for (nfds_t k = 0; k < n;)
+        {
+            short re = pfd[k].revents;
+            bool ok = true;
+            if (re & POLLIN)
+                ok = spg_drain(mine[k]);
+            if (re & (POLLERR | POLLHUP | POLLNVAL))
+                ok = false;
+            if (!ok)
+            {
+                atomic_store(&mine[k]->failed, true);
+                pfd[k] = pfd[n - 1];
+                mine[k] = mine[n - 1];
+                --n;
+                continue;
+            }
+            ++k;
+        }
+    }
+    return NULL;
+}
+#endif
+#endif
+
+bool spg_start(SpGroup *g)
+{
+    if (!g || g->nports == 0 || atomic_load(&g->run))
+        return false;
+    unsigned k = g->want_threads;
+    if (k > g->nports)
+        k = (unsigned)g->nports;
+#ifdef _WIN32
+    // 每线程最多等 MAXIMUM_WAIT_OBJECTS-1 个端口（一个槽留给 stop_ev）
+    while (k < SPG_MAX_THREADS && (g->nports + k - 1) / k > MAXIMUM_WAIT_OBJECTS - 1)
+        ++k;
+    g->stop_ev = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!g->stop_ev)
+        return false;
+#endif
+    g->nthreads = k;
+    for (unsigned t = 0; t < k; ++t)
+    {
+        g->workers[t].started = false;
+#ifndef _WIN32
+        g->workers[t].epfd = -1;
+#endif
+    }
+    atomic_store(&g->run, true);
+
+    for (unsigned t = 0; t < k; ++t)
+    {
+        SpgWorker *w = &g->workers[t];
+        w->grp = g;
+        w->index = t;
+#ifdef _WIN32
+        w->th = CreateThread(NULL, 0, spg_worker, w, 0, NULL);
+        w->started = (w->th != NULL);
+#else
+#if defined(__linux__)
+        w->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (w->epfd < 0)
+            break;
+#endif
+        w->started = (pthread_create(&w->th, NULL, spg_worker, w) == 0);
+#endif
+        if (!w->started)
+            break;
+    }
+    if (!g->workers[k - 1].started)
+    {
+        fprintf(stderr, "spg_start: thread setup failed\n");
+        spg_stop(g);
+        return false;
+    }
+    return true;
+}
+
+void spg_stop(SpGroup *g)
+{
+    if (!g)
+        return;
+    atomic_store(&g->run, false);
+#ifdef _WIN32
+    if (g->stop_ev)
+        SetEvent(g->stop_ev);
+#endif
+    for (unsigned t = 0; t < g->nthreads; ++t)
+    {
+        SpgWorker *w = &g->workers[t];
+        if (w->started)
+        {
+#ifdef _WIN32
+            WaitForSingleObject(w->th, INFINITE);
+            CloseHandle(w->th);
+#else
+            pthread_join(w->th, NULL);
+#endif
+            w->started = false;
+        }
+#if defined(__linux__)
+        if (w->epfd >= 0)
+            close(w->epfd);
+        w->epfd = -1;
+#endif
+    }
+#ifdef _WIN32
+    if (g->stop_ev)
+        CloseHandle(g->stop_ev);
+    g->stop_ev = NULL;
+#endif
+    for (size_t i = 0; i < g->nports; ++i)
+    {
+        sp_close(&g->ports[i].sp);
+        rbs_free(&g->ports[i].rb);
+    }
+    g->nports = 0;
+    g->nthreads = 0;
+}
+
+void spg_set_notify(SpGroup *g, RbEvent *ev)
+{
+    if (g)
+        g->notify = ev;
+}
+
+bool spg_set_proto(SpGroup *g, const ProtoDesc *d)
+{
+    if (!g || !proto_valid(d))
+        return false;
+    g->proto = *d;
+    return true;
+}
+
+size_t spg_pending(const SpGroup *g)
+{
+    size_t n = 0;
+    for (size_t i = 0; g && i < g->nports; ++i)
+        n += rbs_size(&g->ports[i].rb);
+    return n;
+}
+
+size_t spg_service(SpGroup *g, size_t max_bytes)
+{
+    if (!g)
+        return 0;
+    size_t total = 0;
+    for (size_t i = 0; i < g->nports; ++i)
+    {
+        SpgPort *p = &g->ports[i];
+        size_t budget = max_bytes ? max_bytes : (size_t)-1;
+        RbSpan sp[2];
+        size_t used = 0;
+        while (budget > 0 && (used = rbs_read_peek_spans(&p->rb, sp)) > 0)
+        {
+            size_t take = used < budget ? used : budget;
+            size_t a = sp[0].len < take ? sp[0].len : take;
+            fp_feed(&p->fp, sp[0].ptr, a);
+            if (take > a)
+                fp_feed(&p->fp, sp[1].ptr, take - a);
+            rbs_read_consume(&p->rb, take);
+            budget -= take;
+            total += take;
+        }
+        atomic_store(&p->frames, (unsigned long)p->fp.frames);
+        atomic_store(&p->chk_fail, (unsigned long)p->fp.chk_fail);
+        atomic_store(&p->noise_bytes, (unsigned long)p->fp.noise_bytes);
+    }
+    return total;
+}
+
+size_t spg_count(const SpGroup *g)
+{
+    return g ? g->nports : 0;
+}
+
+const SpgPort *spg_port(const SpGroup *g, size_t i)
+{
+    return (g && i < g->nports) ? &g->ports[i] : NULL;
+}
@@ -0,0 +1,132 @@
+#ifndef SP_GROUP_H
+#define SP_GROUP_H
+
+// 多串口复用：少量 I/O 线程服务 N 个串口（测试架上一台主机 16~32 个 USB 串口）
+//
+// - 每个端口有自己的 SerialPort / SPSC 环 / 帧解析器 / 统计
+// - 端口按下标轮流分给 K 个 I/O 线程（端口 i -> 线程 i % K），线程数不随端口数增长
+// - I/O 线程用就绪通知等数据：Linux epoll，其他 POSIX poll，Windows 重叠读 + WaitForMultipleObjects
+// - I/O 线程是各端口环的唯一生产者；spg_service 的调用者（通常是 printer 线程）是唯一消费者
+// - 环满时与单端口版一致：丢弃新数据并计数，I/O 线程永不等待消费者
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../ringbuf/ringbuf_spsc.h"
+#include "serial_port.h"
+#include "frame_parser.h"
+
+#define SPG_MAX_PORTS 64
+#define SPG_MAX_THREADS 8
+#define SPG_RB_CAP (64 * 1024) // 每端口环容量，与单端口的 g_rb 一致
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    struct SpGroup;
+    struct SpgPort;
+
+    // 收到完整帧（在 spg_service 的调用线程里回调；payload 只在回调内有效）
+    typedef void (*SpgFrameCallback)(const struct SpgPort *port, const uint8_t *payload, size_t len, void *user);
+
+    typedef struct SpgPort
+    {
+        SerialPort sp;
+        RingBufSpsc rb;
+        FrameParser fp;      // 只由消费者使用
+        struct SpGroup *grp; // 回指，帧回调用
+        unsigned index;      // 在组里的下标
+
+        // 生产者（I/O 线程）写
+        atomic_ulong rx_bytes;
+        atomic_ulong drop_bytes; // 环满丢弃
+        atomic_bool failed;      // 读出错 / 设备断开，已停止服务
+
+        // 消费者从 fp 发布，供命令线程读
+        atomic_ulong frames;
+        atomic_ulong chk_fail;
+        atomic_ulong noise_bytes;
+
+#ifdef _WIN32
+        OVERLAPPED ov;     // 在途读请求（事件句柄低位置 1，不投递完成端口）
+        size_t pend_room;  // 在途请求的缓冲长度
+        bool pend_spill;   // 在途请求读进的是丢弃缓冲
+        bool pending;      // 有在途请求
+        uint8_t spill[4096];
+#endif
+    } SpgPort;
+
+    typedef struct SpgWorker
+    {
+        struct SpGroup *grp;
+        unsigned index;
+#ifdef _WIN32
+        HANDLE th;
+#else
+        pthread_t th;
+        int epfd; // Linux: 本线程的 epoll 实例；其他平台不用
+#endif
+        bool started;
+    } SpgWorker;
+
+    typedef struct SpGroup
+    {
+        SpgPort ports[SPG_MAX_PORTS];
+        size_t nports;
+        SpgWorker workers[SPG_MAX_THREADS];
+        unsigned nthreads; // 实际启动的 I/O 线程数
+        unsigned want_threads;
+        atomic_bool run;
+#ifdef _WIN32
+        HANDLE stop_ev; // spg_stop 用来唤醒 WaitForMultipleObjects
+#endif
+        SpgFrameCallback cb;
+        void *user;
+        RbEvent *notify; // 非 NULL 时各端口环发布数据都通知它（见 spg_set_notify）
+        ProtoDesc proto; // 之后 spg_add 的端口用的帧协议（默认 AA55，见 spg_set_proto）
+    } SpGroup;
+
+    // 初始化空组：nthreads 为 I/O 线程上限（1..SPG_MAX_THREADS），cb 可为 NULL（只统计）
+    void spg_init(SpGroup *g, unsigned nthreads, SpgFrameCallback cb, void *user);
+
+    // 打开一个端口加入组（必须在 spg_start 之前）；返回端口下标，失败 -1
+    int spg_add(SpGroup *g, const char *name, int baud);
+
+    // 启动 I/O 线程（线程数 = min(nthreads, 端口数)）
+    bool spg_start(SpGroup *g);
+
+    // 停止 I/O 线程并关闭所有端口、释放环；调用时不得有线程正在 spg_service
+    void spg_stop(SpGroup *g);
+
+    // 让之后 spg_add 的端口环都通知 ev（消费者可以和其它环一起睡在同一个事件上）
+    void spg_set_notify(SpGroup *g, RbEvent *ev);
+
+    // 让之后 spg_add 的端口都按 d 解析（描述不合法返回 false）
+    bool spg_set_proto(SpGroup *g, const ProtoDesc *d);
+
+    // 消费者：所有端口环里待处理的字节数
+    size_t spg_pending(const SpGroup *g);
+
+    // 消费者：把每个端口环里的数据喂给各自的解析器，每端口最多 max_bytes（0 不限）
+    // 返回本次消费的总字节数（0 表示所有端口都没有新数据）
+    size_t spg_service(SpGroup *g, size_t max_bytes);
+
+    // 端口数 / 第 i 个端口（统计字段可从任意线程原子读取）
+    size_t spg_count(const SpGroup *g);
+    const SpgPort *spg_port(const SpGroup *g, size_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_GROUP_H
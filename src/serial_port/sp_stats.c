@@ -0,0 +1,329 @@
+#include "sp_stats.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+#include "../ringbuf/ringbuf_wait.h" // rb_ev_now_ns / rb_ev_sleep_ms
+
+#define SPS_EXPORT_POLL_MS 100 // 导出线程最多睡这么久（只为检查 run）
+
+/* ---------------- 时钟 ---------------- */
+uint64_t sps_wall_ms(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* ---------------- 直方图 ---------------- */
+
+// 最高置位（v != 0）
+static unsigned sph_msb(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return (unsigned)i;
+#elif defined(__GNUC__)
+    return 63u - (unsigned)__builtin_clzll(v);
+#else
+    unsigned n = 0;
+    while (v >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+// 值 -> 格：[0, SUB) 一格一个；msb = k 时取 k 之后的 SPH_SUB_BITS 位作格内下标
+static unsigned sph_index(uint64_t v)
+{
+    if (v < SPH_SUB)
+        return (unsigned)v;
+    unsigned msb = sph_msb(v);
+    if (msb >= SPH_MAX_EXP)
+        return SPH_BUCKETS - 1;
+    unsigned g = msb - SPH_SUB_BITS + 1;
+    return g * SPH_SUB + (unsigned)(v >> (msb - SPH_SUB_BITS)) - SPH_SUB;
+}
+
+// 格 -> 格内最大值
+static uint64_t sph_upper(unsigned i)
+{
+    unsigned g = i / SPH_SUB, sub = i % SPH_SUB;
+    if (g == 0)
+        return i;
+    uint64_t lower = (uint64_t)(SPH_SUB + sub) << (g - 1);
+    return lower + ((uint64_t)1 << (g - 1)) - 1;
+}
+
+void sph_record(SpHist *h, uint64_t v)
+{
+    sps_add(&h->b[sph_index(v)], 1);
+    sps_add(&h->count, 1);
+    sps_add(&h->sum, v);
+    if (v > sps_get(&h->max))
+        sps_set(&h->max, v);
+}
+
+void sph_clear(SpHist *h)
+{
+    for (unsigned i = 0; i < SPH_BUCKETS; ++i)
+        sps_set(&h->b[i], 0);
+    sps_set(&h->count, 0);
+    sps_set(&h->sum, 0);
+    sps_set(&h->max, 0);
+}
+
+void sph_snapshot(const SpHist *h, SpHistSnap *out)
+{
+    // count 按格求和，保证分位数与各格一致（写者可能正在两次 store 之间）
+    uint64_t n = 0;
+    for (unsigned i = 0; i < SPH_BUCKETS; ++i)
+        n += out->b[i] = sps_get(&h->b[i]);
+    out->count = n;
+    out->sum = sps_get(&h->sum);
+    out->max = sps_get(&h->max);
+}
+
+void sph_delta(SpHistSnap *d, const SpHistSnap *now, const SpHistSnap *prev)
+{
+    uint64_t n = 0, top = 0;
+    for (unsigned i = 0; i < SPH_BUCKETS; ++i)
+    {
+        d->b[i] = now->b[i] - prev->b[i];
+        n += d->b[i];
+        if (d->b[i])
+            top = sph_upper(i);
+    }
+    d->count = n;
+    d->sum = now->sum - prev->sum;
+    d->max = top < now->max ? top : now->max;
+}
+
+uint64_t sph_pct(const SpHistSnap *s, double pct)
+{
+    if (!s->count)
+        return 0;
+    uint64_t rank = (uint64_t)(pct * (double)s->count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t acc = 0;
+    for (unsigned i = 0; i < SPH_BUCKETS; ++i)
+    {
+        acc += s->b[i];
+        if (acc >= rank)
+        {
+            uint64_t up = sph_upper(i);
+            return up < s->max ? up : s->max;
+        }
+    }
+    return s->max;
+}
+
+double sph_mean(const SpHistSnap *s) { return s->count ? (double)s->sum / (double)s->count : 0.0; }
+
+void sph_write_json(FILE *f, const char *name, const SpHistSnap *s, double scale)
+{
+    fprintf(f, ",\"%s\":{\"n\":%llu,\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}",
+            name, (unsigned long long)s->count, sph_mean(s) / scale, (double)sph_pct(s, 0.50) / scale,
+            (double)sph_pct(s, 0.90) / scale, (double)sph_pct(s, 0.99) / scale, (double)sph_pct(s, 0.999) / scale,
+            (double)s->max / scale);
+}
+
+void sph_write_csv_header(FILE *f, const char *name)
+{
+    fprintf(f, ",%s_n,%s_mean,%s_p50,%s_p90,%s_p99,%s_p999,%s_max", name, name, name, name, name, name, name);
+}
+
+void sph_write_csv(FILE *f, const SpHistSnap *s, double scale)
+{
+    fprintf(f, ",%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f", (unsigned long long)s->count, sph_mean(s) / scale,
+            (double)sph_pct(s, 0.50) / scale, (double)sph_pct(s, 0.90) / scale, (double)sph_pct(s, 0.99) / scale,
+            (double)sph_pct(s, 0.999) / scale, (double)s->max / scale);
+}
+
+/* ---------------- 接收链路 ---------------- */
+
+void sps_init(SpStats *s)
+{
+    memset(s, 0, sizeof(*s));
+    sps_marks_init(&s->marks);
+    s->t0 = rb_ev_now_ns();
+}
+
+static void sps_rx(SpsReader *rd, size_t n)
+{
+    sps_add(&rd->rx_bytes, n);
+    sps_add(&rd->reads, 1);
+    sph_record(&rd->read_size, n);
+}
+
+void sps_rx_commit(SpStats *s, size_t n, size_t ring_used)
+{
+    SpsReader *rd = &s->rd;
+    sps_rx(rd, n);
+    rd->pos += n;
+    if (ring_used > sps_get(&rd->ring_hwm))
+        sps_set(&rd->ring_hwm, ring_used);
+    SpsMark *m = sps_marks_reserve(&s->marks);
+    if (!m)
+    {
+        sps_add(&rd->mark_drops, 1);
+        return;
+    }
+    m->end = rd->pos;
+    m->t_ns = rb_ev_now_ns();
+    sps_marks_commit(&s->marks);
+}
+
+void sps_rx_drop(SpStats *s, size_t n)
+{
+    sps_rx(&s->rd, n);
+    sps_add(&s->rd.drop_bytes, n);
+}
+
+void sps_rx_error(SpStats *s) { sps_add(&s->rd.read_errors, 1); }
+
+// printer：丢掉 end <= pos 的标记（那次提交的数据已全部消费）
+static void sps_retire(SpStats *s, uint64_t pos)
+{
+    const SpsMark *m;
+    while ((m = sps_marks_front(&s->marks)) != NULL && m->end <= pos)
+        sps_marks_release(&s->marks, 1);
+}
+
+void sps_batch(SpStats *s, size_t avail, uint64_t fed)
+{
+    SpsParser *pr = &s->pr;
+    pr->feed_pos = pr->pos;
+    pr->feed_bytes = fed;
+    sps_add(&pr->batches, 1);
+    sph_record(&pr->lag_bytes, avail);
+    // 最早未消费的字节在 pos，含它的是第一个 end > pos 的提交
+    sps_retire(s, pr->pos);
+    const SpsMark *m = sps_marks_front(&s->marks);
+    if (avail && m)
+        sph_record(&pr->lag_ns, rb_ev_now_ns() - m->t_ns);
+}
+
+void sps_frame(SpStats *s, uint64_t end_fed)
+{
+    SpsParser *pr = &s->pr;
+    if (end_fed < pr->feed_bytes)
+        return; // 帧尾在本批之前（解析器保留的尾巴里），不记
+    // 帧尾字节在流位置 end - 1，属于第一个 end >= 帧尾位置 的提交；之前的标记后面的帧也用不到了
+    uint64_t end = pr->feed_pos + (end_fed - pr->feed_bytes);
+    const SpsMark *m;
+    while ((m = sps_marks_front(&s->marks)) != NULL && m->end < end)
+        sps_marks_release(&s->marks, 1);
+    if (m)
+        sph_record(&pr->parse_ns, rb_ev_now_ns() - m->t_ns);
+}
+
+void sps_consume(SpStats *s, size_t n)
+{
+    s->pr.pos += n;
+    sps_retire(s, s->pr.pos);
+}
+
+void sps_skip(SpStats *s, size_t n)
+{
+    sps_add(&s->pr.skip_bytes, n);
+    sps_consume(s, n);
+}
+
+/* ---------------- 周期导出 ---------------- */
+
+static void sps_export_line(SpsExport *e, bool first)
+{
+    e->emit(e->f, e->csv, first, e->user);
+    fflush(e->f);
+    atomic_fetch_add(&e->lines, 1);
+}
+
+static void sps_export_run(SpsExport *e)
+{
+    uint64_t step = (uint64_t)e->interval_ms * 1000000u;
+    uint64_t next = rb_ev_now_ns() + step;
+    sps_export_line(e, true);
+    while (atomic_load(&e->run))
+    {
+        uint64_t now = rb_ev_now_ns();
+        if (now < next)
+        {
+            uint64_t ms = (next - now) / 1000000u + 1;
+            rb_ev_sleep_ms(ms < SPS_EXPORT_POLL_MS ? (unsigned)ms : SPS_EXPORT_POLL_MS);
+            continue;
+        }
+        next += step;
+        if (next <= now)
+            next = now + step; // 落后太多（机器挂起过）就不补行
+        sps_export_line(e, false);
+    }
+    sps_export_line(e, false); // 停止前的最后一个区间
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sps_export_thread(LPVOID arg)
+{
+    sps_export_run((SpsExport *)arg);
+    return 0;
+}
+#else
+static void *sps_export_thread(void *arg)
+{
+    sps_export_run((SpsExport *)arg);
+    return NULL;
+}
+#endif
+
+bool sps_export_start(SpsExport *e, const char *path, unsigned interval_ms, bool csv, SpsEmitFn emit,
+                      void *user)
+{
+    if (!e || !path || !*path || !interval_ms || !emit || strlen(path) >= sizeof(e->path))
+        return false;
+    memset(e, 0, sizeof(*e));
+    e->f = fopen(path, "a");
+    if (!e->f)
+        return false;
+    strcpy(e->path, path);
+    e->csv = csv;
+    e->interval_ms = interval_ms;
+    e->emit = emit;
+    e->user = user;
+    atomic_store(&e->run, true);
+#ifdef _WIN32
+    e->th = CreateThread(NULL, 0, sps_export_thread, e, 0, NULL);
+    e->started = (e->th != NULL);
+#else
+    e->started = (pthread_create(&e->th, NULL, sps_export_thread, e) == 0);
+#endif
+    if (!e->started)
+    {
+        fclose(e->f);
+        e->f = NULL;
+        return false;
+    }
+    return true;
+}
+
+void sps_export_stop(SpsExport *e)
+{
+    if (!e || !e->started)
+        return;
+    atomic_store(&e->run, false);
+#ifdef _WIN32
+    WaitForSingleObject(e->th, INFINITE);
+    CloseHandle(e->th);
+#else
+    pthread_join(e->th, NULL);
+#endif
+    e->started = false;
+    fclose(e->f);
+    e->f = NULL;
+}
+
+bool sps_export_running(const SpsExport *e) { return e && e->started; }
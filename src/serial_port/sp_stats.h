@@ -0,0 +1,209 @@
+#ifndef SP_STATS_H
+#define SP_STATS_H
+
+// 运行时统计：按线程分块、按缓存行对齐的计数器 + HDR 式直方图，热路径上没有原子读改写
+//
+// - 每个写线程一块（SpsReader 归 reader，SpsParser 归 printer），块首对齐到缓存行，两块互不共享缓存行
+// - 单写者：写线程用 relaxed load + store 更新（普通的读写指令，没有 lock 前缀），任意线程 relaxed 读；
+//   读到的是“最近某一刻”的值，不同字段之间不保证是同一瞬间
+// - 直方图 SpHist：对数-线性分桶，小于 SPH_SUB 的值一格一个，之后每个 [2^k, 2^(k+1)) 再等分 SPH_SUB 格，
+//   相对误差 < 1/SPH_SUB；覆盖 0 ~ 2^SPH_MAX_EXP，更大的记进最后一格
+// - 解析延迟：reader 每次提交进环时记一个标记 {提交后的流位置, 时刻}（同 tx_queue 的消息标记），
+//   printer 交付一帧时找到含帧尾字节的那次提交，延迟 = 交付时刻 - 该提交时刻
+// - 消费滞后：printer 每开始一批，记环内待消费字节，以及最早未消费数据进环后已等了多久
+// - 导出：sps_export_start 起一个线程，每 interval_ms 调一次 emit 回调往文件写一行（JSON lines 或 CSV）；
+//   直方图按区间（两次快照之差）导出，便于画图
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../ringbuf/ringbuf_typed.h"
+
+#define SPS_CACHELINE 64
+#define SPS_ALIGNED _Alignas(SPS_CACHELINE)
+#define SPH_SUB_BITS 4                // 每个 2 的幂区间等分 16 格（相对误差 < 6.25%）
+#define SPH_SUB (1u << SPH_SUB_BITS)
+#define SPH_MAX_EXP 40                // 上限 2^40：按 ns 约 18 分钟，按字节 1 TiB
+#define SPH_BUCKETS ((SPH_MAX_EXP - SPH_SUB_BITS + 1) * SPH_SUB)
+#define SPS_MAX_MARKS 8192            // 在途的提交标记（满了不记，延迟样本会偏小或缺失）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // 直方图：单线程写，任意线程读
+    typedef struct
+    {
+        atomic_ullong count;
+        atomic_ullong sum;
+        atomic_ullong max;
+        atomic_ullong b[SPH_BUCKETS];
+    } SpHist;
+
+    // 直方图快照（普通内存，可相减得到区间直方图）
+    typedef struct
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max; // 区间快照里是最高非空格的上界（不超过总的 max）
+        uint64_t b[SPH_BUCKETS];
+    } SpHistSnap;
+
+    // reader 线程写
+    typedef struct
+    {
+        SPS_ALIGNED atomic_ullong rx_bytes; // 读到的字节（含环满丢弃的）
+        atomic_ullong reads;                // 读到数据的 read 调用
+        atomic_ullong read_errors;
+        atomic_ullong drop_bytes; // 环满丢弃
+        atomic_ullong ring_hwm;   // 提交后环内字节的最大值（高水位）
+        atomic_ullong mark_drops; // 标记环满没记上的提交
+        uint64_t pos;             // 已提交进环的字节（只由 reader 读写）
+        SpHist read_size;         // 每次 read 返回的字节数
+    } SpsReader;
+
+    // printer 线程写
+    typedef struct
+    {
+        SPS_ALIGNED atomic_ullong frames; // 以下四项从解析器发布
+        atomic_ullong chk_fail;
+        atomic_ullong noise_bytes; // 找帧头时丢弃的字节
+        atomic_ullong oversize;
+        atomic_ullong skip_bytes; // 不展示时从环里丢弃的最旧数据
+        atomic_ullong batches;    // 从环里取数据的批次
+        uint64_t pos;             // 已消费（含丢弃）的字节（只由 printer 读写）
+        uint64_t feed_pos;        // 本批开始时的 pos
+        uint64_t feed_bytes;      // 本批开始时解析器已收的字节，帧尾位置据此换算成环的流位置
+        SpHist parse_ns;          // 帧尾进环 -> 交付
+        SpHist lag_ns;            // 每批开始时最早未消费数据已等待的时间
+        SpHist lag_bytes;         // 每批开始时环内待消费字节
+    } SpsParser;
+
+    typedef struct
+    {
+        uint64_t end;  // 这次提交之后的流位置
+        uint64_t t_ns; // 提交时刻
+    } SpsMark;
+
+    RB_TYPED_SPSC_DEFINE(SpsMarkRing, sps_marks, SpsMark, SPS_MAX_MARKS)
+
+    typedef struct
+    {
+        SpsReader rd;
+        SpsParser pr;
+        SpsMarkRing marks; // reader 生产，printer 消费
+        uint64_t t0;       // sps_init 的时刻（ns）
+    } SpStats;
+
+    // 单独占一条缓存行的计数器（给只收 atomic_ulong * 的接口用，如 txq_start 的 total_tx）
+    typedef struct
+    {
+        SPS_ALIGNED atomic_ulong v;
+    } SpsLine;
+
+    // 单写者更新 / 任意线程读
+    static inline void sps_add(atomic_ullong *c, uint64_t n)
+    {
+        atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+    }
+    static inline void sps_set(atomic_ullong *c, uint64_t v) { atomic_store_explicit(c, v, memory_order_relaxed); }
+    static inline uint64_t sps_get(const atomic_ullong *c)
+    {
+        return atomic_load_explicit((atomic_ullong *)c, memory_order_relaxed);
+    }
+
+    /* ---------------- 直方图 ---------------- */
+
+    // 单写者记一个值
+    void sph_record(SpHist *h, uint64_t v);
+
+    // 清零（写者不在记录时调用；读者可以同时读）
+    void sph_clear(SpHist *h);
+
+    // 任意线程：拷一份快照
+    void sph_snapshot(const SpHist *h, SpHistSnap *out);
+
+    // d = now - prev（区间直方图）
+    void sph_delta(SpHistSnap *d, const SpHistSnap *now, const SpHistSnap *prev);
+
+    // 分位数（0~1）：返回所在格的上界（不超过 max），没有样本返回 0
+    uint64_t sph_pct(const SpHistSnap *s, double pct);
+
+    double sph_mean(const SpHistSnap *s);
+
+    // 导出辅助：值统一除以 scale（如 ns -> us 传 1000）
+    // JSON：,"name":{"n":..,"mean":..,"p50":..,"p90":..,"p99":..,"p999":..,"max":..}
+    void sph_write_json(FILE *f, const char *name, const SpHistSnap *s, double scale);
+    // CSV：表头 ,name_n,name_mean,...；数据 ,n,mean,...
+    void sph_write_csv_header(FILE *f, const char *name);
+    void sph_write_csv(FILE *f, const SpHistSnap *s, double scale);
+
+    /* ---------------- 接收链路 ---------------- */
+
+    // 清零（reader / printer 都未运行时调用）
+    void sps_init(SpStats *s);
+
+    // reader：读到 n 字节、即将提交进环（在 rbs_write_commit 之前调用，ring_used 为提交后环内字节）/
+    //         环满丢弃 / 读出错
+    void sps_rx_commit(SpStats *s, size_t n, size_t ring_used);
+    void sps_rx_drop(SpStats *s, size_t n);
+    void sps_rx_error(SpStats *s);
+
+    // printer：开始一批（avail = 环内可读字节，fed = 解析器已收字节，非解析模式传 0）
+    void sps_batch(SpStats *s, size_t avail, uint64_t fed);
+    // printer：解析器交付一帧（end_fed = 帧尾在解析器字节流里的位置，即 FrameParser.end_pos）
+    void sps_frame(SpStats *s, uint64_t end_fed);
+    // printer：从环里消费了 n 字节 / 不展示时丢弃了 n 字节
+    void sps_consume(SpStats *s, size_t n);
+    void sps_skip(SpStats *s, size_t n);
+
+    // 墙上时钟（Unix 毫秒，导出时间戳用）；单调时钟用 rb_ev_now_ns（ringbuf_wait.h），标记时刻即取自它
+    uint64_t sps_wall_ms(void);
+
+    /* ---------------- 周期导出 ---------------- */
+
+    // first 为 true 时是本次导出的第一行：CSV 先写表头；回调应重置自己的区间基线
+    typedef void (*SpsEmitFn)(FILE *f, bool csv, bool first, void *user);
+
+    typedef struct
+    {
+        FILE *f;
+        char path[256];
+        bool csv;
+        unsigned interval_ms;
+        SpsEmitFn emit;
+        void *user;
+        atomic_bool run;
+        bool started;
+        atomic_ulong lines; // 已写出的行
+#ifdef _WIN32
+        HANDLE th;
+#else
+        pthread_t th;
+#endif
+    } SpsExport;
+
+    // 以追加方式打开 path，起线程每 interval_ms 调一次 emit 并刷盘
+    bool sps_export_start(SpsExport *e, const char *path, unsigned interval_ms, bool csv, SpsEmitFn emit,
+                          void *user);
+
+    // 停线程（退出前再写一行），关文件；可重复调用
+    void sps_export_stop(SpsExport *e);
+
+    bool sps_export_running(const SpsExport *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_STATS_H
@@ -0,0 +1,198 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np、sched_getcpu
+#endif
+#include "sp_thread.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+static void spt_err(char *err, size_t errlen, const char *msg)
+{
+    if (err && errlen)
+        snprintf(err, errlen, "%s", msg);
+}
+
+void spt_default_config(SptConfig *cfg)
+{
+    if (!cfg)
+        return;
+    cfg->cpu = -1;
+    cfg->prio = SPT_NORMAL;
+    cfg->rt_prio = 0;
+}
+
+/* ---------------- 平台相关 ---------------- */
+#ifdef _WIN32
+int spt_cpu_count(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+}
+
+int spt_current_cpu(void) { return (int)GetCurrentProcessorNumber(); }
+
+static bool spt_set_affinity(SptThread th, int cpu, char *err, size_t errlen)
+{
+    DWORD_PTR mask, proc, sys;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys))
+    {
+        spt_err(err, errlen, "GetProcessAffinityMask 失败");
+        return false;
+    }
+    if (cpu < 0)
+        mask = proc; // 撤销绑核：回到进程允许的全部 CPU
+    else if (cpu >= (int)(sizeof(DWORD_PTR) * 8) || !(proc & ((DWORD_PTR)1 << cpu)))
+    {
+        // 超过 64 个逻辑 CPU 的机器还有处理器组，这里只处理进程所在的组
+        spt_err(err, errlen, "CPU 不存在或不在进程的亲和掩码里");
+        return false;
+    }
+    else
+        mask = (DWORD_PTR)1 << cpu;
+    if (SetThreadAffinityMask(th, mask) == 0)
+    {
+        spt_err(err, errlen, "SetThreadAffinityMask 失败");
+        return false;
+    }
+    return true;
+}
+
+static bool spt_set_prio(SptThread th, const SptConfig *cfg, char *err, size_t errlen)
+{
+    int p = cfg->prio == SPT_REALTIME ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL;
+    if (!SetThreadPriority(th, p))
+    {
+        spt_err(err, errlen, "SetThreadPriority 失败");
+        return false;
+    }
+    return true;
+}
+
+bool spt_apply_self(const SptConfig *cfg, char *err, size_t errlen)
+{
+    return spt_apply(GetCurrentThread(), cfg, err, errlen);
+}
+#else
+int spt_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+int spt_current_cpu(void)
+{
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+static bool spt_set_affinity(SptThread th, int cpu, char *err, size_t errlen)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= CPU_SETSIZE)
+    {
+        spt_err(err, errlen, "CPU 编号太大");
+        return false;
+    }
+    if (cpu < 0)
+    {
+        // 撤销绑核：内核会与 cpuset 取交集，多给的 CPU 不会出错
+        long conf = sysconf(_SC_NPROCESSORS_CONF);
+        for (long i = 0; i < conf && i < CPU_SETSIZE; ++i)
+            CPU_SET((int)i, &set);
+    }
+    else
+        CPU_SET(cpu, &set);
+    int r = pthread_setaffinity_np(th, sizeof(set), &set);
+    if (r != 0)
+    {
+        spt_err(err, errlen, r == EINVAL ? "CPU 不存在或不在允许的 cpuset 里" : "pthread_setaffinity_np 失败");
+        return false;
+    }
+    return true;
+#else
+    (void)th;
+    if (cpu < 0)
+        return true;
+    spt_err(err, errlen, "这个平台不支持绑核");
+    return false;
+#endif
+}
+
+static bool spt_set_prio(SptThread th, const SptConfig *cfg, char *err, size_t errlen)
+{
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    int policy = SCHED_OTHER;
+    if (cfg->prio == SPT_REALTIME)
+    {
+        int lo = sched_get_priority_min(SCHED_FIFO), hi = sched_get_priority_max(SCHED_FIFO);
+        int p = cfg->rt_prio > 0 ? cfg->rt_prio : SPT_RT_DEFAULT;
+        policy = SCHED_FIFO;
+        sp.sched_priority = p < lo ? lo : p > hi ? hi : p;
+    }
+    int r = pthread_setschedparam(th, policy, &sp);
+    if (r != 0)
+    {
+        spt_err(err, errlen,
+                r == EPERM ? "没有实时调度权限（需要 root / CAP_SYS_NICE，或用 ulimit -r 放开 RLIMIT_RTPRIO）"
+                           : "pthread_setschedparam 失败");
+        return false;
+    }
+    return true;
+}
+
+bool spt_apply_self(const SptConfig *cfg, char *err, size_t errlen)
+{
+    return spt_apply(pthread_self(), cfg, err, errlen);
+}
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+bool spt_apply(SptThread th, const SptConfig *cfg, char *err, size_t errlen)
+{
+    if (!cfg)
+    {
+        spt_err(err, errlen, "没有配置");
+        return false;
+    }
+    // 先绑核再提优先级：实时线程在错误的核上就算只跑一瞬间也是在抢别人的核
+    bool ok = spt_set_affinity(th, cfg->cpu, err, errlen);
+    char err2[128] = {0};
+    if (!spt_set_prio(th, cfg, err2, sizeof(err2)))
+    {
+        if (ok)
+            spt_err(err, errlen, err2);
+        ok = false;
+    }
+    return ok;
+}
+
+const char *spt_describe(const SptConfig *cfg, char *buf, size_t len)
+{
+    char cpu[16] = "any";
+    if (cfg->cpu >= 0)
+        snprintf(cpu, sizeof(cpu), "%d", cfg->cpu);
+    if (cfg->prio == SPT_REALTIME)
+    {
+#ifdef _WIN32
+        snprintf(buf, len, "cpu=%s rt", cpu);
+#else
+        snprintf(buf, len, "cpu=%s rt(%d)", cpu, cfg->rt_prio > 0 ? cfg->rt_prio : SPT_RT_DEFAULT);
+#endif
+    }
+    else
+        snprintf(buf, len, "cpu=%s normal", cpu);
+    return buf;
+}
@@ -0,0 +1,75 @@
+#ifndef SP_THREAD_H
+#define SP_THREAD_H
+
+// 线程调度配置：绑核与实时优先级，给 reader / printer 这类延迟敏感的线程用
+//
+// - 绑核：线程固定在一个逻辑 CPU 上，不被调度器搬来搬去（搬一次缓存和 TLB 全部重来）；
+//   reader 与 printer 绑在不同的物理核上，各自的热数据留在各自的 L1/L2
+// - 实时优先级：Linux/macOS SCHED_FIFO，Windows THREAD_PRIORITY_TIME_CRITICAL；
+//   其它普通线程（编译、浏览器……）再多也抢不走它，尾延迟不再随机器负载飘
+// - 可以作用到正在运行的线程（spt_apply），也可以线程自己调用（spt_apply_self）
+// - 失败（没有权限 / 平台不支持 / CPU 不存在）返回 false 并写 err，不影响线程继续运行；
+//   绑核与优先级分开设置，其中一项失败时另一项可能已经生效
+//
+// 权限：Linux 的 SCHED_FIFO 需要 root、CAP_SYS_NICE 或 ulimit -r（RLIMIT_RTPRIO）；
+// Windows 的 TIME_CRITICAL 普通用户即可（进程优先级类不改）。macOS 没有绑核接口，只支持优先级。
+// 实时线程忙等会饿死同核的普通线程：只给会阻塞等待的线程（等串口 / 等环事件）设实时
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define SPT_RT_DEFAULT 50 // SCHED_FIFO 默认优先级（1~99；中断线程一般是 50，这里与之平级）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        SPT_NORMAL = 0,  // 普通分时调度（也用来撤销实时）
+        SPT_REALTIME = 1 // SCHED_FIFO / THREAD_PRIORITY_TIME_CRITICAL
+    } SptPrio;
+
+    typedef struct
+    {
+        int cpu;      // 绑定的逻辑 CPU（0 起），-1 不绑（可在进程允许的所有 CPU 上运行）
+        SptPrio prio;
+        int rt_prio;  // SPT_REALTIME 时的 SCHED_FIFO 优先级（0 取 SPT_RT_DEFAULT）；Windows 忽略
+    } SptConfig;
+
+#ifdef _WIN32
+    typedef HANDLE SptThread;
+#else
+    typedef pthread_t SptThread;
+#endif
+
+    // 默认配置：不绑核、普通优先级
+    void spt_default_config(SptConfig *cfg);
+
+    // 作用到线程 th（可以是正在运行的线程）；err 可为 NULL
+    bool spt_apply(SptThread th, const SptConfig *cfg, char *err, size_t errlen);
+
+    // 作用到调用线程自己
+    bool spt_apply_self(const SptConfig *cfg, char *err, size_t errlen);
+
+    // 逻辑 CPU 数（至少 1）
+    int spt_cpu_count(void);
+
+    // 调用线程当前所在的逻辑 CPU；不支持返回 -1
+    int spt_current_cpu(void);
+
+    // 显示用：如 "cpu=2 rt(50)"、"cpu=any normal"
+    const char *spt_describe(const SptConfig *cfg, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SP_THREAD_H
@@ -0,0 +1,381 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // posix_openpt / ptsname / pthread_getcpuclockid
+#endif
+#include "stress.h"
+#include "../ringbuf/ringbuf_wait.h" // rb_ev_now_ns / rb_ev_sleep_ms
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#endif
+
+#define ST_BATCH_BYTES (16 * 1024) // 一次写出的上限（帧 + 噪声）
+#define ST_FAST_FRAMES 64          // rate=0 时每批帧数
+#define ST_WRITE_WAIT_MS 100       // 主端写不动时多久回来看一次 run
+
+static const uint8_t k_magic[4] = {'S', 'T', 'R', 'S'};
+
+/* ---------------- 平台相关：线程 CPU ---------------- */
+#ifdef _WIN32
+double st_thread_cpu_ms(StThread th)
+{
+    FILETIME c, e, k, u;
+    if (!th || !GetThreadTimes(th, &c, &e, &k, &u))
+        return -1;
+    ULARGE_INTEGER kk = {{k.dwLowDateTime, k.dwHighDateTime}}, uu = {{u.dwLowDateTime, u.dwHighDateTime}};
+    return (double)(kk.QuadPart + uu.QuadPart) / 1e4; // 100ns 为单位
+}
+#else
+double st_thread_cpu_ms(StThread th)
+{
+#ifdef __APPLE__
+    mach_port_t mt = pthread_mach_thread_np(th);
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t cnt = THREAD_BASIC_INFO_COUNT;
+    if (thread_info(mt, THREAD_BASIC_INFO, (thread_info_t)&info, &cnt) != KERN_SUCCESS)
+        return -1;
+    return (info.user_time.seconds + info.system_time.seconds) * 1e3 +
+           (info.user_time.microseconds + info.system_time.microseconds) / 1e3;
+#else
+    clockid_t cid;
+    struct timespec ts;
+    if (pthread_getcpuclockid(th, &cid) != 0 || clock_gettime(cid, &ts) != 0)
+        return -1;
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+#endif
+
+/* ---------------- 探针帧 ---------------- */
+
+static void put_le(uint8_t *p, uint64_t v, int w)
+{
+    for (int i = 0; i < w; ++i)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int w)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < w; ++i)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+bool st_probe_time(const uint8_t *payload, size_t len, uint64_t *t_ns)
+{
+    if (!payload || len < ST_PROBE_BYTES || memcmp(payload, k_magic, sizeof(k_magic)))
+        return false;
+    if (t_ns)
+        *t_ns = get_le(payload + 8, 8);
+    return true;
+}
+
+void st_on_frame(Stress *st, const uint8_t *payload, size_t len)
+{
+    uint64_t t;
+    if (!st || !st_probe_time(payload, len, &t))
+        return;
+    sph_record(&st->parse, rb_ev_now_ns() - t);
+    uint32_t seq = (uint32_t)get_le(payload + 4, 4);
+    if (seq >= st->next_seq)
+    {
+        if (seq > st->next_seq)
+            atomic_fetch_add(&st->lost, (unsigned long long)(seq - st->next_seq));
+        st->next_seq = seq + 1;
+    }
+    else
+        atomic_fetch_add(&st->reorder, 1);
+    atomic_fetch_add(&st->rx, 1);
+}
+
+void st_on_display(Stress *st, uint64_t t_ns)
+{
+    if (st)
+        sph_record(&st->display, rb_ev_now_ns() - t_ns);
+}
+
+/* ---------------- 发生器线程 ---------------- */
+
+// 写完 n 字节或 run 被清掉；出错返回 false
+static bool st_write_all(Stress *st, const uint8_t *p, size_t n)
+{
+    size_t done = 0;
+    while (done < n && atomic_load(&st->run))
+    {
+#ifndef _WIN32
+        if (st->master >= 0)
+        {
+            ssize_t w = write(st->master, p + done, n - done);
+            if (w > 0)
+            {
+                done += (size_t)w;
+                continue;
+            }
+            if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                return false;
+            // 从端的输入队列满了（接收端没跟上）：等可写
+            struct pollfd pfd = {st->master, POLLOUT, 0};
+            poll(&pfd, 1, ST_WRITE_WAIT_MS);
+            continue;
+        }
+#endif
+        long w = sp_write(&st->out, p + done, n - done);
+        if (w < 0)
+            return false;
+        done += (size_t)w; // 0：写超时，接着试
+    }
+    return true;
+}
+
+static void st_run(Stress *st)
+{
+    uint8_t *batch = (uint8_t *)malloc(ST_BATCH_BYTES);
+    uint8_t body[PROTO_MAX_FRAME];
+    uint8_t enc[2 * PROTO_MAX_FRAME + 2];
+    uint32_t x = 0x2545F491u; // 噪声
+    uint64_t sent = 0;
+    const uint64_t t0 = st->t_start;
+    const uint64_t limit_ns = (uint64_t)st->cfg.seconds * 1000000000u;
+    if (!batch)
+        atomic_fetch_add(&st->write_errors, 1);
+    else if (st->proto.framing != PF_LENGTH)
+    {
+        // 分隔符协议：先写一个分隔符，把接收端可能残留的半帧截断，第一帧不至于和它粘在一起
+        uint8_t delim = (st->proto.framing == PF_COBS) ? 0x00 : 0xC0;
+        st_write_all(st, &delim, 1);
+    }
+    while (batch && atomic_load(&st->run))
+    {
+        uint64_t now = rb_ev_now_ns();
+        if (limit_ns && now - t0 >= limit_ns)
+            break;
+        uint64_t due = st->cfg.rate ? (now - t0) * st->cfg.rate / 1000000000u + 1 : sent + ST_FAST_FRAMES;
+        if (due <= sent)
+        {
+            rb_ev_sleep_ms(1);
+            continue;
+        }
+        size_t fill = 0, noise = 0;
+        uint64_t first = sent;
+        while (sent < due)
+        {
+            uint64_t t = rb_ev_now_ns();
+            memcpy(body, k_magic, sizeof(k_magic));
+            put_le(body + 4, sent, 4);
+            put_le(body + 8, t, 8);
+            for (unsigned i = ST_PROBE_BYTES; i < st->cfg.payload; ++i)
+                body[i] = (uint8_t)(sent + i);
+            size_t m = proto_encode(&st->proto, body, st->cfg.payload, enc, sizeof(enc));
+            size_t nz = 0;
+            if (st->cfg.noise_pct)
+            {
+                nz = m * st->cfg.noise_pct / (100 - st->cfg.noise_pct);
+                x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+                nz = nz / 2 + x % (nz + 1); // 平均值不变，长度有起伏
+            }
+            if (m == 0 || m + nz > ST_BATCH_BYTES)
+            {
+                atomic_fetch_add(&st->write_errors, 1); // 配置被 st_start 校验过，不应发生
+                atomic_store(&st->run, false);
+                break;
+            }
+            if (fill + m + nz > ST_BATCH_BYTES)
+                break; // 本批满了，剩下的下一轮
+            for (size_t i = 0; i < nz; ++i)
+            {
+                x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+                batch[fill++] = (uint8_t)x;
+            }
+            memcpy(batch + fill, enc, m);
+            fill += m;
+            noise += nz;
+            ++sent;
+        }
+        if (fill && !st_write_all(st, batch, fill))
+        {
+            atomic_fetch_add(&st->write_errors, 1);
+            break;
+        }
+        atomic_fetch_add(&st->sent, sent - first);
+        atomic_fetch_add(&st->sent_bytes, (unsigned long long)fill);
+        atomic_fetch_add(&st->noise_bytes, (unsigned long long)noise);
+    }
+    free(batch);
+#ifdef _WIN32
+    st->cpu_ms = st_thread_cpu_ms(GetCurrentThread());
+#else
+    st->cpu_ms = st_thread_cpu_ms(pthread_self());
+#endif
+    atomic_store(&st->t_end, rb_ev_now_ns());
+    atomic_store(&st->done, true);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI st_thread(LPVOID arg)
+{
+    st_run((Stress *)arg);
+    return 0;
+}
+#else
+static void *st_thread(void *arg)
+{
+    st_run((Stress *)arg);
+    return NULL;
+}
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+void st_init(Stress *st)
+{
+    if (!st)
+        return;
+    memset(st, 0, sizeof(*st));
+#ifndef _WIN32
+    st->master = st->slave = -1;
+    st->out.fd = -1;
+#endif
+}
+
+bool st_open_pty(Stress *st)
+{
+#ifdef _WIN32
+    (void)st;
+    return false;
+#else
+    if (!st)
+        return false;
+    int m = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m < 0)
+        return false;
+    const char *name = NULL;
+    if (grantpt(m) != 0 || unlockpt(m) != 0 || !(name = ptsname(m)))
+    {
+        close(m);
+        return false;
+    }
+    int s = open(name, O_RDWR | O_NOCTTY);
+    if (s < 0)
+    {
+        close(m);
+        return false;
+    }
+    fcntl(m, F_SETFL, fcntl(m, F_GETFL) | O_NONBLOCK);
+    strncpy(st->slave_name, name, sizeof(st->slave_name) - 1);
+    st->slave_name[sizeof(st->slave_name) - 1] = 0;
+    st->master = m;
+    st->slave = s;
+    st->pty = true;
+    return true;
+#endif
+}
+
+bool st_open_port(Stress *st, const char *name, int baud)
+{
+    if (!st || !name)
+        return false;
+    st->pty = false;
+    return sp_open(&st->out, name, baud);
+}
+
+bool st_start(Stress *st, const ProtoDesc *d, const StressConfig *cfg)
+{
+    if (!st || !d || !cfg || st->started)
+        return false;
+#ifndef _WIN32
+    if (st->master < 0 && !sp_is_open(&st->out))
+        return false;
+#else
+    if (!sp_is_open(&st->out))
+        return false;
+#endif
+    // 负载放得下探针头、不超过协议上限，编码后一帧加最多的噪声能放进一批
+    if (cfg->payload < ST_PROBE_BYTES || cfg->payload > d->max_body || cfg->noise_pct > ST_MAX_NOISE_PCT)
+        return false;
+    uint8_t probe[PROTO_MAX_FRAME] = {0};
+    uint8_t enc[2 * PROTO_MAX_FRAME + 2];
+    size_t m = proto_encode(d, probe, cfg->payload, enc, sizeof(enc));
+    size_t nz_max = m * cfg->noise_pct / (100 - cfg->noise_pct); // 单帧噪声最多 1.5 倍平均值
+    if (m == 0 || m + nz_max + nz_max / 2 > ST_BATCH_BYTES)
+        return false;
+
+    st->proto = *d;
+    st->cfg = *cfg;
+    atomic_store(&st->sent, 0);
+    atomic_store(&st->sent_bytes, 0);
+    atomic_store(&st->noise_bytes, 0);
+    atomic_store(&st->write_errors, 0);
+    atomic_store(&st->rx, 0);
+    atomic_store(&st->lost, 0);
+    atomic_store(&st->reorder, 0);
+    st->next_seq = 0;
+    sph_clear(&st->parse);
+    sph_clear(&st->display);
+    atomic_store(&st->t_end, 0);
+    atomic_store(&st->done, false);
+    st->t_start = rb_ev_now_ns();
+
+    atomic_store(&st->run, true);
+#ifdef _WIN32
+    st->th = CreateThread(NULL, 0, st_thread, st, 0, NULL);
+    st->started = (st->th != NULL);
+#else
+    st->started = (pthread_create(&st->th, NULL, st_thread, st) == 0);
+#endif
+    if (!st->started)
+        atomic_store(&st->run, false);
+    return st->started;
+}
+
+void st_stop(Stress *st)
+{
+    if (!st || !st->started)
+        return;
+    atomic_store(&st->run, false);
+#ifdef _WIN32
+    WaitForSingleObject(st->th, INFINITE);
+    CloseHandle(st->th);
+    st->th = NULL;
+#else
+    pthread_join(st->th, NULL);
+#endif
+    st->started = false;
+}
+
+void st_close(Stress *st)
+{
+    if (!st)
+        return;
+    st_stop(st);
+    if (sp_is_open(&st->out))
+        sp_close(&st->out);
+#ifndef _WIN32
+    if (st->master >= 0)
+        close(st->master);
+    if (st->slave >= 0)
+        close(st->slave);
+    st->master = st->slave = -1;
+#endif
+}
+
+bool st_running(const Stress *st)
+{
+    return st && st->started && !atomic_load(&st->done);
+}
+
+double st_elapsed(const Stress *st)
+{
+    if (!st || !st->t_start)
+        return 0.0;
+    uint64_t end = atomic_load(&st->t_end);
+    return (double)((end ? end : rb_ev_now_ns()) - st->t_start) / 1e9;
+}
@@ -0,0 +1,125 @@
+#ifndef STRESS_H
+#define STRESS_H
+
+// 压力发生器：不接硬件测整条接收链路（sp_read_wait -> SPSC 环 -> 帧解析 -> 帧槽队列 -> 控制台）
+//
+// - 对端：POSIX 用 posix_openpt 开一对伪终端（同 openpty，不用链接 libutil），发生器写主端，终端照常 open 从端；
+//   Windows（或想走真实回环线时）给出虚拟串口对（com0com 等）/ 回环线的另一端，发生器用 sp_open 打开它
+// - 发生器线程按设定的帧率、负载长度和噪声比例，用当前协议（proto_encode）编码探针帧写出；
+//   探针负载 = "STRS" | seq(4, LE) | t_ns(8, LE，发生器写出前的 rb_ev_now_ns) | 填充
+// - 接收侧两个挂钩：解析出帧时 st_on_frame（printer 线程），帧写到控制台后 st_on_display（render 线程）；
+//   分别记“写出 -> 解析”和“写出 -> 显示”的延迟（SpHist 对数-线性直方图，与 stat 的解析延迟同一精度），并按 seq 统计丢帧/乱序
+// - 发生器与接收侧在同一进程里，用同一个单调时钟，延迟不受两台机器时钟差影响
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "serial_port.h"
+#include "proto.h"
+#include "sp_stats.h" // SpHist
+
+#define ST_PROBE_BYTES 16   // 探针负载最短：magic + seq + 时间戳
+#define ST_MAX_NOISE_PCT 90
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef _WIN32
+    typedef HANDLE StThread;
+#else
+    typedef pthread_t StThread;
+#endif
+
+    typedef struct
+    {
+        unsigned rate;      // 帧/秒（0 = 尽快写，受接收端读取速度限制）
+        unsigned payload;   // 每帧负载字节（ST_PROBE_BYTES ~ 协议 max_body）
+        unsigned noise_pct; // 噪声字节占写出总字节的百分比（0 ~ ST_MAX_NOISE_PCT）
+        unsigned seconds;   // 跑多久（0 = 直到 st_stop）
+    } StressConfig;
+
+    typedef struct
+    {
+        // 发生器
+        ProtoDesc proto;
+        StressConfig cfg;
+        SerialPort out; // 指定对端端口时使用
+#ifndef _WIN32
+        int master;           // pty 主端（-1：用 out）
+        int slave;            // pty 从端：发生器停下前一直开着，终端重开从端时主端不会读到挂断
+        char slave_name[128]; // 给 open 用的从端路径
+#endif
+        bool pty;
+        atomic_bool run;
+        atomic_bool done; // 发生器已经到时（或写出错）退出
+        bool started;     // 线程已创建，st_stop 要 join
+        StThread th;
+        uint64_t t_start;     // 发生器开始时刻（ns）
+        atomic_ullong t_end;  // 发生器退出时刻（0：还在跑）
+        atomic_ullong sent;   // 写出的探针帧
+        atomic_ullong sent_bytes;  // 写出的总字节（含噪声）
+        atomic_ullong noise_bytes; // 其中的噪声字节
+        atomic_ulong write_errors;
+        double cpu_ms; // 发生器线程退出前记下自己用掉的 CPU（毫秒，-1 取不到）
+
+        // 接收侧：printer 写
+        uint32_t next_seq;    // 期望的下一个 seq（只由 st_on_frame 读写）
+        atomic_ullong rx;     // 解析出的探针帧
+        atomic_ullong lost;   // seq 跳过的帧（环满丢弃 / 校验失败 / 噪声吞掉）
+        atomic_ullong reorder; // seq 比期望的小（重复或乱序）
+        SpHist parse;         // 写出 -> 解析出帧（ns）
+        // 接收侧：render 写
+        SpHist display;       // 写出 -> 写到控制台（ns）
+    } Stress;
+
+    // 清零（端口未开，线程未起）
+    void st_init(Stress *st);
+
+    // 对端：POSIX 开一对伪终端（成功后从端路径在 st->slave_name）；Windows 不支持，返回 false
+    bool st_open_pty(Stress *st);
+
+    // 对端：打开虚拟串口对 / 回环线的另一端（同步模式，与接收端同波特率）
+    bool st_open_port(Stress *st, const char *name, int baud);
+
+    // 按 d 的协议、cfg 的节奏启动发生器线程（对端已打开，接收端已在读）；清零全部统计
+    bool st_start(Stress *st, const ProtoDesc *d, const StressConfig *cfg);
+
+    // 停发生器线程（可重复调用）；对端保持打开，已写出的数据接收端还能读完；统计保留到下一次 st_start
+    void st_stop(Stress *st);
+
+    // 停线程并关闭对端（pty 主端关闭后从端会读到挂断，接收端应随后关闭）
+    void st_close(Stress *st);
+
+    // 发生器是否还在写
+    bool st_running(const Stress *st);
+
+    // 发生器已跑的秒数（退出后固定为总时长）
+    double st_elapsed(const Stress *st);
+
+    // 是否探针帧；是则 t_ns 写出时刻（len 可以小于整帧，只要包含探针头部）
+    bool st_probe_time(const uint8_t *payload, size_t len, uint64_t *t_ns);
+
+    // printer：解析出一帧（非探针帧忽略）
+    void st_on_frame(Stress *st, const uint8_t *payload, size_t len);
+
+    // render：t_ns 写出的探针帧已写到控制台
+    void st_on_display(Stress *st, uint64_t t_ns);
+
+    // 线程累计 CPU 时间（毫秒）；取不到返回 -1
+    double st_thread_cpu_ms(StThread th);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STRESS_H
@@ -0,0 +1,207 @@
+#include "tx_queue.h"
+#include <string.h>
+
+#define TXQ_IDLE_MS 200   // 没有待发数据时最多睡这么久（只为检查 run）
+#define TXQ_CTS_POLL_MS 2 // CTS 拉低时多久看一次
+#define TXQ_ERR_MS 10     // 写出错后歇一会儿，别空转
+
+/* ---------------- 写线程 ---------------- */
+
+// 最后一个字节已写出的消息出队并记延迟
+static void txq_retire(TxQueue *q)
+{
+    const TxMark *m;
+    uint64_t now = 0;
+    while ((m = txq_marks_front(&q->msgs)) != NULL && m->end <= q->out_pos)
+    {
+        if (!now)
+            now = rb_ev_now_ns();
+        sph_record(&q->lat_ns, now - m->t_ns);
+        atomic_fetch_add(&q->msgs_done, 1);
+        txq_marks_release(&q->msgs, 1);
+    }
+}
+
+static void txq_run(TxQueue *q)
+{
+    bool stalled = false;
+    while (atomic_load(&q->run))
+    {
+        if (rbs_wait_readable(&q->ring, 1, TXQ_IDLE_MS) == 0)
+            continue;
+
+        // 硬件流控：对端拉低 CTS 就先不发起写，数据留在队列里（发送方经 txq_send 感受到背压）
+        if (atomic_load(&q->sp->rtscts) && sp_get_cts(q->sp) == 0)
+        {
+            if (!stalled)
+                atomic_fetch_add(&q->cts_wait, 1);
+            stalled = true;
+            rb_ev_sleep_ms(TXQ_CTS_POLL_MS);
+            continue;
+        }
+        stalled = false;
+
+        // 积压的所有消息一次写出（镜像环下可读区总是一段；普通环绕回时分两次）
+        RbSpan s[2];
+        if (rbs_read_peek_spans(&q->ring, s) == 0)
+            continue;
+        long w = sp_write(q->sp, s[0].ptr, s[0].len);
+        atomic_fetch_add(&q->writes, 1);
+        if (w < 0)
+        {
+            atomic_fetch_add(&q->errors, 1);
+            rb_ev_sleep_ms(TXQ_ERR_MS);
+            continue;
+        }
+        if ((size_t)w < s[0].len)
+            atomic_fetch_add(&q->partial, 1); // 没写完的部分留在队首，下一轮接着写
+        if (w == 0)
+            continue;
+
+        rbs_read_consume(&q->ring, (size_t)w);
+        q->out_pos += (uint64_t)w;
+        atomic_fetch_add(&q->bytes, (unsigned long)w);
+        if (q->total_tx)
+            atomic_fetch_add(q->total_tx, (unsigned long)w);
+        rb_ev_signal(&q->space);
+        txq_retire(q);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI txq_thread(LPVOID arg)
+{
+    txq_run((TxQueue *)arg);
+    return 0;
+}
+#else
+static void *txq_thread(void *arg)
+{
+    txq_run((TxQueue *)arg);
+    return NULL;
+}
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+bool txq_start(TxQueue *q, SerialPort *sp, atomic_ulong *total_tx)
+{
+    if (!q || !sp_is_open(sp))
+        return false;
+    memset(q, 0, sizeof(*q));
+    q->sp = sp;
+    q->total_tx = total_tx;
+    if (!rbs_init_mirror(&q->ring, TXQ_RING_BYTES) && !rbs_init(&q->ring, TXQ_RING_BYTES))
+        return false;
+    txq_marks_init(&q->msgs);
+    rb_ev_init(&q->space);
+    q->t_start = rb_ev_now_ns();
+
+    atomic_store(&q->run, true);
+#ifdef _WIN32
+    q->th = CreateThread(NULL, 0, txq_thread, q, 0, NULL);
+    bool ok = (q->th != NULL);
+#else
+    bool ok = (pthread_create(&q->th, NULL, txq_thread, q) == 0);
+#endif
+    if (!ok)
+    {
+        atomic_store(&q->run, false);
+        rb_ev_destroy(&q->space);
+        rbs_free(&q->ring);
+        return false;
+    }
+    return true;
+}
+
+size_t txq_stop(TxQueue *q, int drain_ms)
+{
+    if (!q || !atomic_load(&q->run))
+        return 0;
+    // 给积压一点时间写完；CTS 一直拉低或端口已坏时到点就放弃
+    long long deadline = rb_ev_now_ms() + (drain_ms > 0 ? drain_ms : 0);
+    while (rbs_size(&q->ring) && rb_ev_now_ms() < deadline)
+        rb_ev_sleep_ms(1);
+
+    atomic_store(&q->run, false);
+    rbs_wake(&q->ring);
+#ifdef _WIN32
+    WaitForSingleObject(q->th, INFINITE);
+    CloseHandle(q->th);
+    q->th = NULL;
+#else
+    pthread_join(q->th, NULL);
+#endif
+    size_t left = rbs_size(&q->ring);
+    rb_ev_wake(&q->space); // 理论上没有等待者（发送方与 stop 在同一线程），保险
+    rb_ev_destroy(&q->space);
+    rbs_free(&q->ring);
+    return left;
+}
+
+bool txq_running(const TxQueue *q)
+{
+    return q && atomic_load(&q->run);
+}
+
+bool txq_send(TxQueue *q, const void *data, size_t n, int timeout_ms)
+{
+    if (!q || !data || n == 0)
+        return true;
+    if (!atomic_load(&q->run) || n > rbs_capacity(&q->ring))
+    {
+        atomic_fetch_add(&q->rejected, 1);
+        return false;
+    }
+
+    // 整条消息放得下才入队：不把一条命令拆成两半、隔着别的消息发出去
+    long long deadline = rb_ev_now_ms() + timeout_ms;
+    for (;;)
+    {
+        unsigned key = rb_ev_prepare(&q->space);
+        if (rbs_free_space(&q->ring) >= n)
+        {
+            rb_ev_cancel(&q->space);
+            break;
+        }
+        int wait = -1;
+        if (timeout_ms >= 0)
+        {
+            long long left = deadline - rb_ev_now_ms();
+            if (left <= 0)
+            {
+                rb_ev_cancel(&q->space);
+                atomic_fetch_add(&q->rejected, 1);
+                return false;
+            }
+            wait = (int)left;
+        }
+        rb_ev_wait(&q->space, key, wait);
+    }
+
+    // 先发布标记再发布数据：写线程看到数据时标记一定已在队列里，延迟从入队算起
+    // 标记环满（在途消息过多）时这条消息只是不计延迟
+    q->enq_pos += n;
+    TxMark *m = txq_marks_reserve(&q->msgs);
+    if (m)
+    {
+        m->end = q->enq_pos;
+        m->t_ns = rb_ev_now_ns();
+        txq_marks_commit(&q->msgs);
+    }
+    rbs_push(&q->ring, data, n);
+    return true;
+}
+
+size_t txq_pending(const TxQueue *q)
+{
+    return (q && atomic_load(&q->run)) ? rbs_size(&q->ring) : 0;
+}
+
+double txq_rate(const TxQueue *q)
+{
+    if (!q || !q->t_start)
+        return 0.0;
+    double sec = (double)(rb_ev_now_ns() - q->t_start) / 1e9;
+    return sec > 0 ? (double)atomic_load(&q->bytes) / sec : 0.0;
+}
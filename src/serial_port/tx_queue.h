@@ -0,0 +1,97 @@
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+// 发送队列：命令线程把消息推进 TX 环就返回，写线程把积压的消息合并成一次 sp_write
+//
+// - 合并：写线程每次把环里所有可写数据（镜像环下总是一段）交给一次 sp_write
+// - 部分写：只消费实际写出的字节，剩下的下一轮接着写，消息不会被截断或丢弃
+// - 背压：环满时 txq_send 等空间（写线程消费后唤醒），超时返回失败；
+//   开了 RTS/CTS 且对端拉低 CTS 时写线程暂停发起写（不在驱动里卡满写超时），队列随之积压
+// - 统计：每条消息从入队到最后一个字节写出的延迟（SpHist，与 stat 的解析延迟同一精度），
+//   以及字节数 / 系统调用次数（合并效果）/ 部分写 / CTS 暂停
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../ringbuf/ringbuf_spsc.h"
+#include "../ringbuf/ringbuf_typed.h"
+#include "serial_port.h"
+#include "sp_stats.h" // SpHist
+
+#define TXQ_RING_BYTES (64 * 1024) // 待发字节
+#define TXQ_MAX_MSGS 4096          // 在途消息（只用于延迟统计）
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        uint64_t end;  // 这条消息最后一个字节之后的流位置
+        uint64_t t_ns; // 入队时刻
+    } TxMark;
+
+    RB_TYPED_SPSC_DEFINE(TxMarkRing, txq_marks, TxMark, TXQ_MAX_MSGS)
+
+    typedef struct
+    {
+        RingBufSpsc ring; // 待发字节：命令线程生产，写线程消费
+        TxMarkRing msgs;  // 消息标记：同上
+        RbEvent space;    // 写线程消费后通知等待空间的发送方
+        SerialPort *sp;
+        atomic_ulong *total_tx; // 写出的字节同时累加到这里（可为 NULL）
+        uint64_t enq_pos; // 生产者：已入队的字节总数
+        uint64_t out_pos; // 写线程：已写出的字节总数
+        atomic_bool run;
+#ifdef _WIN32
+        HANDLE th;
+#else
+        pthread_t th;
+#endif
+        uint64_t t_start; // txq_start 的时刻（ns），算吞吐
+
+        // 统计：写线程写，任意线程原子读
+        atomic_ulong bytes;    // 已写出字节
+        atomic_ulong msgs_done; // 已完整写出的消息
+        atomic_ulong writes;   // sp_write 调用次数
+        atomic_ulong partial;  // 只写出一部分的次数
+        atomic_ulong errors;   // sp_write 出错
+        atomic_ulong cts_wait; // 因 CTS 拉低暂停的次数
+        atomic_ulong rejected; // 等空间超时被拒的消息（发送方写）
+        SpHist lat_ns;         // 入队 -> 最后一个字节写出（写线程记录）
+    } TxQueue;
+
+    // 为已打开的端口启动写线程；total_tx 非 NULL 时写出的字节也累加到它
+    bool txq_start(TxQueue *q, SerialPort *sp, atomic_ulong *total_tx);
+
+    // 停止：最多等 drain_ms 把积压写完，然后停线程、释放队列（之后才能 sp_close）
+    // 返回没来得及写出而丢弃的字节数
+    size_t txq_stop(TxQueue *q, int drain_ms);
+
+    // 写线程是否在运行
+    bool txq_running(const TxQueue *q);
+
+    // 发送方（单线程）：整条消息入队；空间不够时最多等 timeout_ms（0 不等，<0 一直等）
+    // 返回 false 表示队列满超时或消息超过队列容量（计入 rejected）
+    bool txq_send(TxQueue *q, const void *data, size_t n, int timeout_ms);
+
+    // 待发字节数
+    size_t txq_pending(const TxQueue *q);
+
+    // 每秒写出字节（从 txq_start 起的平均值）
+    double txq_rate(const TxQueue *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TX_QUEUE_H